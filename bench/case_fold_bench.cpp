@@ -0,0 +1,121 @@
+#include "system/utf8_case.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Compares the former TextToLower with foldCaseUtf8 on mixed-script names.
+ * @details Usage: case_fold_bench [name count]. Every set is folded by the former
+ * std::tolower loop (which allocates and leaves Cyrillic untouched), by the scalar path
+ * and by foldCaseUtf8 into a reused buffer; the last two must give the same bytes.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char *LATIN[] = {"Alexander", "Elena", "Sergei", "Maria", "Fedor", "Vera", "Yakov", "Vitaliy"};
+const char *CYRILLIC[] = {"Александр", "Елена", "Сергей", "Мария", "Фёдор", "Вера", "Яков", "Виталий"};
+const char *SURNAMES[] = {"PETROV", "Иванова", "Smirnov", "КУЗНЕЦОВ", "Popova", "Лебедев", "Kozlov", "Новикова"};
+
+/**
+ * @brief The former TextToLower: std::tolower byte by byte into a new string.
+ */
+std::string legacyTextToLower(const std::string &str) {
+  std::string result = str;
+  std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return std::tolower(c); });
+  return result;
+}
+
+/**
+ * @brief Builds a set of names.
+ * @param kind 0 - Latin logins, 1 - Cyrillic names, 2 - mixed "name surname", 3 - long ASCII logins.
+ */
+std::vector<std::string> makeNames(int kind, std::size_t count) {
+  std::vector<std::string> names;
+  names.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    std::string name;
+    switch (kind) {
+    case 0:
+      name = std::string(LATIN[i % 8]) + std::to_string(1950 + i % 60);
+      break;
+    case 1:
+      name = std::string(CYRILLIC[i % 8]) + " " + CYRILLIC[(i / 8) % 8];
+      break;
+    case 2:
+      name = std::string(i % 2 ? LATIN[i % 8] : CYRILLIC[i % 8]) + " " + SURNAMES[(i / 8) % 8];
+      break;
+    default:
+      name = std::string(LATIN[i % 8]) + "." + LATIN[(i / 8) % 8] + ".Mailbox" + std::to_string(i) + "@Example.COM";
+      break;
+    }
+    names.push_back(name);
+  }
+  return names;
+}
+
+/**
+ * @brief Runs all variants over one set of names.
+ */
+void runSet(const char *title, const std::vector<std::string> &names, int rounds) {
+  std::size_t bytes = 0;
+  for (const auto &name : names)
+    bytes += name.size();
+
+  std::size_t checksum = 0;
+  auto start = Clock::now();
+  for (int r = 0; r < rounds; ++r)
+    for (const auto &name : names)
+      checksum += static_cast<unsigned char>(legacyTextToLower(name)[0]);
+  double legacyNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+  std::vector<char> buffer(256);
+  std::vector<char> reference(256);
+  start = Clock::now();
+  for (int r = 0; r < rounds; ++r)
+    for (const auto &name : names)
+      checksum += foldCaseUtf8Scalar(name, buffer.data());
+  double scalarNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+  start = Clock::now();
+  for (int r = 0; r < rounds; ++r)
+    for (const auto &name : names)
+      checksum += foldCaseUtf8(name, buffer.data());
+  double vectorNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+  for (const auto &name : names) {
+    foldCaseUtf8Scalar(name, reference.data());
+    foldCaseUtf8(name, buffer.data());
+    if (std::memcmp(reference.data(), buffer.data(), name.size()) != 0) {
+      std::printf("mismatch on %s\n", name.c_str());
+      std::exit(1);
+    }
+  }
+
+  double total = static_cast<double>(names.size()) * rounds;
+  double mb = static_cast<double>(bytes) * rounds / 1e6;
+  std::printf("%-22s legacy %6.1f ns/name | scalar %6.1f ns/name %7.0f MB/s | foldCaseUtf8 %6.1f ns/name %7.0f "
+              "MB/s | checksum %zu\n",
+              title, legacyNs / total, scalarNs / total, mb / (scalarNs / 1e9), vectorNs / total,
+              mb / (vectorNs / 1e9), checksum);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+  const int rounds = 20;
+
+  runSet("latin logins", makeNames(0, count), rounds);
+  runSet("cyrillic names", makeNames(1, count), rounds);
+  runSet("mixed name+surname", makeNames(2, count), rounds);
+  runSet("long ascii logins", makeNames(3, count), rounds);
+  return 0;
+}
@@ -0,0 +1,292 @@
+#include "ChatBot/chat_system.h"
+#include "server/chat_server.h"
+#include "server/server_protocol.h"
+#include "service/chat_service.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @brief Load test of ChatServer: many client connections sending and fetching at once.
+ * @details Usage: chat_server_load_bench [connections] [requests per connection].
+ * Users and chats are created through ChatService, then the process forks: the child
+ * serves a Unix socket, the parent opens all connections, logs every one in as its own
+ * session and keeps one request per connection in flight, alternating Send and Fetch of
+ * the last window. Request rate, latency percentiles and failed requests are printed.
+ * The two processes split the descriptors, so 10000 connections need a limit of about
+ * 10000 open files each. The chat system is kept in memory (no mutation log).
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const std::size_t FETCH_COUNT = 20; ///< Window size of the Fetch requests.
+
+/**
+ * @brief One client connection.
+ */
+struct Client {
+  int _socket = -1;         ///< Connected socket.
+  std::string _input;       ///< Received bytes of an incomplete response.
+  std::size_t _chatId = 0;  ///< Chat the client writes to and reads.
+  std::size_t _done = 0;    ///< Answered requests.
+  Clock::time_point _sent;  ///< Time the request in flight was sent.
+};
+
+/**
+ * @brief Sends the next request of a client.
+ * @return False if the socket did not take the whole request.
+ */
+bool sendRequest(Client &client, std::size_t index, std::string &buffer) {
+  std::string text = "Нагрузка " + std::to_string(index) + ":" + std::to_string(client._done);
+  Request request;
+  request._chatId = client._chatId;
+  if (client._done % 2 == 0) {
+    request._type = RequestType::Send;
+    request._text = text;
+  } else {
+    request._type = RequestType::Fetch;
+    request._first = SIZE_MAX;
+    request._count = FETCH_COUNT;
+  }
+
+  buffer.clear();
+  encodeRequest(buffer, request);
+
+  client._sent = Clock::now();
+  // один запрос в полете: буфер сокета пуст, короткий кадр уходит целиком
+  return ::send(client._socket, buffer.data(), buffer.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(buffer.size());
+}
+
+/**
+ * @brief Connects to the Unix socket of the server.
+ * @return The socket, -1 on an error.
+ */
+int connectClient(const std::string &path) {
+  int client = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (client < 0)
+    return -1;
+
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  // блокирующее подключение: при полной очереди ждем, пока сервер примет прежних
+  if (::connect(client, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0) {
+    ::close(client);
+    return -1;
+  }
+  return client;
+}
+
+/**
+ * @brief Reads the responses of all clients until each got the given number of answers.
+ * @param onResponse Called with the client and the status of every response; returns false when the client is done.
+ * @return False on a socket or framing error.
+ */
+template <typename Function>
+bool pumpResponses(int epoll, std::vector<Client> &clients, std::size_t activeClients, Function onResponse) {
+  std::vector<epoll_event> events(1024);
+  std::vector<char> readBuffer(64 << 10);
+  Response response;
+  while (activeClients > 0) {
+    int count = ::epoll_wait(epoll, events.data(), static_cast<int>(events.size()), 10000);
+    if (count <= 0) {
+      if (count < 0 && errno == EINTR)
+        continue;
+      std::fprintf(stderr, "no responses, %zu clients waiting\n", activeClients);
+      return false;
+    }
+
+    for (int i = 0; i < count; ++i) {
+      auto &client = clients[events[i].data.u64];
+      while (true) {
+        ssize_t received = ::recv(client._socket, readBuffer.data(), readBuffer.size(), 0);
+        if (received > 0) {
+          client._input.append(readBuffer.data(), static_cast<std::size_t>(received));
+          continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+          break;
+        if (received < 0 && errno == EINTR)
+          continue;
+        std::fprintf(stderr, "connection closed by the server\n");
+        return false;
+      }
+
+      std::string_view body;
+      std::size_t frameSize = 0;
+      std::size_t consumed = 0;
+      FrameStatus frameStatus;
+      while ((frameStatus = extractFrame(std::string_view(client._input).substr(consumed), body, frameSize)) ==
+             FrameStatus::Complete) {
+        consumed += frameSize;
+        if (!decodeResponse(body, response)) {
+          std::fprintf(stderr, "malformed response\n");
+          return false;
+        }
+        // сообщения собеседника приходят между ответами; их доставку меряет push_delivery_bench
+        if (response._type == RequestType::Push)
+          continue;
+        if (!onResponse(events[i].data.u64, response._status))
+          --activeClients;
+      }
+      if (frameStatus == FrameStatus::Malformed) {
+        std::fprintf(stderr, "malformed frame\n");
+        return false;
+      }
+      client._input.erase(0, consumed);
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Gets a percentile of sorted latencies in microseconds.
+ */
+double percentile(const std::vector<double> &sorted, double fraction) {
+  if (sorted.empty())
+    return 0;
+  return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(fraction * sorted.size()))];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t connectionCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000;
+  std::size_t requestsPerConnection = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 50;
+  if (connectionCount == 0 || requestsPerConnection == 0) {
+    std::fprintf(stderr, "usage: chat_server_load_bench [connections] [requests per connection]\n");
+    return 2;
+  }
+
+  // каждому процессу нужен дескриптор на соединение
+  rlimit limit{};
+  ::getrlimit(RLIMIT_NOFILE, &limit);
+  limit.rlim_cur = limit.rlim_max;
+  ::setrlimit(RLIMIT_NOFILE, &limit);
+  if (limit.rlim_cur < connectionCount + 64) {
+    std::fprintf(stderr, "open file limit %llu is too low for %zu connections\n",
+                 static_cast<unsigned long long>(limit.rlim_cur), connectionCount);
+    return 2;
+  }
+
+  // пользователь i и i + 1 ведут чат i; соединение k входит пользователем k и пишет в его чат
+  ChatSystem chatSystem;
+  ChatService chatService(chatSystem);
+  std::size_t userCount = std::max<std::size_t>(2, std::min<std::size_t>(connectionCount, 2000));
+  std::vector<UserId> users(userCount);
+  std::vector<SessionId> sessions(userCount);
+  std::vector<std::size_t> chats(userCount);
+  std::size_t failures = 0;
+  for (std::size_t i = 0; i < userCount; ++i) {
+    std::string login = "load" + std::to_string(i);
+    failures += chatService.registerUser(login, "Pass1x", "Load", users[i]) != ServiceStatus::Ok;
+    failures += chatService.login(login, "Pass1x", sessions[i]) != ServiceStatus::Ok;
+  }
+  for (std::size_t i = 0; i < userCount; ++i) {
+    failures += chatService.createChat(sessions[i], {users[(i + 1) % userCount]}, chats[i]) != ServiceStatus::Ok;
+    chatService.logout(sessions[i]);
+  }
+
+  std::string path = "/tmp/chat_server_load_bench." + std::to_string(::getpid()) + ".sock";
+  ChatServer chatServer(chatSystem);
+  chatServer.listenUnix(path);
+
+  pid_t server = ::fork();
+  if (server < 0) {
+    std::perror("fork");
+    return 1;
+  }
+  if (server == 0) {
+    chatServer.run();
+    ::_exit(0);
+  }
+
+  int epoll = ::epoll_create1(EPOLL_CLOEXEC);
+  std::vector<Client> clients(connectionCount);
+  std::string buffer;
+
+  auto start = Clock::now();
+  for (std::size_t k = 0; k < connectionCount; ++k) {
+    auto &client = clients[k];
+    client._socket = connectClient(path);
+    if (client._socket < 0) {
+      std::fprintf(stderr, "connect %zu: %s\n", k, std::strerror(errno));
+      ::kill(server, SIGKILL);
+      return 1;
+    }
+    client._chatId = chats[k % userCount];
+
+    std::string login = "load" + std::to_string(k % userCount);
+    Request request;
+    request._type = RequestType::Login;
+    request._login = login;
+    request._password = "Pass1x";
+    buffer.clear();
+    encodeRequest(buffer, request);
+    ::send(client._socket, buffer.data(), buffer.size(), MSG_NOSIGNAL);
+
+    ::fcntl(client._socket, F_SETFL, ::fcntl(client._socket, F_GETFL) | O_NONBLOCK);
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLET;
+    event.data.u64 = k;
+    ::epoll_ctl(epoll, EPOLL_CTL_ADD, client._socket, &event);
+  }
+
+  bool connected = pumpResponses(epoll, clients, connectionCount, [&](std::size_t, ServiceStatus status) {
+    failures += status != ServiceStatus::Ok;
+    return false;
+  });
+  double loginSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+  std::printf("connect+login %zu connections: %.3f s (%.0f logins/s)\n", connectionCount, loginSeconds,
+              connectionCount / loginSeconds);
+
+  std::vector<double> latencies;
+  latencies.reserve(connectionCount * requestsPerConnection);
+  start = Clock::now();
+  bool sent = true;
+  for (std::size_t k = 0; k < connectionCount && connected; ++k)
+    sent &= sendRequest(clients[k], k, buffer);
+
+  bool answered = connected && sent && pumpResponses(epoll, clients, connectionCount, [&](std::size_t k, ServiceStatus status) {
+    auto &client = clients[k];
+    latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - client._sent).count());
+    failures += status != ServiceStatus::Ok;
+    if (++client._done == requestsPerConnection)
+      return false;
+    failures += !sendRequest(client, k, buffer);
+    return true;
+  });
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::sort(latencies.begin(), latencies.end());
+  std::printf("requests %zu (send/fetch): %.0f req/s, latency p50 %.0f us, p99 %.0f us, max %.0f us\n",
+              latencies.size(), latencies.size() / seconds, percentile(latencies, 0.5), percentile(latencies, 0.99),
+              latencies.empty() ? 0.0 : latencies.back());
+
+  for (auto &client : clients)
+    if (client._socket >= 0)
+      ::close(client._socket);
+  ::close(epoll);
+  ::kill(server, SIGKILL);
+  ::waitpid(server, nullptr, 0);
+
+  std::printf("failures %zu\n", failures + !answered);
+  return failures || !answered ? 1 : 0;
+}
@@ -0,0 +1,110 @@
+#include "ChatBot/chat_system.h"
+#include "service/chat_service.h"
+#include "user/user_inbox.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Drives ChatService without the console: register, log in, create chats, send, read, mark read, list.
+ * @details Usage: chat_service_bench [users] [messages]. The chat system is kept in memory
+ * (no mutation log), so the numbers show the cost of the operations themselves.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Prints the rate of one operation and checks that all calls succeeded.
+ */
+void report(const char *title, Clock::time_point start, std::size_t operations, std::size_t failures) {
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  std::printf("%-14s %9zu ops %9.0f ops/s %7.2f us/op%s\n", title, operations, operations / seconds,
+              seconds * 1e6 / operations, failures ? " FAILURES" : "");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t userCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000;
+  std::size_t messageCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+
+  ChatSystem chatSystem;
+  ChatService chatService(chatSystem);
+  std::size_t failures = 0;
+
+  std::vector<UserId> users(userCount);
+  auto start = Clock::now();
+  for (std::size_t i = 0; i < userCount; ++i)
+    failures += chatService.registerUser("user" + std::to_string(i), "Pass" + std::to_string(i % 10) + "x",
+                                         "Name" + std::to_string(i % 1000), users[i]) != ServiceStatus::Ok;
+  report("registerUser", start, userCount, failures);
+
+  // каждый пользователь работает в своем сеансе
+  std::vector<SessionId> sessions(userCount);
+  start = Clock::now();
+  for (std::size_t i = 0; i < userCount; ++i)
+    failures += chatService.login("user" + std::to_string(i), "Pass" + std::to_string(i % 10) + "x", sessions[i]) !=
+                ServiceStatus::Ok;
+  report("login", start, userCount, failures);
+
+  // каждый пользователь в чате с четырьмя соседями
+  std::vector<std::size_t> chats;
+  start = Clock::now();
+  for (std::size_t i = 0; i < userCount; ++i) {
+    for (std::size_t step = 1; step <= 2; ++step) {
+      std::size_t chatId;
+      failures += chatService.createChat(sessions[i], {users[(i + step) % userCount]}, chatId) != ServiceStatus::Ok;
+      chats.push_back(chatId);
+    }
+  }
+  report("createChat", start, chats.size(), failures);
+
+  const std::string text = "Привет! Как дела? Встречаемся в 19:00 у входа.";
+  std::size_t messageId;
+  start = Clock::now();
+  for (std::size_t i = 0; i < messageCount; ++i) {
+    std::size_t chat = (i * 7919) % chats.size();
+    SessionId sender = sessions[(chat / 2 + (i & 1) * (chat % 2 + 1)) % userCount];
+    failures += chatService.sendMessage(sender, chats[chat], text, messageId) != ServiceStatus::Ok;
+  }
+  report("sendMessage", start, messageCount, failures);
+
+  ChatWindow window;
+  std::vector<MessageView> messages;
+  std::size_t reads = messageCount / 10;
+  std::size_t checksum = 0;
+  start = Clock::now();
+  for (std::size_t i = 0; i < reads; ++i) {
+    std::size_t chat = (i * 104729) % chats.size();
+    failures += chatService.readChat(sessions[chat / 2], chats[chat], 0, CHAT_WINDOW_SIZE, window, messages) !=
+                ServiceStatus::Ok;
+    checksum += messages.size();
+  }
+  report("readChat(20)", start, reads, failures);
+  window = ChatWindow(); // снимает блокировку последнего прочитанного чата
+
+  start = Clock::now();
+  for (std::size_t i = 0; i < reads; ++i) {
+    std::size_t chat = (i * 104729) % chats.size();
+    failures += chatService.markRead(sessions[chat / 2], chats[chat], i % 2) != ServiceStatus::Ok;
+  }
+  report("markRead", start, reads, failures);
+
+  std::vector<ChatSummary> summaries;
+  bool hasMore;
+  start = Clock::now();
+  for (std::size_t i = 0; i < reads; ++i) {
+    failures += chatService.listChats(sessions[i % userCount], 0, INBOX_PAGE_SIZE, summaries, hasMore) !=
+                ServiceStatus::Ok;
+    checksum += summaries.size();
+  }
+  report("listChats", start, reads, failures);
+
+  std::printf("checksum %zu\n", checksum);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,248 @@
+#include "ChatBot/chat_system.h"
+#include "chat/chat.h"
+#include "service/chat_service.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Drives ChatService from several threads at once and checks the result.
+ * @details Usage: chat_system_stress_bench [max threads] [chats per thread] [messages per thread].
+ * For 1, 2, 4 ... max threads each thread registers and logs in its own users, creates chats and then
+ * sends messages only to them, so the send rate shows how the core scales across
+ * independent chats. The mixed run lets all threads read windows and send to random
+ * chats of one shared set. After every run each chat is checked: the number of messages
+ * matches the successful sends, message IDs increase inside a chat and no ID is used twice.
+ * The chat system is kept in memory (no mutation log).
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Chats and users created by one thread.
+ */
+struct ThreadChats {
+  std::vector<UserId> _users;       ///< User i and user i + 1 share chat i.
+  std::vector<SessionId> _sessions; ///< Session of each user.
+  std::vector<std::size_t> _chats;  ///< Chat IDs.
+  std::size_t _failures = 0;        ///< Calls that did not return Ok.
+};
+
+/**
+ * @brief xorshift64: cheap per-thread random numbers.
+ */
+std::uint64_t nextRandom(std::uint64_t &state) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+/**
+ * @brief Runs a function in several threads, each getting its number; returns the wall time.
+ */
+template <typename Function> double runThreads(std::size_t threadCount, Function function) {
+  std::atomic<std::size_t> ready{0};
+  std::atomic<bool> go{false};
+  std::vector<std::thread> threads;
+  threads.reserve(threadCount);
+  for (std::size_t thread = 0; thread < threadCount; ++thread)
+    threads.emplace_back([&, thread] {
+      ready.fetch_add(1);
+      while (!go.load(std::memory_order_acquire))
+        std::this_thread::yield();
+      function(thread);
+    });
+
+  // время считается с момента, когда все потоки запущены
+  while (ready.load() != threadCount)
+    std::this_thread::yield();
+  auto start = Clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto &thread : threads)
+    thread.join();
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Registers and logs in the users of a thread and creates its chats concurrently with the other threads.
+ */
+void createThreadChats(ChatService &chatService, const std::string &prefix, std::size_t chatCount,
+                       ThreadChats &threadChats) {
+  threadChats._users.resize(chatCount + 1);
+  threadChats._sessions.resize(chatCount + 1);
+  for (std::size_t i = 0; i <= chatCount; ++i) {
+    threadChats._failures += chatService.registerUser(prefix + std::to_string(i), "Pass1x", "Name" + std::to_string(i),
+                                                      threadChats._users[i]) != ServiceStatus::Ok;
+    threadChats._failures +=
+        chatService.login(prefix + std::to_string(i), "Pass1x", threadChats._sessions[i]) != ServiceStatus::Ok;
+  }
+
+  for (std::size_t i = 0; i < chatCount; ++i) {
+    std::size_t chatId = 0;
+    threadChats._failures +=
+        chatService.createChat(threadChats._sessions[i], {threadChats._users[i + 1]}, chatId) != ServiceStatus::Ok;
+    threadChats._chats.push_back(chatId);
+  }
+}
+
+/**
+ * @brief Checks the messages of the chats against the expected counts.
+ * @return Number of violations.
+ */
+std::size_t verifyChats(const ChatSystem &chatSystem, const std::vector<std::size_t> &chatIds,
+                        const std::vector<std::size_t> &expectedCounts) {
+  std::size_t violations = 0;
+  std::vector<std::size_t> messageIds;
+  for (std::size_t i = 0; i < chatIds.size(); ++i) {
+    auto chat_ptr = chatSystem.getChatById(chatIds[i]);
+    if (!chat_ptr) {
+      ++violations;
+      continue;
+    }
+
+    const auto &messages = chat_ptr->getMessages();
+    violations += messages.size() != expectedCounts[i];
+    std::size_t previousId = 0;
+    for (const auto &message : messages) {
+      violations += message.getMessageId() <= previousId;
+      previousId = message.getMessageId();
+      messageIds.push_back(previousId);
+    }
+  }
+
+  std::sort(messageIds.begin(), messageIds.end());
+  violations += std::adjacent_find(messageIds.begin(), messageIds.end()) != messageIds.end();
+  return violations;
+}
+
+/**
+ * @brief Sends messages from each thread to its own chats.
+ * @return Send rate, messages per second.
+ */
+double runIndependent(std::size_t threadCount, std::size_t chatsPerThread, std::size_t messagesPerThread,
+                      std::size_t &violations) {
+  ChatSystem chatSystem;
+  ChatService chatService(chatSystem);
+  std::vector<ThreadChats> threadChats(threadCount);
+  runThreads(threadCount, [&](std::size_t thread) {
+    createThreadChats(chatService, "user" + std::to_string(thread) + "x", chatsPerThread, threadChats[thread]);
+  });
+
+  const std::string text = "Привет! Как дела? Встречаемся в 19:00 у входа.";
+  double seconds = runThreads(threadCount, [&](std::size_t thread) {
+    auto &own = threadChats[thread];
+    std::size_t messageId;
+    for (std::size_t i = 0; i < messagesPerThread; ++i) {
+      std::size_t chat = i % own._chats.size();
+      SessionId sender = own._sessions[chat + (i / own._chats.size()) % 2];
+      own._failures += chatService.sendMessage(sender, own._chats[chat], text, messageId) != ServiceStatus::Ok;
+    }
+  });
+
+  std::vector<std::size_t> chatIds;
+  std::vector<std::size_t> expectedCounts;
+  for (const auto &own : threadChats) {
+    violations += own._failures;
+    for (std::size_t chat = 0; chat < own._chats.size(); ++chat) {
+      chatIds.push_back(own._chats[chat]);
+      expectedCounts.push_back(messagesPerThread / own._chats.size() + (chat < messagesPerThread % own._chats.size()));
+    }
+  }
+  violations += verifyChats(chatSystem, chatIds, expectedCounts);
+  return threadCount * messagesPerThread / seconds;
+}
+
+/**
+ * @brief Reads windows and sends messages from all threads to random chats of a shared set.
+ * @return Operation rate, operations per second.
+ */
+double runMixed(std::size_t threadCount, std::size_t chatsPerThread, std::size_t operationsPerThread,
+                std::size_t &violations) {
+  ChatSystem chatSystem;
+  ChatService chatService(chatSystem);
+  ThreadChats shared;
+  createThreadChats(chatService, "mixed", chatsPerThread * threadCount, shared);
+
+  std::unique_ptr<std::atomic<std::size_t>[]> sent(new std::atomic<std::size_t>[shared._chats.size()]);
+  for (std::size_t chat = 0; chat < shared._chats.size(); ++chat)
+    sent[chat].store(0);
+
+  const std::string text = "Проверка связи";
+  std::atomic<std::size_t> failures{0};
+  double seconds = runThreads(threadCount, [&](std::size_t thread) {
+    std::uint64_t random = 0x9E3779B97F4A7C15ull * (thread + 1);
+    ChatWindow window;
+    std::vector<MessageView> messages;
+    std::size_t messageId;
+    std::size_t threadFailures = 0;
+    for (std::size_t i = 0; i < operationsPerThread; ++i) {
+      std::uint64_t value = nextRandom(random);
+      std::size_t chat = value % shared._chats.size();
+      SessionId user = shared._sessions[chat + (value >> 32) % 2];
+
+      // девять чтений на одну запись
+      if ((value >> 40) % 10 != 0) {
+        threadFailures += chatService.readChat(user, shared._chats[chat], SIZE_MAX, CHAT_WINDOW_SIZE, window,
+                                               messages) != ServiceStatus::Ok;
+        continue;
+      }
+      window = ChatWindow();
+      if (chatService.sendMessage(user, shared._chats[chat], text, messageId) == ServiceStatus::Ok)
+        sent[chat].fetch_add(1, std::memory_order_relaxed);
+      else
+        ++threadFailures;
+    }
+    failures += threadFailures;
+  });
+
+  std::vector<std::size_t> expectedCounts(shared._chats.size());
+  for (std::size_t chat = 0; chat < shared._chats.size(); ++chat)
+    expectedCounts[chat] = sent[chat].load();
+  violations += shared._failures + failures.load() + verifyChats(chatSystem, shared._chats, expectedCounts);
+  return threadCount * operationsPerThread / seconds;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  if (argc > 1)
+    maxThreads = std::strtoull(argv[1], nullptr, 10);
+  std::size_t chatsPerThread = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 256;
+  std::size_t messagesPerThread = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 200000;
+  if (maxThreads == 0 || chatsPerThread == 0) {
+    std::fprintf(stderr, "usage: chat_system_stress_bench [max threads] [chats per thread] [messages per thread]\n");
+    return 2;
+  }
+
+  std::printf("cores %u, %zu chats and %zu messages per thread\n", std::thread::hardware_concurrency(),
+              chatsPerThread, messagesPerThread);
+
+  std::size_t violations = 0;
+  double singleRate = 0;
+  for (std::size_t threadCount = 1;; threadCount = std::min(threadCount * 2, maxThreads)) {
+    double rate = runIndependent(threadCount, chatsPerThread, messagesPerThread, violations);
+    if (threadCount == 1)
+      singleRate = rate;
+    std::printf("send   %3zu threads %11.0f msg/s  x%.2f\n", threadCount, rate, rate / singleRate);
+    if (threadCount == maxThreads)
+      break;
+  }
+
+  double rate = runMixed(maxThreads, chatsPerThread, messagesPerThread, violations);
+  std::printf("mixed  %3zu threads %11.0f op/s   (90%% readChat, 10%% sendMessage)\n", maxThreads, rate);
+
+  std::printf("violations %zu\n", violations);
+  return violations ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+#include "message/message.h"
+#include "message/message_content.h"
+#include "message/message_content_struct.h"
+#include "message/message_store.h"
+#include "system/date_time_utils.h"
+#include "user/user.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Compares the old per-message heap layout of Chat with MessageStore.
+ * @details Usage: message_store_bench [message count]. Reports build time, the time of a
+ * full scan (what printChat does minus the terminal output) and the heap bytes held.
+ */
+
+namespace {
+
+const std::size_t SIZE_PREFIX = alignof(std::max_align_t); ///< Room for the block size before each block.
+
+std::size_t g_allocatedBytes = 0; ///< Heap bytes currently held.
+std::size_t g_allocations = 0;    ///< Number of heap allocations since the last reset.
+
+} // namespace
+
+// размер блока хранится перед ним, чтобы считать удерживаемую память, а не запрошенную
+void *operator new(std::size_t size) {
+  auto *block = static_cast<char *>(std::malloc(size + SIZE_PREFIX));
+  if (!block)
+    throw std::bad_alloc();
+  *reinterpret_cast<std::size_t *>(block) = size;
+  g_allocatedBytes += size;
+  ++g_allocations;
+  return block + SIZE_PREFIX;
+}
+
+void operator delete(void *ptr) noexcept {
+  if (!ptr)
+    return;
+  auto *block = static_cast<char *>(ptr) - SIZE_PREFIX;
+  g_allocatedBytes -= *reinterpret_cast<std::size_t *>(block);
+  std::free(block);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept { operator delete(ptr); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Milliseconds elapsed since start.
+ */
+double elapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Deterministic message text of varying length.
+ */
+std::string makeText(std::size_t index) {
+  std::string text = "Сообщение номер " + std::to_string(index);
+  text.append(index % 64, 'x');
+  return text;
+}
+
+/**
+ * @brief Prints one result row.
+ */
+void report(const char *name, double buildMs, double scanMs, std::size_t bytes, std::size_t allocations,
+            std::size_t count, std::size_t checksum) {
+  std::printf("%-22s build %8.2f ms  scan %7.3f ms  heap %10zu B  (%6.1f B/msg, %zu allocs)  checksum %zu\n", name,
+              buildMs, scanMs, bytes, static_cast<double>(bytes) / count, allocations, checksum);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+  auto sender = std::make_shared<User>(UserData("bench", "Bench", "hash", "bench@mail", "+000"));
+  const TimeStamp timeStamp = makeTimeStamp(2025, 1, 1, 12, 0, 0);
+
+  std::vector<std::string> texts;
+  texts.reserve(count);
+  for (std::size_t i = 0; i < count; ++i)
+    texts.push_back(makeText(i));
+
+  // старая схема: shared_ptr<Message> с собственным вектором содержимого
+  {
+    std::size_t baseBytes = g_allocatedBytes;
+    g_allocations = 0;
+    auto start = Clock::now();
+    std::vector<std::shared_ptr<Message>> messages;
+    for (std::size_t i = 0; i < count; ++i) {
+      std::vector<MessageContent> content;
+      content.emplace_back(TextContent(texts[i]));
+      messages.push_back(std::make_shared<Message>(std::move(content), sender->getUserId(), timeStamp, i + 1));
+    }
+    double buildMs = elapsedMs(start);
+    std::size_t bytes = g_allocatedBytes - baseBytes;
+    std::size_t allocations = g_allocations;
+
+    start = Clock::now();
+    std::size_t checksum = 0;
+    for (const auto &message : messages) {
+      checksum += message->getMessagetId() + static_cast<std::size_t>(message->getTimeStamp() % 1000);
+      for (const auto &part : message->getContent())
+        checksum += getContentValue(part).size();
+    }
+    report("vector<shared_ptr>", buildMs, elapsedMs(start), bytes, allocations, count, checksum);
+  }
+
+  // новая схема: заголовки блоками, текст в арене
+  {
+    std::size_t baseBytes = g_allocatedBytes;
+    g_allocations = 0;
+    auto start = Clock::now();
+    MessageStore store;
+    for (std::size_t i = 0; i < count; ++i) {
+      MessagePart part{ContentKind::Text, texts[i]};
+      store.append(i + 1, sender->getUserId(), timeStamp, &part, 1);
+    }
+    double buildMs = elapsedMs(start);
+    std::size_t bytes = g_allocatedBytes - baseBytes;
+    std::size_t allocations = g_allocations;
+
+    start = Clock::now();
+    std::size_t checksum = 0;
+    for (const auto &message : store) {
+      checksum += message.getMessageId() + static_cast<std::size_t>(message.getTimeStamp() % 1000);
+      for (std::size_t p = 0; p < message.getPartCount(); ++p)
+        checksum += message.getPart(p)._value.size();
+    }
+    report("MessageStore", buildMs, elapsedMs(start), bytes, allocations, count, checksum);
+  }
+  return 0;
+}
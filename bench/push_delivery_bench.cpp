@@ -0,0 +1,390 @@
+#include "ChatBot/chat_system.h"
+#include "server/chat_server.h"
+#include "server/server_protocol.h"
+#include "service/chat_service.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @brief Delivery latency of Push frames of ChatServer under a steady message rate.
+ * @details Usage: push_delivery_bench [chats] [messages per second] [seconds].
+ * Every chat has a sender and a receiver user, each with its own connection; the server
+ * runs in a forked child on a Unix socket. The parent sends messages round robin over
+ * the senders at the given rate without waiting for the answers; the text carries the
+ * send time. Receivers take the Push frames, and the latency of every pushed message is
+ * the time from its send to the decoding of its frame. Notices (ranges too long to push)
+ * and resyncs are counted; the run checks that every receiver saw every message of its
+ * chat, either pushed or announced by a notice. The chat system is kept in memory.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief One client connection.
+ */
+struct Client {
+  int _socket = -1;         ///< Connected socket.
+  std::string _input;       ///< Received bytes of an incomplete frame.
+  std::string _output;      ///< Requests the socket did not take yet.
+  std::size_t _chatId = 0;  ///< Chat of the client.
+  bool _isReceiver = false; ///< Receives the messages of the sender of its chat.
+  std::size_t _seen = 0;    ///< Receiver: messages of the chat pushed or announced.
+};
+
+/**
+ * @brief Totals of the run.
+ */
+struct Counters {
+  std::size_t _answers = 0;       ///< Answers to Send.
+  std::size_t _failures = 0;      ///< Answers other than Ok, malformed frames.
+  std::size_t _pushed = 0;        ///< Messages received in Push frames by receivers.
+  std::size_t _notices = 0;       ///< Push frames without messages.
+  std::size_t _resyncs = 0;       ///< Push frames of dropped deliveries.
+  std::vector<double> _latencies; ///< Latency of every pushed message, microseconds.
+};
+
+/**
+ * @brief Connects to the Unix socket of the server.
+ * @return The socket, -1 on an error.
+ */
+int connectClient(const std::string &path) {
+  int client = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (client < 0)
+    return -1;
+
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  if (::connect(client, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0) {
+    ::close(client);
+    return -1;
+  }
+  return client;
+}
+
+/**
+ * @brief Sends what the socket of a client takes.
+ * @return False on a socket error.
+ */
+bool flushClient(Client &client) {
+  std::size_t sent = 0;
+  while (sent < client._output.size()) {
+    ssize_t written = ::send(client._socket, client._output.data() + sent, client._output.size() - sent, MSG_NOSIGNAL);
+    if (written > 0) {
+      sent += static_cast<std::size_t>(written);
+      continue;
+    }
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    return false;
+  }
+  client._output.erase(0, sent);
+  return true;
+}
+
+/**
+ * @brief Gets the send time written into a message text, nanoseconds of Clock.
+ */
+long long parseSendTime(std::string_view text) {
+  long long value = 0;
+  for (char symbol : text) {
+    if (symbol < '0' || symbol > '9')
+      break;
+    value = value * 10 + (symbol - '0');
+  }
+  return value;
+}
+
+/**
+ * @brief Reads a client and accounts its frames.
+ * @return False on a socket or framing error.
+ */
+bool readClient(Client &client, std::vector<char> &readBuffer, Response &response, Counters &counters) {
+  while (true) {
+    ssize_t received = ::recv(client._socket, readBuffer.data(), readBuffer.size(), 0);
+    if (received > 0) {
+      client._input.append(readBuffer.data(), static_cast<std::size_t>(received));
+      continue;
+    }
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    if (received < 0 && errno == EINTR)
+      continue;
+    std::fprintf(stderr, "connection closed by the server\n");
+    return false;
+  }
+
+  std::string_view body;
+  std::size_t frameSize = 0;
+  std::size_t consumed = 0;
+  FrameStatus frameStatus;
+  while ((frameStatus = extractFrame(std::string_view(client._input).substr(consumed), body, frameSize)) ==
+         FrameStatus::Complete) {
+    consumed += frameSize;
+    if (!decodeResponse(body, response)) {
+      std::fprintf(stderr, "malformed response\n");
+      return false;
+    }
+    if (response._type != RequestType::Push) {
+      ++counters._answers;
+      counters._failures += response._status != ServiceStatus::Ok;
+      continue;
+    }
+    // отправитель тоже получает свои сообщения - учитываются только получатели
+    if (!client._isReceiver)
+      continue;
+    if (response._id == 0) {
+      ++counters._resyncs;
+      continue;
+    }
+
+    if (response._messages.empty()) {
+      ++counters._notices;
+      client._seen = std::max(client._seen, response._messageCount);
+      continue;
+    }
+    long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    for (const auto &message : response._messages) {
+      long long sendTime = parseSendTime(response._parts[message._firstPart]._value);
+      counters._latencies.push_back(static_cast<double>(now - sendTime) / 1000.0);
+    }
+    counters._pushed += response._messages.size();
+    client._seen = std::max(client._seen, response._first + response._messages.size());
+  }
+  if (frameStatus == FrameStatus::Malformed) {
+    std::fprintf(stderr, "malformed frame\n");
+    return false;
+  }
+  client._input.erase(0, consumed);
+  return true;
+}
+
+/**
+ * @brief Gets the processor time of a process from /proc, seconds.
+ */
+double processCpuSeconds(pid_t process) {
+  std::string path = "/proc/" + std::to_string(process) + "/stat";
+  std::FILE *file = std::fopen(path.c_str(), "r");
+  if (!file)
+    return 0;
+  char line[1024] = {};
+  std::size_t length = std::fread(line, 1, sizeof(line) - 1, file);
+  std::fclose(file);
+
+  // после имени процесса в скобках: поля 3..13, затем utime и stime в тиках
+  const char *fields = std::strrchr(line, ')');
+  unsigned long long userTicks = 0;
+  unsigned long long systemTicks = 0;
+  if (length == 0 || !fields ||
+      std::sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &userTicks, &systemTicks) != 2)
+    return 0;
+  return static_cast<double>(userTicks + systemTicks) / static_cast<double>(::sysconf(_SC_CLK_TCK));
+}
+
+/**
+ * @brief Gets a percentile of sorted latencies in microseconds.
+ */
+double percentile(const std::vector<double> &sorted, double fraction) {
+  if (sorted.empty())
+    return 0;
+  return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(fraction * sorted.size()))];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t chatCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+  double rate = argc > 2 ? std::strtod(argv[2], nullptr) : 100000;
+  double duration = argc > 3 ? std::strtod(argv[3], nullptr) : 2;
+  if (chatCount == 0 || rate <= 0 || duration <= 0) {
+    std::fprintf(stderr, "usage: push_delivery_bench [chats] [messages per second] [seconds]\n");
+    return 2;
+  }
+
+  rlimit limit{};
+  ::getrlimit(RLIMIT_NOFILE, &limit);
+  limit.rlim_cur = limit.rlim_max;
+  ::setrlimit(RLIMIT_NOFILE, &limit);
+  if (limit.rlim_cur < 2 * chatCount + 64) {
+    std::fprintf(stderr, "open file limit %llu is too low for %zu chats\n",
+                 static_cast<unsigned long long>(limit.rlim_cur), chatCount);
+    return 2;
+  }
+
+  // в чате i пишет send<i>, читает recv<i>
+  ChatSystem chatSystem;
+  ChatService chatService(chatSystem);
+  std::vector<std::size_t> chats(chatCount);
+  std::size_t setupFailures = 0;
+  for (std::size_t i = 0; i < chatCount; ++i) {
+    UserId sender;
+    UserId receiver;
+    SessionId session;
+    setupFailures += chatService.registerUser("send" + std::to_string(i), "Pass1x", "Send", sender) != ServiceStatus::Ok;
+    setupFailures += chatService.registerUser("recv" + std::to_string(i), "Pass1x", "Recv", receiver) != ServiceStatus::Ok;
+    setupFailures += chatService.login("send" + std::to_string(i), "Pass1x", session) != ServiceStatus::Ok;
+    setupFailures += chatService.createChat(session, {receiver}, chats[i]) != ServiceStatus::Ok;
+    chatService.logout(session);
+  }
+
+  std::string path = "/tmp/push_delivery_bench." + std::to_string(::getpid()) + ".sock";
+  ChatServer chatServer(chatSystem);
+  chatServer.listenUnix(path);
+
+  pid_t server = ::fork();
+  if (server < 0) {
+    std::perror("fork");
+    return 1;
+  }
+  if (server == 0) {
+    chatServer.run();
+    ::_exit(0);
+  }
+
+  // соединения 0..chatCount-1 - отправители, дальше - получатели
+  int epoll = ::epoll_create1(EPOLL_CLOEXEC);
+  std::vector<Client> clients(2 * chatCount);
+  std::string buffer;
+  for (std::size_t k = 0; k < clients.size(); ++k) {
+    auto &client = clients[k];
+    client._socket = connectClient(path);
+    if (client._socket < 0) {
+      std::fprintf(stderr, "connect %zu: %s\n", k, std::strerror(errno));
+      ::kill(server, SIGKILL);
+      return 1;
+    }
+    client._chatId = chats[k % chatCount];
+    client._isReceiver = k >= chatCount;
+
+    std::string login = (client._isReceiver ? "recv" : "send") + std::to_string(k % chatCount);
+    Request request;
+    request._type = RequestType::Login;
+    request._login = login;
+    request._password = "Pass1x";
+    encodeRequest(client._output, request);
+    flushClient(client);
+
+    ::fcntl(client._socket, F_SETFL, ::fcntl(client._socket, F_GETFL) | O_NONBLOCK);
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+    event.data.u64 = k;
+    ::epoll_ctl(epoll, EPOLL_CTL_ADD, client._socket, &event);
+  }
+
+  Counters counters;
+  std::size_t total = static_cast<std::size_t>(rate * duration);
+  counters._latencies.reserve(total);
+  std::vector<epoll_event> events(1024);
+  std::vector<char> readBuffer(64 << 10);
+  Response response;
+  bool healthy = true;
+
+  // входы: ответ каждого соединения, пока не пришли все, сообщения не отправляются
+  while (healthy && counters._answers < clients.size()) {
+    int count = ::epoll_wait(epoll, events.data(), static_cast<int>(events.size()), 10000);
+    healthy = count > 0;
+    for (int i = 0; i < count && healthy; ++i)
+      healthy = readClient(clients[events[i].data.u64], readBuffer, response, counters);
+  }
+  setupFailures += counters._failures;
+  counters._answers = 0;
+  counters._failures = 0;
+
+  std::size_t sent = 0;
+  std::size_t expected = 0;
+  double serverCpu = processCpuSeconds(server);
+  double clientCpu = processCpuSeconds(::getpid());
+  auto start = Clock::now();
+  auto lastProgress = start;
+  while (healthy) {
+    auto now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - start).count();
+
+    // отправка по расписанию: все сообщения, чей срок наступил
+    std::size_t due = std::min(total, static_cast<std::size_t>(elapsed * rate));
+    for (; sent < due; ++sent) {
+      auto &client = clients[sent % chatCount];
+      std::string text = std::to_string(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+      Request request;
+      request._type = RequestType::Send;
+      request._chatId = client._chatId;
+      request._text = text;
+      encodeRequest(client._output, request);
+      healthy &= flushClient(client);
+    }
+
+    // прочитано все: каждый получатель видел все сообщения своего чата
+    std::size_t seen = 0;
+    for (std::size_t k = chatCount; k < clients.size(); ++k)
+      seen += clients[k]._seen;
+    if (seen != expected) {
+      expected = seen;
+      lastProgress = now;
+    }
+    if (sent == total && seen == total && counters._answers == total)
+      break;
+    if (now - lastProgress > std::chrono::seconds(10)) {
+      std::fprintf(stderr, "stalled: %zu of %zu messages seen\n", seen, total);
+      healthy = false;
+      break;
+    }
+
+    // ожидание до следующей миллисекунды расписания: опрос в цикле отнял бы процессор у сервера
+    int count = ::epoll_wait(epoll, events.data(), static_cast<int>(events.size()), sent < total ? 1 : 10);
+    if (count < 0 && errno != EINTR)
+      healthy = false;
+    for (int i = 0; i < count && healthy; ++i) {
+      auto &client = clients[events[i].data.u64];
+      if (events[i].events & EPOLLOUT)
+        healthy = flushClient(client);
+      if (healthy && (events[i].events & EPOLLIN))
+        healthy = readClient(client, readBuffer, response, counters);
+    }
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  serverCpu = processCpuSeconds(server) - serverCpu;
+  clientCpu = processCpuSeconds(::getpid()) - clientCpu;
+
+  auto &latencies = counters._latencies;
+  std::sort(latencies.begin(), latencies.end());
+  std::printf("sent %zu messages in %zu chats: %.0f msg/s (target %.0f)\n", sent, chatCount, sent / seconds, rate);
+  std::printf("pushed %zu, notices %zu, resyncs %zu, seen %zu of %zu\n", counters._pushed, counters._notices,
+              counters._resyncs, expected, total);
+  std::printf("push latency p50 %.0f us, p99 %.0f us, max %.0f us\n", percentile(latencies, 0.5),
+              percentile(latencies, 0.99), latencies.empty() ? 0.0 : latencies.back());
+  // на одном ядре сервер и клиенты делят процессор: время на сообщение показывает запас
+  std::printf("cpu per message: server %.2f us, clients %.2f us\n", serverCpu * 1e6 / (sent ? sent : 1),
+              clientCpu * 1e6 / (sent ? sent : 1));
+
+  for (auto &client : clients)
+    if (client._socket >= 0)
+      ::close(client._socket);
+  ::close(epoll);
+  ::kill(server, SIGKILL);
+  ::waitpid(server, nullptr, 0);
+
+  std::size_t failures = setupFailures + counters._failures + !healthy;
+  std::printf("failures %zu\n", failures);
+  return failures ? 1 : 0;
+}
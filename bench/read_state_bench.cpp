@@ -0,0 +1,156 @@
+#include "ChatBot/chat_system.h"
+#include "chat/chat.h"
+#include "chat/read_state_table.h"
+#include "user/user.h"
+#include "user/user_table.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Measures Chat::getLastReadMessageIndex in large group chats.
+ * @details Usage: read_state_bench [lookups per group size]. Compares the former
+ * weak_ptr-keyed map (reproduced here) with ReadStateTable, first with all participants
+ * alive, then after half of them were removed from the system.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief The hash that used to key Chat::_lastReadMessageMap: locks the weak_ptr each time.
+ */
+struct WeakPtrHash {
+  std::size_t operator()(const std::weak_ptr<User> &w) const { return std::hash<User *>()(w.lock().get()); }
+};
+
+/**
+ * @brief Owner-based equality of the former map.
+ */
+struct WeakPtrEqual {
+  bool operator()(const std::weak_ptr<User> &a, const std::weak_ptr<User> &b) const {
+    return !a.owner_before(b) && !b.owner_before(a);
+  }
+};
+
+using WeakMap = std::unordered_map<std::weak_ptr<User>, std::size_t, WeakPtrHash, WeakPtrEqual>;
+
+/**
+ * @brief Nanoseconds per operation since start.
+ */
+double nsPerOp(Clock::time_point start, std::size_t ops) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(ops);
+}
+
+/**
+ * @brief Creates a user with a unique login.
+ */
+std::shared_ptr<User> makeUser(std::size_t index) {
+  std::string login = "user" + std::to_string(index);
+  return std::make_shared<User>(UserData(login, login, "hash", "bench@mail", "+000"));
+}
+
+/**
+ * @brief Runs all measurements for one group size.
+ */
+void runGroup(std::size_t participants, std::size_t lookups) {
+  std::vector<std::shared_ptr<User>> users;
+  WeakMap weakMap;
+  std::size_t checksum = 0;
+  double weakNs;
+  double tableNs;
+
+  // все участники живы: Chat поверх ChatSystem, как в программе
+  {
+    ChatSystem chatSystem;
+    auto chat = std::make_shared<Chat>(chatSystem.getUserTable());
+    for (std::size_t i = 0; i < participants; ++i) {
+      users.push_back(makeUser(i));
+      chatSystem.addUser(users.back());
+      chat->addParticipant(users.back());
+      chat->updateLastReadMessageIndex(users.back(), i);
+      weakMap[users.back()] = i;
+    }
+
+    auto start = Clock::now();
+    for (std::size_t n = 0; n < lookups; ++n) {
+      auto it = weakMap.find(users[n % participants]);
+      checksum += it != weakMap.end() ? it->second : 0;
+    }
+    weakNs = nsPerOp(start, lookups);
+
+    start = Clock::now();
+    for (std::size_t n = 0; n < lookups; ++n)
+      checksum += chat->getLastReadMessageIndex(users[n % participants]);
+    tableNs = nsPerOp(start, lookups);
+  }
+
+  // половина участников удаляется из системы, на их место приходят новые
+  UserTable userTable;
+  ReadStateTable readStates(userTable);
+  std::vector<UserId> ids;
+  for (std::size_t i = 0; i < participants; ++i) {
+    ids.push_back(userTable.add(users[i]));
+    readStates.set(ids.back(), i);
+  }
+
+  std::vector<std::shared_ptr<User>> survivors;
+  std::vector<UserId> survivorIds;
+  for (std::size_t i = 0; i < participants; ++i) {
+    if (i % 2 == 0) {
+      userTable.remove(ids[i]);
+    } else {
+      survivors.push_back(users[i]);
+      survivorIds.push_back(ids[i]);
+    }
+  }
+  users.clear();
+
+  for (std::size_t i = 0; i < participants / 2; ++i) {
+    auto user = makeUser(participants + i);
+    survivors.push_back(user);
+    weakMap[user] = i;
+    survivorIds.push_back(userTable.add(user));
+    readStates.set(survivorIds.back(), i);
+  }
+
+  // записи ушедших пользователей уже нельзя найти (их ключ хешируется как nullptr), но они остаются в таблице
+  std::size_t expired = 0;
+  for (const auto &entry : weakMap)
+    expired += entry.first.expired() ? 1 : 0;
+
+  auto start = Clock::now();
+  for (std::size_t n = 0; n < lookups; ++n) {
+    auto it = weakMap.find(survivors[n % survivors.size()]);
+    checksum += it != weakMap.end() ? it->second : 0;
+  }
+  double weakChurnNs = nsPerOp(start, lookups);
+
+  start = Clock::now();
+  for (std::size_t n = 0; n < lookups; ++n) {
+    const std::size_t *lastRead = readStates.find(survivorIds[n % survivorIds.size()]);
+    checksum += lastRead ? *lastRead : 0;
+  }
+  double tableChurnNs = nsPerOp(start, lookups);
+
+  std::printf("%7zu participants | alive: weak_map %7.1f ns, ReadStateTable %5.1f ns | after churn: weak_map %9.1f "
+              "ns (%zu of %zu entries expired), ReadStateTable %5.1f ns (%zu entries) | checksum "
+              "%zu\n",
+              participants, weakNs, tableNs, weakChurnNs, expired, weakMap.size(), tableChurnNs, readStates.size(),
+              checksum);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t lookups = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+  for (std::size_t participants : {16, 256, 4096, 65536})
+    runGroup(participants, lookups);
+  return 0;
+}
@@ -0,0 +1,257 @@
+#include "server/server_protocol.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Round trip and fuzzing of the wire protocol of ChatServer.
+ * @details Usage: server_protocol_bench [frames] [fuzz iterations]. Encodes a mix of
+ * requests of every type and of responses (Send, a page of ListChats, a Fetch window
+ * of 20 messages, a Push of them), then extracts and decodes all frames back, and reports the rate and
+ * the size per frame. Every decoded frame is encoded again and must give the same bytes.
+ * The fuzzer feeds the decoders and extractFrame with damaged frames (flipped bits, cut
+ * or extended bodies, random bytes); a body that is accepted must also encode back to
+ * itself. Build with -fsanitize=address,undefined to check for out-of-bounds reads.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief xorshift64: cheap deterministic random numbers.
+ */
+std::uint64_t nextRandom(std::uint64_t &state) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+/**
+ * @brief Builds one request of each type; the strings live in texts.
+ */
+std::vector<Request> makeRequests(const std::vector<std::string> &texts) {
+  std::vector<Request> requests(8);
+  requests[0]._type = RequestType::Register;
+  requests[0]._login = texts[0];
+  requests[0]._password = texts[1];
+  requests[0]._name = texts[2];
+  requests[1]._type = RequestType::Login;
+  requests[1]._login = texts[0];
+  requests[1]._password = texts[1];
+  requests[2]._type = RequestType::Logout;
+  requests[3]._type = RequestType::CreateChat;
+  requests[3]._participants = {texts[0], texts[2]};
+  requests[4]._type = RequestType::Send;
+  requests[4]._chatId = 123456;
+  requests[4]._text = texts[3];
+  requests[5]._type = RequestType::ListChats;
+  requests[5]._first = 40;
+  requests[5]._count = 20;
+  requests[6]._type = RequestType::Fetch;
+  requests[6]._chatId = 123456;
+  requests[6]._first = SIZE_MAX;
+  requests[6]._count = 20;
+  requests[7]._type = RequestType::MarkRead;
+  requests[7]._chatId = 123456;
+  requests[7]._first = 1000;
+  return requests;
+}
+
+/**
+ * @brief Builds a Send, a ListChats, a Fetch and a Push response; the strings live in texts.
+ */
+std::vector<Response> makeResponses(const std::vector<std::string> &texts) {
+  std::vector<Response> responses(6);
+  responses[0].reset(RequestType::Send, ServiceStatus::Ok);
+  responses[0]._id = 98765432;
+  responses[1].reset(RequestType::Login, ServiceStatus::WrongPassword);
+
+  responses[2].reset(RequestType::ListChats, ServiceStatus::Ok);
+  responses[2]._hasMore = true;
+  for (std::size_t i = 0; i < 20; ++i)
+    responses[2]._chats.push_back(ChatSummary{1000 + i * 7, 1700000000 - static_cast<TimeStamp>(i) * 60, 500 + i, i % 3});
+
+  auto &fetch = responses[3];
+  fetch.reset(RequestType::Fetch, ServiceStatus::Ok);
+  fetch._first = 480;
+  fetch._messageCount = 500;
+  fetch._lastRead = 495;
+  for (std::size_t i = 0; i < 20; ++i) {
+    WireMessage message;
+    message._messageId = 5000000 + i * 13;
+    message._timeStamp = 1700000000 + static_cast<TimeStamp>(i) * 45;
+    message._sender = texts[i % 2 == 0 ? 0 : 2];
+    message._firstPart = fetch._parts.size();
+    message._partCount = 1;
+    fetch._parts.push_back(MessagePart{ContentKind::Text, texts[3 + i % 2]});
+    fetch._messages.push_back(message);
+  }
+
+  // новые сообщения чата и извещение о потерянных
+  responses[4] = fetch;
+  responses[4]._type = RequestType::Push;
+  responses[4]._id = 123456;
+  responses[5].reset(RequestType::Push, ServiceStatus::Ok);
+  return responses;
+}
+
+/**
+ * @brief Gets the body of the only frame in a buffer.
+ */
+std::string_view frameBody(std::string_view frame) {
+  std::string_view body;
+  std::size_t frameSize = 0;
+  extractFrame(frame, body, frameSize);
+  return body;
+}
+
+/**
+ * @brief Decodes a body and, if it is accepted, checks that it encodes back to itself.
+ * @return 1 if an accepted body re-encodes differently, 0 otherwise.
+ */
+std::size_t checkBody(std::string_view body, bool isRequest, Request &request, Response &response, std::string &buffer,
+                      std::size_t &accepted) {
+  buffer.clear();
+  if (isRequest) {
+    if (!decodeRequest(body, request))
+      return 0;
+    encodeRequest(buffer, request);
+  } else {
+    if (!decodeResponse(body, response))
+      return 0;
+    encodeResponse(buffer, response);
+  }
+  ++accepted;
+  return frameBody(buffer) != body;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t frameCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+  std::size_t fuzzIterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+
+  const std::vector<std::string> texts = {"ivanov_1", "Passw0rd", "Иван",
+                                          "Привет! Как дела? Встречаемся в 19:00 у входа.", "ok 👍"};
+  auto requests = makeRequests(texts);
+  auto responses = makeResponses(texts);
+  std::size_t violations = 0;
+
+  // кодирование: запросы всех видов вперемешку с ответами
+  std::string stream;
+  auto start = Clock::now();
+  for (std::size_t i = 0; i < frameCount; ++i) {
+    if (i % 2 == 0)
+      encodeRequest(stream, requests[(i / 2) % requests.size()]);
+    else
+      encodeResponse(stream, responses[(i / 2) % responses.size()]);
+  }
+  double encodeSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  // разбор на месте: виды указывают в поток, ничего не копируется
+  Request request;
+  Response response;
+  std::size_t decoded = 0;
+  std::size_t checksum = 0;
+  std::string_view input(stream);
+  std::string_view body;
+  std::size_t frameSize = 0;
+  start = Clock::now();
+  for (std::size_t i = 0; extractFrame(input, body, frameSize) == FrameStatus::Complete; ++i) {
+    input.remove_prefix(frameSize);
+    if (i % 2 == 0) {
+      decoded += decodeRequest(body, request);
+      checksum += request._text.size() + request._chatId;
+    } else {
+      decoded += decodeResponse(body, response);
+      checksum += response._messages.size() + response._chats.size();
+    }
+  }
+  double decodeSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+  violations += decoded != frameCount || !input.empty();
+
+  std::printf("frames %zu, %.1f bytes/frame average (checksum %zu)\n", frameCount,
+              static_cast<double>(stream.size()) / frameCount, checksum);
+  std::printf("encode %8.1f ns/frame %8.0f MB/s\n", encodeSeconds * 1e9 / frameCount, stream.size() / encodeSeconds / 1e6);
+  std::printf("decode %8.1f ns/frame %8.0f MB/s\n", decodeSeconds * 1e9 / frameCount, stream.size() / decodeSeconds / 1e6);
+
+  // круговая проверка: каждый эталонный кадр разбирается и кодируется в те же байты
+  std::vector<std::string> corpus;
+  std::vector<bool> corpusIsRequest;
+  for (const auto &sample : requests) {
+    corpus.emplace_back();
+    encodeRequest(corpus.back(), sample);
+    corpusIsRequest.push_back(true);
+  }
+  for (const auto &sample : responses) {
+    corpus.emplace_back();
+    encodeResponse(corpus.back(), sample);
+    corpusIsRequest.push_back(false);
+  }
+  std::string buffer;
+  std::size_t accepted = 0;
+  for (std::size_t i = 0; i < corpus.size(); ++i)
+    violations += checkBody(frameBody(corpus[i]), corpusIsRequest[i], request, response, buffer, accepted);
+  violations += accepted != corpus.size();
+  violations += response._type != RequestType::Push || response._id != 0 || !response._messages.empty();
+  violations += checkBody(frameBody(corpus[corpus.size() - 2]), false, request, response, buffer, accepted);
+  violations += response._messages.size() != 20 || response._messages[19]._messageId != 5000000 + 19 * 13 ||
+                response._parts[3]._value != texts[4] || response._id != 123456;
+
+  // Push посылает только сервер: такой запрос отклоняется
+  Request push;
+  push._type = RequestType::Push;
+  buffer.clear();
+  encodeRequest(buffer, push);
+  violations += decodeRequest(frameBody(buffer), request);
+
+  // фаззинг: поврежденные тела должны отклоняться или кодироваться обратно в себя
+  std::uint64_t random = 0x9E3779B97F4A7C15ull;
+  std::string mutated;
+  std::size_t fuzzAccepted = 0;
+  start = Clock::now();
+  for (std::size_t i = 0; i < fuzzIterations; ++i) {
+    std::size_t sample = nextRandom(random) % corpus.size();
+    mutated.assign(frameBody(corpus[sample]));
+    std::uint64_t value = nextRandom(random);
+    switch (value % 4) {
+    case 0: // несколько перевернутых битов
+      for (std::size_t flip = 0; flip < 1 + (value >> 8) % 4 && !mutated.empty(); ++flip)
+        mutated[nextRandom(random) % mutated.size()] ^= static_cast<char>(1u << (nextRandom(random) % 8));
+      break;
+    case 1: // обрезанное тело
+      mutated.resize(mutated.empty() ? 0 : (value >> 8) % mutated.size());
+      break;
+    case 2: // лишние байты в конце
+      for (std::size_t extra = 0; extra < 1 + (value >> 8) % 8; ++extra)
+        mutated.push_back(static_cast<char>(nextRandom(random)));
+      break;
+    default: // случайные байты
+      mutated.resize((value >> 8) % 64);
+      for (auto &byte : mutated)
+        byte = static_cast<char>(nextRandom(random));
+      break;
+    }
+
+    violations += checkBody(mutated, true, request, response, buffer, fuzzAccepted);
+    violations += checkBody(mutated, false, request, response, buffer, fuzzAccepted);
+
+    // поток с испорченным префиксом: кадр не выходит за пределы данных
+    std::string_view frame;
+    if (extractFrame(mutated, frame, frameSize) == FrameStatus::Complete)
+      violations += frameSize > mutated.size() || frame.data() + frame.size() != mutated.data() + frameSize;
+  }
+  double fuzzSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+  std::printf("fuzz   %zu inputs, %zu accepted, %.0f ns/input\n", fuzzIterations, fuzzAccepted,
+              fuzzSeconds * 1e9 / (fuzzIterations ? fuzzIterations : 1));
+
+  std::printf("violations %zu\n", violations);
+  return violations ? 1 : 0;
+}
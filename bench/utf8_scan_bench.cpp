@@ -0,0 +1,119 @@
+#include "system/system_function.h"
+#include "system/utf8_scan.h"
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Compares the former input validation loop with scanUtf8.
+ * @details Usage: utf8_scan_bench [total megabytes per set]. Every set is validated by the
+ * former getUtf8CharLen + substr loop (one string per character), by the scalar path and
+ * by scanUtf8; the last two must give the same result.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char *LOGINS[] = {"Alex2104", "Elena1510", "Serg0101", "Vit2504", "mar1980", "fed1980"};
+const char *ASCII_WORDS[] = {"the ", "meeting ", "is ", "moved ", "to ", "Friday, ", "10:30. ", "Agenda: ", "see "};
+const char *CYRILLIC_WORDS[] = {"встреча ", "перенесена ", "на ", "пятницу, ", "Ёлка ", "Повестка: ", "смотри "};
+
+/**
+ * @brief The former validation: counts characters and checks classes via substr.
+ * @return Number of characters, or 0 if a character is broken.
+ */
+std::size_t legacyValidate(const std::string &inputData, bool &isCapital, bool &isNumber) {
+  std::size_t utf8SymbolCount = 0;
+  for (std::size_t i = 0; i < inputData.size();) {
+    std::size_t charLen = getUtf8CharLen(static_cast<unsigned char>(inputData[i]));
+    if (i + charLen > inputData.size())
+      return 0;
+
+    std::string utf8Char = inputData.substr(i, charLen);
+    ++utf8SymbolCount;
+    if (charLen == 1) {
+      if (std::isdigit(static_cast<unsigned char>(utf8Char[0])))
+        isNumber = true;
+      if (std::isupper(static_cast<unsigned char>(utf8Char[0])))
+        isCapital = true;
+    }
+    i += charLen;
+  }
+  return utf8SymbolCount;
+}
+
+/**
+ * @brief Builds texts of about the given size from a word list.
+ */
+std::vector<std::string> makeTexts(const char *const *words, std::size_t wordCount, std::size_t textSize,
+                                   std::size_t totalBytes) {
+  std::vector<std::string> texts;
+  std::size_t bytes = 0;
+  for (std::size_t n = 0; bytes < totalBytes; ++n) {
+    std::string text;
+    for (std::size_t k = n; text.size() < textSize; ++k)
+      text += words[k % wordCount];
+    bytes += text.size();
+    texts.push_back(std::move(text));
+  }
+  return texts;
+}
+
+/**
+ * @brief Runs all variants over one set of texts.
+ */
+void runSet(const char *title, const std::vector<std::string> &texts, std::uint32_t allowed) {
+  std::size_t bytes = 0;
+  for (const auto &text : texts)
+    bytes += text.size();
+  double mb = static_cast<double>(bytes) / 1e6;
+
+  std::size_t checksum = 0;
+  bool isCapital = false, isNumber = false;
+  auto start = Clock::now();
+  for (const auto &text : texts)
+    checksum += legacyValidate(text, isCapital, isNumber);
+  double legacyNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+  start = Clock::now();
+  for (const auto &text : texts)
+    checksum += scanUtf8Scalar(text, allowed)._codePoints;
+  double scalarNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+  start = Clock::now();
+  for (const auto &text : texts)
+    checksum += scanUtf8(text, allowed)._codePoints;
+  double vectorNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+  for (const auto &text : texts) {
+    Utf8ScanResult a = scanUtf8Scalar(text, allowed);
+    Utf8ScanResult b = scanUtf8(text, allowed);
+    if (a._codePoints != b._codePoints || a._classes != b._classes || a._errorLength != b._errorLength) {
+      std::printf("mismatch on %s\n", text.c_str());
+      std::exit(1);
+    }
+  }
+
+  std::printf("%-24s legacy %7.0f MB/s | scalar %7.0f MB/s | scanUtf8 %7.0f MB/s | %6.1f ns/text | checksum %zu\n",
+              title, mb / (legacyNs / 1e9), mb / (scalarNs / 1e9), mb / (vectorNs / 1e9),
+              vectorNs / static_cast<double>(texts.size()), checksum);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 32;
+  std::size_t total = megabytes * 1000000;
+
+  runSet("logins (~8 B)", makeTexts(LOGINS, 6, 1, total / 8), UTF8_CLASS_ASCII);
+  runSet("ascii messages (200 B)", makeTexts(ASCII_WORDS, 9, 200, total), UTF8_CLASS_ANY);
+  runSet("cyrillic messages (200 B)", makeTexts(CYRILLIC_WORDS, 7, 200, total), UTF8_CLASS_ANY);
+  runSet("ascii paste (64 KB)", makeTexts(ASCII_WORDS, 9, 65536, total), UTF8_CLASS_ANY);
+  runSet("cyrillic paste (64 KB)", makeTexts(CYRILLIC_WORDS, 7, 65536, total), UTF8_CLASS_ANY);
+  return 0;
+}
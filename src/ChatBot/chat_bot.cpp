@@ -1,50 +1,245 @@
 #include "chat_system.h"
+#include "exception/server_exception.h"
+#include "exception/storage_exception.h"
 #include "menu/0_init_system.h"
 #include "menu/1_registration.h"
 #include "menu/2_0_login_menu.h"
+#if defined(__linux__)
+#include "server/chat_server.h"
+#endif
+#include "service/batch_runner.h"
+#include "service/dataset_generator.h"
+#include "storage/log_compactor.h"
+#include "storage/mutation_codec.h"
+#include "storage/mutation_log.h"
+#include "storage/snapshot.h"
 #include "system/system_function.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <fstream>
 #include <iostream>
+#include <memory>
+
+const std::string DATA_DIRECTORY = "chatbot_data"; ///< Directory with the snapshot and the mutation log.
+
+namespace {
+
+/**
+ * @brief Runs a command script without prompts and prints the report.
+ * @param chatSystem The chat system.
+ * @param scriptPath Path of the script, "-" for standard input.
+ * @return 0 on success, 1 if the script cannot be opened.
+ */
+int runBatchMode(ChatSystem &chatSystem, const std::string &scriptPath) {
+  BatchRunner batchRunner(chatSystem);
+
+  if (scriptPath == "-") {
+    batchRunner.load(std::cin, std::cerr);
+  } else {
+    std::ifstream script(scriptPath);
+    if (!script) {
+      std::cerr << " ! Не удалось открыть сценарий " << scriptPath << std::endl;
+      return 1;
+    }
+    batchRunner.load(script, std::cerr);
+  }
+
+  batchRunner.run(std::cerr);
+  batchRunner.printReport(std::cout);
+  return 0;
+}
+
+#if defined(__linux__)
+std::atomic<ChatServer *> runningServer{nullptr}; ///< Server stopped by SIGINT and SIGTERM.
+
+/**
+ * @brief Signal handler of the server mode.
+ */
+void stopServer(int) {
+  if (ChatServer *chatServer = runningServer.load())
+    chatServer->stop();
+}
+
+/**
+ * @brief Serves network clients until SIGINT or SIGTERM.
+ * @param chatSystem The chat system.
+ * @param address Port of the loopback interface (digits only) or path of a Unix socket.
+ * @return 0 after a stop signal, 1 if the server cannot start.
+ */
+int runServerMode(ChatSystem &chatSystem, const std::string &address) {
+  try {
+    ChatServer chatServer(chatSystem);
+    if (!address.empty() && address.find_first_not_of("0123456789") == std::string::npos &&
+        address.size() <= 5 && std::stoul(address) <= UINT16_MAX) {
+      std::uint16_t port = chatServer.listenTcp(static_cast<std::uint16_t>(std::stoul(address)));
+      std::cerr << "Сервер слушает 127.0.0.1:" << port << std::endl;
+    } else {
+      chatServer.listenUnix(address);
+      std::cerr << "Сервер слушает " << address << std::endl;
+    }
+
+    runningServer = &chatServer;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    chatServer.run();
+    runningServer = nullptr;
+  } catch (const ServerException &ex) {
+    runningServer = nullptr;
+    std::cerr << " ! " << ex.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
+#else
+/**
+ * @brief Server mode needs epoll, so it is only available on Linux.
+ */
+int runServerMode(ChatSystem &, const std::string &) {
+  std::cerr << " ! Режим сервера доступен только в Linux" << std::endl;
+  return 1;
+}
+#endif
+
+} // namespace
 
 /**
  * @brief Main entry point for the chat system application.
+ * @param argc Number of arguments.
+ * @param argv Arguments: --batch <script|-> runs a command script instead of the menus,
+ * --in-memory starts without the data directory and saves nothing, --generate <spec> fills an
+ * empty system with a synthetic data set (see parseDatasetSpec), --server <port|path> serves network
+ * clients on a loopback TCP port or a Unix socket until SIGINT or SIGTERM (see ChatServer).
  * @return 0 on successful execution or exit.
  * @details Initializes the chat system, handles user authentication
  * (registration/login), and manages the main program loop.
  */
-int main() {
+int main(int argc, char **argv) {
+
+  std::string batchScript;
+  std::string serverAddress;
+  bool inMemory = false;
+  bool generate = false;
+  DatasetConfig datasetConfig;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--batch" && i + 1 < argc) {
+      batchScript = argv[++i];
+    } else if (arg == "--server" && i + 1 < argc) {
+      serverAddress = argv[++i];
+    } else if (arg == "--in-memory") {
+      inMemory = true;
+    } else if (arg == "--generate" && i + 1 < argc && parseDatasetSpec(argv[i + 1], datasetConfig)) {
+      generate = true;
+      ++i;
+    } else {
+      std::cerr << "Использование: ChatBot [--batch <сценарий|->] [--server <порт|путь>] [--in-memory] [--generate "
+                   "users=N,chats=N,messages=N,groups=0.2,group=3-10,zipf=1.0,seed=N,threads=N,password=P,days=N]"
+                << std::endl;
+      return 2;
+    }
+  }
 
   std::setlocale(LC_ALL, "");
-  enableUTF8Console();
+  if (batchScript.empty() && serverAddress.empty())
+    enableUTF8Console();
 
   // Create ChatSystem instance
   ChatSystem chatSystem;
 
-  // Initialize the system with test data
-  systemInitTest(chatSystem);
+  // Restore the state of previous runs and journal all further mutations
+  std::unique_ptr<LogCompactor> logCompactor;
+  if (!inMemory) try {
+    std::uint64_t snapshotLsn = loadSnapshot(snapshotPath(DATA_DIRECTORY), chatSystem);
+    std::uint64_t lastLsn = replayMutationLog(DATA_DIRECTORY, chatSystem, snapshotLsn);
+    chatSystem.attachMutationLog(std::make_shared<MutationLog>(DATA_DIRECTORY, MutationLogConfig(), lastLsn + 1));
+    logCompactor = std::make_unique<LogCompactor>(DATA_DIRECTORY, chatSystem.getMutationLog(), LogCompactorConfig(),
+                                                  snapshotLsn);
+  } catch (const StorageException &ex) {
+    std::cout << " ! " << ex.what() << std::endl;
+    return 1;
+  }
+
+  // Synthetic data set instead of the test data; saved at once as a snapshot
+  if (generate) {
+    if (!chatSystem.getUsers().empty()) {
+      std::cerr << " ! Генерация возможна только в пустую систему, удалите каталог " << DATA_DIRECTORY << std::endl;
+      return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::size_t messageCount = generateDataset(chatSystem, datasetConfig);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Сгенерировано: " << chatSystem.getUsers().size() << " пользователей, " << chatSystem.getChats().size()
+              << " чатов, " << messageCount << " сообщений за " << seconds << " с" << std::endl;
+
+    // компактор останавливается на время checkpoint и стартует от нового снимка
+    if (logCompactor) {
+      logCompactor->stop();
+      writeCheckpoint(chatSystem, DATA_DIRECTORY);
+      logCompactor = std::make_unique<LogCompactor>(DATA_DIRECTORY, chatSystem.getMutationLog(), LogCompactorConfig(),
+                                                    chatSystem.getMutationLog()->getLastLsn());
+    }
+  }
+
+  // Batch mode: the script brings its own users, the result is saved like an interactive run
+  if (!batchScript.empty()) {
+    int result = runBatchMode(chatSystem, batchScript);
+    if (logCompactor) {
+      logCompactor->stop();
+      writeCheckpoint(chatSystem, DATA_DIRECTORY);
+    }
+    return result;
+  }
+
+  // Server mode: clients register over the network, the result is saved on a stop signal
+  if (!serverAddress.empty()) {
+    int result = runServerMode(chatSystem, serverAddress);
+    if (logCompactor) {
+      logCompactor->stop();
+      writeCheckpoint(chatSystem, DATA_DIRECTORY);
+    }
+    return result;
+  }
+
+  // Initialize the system with test data on the first run
+  if (chatSystem.getUsers().empty())
+    systemInitTest(chatSystem);
 
   short userChoice;
+  ChatService chatService(chatSystem);
 
   // Main program loop
   while (true) {
-    // Reset active user
-    chatSystem.setActiveUser(nullptr);
-
     // Display authentication menu and get user choice
     userChoice = authMenu();
 
     // Handle user choice for registration, login, or exit
-    switch (userChoice) {
-    case 0: // Exit the program
-      return 0;
-    case 1: // Register a new user
-      userRegistration(chatSystem);
-      break;
-    case 2: // Log in an existing user
-      if (userLoginInsystem(chatSystem))
-        loginMenuChoice(chatSystem);
-      break;
-    default:
-      break; // Handle invalid choices
+    try {
+      switch (userChoice) {
+      case 0: // Exit the program
+        if (logCompactor) {
+          logCompactor->stop();
+          writeCheckpoint(chatSystem, DATA_DIRECTORY);
+        }
+        return 0;
+      case 1: // Register a new user
+        userRegistration(chatSystem);
+        break;
+      case 2: { // Log in an existing user; the console works in its own session
+        SessionId sessionId;
+        if (userLoginInsystem(chatSystem, sessionId)) {
+          loginMenuChoice(chatSystem, sessionId);
+          chatService.logout(sessionId);
+        }
+        break;
+      }
+      default:
+        break; // Handle invalid choices
+      }
+    } catch (const StorageException &ex) { // журнал недоступен - дальше работать без сохранения нельзя
+      std::cout << " ! " << ex.what() << std::endl;
+      return 1;
     }
   }
 
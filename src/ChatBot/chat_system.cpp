@@ -1,15 +1,73 @@
 #include "chat_system.h"
 #include "chat/chat.h"
+#include "storage/mutation_codec.h"
 #include "system/system_function.h"
+#include "user/user_chat_list.h"
+#include <functional>
 #include <iostream>
 #include <memory>
 
+namespace {
+
+/**
+ * @brief Buffer for encoding log records, one per thread.
+ */
+thread_local std::string t_recordBuffer;
+
+/**
+ * @brief Gets the cleared record buffer of the calling thread.
+ */
+std::string &getRecordBuffer() {
+  t_recordBuffer.clear();
+  return t_recordBuffer;
+}
+
+} // namespace
+
 /**
  * @brief Default constructor for ChatSystem.
  */
 ChatSystem::ChatSystem() {}
 
+/**
+ * @brief Attaches the mutation log; all following mutations are journaled.
+ * @param mutationLog Shared pointer to the log, or nullptr to stop journaling.
+ */
+void ChatSystem::attachMutationLog(const std::shared_ptr<MutationLog> &mutationLog) { _mutationLog = mutationLog; }
+
+/**
+ * @brief Gets the attached mutation log.
+ * @return Shared pointer to the log, or nullptr.
+ */
+const std::shared_ptr<MutationLog> &ChatSystem::getMutationLog() const { return _mutationLog; }
+
+/**
+ * @brief Appends a record to the mutation log.
+ * @param type Record kind.
+ * @param record Encoded record.
+ */
+void ChatSystem::journal(MutationType type, const std::string &record) { _mutationLog->append(type, record); }
+
+/**
+ * @brief Gets the shard of a login.
+ * @param login The login.
+ * @return Reference to the shard.
+ */
+ChatSystem::LoginShard &ChatSystem::getLoginShard(const std::string &login) {
+  return _loginShards[std::hash<std::string>()(login) % CHAT_SYSTEM_SHARD_COUNT];
+}
+
+/**
+ * @brief Gets the shard of a login for lookups.
+ * @param login The login.
+ * @return Reference to the shard.
+ */
+const ChatSystem::LoginShard &ChatSystem::getLoginShard(const std::string &login) const {
+  return _loginShards[std::hash<std::string>()(login) % CHAT_SYSTEM_SHARD_COUNT];
+}
+
 std::size_t ChatSystem::getNewChatId() {
+  std::lock_guard<std::mutex> lock(_chatsMutex);
   return _idChatManager.getNextChatId();
 }
 
@@ -23,50 +81,95 @@ std::size_t ChatSystem::getNewMessageId() {
  * @return Shared pointer to chat if found, nullptr otherwise.
  */
 std::shared_ptr<Chat> ChatSystem::getChatById(std::size_t chatId) const {
-  auto it = _chatIdChatMap.find(chatId);
-  if (it != _chatIdChatMap.end())
+  const auto &shard = _chatShards[chatId % CHAT_SYSTEM_SHARD_COUNT];
+  std::shared_lock<std::shared_mutex> lock(shard._mutex);
+  auto it = shard._chats.find(chatId);
+  if (it != shard._chats.end())
     return it->second;
   return nullptr;
 }
 
 /**
  * @brief Gets the list of users.
- * @return Const reference to the vector of users.
+ * @return Const reference to the vector of users; not to be used while other threads add users.
  */
 const std::vector<std::shared_ptr<User>> &ChatSystem::getUsers() const {
   return _users;
 }
 
+/**
+ * @brief Gets the table resolving user handles.
+ * @return Const reference to the table.
+ */
+const UserTable &ChatSystem::getUserTable() const { return _userTable; }
+
 /**
  * @brief Gets the list of chats.
- * @return Const reference to the vector of chats.
+ * @return Const reference to the vector of chats; not to be used while other threads add chats.
  */
 const std::vector<std::shared_ptr<Chat>> &ChatSystem::getChats() const {
   return _chats;
 }
 
 /**
- * @brief Gets the active user.
- * @return Const reference to the active user.
+ * @brief Gets the table of login sessions.
+ * @return Reference to the table.
  */
-const std::shared_ptr<User> &ChatSystem::getActiveUser() const {
-  return _activeUser;
+SessionTable &ChatSystem::getSessions() { return _sessions; }
+
+/**
+ * @brief Gets the subscriptions of sessions to new messages.
+ * @return Reference to the table.
+ */
+DeliveryTable &ChatSystem::getDelivery() { return _delivery; }
+
+/**
+ * @brief Gets the user of a session.
+ * @param sessionId Handle of the session.
+ * @return Shared pointer to the user, or nullptr if the session is not open.
+ */
+std::shared_ptr<User> ChatSystem::getSessionUser(SessionId sessionId) const {
+  return _userTable.getShared(_sessions.getUserId(sessionId));
 }
 
 /**
- * @brief Gets the login user map.
- * @return Const reference to the unordered map.
+ * @brief Gets the screen buffer of the console UI.
+ * @return Reference to the buffer.
  */
-const std::unordered_map<std::string, std::shared_ptr<User>> &
-ChatSystem::getLoginUserMap() const {
-  return _loginUserMap;
+ScreenBuffer &ChatSystem::getScreen() { return _screen; }
+
+/**
+ * @brief Finds a user by login.
+ * @param login The login.
+ * @return Shared pointer to the user, or nullptr if there is no such login.
+ */
+std::shared_ptr<User> ChatSystem::findUserByLogin(const std::string &login) const {
+  const auto &shard = getLoginShard(login);
+  std::shared_lock<std::shared_mutex> lock(shard._mutex);
+  auto it = shard._users.find(login);
+  if (it != shard._users.end())
+    return it->second;
+  return nullptr;
 }
 
+/**
+ * @brief Gets the chat ID manager.
+ * @return Reference to the manager.
+ */
+idChatManager &ChatSystem::getIdChatManager() { return _idChatManager; }
+
+/**
+ * @brief Gets the message ID manager.
+ * @return Reference to the manager.
+ */
+idMessageManager &ChatSystem::getIdMessageManager() { return _idMessageManager; }
+
 /**
  * @brief Releases a chat ID back to the ID manager.
  * @param chatId ID to release.
  */
 void ChatSystem::releaseChatId(std::size_t chatId) {
+  std::lock_guard<std::mutex> lock(_chatsMutex);
   _idChatManager.releaseChatId(chatId);
 }
 
@@ -79,41 +182,109 @@ void ChatSystem::releaseMessageId(std::size_t messageId) {
 }
 
 /**
- * @brief Sets the active user.
- * @param user Shared pointer to the user to set as active.
+ * @brief Marks a message ID restored from storage as used.
+ * @param messageId The ID to reserve.
  */
-void ChatSystem::setActiveUser(const std::shared_ptr<User> &user) {
-  _activeUser = user;
-}
-
-/**
- * @brief set the login-to-user map.
- */
-void ChatSystem::setLoginUserMap(const std::string &login,
-                                 const std::shared_ptr<User> &user) {
-  _loginUserMap.insert({login, user});
-}
+void ChatSystem::reserveMessageId(std::size_t messageId) { _idMessageManager.reserveMessageId(messageId); }
 
 /**
  * @brief Adds a user to the system.
  * @param user Shared pointer to the user to add.
+ * @return False if the login is taken; the user is not added then.
+ * @details The check and the insertion are one step, so two threads cannot register
+ * the same login. A user without a chat list gets an empty one.
  */
-void ChatSystem::addUser(const std::shared_ptr<User> &user) {
-  _users.push_back(user);
+bool ChatSystem::addUser(const std::shared_ptr<User> &user) {
+  auto &loginShard = getLoginShard(user->getLogin());
+  std::unique_lock<std::shared_mutex> loginLock(loginShard._mutex);
+  if (loginShard._users.count(user->getLogin()) != 0)
+    return false;
 
-  setLoginUserMap(user->getLogin(), user);
-  return;
+  {
+    std::unique_lock<std::shared_mutex> lock(_usersMutex);
+    _users.push_back(user);
+    user->setUserId(_userTable.add(user));
+    _userSearchIndex.add(user->getUserId(), user->getLogin(), user->getUserName());
+  }
+  // список чатов нужен до публикации логина: по логину пользователя могут сразу позвать в чат
+  if (!user->getUserChatList())
+    user->createChatList(std::make_shared<UserChatList>(user));
+
+  loginShard._users.emplace(user->getLogin(), user);
+  user->setMutationObserver(this);
+
+  // запись до снятия блокировки логина - раньше любых записей о действиях пользователя
+  if (_mutationLog) {
+    auto &record = getRecordBuffer();
+    encodeAddUser(record, *user);
+    journal(MutationType::AddUser, record);
+  }
+  return true;
 }
 
 /**
  * @brief Adds a chat to the system.
  * @param chat Shared pointer to the chat to add.
  */
-void ChatSystem::addChat(const std::shared_ptr<Chat> &chat) {
-  _chats.push_back(chat);
-  std::size_t newChatId = getNewChatId();
-  chat->addChatId(newChatId);
-  _chatIdChatMap.insert({newChatId, chat});
+void ChatSystem::addChat(const std::shared_ptr<Chat> &chat) { registerChat(chat, getNewChatId()); }
+
+/**
+ * @brief Adds a chat restored from storage under its saved ID.
+ * @param chat Shared pointer to the chat.
+ * @param chatId Saved ID of the chat.
+ */
+void ChatSystem::restoreChat(const std::shared_ptr<Chat> &chat, std::size_t chatId) {
+  {
+    std::lock_guard<std::mutex> lock(_chatsMutex);
+    _idChatManager.reserveChatId(chatId);
+  }
+  registerChat(chat, chatId);
+}
+
+/**
+ * @brief Registers a chat under the given ID and journals its current state.
+ * @param chat Shared pointer to the chat.
+ * @param chatId ID assigned to the chat.
+ * @details A new chat may already hold its first message (the menu adds the chat to the
+ * system only after the message was typed), so the messages and read indexes are
+ * journaled right after the chat itself.
+ * The chat is published in the chat map last, under its own lock, so other threads
+ * find it only after its records are in the log.
+ */
+void ChatSystem::registerChat(const std::shared_ptr<Chat> &chat, std::size_t chatId) {
+  std::unique_lock<std::shared_mutex> chatLock(chat->getMutex());
+  chat->addChatId(chatId);
+  chat->setMutationObserver(this);
+  {
+    std::lock_guard<std::mutex> lock(_chatsMutex);
+    _chats.push_back(chat);
+  }
+
+  auto &chatShard = _chatShards[chatId % CHAT_SYSTEM_SHARD_COUNT];
+  {
+    std::unique_lock<std::shared_mutex> lock(chatShard._mutex);
+    chatShard._chats.emplace(chatId, chat);
+  }
+
+  if (!_mutationLog)
+    return;
+
+  auto &record = getRecordBuffer();
+  encodeAddChat(record, *chat);
+  journal(MutationType::AddChat, record);
+
+  // первые сообщения только журналируются: подписчики узнают о чате из его списка
+  for (const auto &message : chat->getMessages()) {
+    auto &messageRecord = getRecordBuffer();
+    encodeAddMessage(messageRecord, *chat, message);
+    journal(MutationType::AddMessage, messageRecord);
+  }
+
+  for (const auto &participant : chat->getParticipants()) {
+    auto user_ptr = _userTable.getShared(participant._userId);
+    if (user_ptr)
+      onLastReadMessageIndexChanged(*chat, *user_ptr, chat->getLastReadMessageIndex(user_ptr));
+  }
 }
 
 /**
@@ -134,20 +305,21 @@ void ChatSystem::eraseChat(const std::shared_ptr<Chat> &chat) {
 
 /**
  * @brief Displays the list of users.
+ * @param activeUserId Handle of the user looking at the list.
  * @param showActiveUser True to include the active user in the list.
  * @return The index of the active user in the list.
  */
-std::size_t ChatSystem::showUserList(
-    const bool showActiveUser) { // вывод на экрын списка пользователей
+std::size_t ChatSystem::showUserList(UserId activeUserId,
+                                     const bool showActiveUser) { // вывод на экрын списка пользователей
   std::cout << "Список пользователей:" << std::endl;
   size_t index = 1;
   size_t returnIndex = std::string::npos;
   for (const auto &user : _users) {
-    if (user == _activeUser) {
+    if (user->getUserId() == activeUserId) {
       returnIndex = index - 1;
     }
 
-    if (!showActiveUser && user == _activeUser)
+    if (!showActiveUser && user->getUserId() == activeUserId)
       continue;
     std::cout << index << ".  Имя - " << user->getUserName() << ", логин - "
               << user->getLogin() << ";" << std::endl;
@@ -157,27 +329,182 @@ std::size_t ChatSystem::showUserList(
 }
 
 /**
- * @brief Finds users matching a search string.
+ * @brief Finds users matching a search string, one page at a time.
  * @param foundUsers Vector to store found users.
  * @param textToFind Search string to match against user names or logins.
+ * @param excludedUser Handle of the user who searches; never returned.
+ * @param offset Number of matches to skip.
+ * @param limit Maximum number of users to return.
+ * @return True if there are more matches after this page.
  */
-void ChatSystem::findUserByTextPart(
-    std::vector<std::shared_ptr<User>> &foundUsers,
-    const std::string &textToFind) { // поиск пользователя
+bool ChatSystem::findUserByTextPart(std::vector<std::shared_ptr<User>> &foundUsers, const std::string &textToFind,
+                                    UserId excludedUser, std::size_t offset,
+                                    std::size_t limit) { // поиск пользователя
 
-  std::string textToFindLower = TextToLower(textToFind);
+  std::vector<UserId> found;
+  std::shared_lock<std::shared_mutex> lock(_usersMutex);
+  bool hasMore = _userSearchIndex.find(textToFind, excludedUser, offset, limit, found);
 
-  // перебираем всех пользователей в векторе
-  for (const auto &user : _users) {
+  for (auto userId : found)
+    foundUsers.push_back(_userTable.getShared(userId));
+  return hasMore;
+}
+
+/**
+ * @brief Finds messages matching a query in all chats of a user.
+ * @param user The user whose chats are searched.
+ * @param query Parsed query (see parseMessageQuery).
+ * @param hits Receives the found messages, grouped by chat in chat list order.
+ */
+void ChatSystem::findMessagesInUserChats(const std::shared_ptr<User> &user, const MessageQuery &query,
+                                         std::vector<MessageSearchHit> &hits) const {
+  hits.clear();
+  if (!user || !user->getUserChatList())
+    return;
+
+  std::vector<std::weak_ptr<Chat>> chats;
+  {
+    std::lock_guard<std::mutex> lock(user->getUserChatList()->getMutex());
+    chats = user->getUserChatList()->getChatFromList();
+  }
+
+  std::vector<std::size_t> messageIndexes;
+  for (const auto &weakChat : chats) {
+    auto chat_ptr = weakChat.lock();
+    if (!chat_ptr)
+      continue;
+
+    std::shared_lock<std::shared_mutex> lock(chat_ptr->getMutex());
+    chat_ptr->findMessages(query, messageIndexes);
+    for (auto messageIndex : messageIndexes)
+      hits.push_back({chat_ptr, messageIndex});
+  }
+}
+
+/**
+ * @brief Marks the cached names of a user in the inboxes of the other participants for rebuilding.
+ * @param user The renamed user.
+ */
+void ChatSystem::invalidateInboxNames(const User &user) {
+  if (!user.getUserChatList())
+    return;
 
-    if (user == _activeUser)
+  // копия списка: два списка чатов одновременно не блокируются
+  std::vector<std::weak_ptr<Chat>> chats;
+  {
+    std::lock_guard<std::mutex> lock(user.getUserChatList()->getMutex());
+    chats = user.getUserChatList()->getChatFromList();
+  }
+
+  for (const auto &weakChat : chats) {
+    auto chat_ptr = weakChat.lock();
+    if (!chat_ptr)
       continue;
 
-    std::string LowerLogin = TextToLower(user->getLogin());
-    std::string LowerName = TextToLower(user->getUserName());
+    for (const auto &participant : chat_ptr->getParticipants()) {
+      User *user_ptr = _userTable.get(participant._userId);
+      if (user_ptr && user_ptr != &user && user_ptr->getUserChatList()) {
+        std::lock_guard<std::mutex> lock(user_ptr->getUserChatList()->getMutex());
+        user_ptr->getUserChatList()->getInbox().invalidateCounterparts(*chat_ptr);
+      }
+    }
+  }
+}
 
-    if (LowerLogin.find(textToFindLower) != std::string::npos ||
-        LowerName.find(textToFindLower) != std::string::npos)
-      foundUsers.push_back(user);
+/**
+ * @brief Reindexes the login and name of a user for search.
+ * @param user The changed user.
+ */
+void ChatSystem::updateSearchIndex(const User &user) {
+  std::unique_lock<std::shared_mutex> lock(_usersMutex);
+  _userSearchIndex.update(user.getUserId(), user.getLogin(), user.getUserName());
+}
+
+/**
+ * @brief Journals a message added to a registered chat and queues it for the subscribed sessions of its participants.
+ * @param chat The chat that received the message.
+ * @param message The new message.
+ */
+void ChatSystem::onMessageAdded(const Chat &chat, const MessageView &message) {
+  if (_mutationLog) {
+    auto &record = getRecordBuffer();
+    encodeAddMessage(record, chat, message);
+    journal(MutationType::AddMessage, record);
   }
+
+  // рассылка под блокировкой чата: сеанс получает сообщения чата в порядке их добавления
+  if (_delivery.getQueueCount() != 0) {
+    std::size_t position = chat.getMessageCount() - 1;
+    for (const auto &participant : chat.getParticipants())
+      if (!participant._deletedFromChat)
+        _delivery.deliver(participant._userId, chat.getChatId(), position);
+  }
+}
+
+/**
+ * @brief Journals a changed last read message index.
+ * @param chat The chat.
+ * @param user The participant.
+ * @param lastReadMessageIndex The new index.
+ */
+void ChatSystem::onLastReadMessageIndexChanged(const Chat &chat, const User &user,
+                                               std::size_t lastReadMessageIndex) {
+  if (!_mutationLog)
+    return;
+
+  auto &record = getRecordBuffer();
+  encodeSetLastRead(record, chat.getChatId(), user.getLogin(), lastReadMessageIndex);
+  journal(MutationType::SetLastRead, record);
+}
+
+/**
+ * @brief Keeps the login map in sync and journals a changed profile field.
+ * @param user The user with the new value already set.
+ * @param field The changed field.
+ * @param oldValue The value before the change.
+ */
+void ChatSystem::onUserDataChanged(const User &user, UserField field, const std::string &oldValue) {
+  std::string newValue;
+
+  switch (field) {
+  case UserField::Login: {
+    newValue = user.getLogin();
+    auto user_ptr = _userTable.getShared(user.getUserId());
+    {
+      auto &oldShard = getLoginShard(oldValue);
+      std::unique_lock<std::shared_mutex> lock(oldShard._mutex);
+      oldShard._users.erase(oldValue);
+    }
+    if (user_ptr) {
+      auto &newShard = getLoginShard(newValue);
+      std::unique_lock<std::shared_mutex> lock(newShard._mutex);
+      newShard._users.emplace(newValue, user_ptr);
+    }
+    updateSearchIndex(user);
+    invalidateInboxNames(user);
+    break;
+  }
+  case UserField::UserName:
+    newValue = user.getUserName();
+    updateSearchIndex(user);
+    invalidateInboxNames(user);
+    break;
+  case UserField::Password:
+    newValue = user.getPassword();
+    break;
+  case UserField::Email:
+    newValue = user.getEmail();
+    break;
+  case UserField::Phone:
+    newValue = user.getPhone();
+    break;
+  }
+
+  if (!_mutationLog)
+    return;
+
+  // запись ищет пользователя по логину, действовавшему до изменения
+  auto &record = getRecordBuffer();
+  encodeSetUserField(record, field == UserField::Login ? oldValue : user.getLogin(), field, newValue);
+  journal(MutationType::SetUserField, record);
 }
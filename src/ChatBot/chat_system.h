@@ -1,34 +1,141 @@
 #pragma once
 #include "chat/chat.h"
+#include "storage/mutation_log.h"
 #include "system/id_generator.h"
+#include "system/mutation_observer.h"
+#include "system/screen_buffer.h"
+#include "user/delivery_table.h"
 #include "user/user.h"
+#include "user/user_search_index.h"
+#include "user/session_table.h"
+#include "user/user_table.h"
+#include <array>
 #include <cstddef>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+const std::size_t CHAT_SYSTEM_SHARD_COUNT = 64; ///< Shards of the chat and login maps.
+
+/**
+ * @brief A message found by a search over several chats.
+ */
+struct MessageSearchHit {
+  std::shared_ptr<Chat> _chat;   ///< Chat of the message.
+  std::size_t _messageIndex = 0; ///< Position of the message in the chat.
+};
+
 /**
- * @brief Manages users, chats, and the active user in the chat system.
+ * @brief Manages users, chats, and login sessions in the chat system.
+ * @details Registered users and chats report their mutations back to the system
+ * through IMutationObserver; with a mutation log attached every mutation is journaled.
+ *
+ * Users, logins and chats may be added and looked up from several threads: the chat and
+ * login maps are split into shards by chat ID and by login hash, each with its own lock,
+ * and the user table is read without a lock. Work inside a chat is guarded by the lock of
+ * the chat (see Chat). Whole-system iteration (getUsers, getChats, snapshots) and the
+ * console menus expect no concurrent writers.
  */
-class ChatSystem {
+class ChatSystem : public IMutationObserver {
 private:
+  /**
+   * @brief Part of the chat ID map.
+   */
+  struct alignas(64) ChatShard {
+    mutable std::shared_mutex _mutex;                              ///< Guards _chats.
+    std::unordered_map<std::size_t, std::shared_ptr<Chat>> _chats; ///< Chat ID -> chat.
+  };
+
+  /**
+   * @brief Part of the login map.
+   */
+  struct alignas(64) LoginShard {
+    mutable std::shared_mutex _mutex;                              ///< Guards _users.
+    std::unordered_map<std::string, std::shared_ptr<User>> _users; ///< Login -> user.
+  };
+
   std::vector<std::shared_ptr<User>> _users; ///< List of users in the system.
+  UserTable _userTable;                      ///< Resolves the UserId handles held by chats and messages.
+  UserSearchIndex _userSearchIndex;          ///< Trigram index over logins and names.
+  mutable std::shared_mutex _usersMutex;     ///< Guards _users, additions to _userTable and _userSearchIndex.
   std::vector<std::shared_ptr<Chat>> _chats; ///< List of chats in the system.
-  std::shared_ptr<User> _activeUser;         ///< Current active user.
-  std::unordered_map<std::string, std::shared_ptr<User>> _loginUserMap;
-  std::unordered_map<std::size_t, std::shared_ptr<Chat>> _chatIdChatMap;
+  std::mutex _chatsMutex;                    ///< Guards _chats and _idChatManager.
+  SessionTable _sessions;                    ///< Logged-in clients; a user may have several sessions.
+  DeliveryTable _delivery;                   ///< Sessions subscribed to new messages.
+  std::array<LoginShard, CHAT_SYSTEM_SHARD_COUNT> _loginShards; ///< Login map by login hash.
+  std::array<ChatShard, CHAT_SYSTEM_SHARD_COUNT> _chatShards;   ///< Chat map by chat ID.
   idChatManager _idChatManager;
   idMessageManager _idMessageManager;
+  std::shared_ptr<MutationLog> _mutationLog; ///< Journal of mutations, nullptr if not persisted.
+  ScreenBuffer _screen;                      ///< Screen of the console UI, reused between screens.
+
+  /**
+   * @brief Gets the shard of a login.
+   * @param login The login.
+   * @return Reference to the shard.
+   */
+  LoginShard &getLoginShard(const std::string &login);
+
+  /**
+   * @brief Gets the shard of a login for lookups.
+   * @param login The login.
+   * @return Reference to the shard.
+   */
+  const LoginShard &getLoginShard(const std::string &login) const;
+
+  /**
+   * @brief Registers a chat under the given ID and journals its current state.
+   * @param chat Shared pointer to the chat.
+   * @param chatId ID assigned to the chat.
+   */
+  void registerChat(const std::shared_ptr<Chat> &chat, std::size_t chatId);
+
+  /**
+   * @brief Marks the cached names of a user in the inboxes of the other participants for rebuilding.
+   * @param user The renamed user.
+   */
+  void invalidateInboxNames(const User &user);
+
+  /**
+   * @brief Reindexes the login and name of a user for search.
+   * @param user The changed user.
+   */
+  void updateSearchIndex(const User &user);
+
+  /**
+   * @brief Appends a record to the mutation log.
+   * @param type Record kind.
+   * @param record Encoded record.
+   */
+  void journal(MutationType type, const std::string &record);
 
 public:
   /**
    * @brief Default constructor for ChatSystem.
    */
   ChatSystem();
+  ChatSystem(const ChatSystem &) = delete;
+  ChatSystem &operator=(const ChatSystem &) = delete;
 
   /**
    * @brief Default destructor.
    */
-  ~ChatSystem() = default;
+  ~ChatSystem() override = default;
+
+  /**
+   * @brief Attaches the mutation log; all following mutations are journaled.
+   * @param mutationLog Shared pointer to the log, or nullptr to stop journaling.
+   */
+  void attachMutationLog(const std::shared_ptr<MutationLog> &mutationLog);
+
+  /**
+   * @brief Gets the attached mutation log.
+   * @return Shared pointer to the log, or nullptr.
+   */
+  const std::shared_ptr<MutationLog> &getMutationLog() const;
 
   /**
    * @brief Retrieves a new unique chat ID.
@@ -51,27 +158,65 @@ public:
 
   /**
    * @brief Gets the list of users.
-   * @return Const reference to the vector of users.
+   * @return Const reference to the vector of users; not to be used while other threads add users.
    */
   const std::vector<std::shared_ptr<User>> &getUsers() const;
 
+  /**
+   * @brief Gets the table resolving user handles.
+   * @return Const reference to the table.
+   */
+  const UserTable &getUserTable() const;
+
   /**
    * @brief Gets the list of chats.
-   * @return Const reference to the vector of chats.
+   * @return Const reference to the vector of chats; not to be used while other threads add chats.
    */
   const std::vector<std::shared_ptr<Chat>> &getChats() const;
 
   /**
-   * @brief Gets the active user.
-   * @return Const reference to the active user.
+   * @brief Gets the table of login sessions.
+   * @return Reference to the table.
+   */
+  SessionTable &getSessions();
+
+  /**
+   * @brief Gets the subscriptions of sessions to new messages.
+   * @return Reference to the table.
+   */
+  DeliveryTable &getDelivery();
+
+  /**
+   * @brief Gets the user of a session.
+   * @param sessionId Handle of the session.
+   * @return Shared pointer to the user, or nullptr if the session is not open.
+   */
+  std::shared_ptr<User> getSessionUser(SessionId sessionId) const;
+
+  /**
+   * @brief Gets the screen buffer of the console UI.
+   * @return Reference to the buffer; the menus compose a screen in it and flush it once.
+   */
+  ScreenBuffer &getScreen();
+
+  /**
+   * @brief Finds a user by login.
+   * @param login The login.
+   * @return Shared pointer to the user, or nullptr if there is no such login.
+   */
+  std::shared_ptr<User> findUserByLogin(const std::string &login) const;
+
+  /**
+   * @brief Gets the chat ID manager.
+   * @return Reference to the manager.
    */
-  const std::shared_ptr<User> &getActiveUser() const;
+  idChatManager &getIdChatManager();
 
   /**
-   * @brief Gets the login-to-user map.
-   * @return Const reference to the unordered map.
+   * @brief Gets the message ID manager.
+   * @return Reference to the manager.
    */
-  const std::unordered_map<std::string, std::shared_ptr<User>> &getLoginUserMap() const;
+  idMessageManager &getIdMessageManager();
 
   /**
    * @brief Releases a chat ID for reuse.
@@ -86,21 +231,19 @@ public:
   void releaseMessageId(std::size_t messageId);
 
   /**
-   * @brief Sets the active user.
-   * @param user Shared pointer to the user to set as active.
+   * @brief Marks a message ID restored from storage as used.
+   * @param messageId The ID to reserve.
    */
-  void setActiveUser(const std::shared_ptr<User> &user);
- 
-  /**
-   * @brief set the login-to-user map.
-   */
-  void setLoginUserMap(const std::string& login, const std::shared_ptr<User>& user);
+  void reserveMessageId(std::size_t messageId);
 
   /**
    * @brief Adds a user to the system.
    * @param user Shared pointer to the user to add.
+   * @return False if the login is taken; the user is not added then.
+   * @details The check and the insertion are one step, so two threads cannot register
+   * the same login. A user without a chat list gets an empty one.
    */
-  void addUser(const std::shared_ptr<User> &user);
+  bool addUser(const std::shared_ptr<User> &user);
 
   /**
    * @brief Adds a chat to the system.
@@ -108,6 +251,13 @@ public:
    */
   void addChat(const std::shared_ptr<Chat> &chat);
 
+  /**
+   * @brief Adds a chat restored from storage under its saved ID.
+   * @param chat Shared pointer to the chat.
+   * @param chatId Saved ID of the chat.
+   */
+  void restoreChat(const std::shared_ptr<Chat> &chat, std::size_t chatId);
+
   /**
    * @brief Removes a user from the system.
    * @param user Shared pointer to the user to remove.
@@ -122,16 +272,47 @@ public:
 
   /**
    * @brief Displays the list of users.
+   * @param activeUserId Handle of the user looking at the list.
    * @param showActiveUser True to include the active user in the list.
    * @return The index of the active user in the list or std::string::npos.
    */
-  std::size_t showUserList(const bool showActiveUser); // вывод на экрын списка пользователей
+  std::size_t showUserList(UserId activeUserId,
+                           const bool showActiveUser); // вывод на экрын списка пользователей
 
   /**
-   * @brief Finds users matching a search string.
+   * @brief Finds users matching a search string, one page at a time.
    * @param users Vector to store found users.
    * @param textToFind Search string to match against user names or logins.
+   * @param excludedUser Handle of the user who searches; never returned.
+   * @param offset Number of matches to skip.
+   * @param limit Maximum number of users to return.
+   * @return True if there are more matches after this page.
+   */
+  bool findUserByTextPart(std::vector<std::shared_ptr<User>> &users, const std::string &textToFind,
+                          UserId excludedUser, std::size_t offset = 0,
+                          std::size_t limit = USER_SEARCH_PAGE_SIZE); // поиск пользователя
+
+  /**
+   * @brief Finds messages matching a query in all chats of a user.
+   * @param user The user whose chats are searched.
+   * @param query Parsed query (see parseMessageQuery).
+   * @param hits Receives the found messages, grouped by chat in chat list order.
+   */
+  void findMessagesInUserChats(const std::shared_ptr<User> &user, const MessageQuery &query,
+                               std::vector<MessageSearchHit> &hits) const;
+
+  /**
+   * @brief Journals a message added to a registered chat and queues it for the subscribed sessions of its participants.
+   */
+  void onMessageAdded(const Chat &chat, const MessageView &message) override;
+
+  /**
+   * @brief Journals a changed last read message index.
+   */
+  void onLastReadMessageIndexChanged(const Chat &chat, const User &user, std::size_t lastReadMessageIndex) override;
+
+  /**
+   * @brief Keeps the login map in sync and journals a changed profile field.
    */
-  void findUserByTextPart(std::vector<std::shared_ptr<User>> &users,
-                          const std::string &textToFind); // поиск пользователя
+  void onUserDataChanged(const User &user, UserField field, const std::string &oldValue) override;
 };
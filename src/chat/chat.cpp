@@ -1,7 +1,16 @@
 #include "chat/chat.h"
 #include "exception/validation_exception.h"
+#include "storage/snapshot.h"
+#include "user/user_chat_list.h"
 #include <algorithm>
 #include <iostream>
+#include <utility>
+
+/**
+ * @brief Constructor for an empty chat.
+ * @param userTable User table of the chat system; must outlive the chat.
+ */
+Chat::Chat(const UserTable &userTable) : _userTable(&userTable), _lastReadMessageMap(userTable) {}
 
 /**
  * @brief Sets the chat ID.
@@ -9,23 +18,163 @@
  */
 void Chat::addChatId(std::size_t chatId) { _chatId = chatId; };
 
+/**
+ * @brief Sets the receiver of chat mutations.
+ * @param observer Observer pointer, or nullptr to detach.
+ */
+void Chat::setMutationObserver(IMutationObserver *observer) { _observer = observer; }
+
+/**
+ * @brief Gets the lock of the chat.
+ * @return Reference to the mutex.
+ */
+std::shared_mutex &Chat::getMutex() const { return _mutex; }
+
+/**
+ * @brief Defers loading of the messages to the first access.
+ * @param snapshot Mapped snapshot holding the messages.
+ * @param chatIndex Index of the chat in the snapshot.
+ */
+void Chat::attachSnapshot(const std::shared_ptr<const SnapshotImage> &snapshot, std::size_t chatIndex) {
+  _snapshot = snapshot;
+  _snapshotChatIndex = chatIndex;
+  snapshot->getChatActivity(chatIndex, _snapshotMessageCount, _lastActivity);
+  _snapshotPending.store(true, std::memory_order_release);
+  updateInboxes();
+}
+
+/**
+ * @brief Builds the messages from the snapshot on first access.
+ */
+void Chat::ensureMessagesLoaded() const {
+  if (!_snapshotPending.load(std::memory_order_acquire))
+    return;
+
+  // несколько читателей под общей блокировкой могут прийти сюда одновременно
+  std::lock_guard<std::mutex> lock(_lazyMutex);
+  if (!_snapshotPending.load(std::memory_order_relaxed))
+    return;
+
+  auto snapshot = std::move(_snapshot);
+  _snapshot.reset();
+  snapshot->loadChatMessages(_snapshotChatIndex, _messages);
+  _snapshotPending.store(false, std::memory_order_release);
+}
+
+/**
+ * @brief Builds the search index over all messages on first search.
+ * @details Until somebody searches the chat, adding a message costs no indexing; this
+ * keeps log replay and snapshot loading as fast as before.
+ */
+void Chat::ensureSearchIndex() const {
+  ensureMessagesLoaded();
+
+  std::lock_guard<std::mutex> lock(_lazyMutex);
+  if (_searchIndex)
+    return;
+
+  auto searchIndex = std::make_unique<MessageSearchIndex>();
+  for (std::size_t i = 0; i < _messages.size(); ++i)
+    searchIndex->addMessage(i, _messages[i]);
+  _searchIndex = std::move(searchIndex);
+}
+
+/**
+ * @brief Passes a just stored message to the search index and the observer.
+ * @param stored The stored message.
+ */
+void Chat::onMessageStored(const MessageView &stored) {
+  if (_searchIndex)
+    _searchIndex->addMessage(_messages.size() - 1, stored);
+
+  _lastActivity = stored.getTimeStamp();
+  updateInboxes();
+
+  if (_observer)
+    _observer->onMessageAdded(*this, stored);
+}
+
+/**
+ * @brief Passes the new activity of the chat to the inboxes of all participants.
+ */
+void Chat::updateInboxes() const {
+  for (const auto &participant : _participants) {
+    User *user_ptr = getUser(participant._userId);
+    if (!user_ptr || !user_ptr->getUserChatList())
+      continue;
+
+    auto &chatList = *user_ptr->getUserChatList();
+    std::lock_guard<std::mutex> lock(chatList.getMutex());
+    chatList.getInbox().update(*this);
+  }
+}
+
 /**
  * @brief Adds a new participant to the chat.
  * @param user Shared pointer to the user to be added.
  */
 void Chat::addParticipant(const std::shared_ptr<User> &user) {
   Participant participant;
-  participant._user = user;
+  participant._userId = user->getUserId();
+  participant._deletedFromChat = false;
   _participants.push_back(participant);
   updateLastReadMessageIndex(user, 0);
+
+  // у остальных участников меняется список собеседников
+  for (const auto &other : _participants) {
+    User *user_ptr = getUser(other._userId);
+    if (user_ptr && user_ptr != user.get() && user_ptr->getUserChatList()) {
+      auto &chatList = *user_ptr->getUserChatList();
+      std::lock_guard<std::mutex> lock(chatList.getMutex());
+      chatList.getInbox().invalidateCounterparts(*this);
+    }
+  }
 }
 
 /**
  * @brief Adds a message to the chat.
- * @param message Shared pointer to the message to be added.
+ * @param message The message; its content is copied into the chat's message store.
+ */
+void Chat::addMessage(const Message &message) {
+  ensureMessagesLoaded();
+  onMessageStored(_messages.append(message));
+}
+
+/**
+ * @brief Adds a message to the chat without building a Message first.
+ * @param messageId Message ID.
+ * @param sender Handle of the sender.
+ * @param timeStamp Timestamp of the message.
+ * @param parts Content parts.
+ * @param partCount Number of parts.
+ */
+void Chat::addMessage(std::size_t messageId, UserId sender, TimeStamp timeStamp,
+                      const MessagePart *parts, std::size_t partCount) {
+  ensureMessagesLoaded();
+  onMessageStored(_messages.append(messageId, sender, timeStamp, parts, partCount));
+}
+
+/**
+ * @brief Allocates room for messages about to be added with restoreMessage.
+ * @param messageCount Number of messages.
+ * @param textBytes Expected total size of their text.
  */
-void Chat::addMessage(const std::shared_ptr<Message> &message) {
-  _messages.push_back(message);
+void Chat::reserveMessages(std::size_t messageCount, std::size_t textBytes) {
+  _messages.reserve(messageCount, textBytes);
+}
+
+/**
+ * @brief Adds a message to a chat that is not yet in the chat system.
+ * @param messageId Message ID.
+ * @param sender Handle of the sender.
+ * @param timeStamp Timestamp of the message.
+ * @param parts Content parts.
+ * @param partCount Number of parts.
+ */
+void Chat::restoreMessage(std::size_t messageId, UserId sender, TimeStamp timeStamp, const MessagePart *parts,
+                          std::size_t partCount) {
+  _messages.append(messageId, sender, timeStamp, parts, partCount);
+  _lastActivity = timeStamp;
 }
 
 /**
@@ -34,10 +183,9 @@ void Chat::addMessage(const std::shared_ptr<Message> &message) {
  */
 void Chat::setDeletedFromChat(const std::shared_ptr<User> &user) {
   auto &participants = _participants;
-  auto it = std::find_if(participants.begin(), participants.end(), [&user](const Participant &participant) {
-    auto user_ptr = participant._user.lock();
-    return user_ptr && (user_ptr == user);
-  });
+  const UserId userId = user->getUserId();
+  auto it = std::find_if(participants.begin(), participants.end(),
+                         [userId](const Participant &participant) { return participant._userId == userId; });
   try {
     if (it != participants.end())
       it->_deletedFromChat = true;
@@ -55,10 +203,27 @@ void Chat::setDeletedFromChat(const std::shared_ptr<User> &user) {
 const std::size_t &Chat::getChatId() const { return _chatId; };
 
 /**
- * @brief Returns the list of messages in the chat.
- * @return Const reference to vector of shared pointers to messages.
+ * @brief Returns the messages of the chat.
+ * @return Const reference to the message store.
  */
-const std::vector<std::shared_ptr<Message>> &Chat::getMessages() const { return _messages; }
+const MessageStore &Chat::getMessages() const {
+  ensureMessagesLoaded();
+  return _messages;
+}
+
+/**
+ * @brief Gets the number of messages without loading them from the snapshot.
+ * @return Number of messages.
+ */
+std::size_t Chat::getMessageCount() const {
+  return _snapshotPending.load(std::memory_order_acquire) ? _snapshotMessageCount : _messages.size();
+}
+
+/**
+ * @brief Gets the time of the last message without loading the messages.
+ * @return Timestamp of the last message, 0 if the chat has no messages.
+ */
+TimeStamp Chat::getLastActivity() const { return _lastActivity; }
 
 /**
  * @brief Returns the list of participants in the chat.
@@ -72,10 +237,27 @@ const std::vector<Participant> &Chat::getParticipants() const { return _particip
  * @return Index of the last read message. Returns 0 if user not found.
  */
 std::size_t Chat::getLastReadMessageIndex(const std::shared_ptr<User> &user) const {
-  auto it = _lastReadMessageMap.find(user);
-  if (it != _lastReadMessageMap.end())
-    return it->second;
-  return 0;
+  return getLastReadMessageIndex(user->getUserId());
+}
+
+/**
+ * @brief Gets the index of the last message read by a user.
+ * @param userId Handle of the user.
+ * @return The index of the last read message, 0 if the user is not a participant.
+ */
+std::size_t Chat::getLastReadMessageIndex(UserId userId) const {
+  const std::size_t *lastRead = _lastReadMessageMap.find(userId);
+  return lastRead ? *lastRead : 0;
+}
+
+/**
+ * @brief Finds the messages of the chat matching a query.
+ * @param query Parsed query (see parseMessageQuery).
+ * @param messageIndexes Receives the positions of the messages in getMessages(), ascending.
+ */
+void Chat::findMessages(const MessageQuery &query, std::vector<std::size_t> &messageIndexes) const {
+  ensureSearchIndex();
+  _searchIndex->find(query, messageIndexes);
 }
 
 /**
@@ -85,10 +267,9 @@ std::size_t Chat::getLastReadMessageIndex(const std::shared_ptr<User> &user) con
  */
 bool Chat::getDeletedFromChat(const std::shared_ptr<User> &user) const {
   const auto &participants = _participants;
-  auto it = std::find_if(participants.begin(), participants.end(), [&user](const Participant &participant) {
-    auto user_ptr = participant._user.lock();
-    return user_ptr && (user_ptr == user);
-  });
+  const UserId userId = user->getUserId();
+  auto it = std::find_if(participants.begin(), participants.end(),
+                         [userId](const Participant &participant) { return participant._userId == userId; });
   try {
     if (it != participants.end())
       return it->_deletedFromChat;
@@ -101,38 +282,101 @@ bool Chat::getDeletedFromChat(const std::shared_ptr<User> &user) const {
 }
 
 /**
- * @brief Prints the chat content for the current user.
+ * @brief Gets the start of the window with the last messages.
+ * @param count Size of the window.
+ * @return Position of the first message of the window in getMessages().
+ */
+std::size_t Chat::getLastWindow(std::size_t count) const {
+  auto messageCount = getMessageCount();
+  return messageCount > count ? messageCount - count : 0;
+}
+
+/**
+ * @brief Gets the start of the window ending just before a message.
+ * @param messageId ID of the message after the window; need not exist in the chat.
+ * @param count Size of the window.
+ * @return Position of the first message of the window in getMessages().
+ */
+std::size_t Chat::getWindowBefore(std::size_t messageId, std::size_t count) const {
+  ensureMessagesLoaded();
+
+  // первое сообщение с id не меньше заданного
+  std::size_t low = 0;
+  std::size_t high = _messages.size();
+  while (low < high) {
+    std::size_t middle = low + (high - low) / 2;
+    if (_messages[middle].getMessageId() < messageId)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  return low > count ? low - count : 0;
+}
+
+/**
+ * @brief Gets the start of the window holding the first unread message of a user.
+ * @param user Shared pointer to the user.
+ * @param count Size of the window.
+ * @return Position of the first message of the window; the last window if all messages are read.
+ */
+std::size_t Chat::getFirstUnreadWindow(const std::shared_ptr<User> &user, std::size_t count) const {
+  // окно заполняется целиком, если непрочитанных меньше размера окна
+  return std::min(getLastReadMessageIndex(user), getLastWindow(count));
+}
+
+/**
+ * @brief Prints a window of the chat for the current user.
+ * @param screen Buffer of the screen being composed.
  * @param currentUser Shared pointer to the user viewing the chat.
+ * @param first Position of the first message of the window in getMessages().
+ * @param count Size of the window.
+ * @return Position after the last printed message.
  */
-void Chat::printChat(const std::shared_ptr<User> &currentUser) {
-  if (!_messages.empty()) {
-    auto messageCount = _messages.size();
-    auto unReadCount = this->getLastReadMessageIndex(currentUser);
-
-    std::cout << std::endl
-              << "Вот твой чат, chatId: " << this->getChatId() << ". В нем всего " << messageCount << " сообщения(ий). ";
-    std::cout << "\033[32m";
-    std::cout << "Из них непрочитанных - " << messageCount - unReadCount << std::endl;
-    std::cout << "\033[0m";
-
-    std::cout << std::endl << "Участники чата Имя/Логин: " << std::endl;
-    for (const auto &participant : this->getParticipants()) {
-      auto user_ptr = participant._user.lock();
-      if (user_ptr) {
-        if (user_ptr != currentUser) {
-          std::cout << user_ptr->getUserName() << "/" << user_ptr->getLogin() << "; ";
-        };
-      } else {
-        std::cout << "удал. пользоыватель";
-      }
+std::size_t Chat::printChat(ScreenBuffer &screen, const std::shared_ptr<User> &currentUser, std::size_t first,
+                            std::size_t count) {
+  ensureMessagesLoaded();
+  if (_messages.empty()) {
+    screen << "Cообщений нет.\n";
+    return 0;
+  }
+
+  auto messageCount = _messages.size();
+  auto lastRead = this->getLastReadMessageIndex(currentUser);
+  if (first >= messageCount)
+    first = getLastWindow(count);
+  auto end = std::min(first + count, messageCount);
+
+  screen << "\nВот твой чат, chatId: " << this->getChatId() << ". В нем всего " << messageCount << " сообщения(ий). ";
+  screen << ANSI_GREEN << "Из них непрочитанных - " << (messageCount > lastRead ? messageCount - lastRead : 0) << '\n'
+         << ANSI_RESET;
+
+  screen << "\nУчастники чата Имя/Логин: \n";
+  for (const auto &participant : this->getParticipants()) {
+    const User *user_ptr = getUser(participant._userId);
+    if (user_ptr) {
+      if (user_ptr != currentUser.get()) {
+        screen << user_ptr->getUserName() << '/' << user_ptr->getLogin() << "; ";
+      };
+    } else {
+      screen << "удал. пользоыватель";
     }
+  }
 
-    std::cout << std::endl;
+  screen << '\n';
 
-    for (const auto &message : _messages)
-      message->printMessage(currentUser);
-  } else
-    std::cout << "Cообщений нет." << std::endl;
+  if (first > 0)
+    screen << "... ранее еще " << first << " сообщения(ий)\n";
+
+  for (std::size_t i = first; i < end; ++i) {
+    if (i == lastRead && i != 0)
+      screen << "---- непрочитанные ----\n";
+    _messages[i].printMessage(screen, *_userTable, currentUser);
+  }
+
+  if (end < messageCount)
+    screen << "... далее еще " << messageCount - end << " сообщения(ий)\n";
+
+  return end;
 }
 
 /**
@@ -141,7 +385,29 @@ void Chat::printChat(const std::shared_ptr<User> &currentUser) {
  * @param newLastReadMessageIndex New index to store.
  */
 void Chat::updateLastReadMessageIndex(const std::shared_ptr<User> &user, std::size_t newLastReadMessageIndex) {
-  _lastReadMessageMap[user] = newLastReadMessageIndex;
+  updateLastReadMessageIndex(*user, newLastReadMessageIndex);
+}
+
+/**
+ * @brief Updates the last read message index of a participant.
+ * @param user The user.
+ * @param newLastReadMessageIndex New index to store.
+ */
+void Chat::updateLastReadMessageIndex(const User &user, std::size_t newLastReadMessageIndex) {
+  const UserId userId = user.getUserId();
+  const std::size_t *lastRead = _lastReadMessageMap.find(userId);
+  if (lastRead && *lastRead == newLastReadMessageIndex)
+    return; // меню вызывает обновление на каждом проходе - не засоряем журнал
+
+  _lastReadMessageMap.set(userId, newLastReadMessageIndex);
+  if (user.getUserChatList()) {
+    auto &chatList = *user.getUserChatList();
+    std::lock_guard<std::mutex> lock(chatList.getMutex());
+    chatList.getInbox().update(*this);
+  }
+
+  if (_observer)
+    _observer->onLastReadMessageIndexChanged(*this, user, newLastReadMessageIndex);
 }
 
 // void Chat::removeParticipant(const std::shared_ptr<User> &user) {
@@ -1,39 +1,87 @@
 #pragma once
 
+#include "chat/read_state_table.h"
 #include "message/message.h"
-#include "system/weak_map.h"
+#include "message/message_search_index.h"
+#include "message/message_store.h"
+#include "system/mutation_observer.h"
 #include "user/user.h"
+#include "user/user_id.h"
+#include "user/user_table.h"
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <vector>
 
+class SnapshotImage;
+
+const std::size_t CHAT_WINDOW_SIZE = 20; ///< Messages shown per page of a chat.
+
 /**
  * @struct Participant
  * @brief Represents a participant in a chat.
  */
 struct Participant {
-  std::weak_ptr<User> _user; ///< Weak reference to the user.
-                             ///< participant.
-  bool _deletedFromChat;     ///< Indicates if the participant was removed from the
-                             ///< chat.
+  UserId _userId;        ///< Handle of the user, resolved through the chat system's UserTable.
+  bool _deletedFromChat; ///< Indicates if the participant was removed from the
+                         ///< chat.
 };
 
 /**
  * @class Chat
  * @brief Manages a chat system with participants and messages.
+ * @details The chat does not lock itself: callers that run in several threads
+ * (ChatService) hold getMutex() shared for reading and exclusive for adding messages or
+ * read indexes, so chats are independent of each other. Loading from the snapshot and
+ * building the search index may start under a shared lock and are serialized separately.
+ * Participants are fixed before the chat is added to the chat system.
  */
 class Chat {
 private:
   std::vector<Participant> _participants;          ///< List of chat participants.
-  std::vector<std::shared_ptr<Message>> _messages; ///< List of messages in the chat.
-  weak_map<User, std::size_t> _lastReadMessageMap;
-  std::size_t _chatId;
+  mutable MessageStore _messages;                  ///< Messages of the chat.
+  const UserTable *_userTable;                     ///< Resolves participant handles (not owned).
+  ReadStateTable _lastReadMessageMap;              ///< Last read message index of each participant.
+  std::size_t _chatId = 0;
+  IMutationObserver *_observer = nullptr; ///< Receiver of chat mutations (not owned).
+  mutable std::shared_ptr<const SnapshotImage> _snapshot; ///< Source of not yet loaded messages.
+  std::size_t _snapshotChatIndex = 0;                     ///< Index of the chat in the snapshot.
+  mutable std::unique_ptr<MessageSearchIndex> _searchIndex; ///< Built on the first search, nullptr before.
+  std::size_t _snapshotMessageCount = 0; ///< Number of messages while they are still in the snapshot.
+  TimeStamp _lastActivity = 0;           ///< Time of the last message, 0 without messages.
+  mutable std::shared_mutex _mutex;      ///< Shared for readers, exclusive for writers.
+  mutable std::mutex _lazyMutex;         ///< Serializes the lazy loading of messages and the search index.
+  mutable std::atomic<bool> _snapshotPending{false}; ///< Messages are still in the snapshot.
+
+  /**
+   * @brief Builds the messages from the snapshot on first access.
+   */
+  void ensureMessagesLoaded() const;
+
+  /**
+   * @brief Builds the search index over all messages on first search.
+   */
+  void ensureSearchIndex() const;
+
+  /**
+   * @brief Passes a just stored message to the search index and the observer.
+   * @param stored The stored message.
+   */
+  void onMessageStored(const MessageView &stored);
+
+  /**
+   * @brief Passes the new activity of the chat to the inboxes of all participants.
+   */
+  void updateInboxes() const;
 
 public:
   /**
-   * @brief Default constructor for an empty chat.
-   * @details The message vector is automatically initialized as empty by std::vector.
+   * @brief Constructor for an empty chat.
+   * @param userTable User table of the chat system; must outlive the chat.
+   * @details The message store is initialized empty.
    */
-  Chat() = default;
+  explicit Chat(const UserTable &userTable);
   Chat(const Chat &) = delete;
   Chat &operator=(const Chat &) = delete;
 
@@ -48,6 +96,25 @@ public:
    */
   void addChatId(std::size_t chatId);
 
+  /**
+   * @brief Gets the lock of the chat.
+   * @return Reference to the mutex; shared for reading, exclusive for adding messages or read indexes.
+   */
+  std::shared_mutex &getMutex() const;
+
+  /**
+   * @brief Sets the receiver of chat mutations.
+   * @param observer Observer pointer, or nullptr to detach.
+   */
+  void setMutationObserver(IMutationObserver *observer);
+
+  /**
+   * @brief Defers loading of the messages to the first access.
+   * @param snapshot Mapped snapshot holding the messages.
+   * @param chatIndex Index of the chat in the snapshot.
+   */
+  void attachSnapshot(const std::shared_ptr<const SnapshotImage> &snapshot, std::size_t chatIndex);
+
   /**
    * @brief Adds a new participant to the chat.
    * @param user Shared pointer to the user to be added.
@@ -56,9 +123,41 @@ public:
 
   /**
    * @brief Adds a message to the chat.
-   * @param message Shared pointer to the message to be added.
+   * @param message The message; its content is copied into the chat's message store.
+   */
+  void addMessage(const Message &message);
+
+  /**
+   * @brief Adds a message to the chat without building a Message first.
+   * @param messageId Message ID.
+   * @param sender Handle of the sender.
+   * @param timeStamp Timestamp of the message.
+   * @param parts Content parts.
+   * @param partCount Number of parts.
+   */
+  void addMessage(std::size_t messageId, UserId sender, TimeStamp timeStamp,
+                  const MessagePart *parts, std::size_t partCount);
+
+  /**
+   * @brief Allocates room for messages about to be added with restoreMessage.
+   * @param messageCount Number of messages.
+   * @param textBytes Expected total size of their text.
+   */
+  void reserveMessages(std::size_t messageCount, std::size_t textBytes);
+
+  /**
+   * @brief Adds a message to a chat that is not yet in the chat system.
+   * @param messageId Message ID.
+   * @param sender Handle of the sender.
+   * @param timeStamp Timestamp of the message.
+   * @param parts Content parts.
+   * @param partCount Number of parts.
+   * @details Neither the inboxes of the participants nor the observer are notified, so
+   * different chats can be filled from different threads; the chat is added to the inboxes
+   * when it is complete.
    */
-  void addMessage(const std::shared_ptr<Message> &message);
+  void restoreMessage(std::size_t messageId, UserId sender, TimeStamp timeStamp, const MessagePart *parts,
+                      std::size_t partCount);
 
   /**
    * @brief Marks a user as deleted from the chat.
@@ -73,10 +172,22 @@ public:
   const std::size_t &getChatId() const;
 
   /**
-   * @brief Retrieves the list of messages in the chat.
-   * @return Constant reference to the vector of messages.
+   * @brief Retrieves the messages of the chat.
+   * @return Constant reference to the message store.
    */
-  const std::vector<std::shared_ptr<Message>> &getMessages() const;
+  const MessageStore &getMessages() const;
+
+  /**
+   * @brief Gets the number of messages without loading them from the snapshot.
+   * @return Number of messages.
+   */
+  std::size_t getMessageCount() const;
+
+  /**
+   * @brief Gets the time of the last message without loading the messages.
+   * @return Timestamp of the last message, 0 if the chat has no messages.
+   */
+  TimeStamp getLastActivity() const;
 
   /**
    * @brief Retrieves the list of participants in the chat.
@@ -84,6 +195,19 @@ public:
    */
   const std::vector<Participant> &getParticipants() const;
 
+  /**
+   * @brief Resolves a user handle of a participant or sender.
+   * @param userId Handle of the user.
+   * @return Pointer to the user, or nullptr if the user was removed.
+   */
+  User *getUser(UserId userId) const { return _userTable->get(userId); }
+
+  /**
+   * @brief Gets the user table the chat resolves handles with.
+   * @return Const reference to the table.
+   */
+  const UserTable &getUserTable() const { return *_userTable; }
+
   /**
    * @brief Gets the index of the last message read by a specific user.
    * @param user Shared pointer to the user.
@@ -91,6 +215,20 @@ public:
    */
   std::size_t getLastReadMessageIndex(const std::shared_ptr<User> &user) const;
 
+  /**
+   * @brief Gets the index of the last message read by a user.
+   * @param userId Handle of the user.
+   * @return The index of the last read message, 0 if the user is not a participant.
+   */
+  std::size_t getLastReadMessageIndex(UserId userId) const;
+
+  /**
+   * @brief Finds the messages of the chat matching a query.
+   * @param query Parsed query (see parseMessageQuery).
+   * @param messageIndexes Receives the positions of the messages in getMessages(), ascending.
+   */
+  void findMessages(const MessageQuery &query, std::vector<std::size_t> &messageIndexes) const;
+
   /**
    * @brief Checks if a user has been marked as deleted from the chat.
    * @param user Shared pointer to the user.
@@ -99,10 +237,40 @@ public:
   bool getDeletedFromChat(const std::shared_ptr<User> &user) const;
 
   /**
-   * @brief Prints the full chat contents for a specific user.
+   * @brief Gets the start of the window with the last messages.
+   * @param count Size of the window.
+   * @return Position of the first message of the window in getMessages().
+   */
+  std::size_t getLastWindow(std::size_t count = CHAT_WINDOW_SIZE) const;
+
+  /**
+   * @brief Gets the start of the window ending just before a message.
+   * @param messageId ID of the message after the window; need not exist in the chat.
+   * @param count Size of the window.
+   * @return Position of the first message of the window in getMessages().
+   * @details Message IDs grow in the order of sending, so the message is found by binary search.
+   */
+  std::size_t getWindowBefore(std::size_t messageId, std::size_t count = CHAT_WINDOW_SIZE) const;
+
+  /**
+   * @brief Gets the start of the window holding the first unread message of a user.
+   * @param user Shared pointer to the user.
+   * @param count Size of the window.
+   * @return Position of the first message of the window; the last window if all messages are read.
+   */
+  std::size_t getFirstUnreadWindow(const std::shared_ptr<User> &user, std::size_t count = CHAT_WINDOW_SIZE) const;
+
+  /**
+   * @brief Prints a window of the chat for a specific user.
+   * @param screen Buffer of the screen being composed.
    * @param currentUser Shared pointer to the user viewing the chat.
+   * @param first Position of the first message of the window in getMessages().
+   * @param count Size of the window.
+   * @return Position after the last printed message.
+   * @details Only the messages inside the window are read.
    */
-  void printChat(const std::shared_ptr<User> &currentUser);
+  std::size_t printChat(ScreenBuffer &screen, const std::shared_ptr<User> &currentUser, std::size_t first,
+                        std::size_t count = CHAT_WINDOW_SIZE);
 
   /**
    * @brief Updates the last read message index for a specific user.
@@ -110,4 +278,11 @@ public:
    * @param newLastReadMessageIndex New index to store.
    */
   void updateLastReadMessageIndex(const std::shared_ptr<User> &user, std::size_t newLastReadMessageIndex);
+
+  /**
+   * @brief Updates the last read message index of a participant.
+   * @param user The user; resolved from a UserId without touching a reference count.
+   * @param newLastReadMessageIndex New index to store.
+   */
+  void updateLastReadMessageIndex(const User &user, std::size_t newLastReadMessageIndex);
 };
@@ -0,0 +1,148 @@
+#include "chat/read_state_table.h"
+#include "user/user_table.h"
+
+namespace {
+
+const std::size_t MIN_CELLS = 8; ///< Cells allocated for the first entry.
+
+} // namespace
+
+/**
+ * @brief Constructor for an empty table.
+ * @param userTable User table of the chat system; must outlive this table.
+ */
+ReadStateTable::ReadStateTable(const UserTable &userTable) : _userTable(&userTable) {}
+
+/**
+ * @brief Gets the first cell to probe for a handle.
+ * @details Fibonacci hashing: the indexes of the handles are dense small numbers, the
+ * multiplication spreads them over the high bits.
+ */
+std::size_t ReadStateTable::homeCell(UserId userId) const {
+  std::uint64_t key = (static_cast<std::uint64_t>(userId._generation) << 32) | userId._index;
+  return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (_entries.size() - 1);
+}
+
+/**
+ * @brief Finds the cell holding a handle.
+ * @return Index of the cell, or _entries.size() if absent.
+ */
+std::size_t ReadStateTable::findCell(UserId userId) const {
+  if (_entries.empty() || !userId.isValid())
+    return _entries.size();
+
+  const std::size_t mask = _entries.size() - 1;
+  for (std::size_t cell = homeCell(userId);; cell = (cell + 1) & mask) {
+    const auto &entry = _entries[cell];
+    if (entry._userId == userId)
+      return cell;
+    if (!entry._userId.isValid())
+      return _entries.size();
+  }
+}
+
+/**
+ * @brief Rebuilds the table with the given number of cells, dropping stale entries.
+ * @param cellCount New number of cells, a power of two.
+ */
+void ReadStateTable::rehash(std::size_t cellCount) {
+  std::vector<Entry> old(cellCount);
+  old.swap(_entries);
+  _count = 0;
+
+  const std::size_t mask = cellCount - 1;
+  for (const auto &entry : old) {
+    if (!entry._userId.isValid() || !_userTable->get(entry._userId))
+      continue;
+
+    std::size_t cell = homeCell(entry._userId);
+    while (_entries[cell]._userId.isValid())
+      cell = (cell + 1) & mask;
+    _entries[cell] = entry;
+    ++_count;
+  }
+}
+
+/**
+ * @brief Frees a cell and moves the following entries of its probe chain back.
+ * @details Backward shift deletion: no tombstones, so lookups never walk over dead cells.
+ */
+void ReadStateTable::eraseCell(std::size_t cell) {
+  const std::size_t mask = _entries.size() - 1;
+  std::size_t hole = cell;
+  for (std::size_t next = (cell + 1) & mask; _entries[next]._userId.isValid(); next = (next + 1) & mask) {
+    // запись можно сдвинуть в дыру, если дыра не раньше ее начальной ячейки
+    std::size_t home = homeCell(_entries[next]._userId);
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      _entries[hole] = _entries[next];
+      hole = next;
+    }
+  }
+  _entries[hole] = Entry();
+  --_count;
+}
+
+/**
+ * @brief Gets the watermark of a participant.
+ * @param userId Handle of the participant.
+ * @return Pointer to the index, or nullptr if the participant has none.
+ */
+const std::size_t *ReadStateTable::find(UserId userId) const {
+  std::size_t cell = findCell(userId);
+  return cell != _entries.size() ? &_entries[cell]._lastReadMessageIndex : nullptr;
+}
+
+/**
+ * @brief Sets the watermark of a participant.
+ * @param userId Handle of the participant.
+ * @param lastReadMessageIndex New index.
+ */
+void ReadStateTable::set(UserId userId, std::size_t lastReadMessageIndex) {
+  if (!userId.isValid())
+    return;
+
+  std::size_t cell = findCell(userId);
+  if (cell != _entries.size()) {
+    _entries[cell]._lastReadMessageIndex = lastReadMessageIndex;
+    return;
+  }
+
+  // заполнение не больше половины; перед ростом выбрасываем ушедших пользователей
+  if ((_count + 1) * 2 > _entries.size()) {
+    removeStale();
+    if (_count * 8 > _entries.size() * 3 || _entries.empty())
+      rehash(_entries.empty() ? MIN_CELLS : _entries.size() * 2);
+  }
+
+  const std::size_t mask = _entries.size() - 1;
+  cell = homeCell(userId);
+  while (_entries[cell]._userId.isValid())
+    cell = (cell + 1) & mask;
+  _entries[cell] = {userId, lastReadMessageIndex};
+  ++_count;
+}
+
+/**
+ * @brief Removes the watermark of a participant.
+ * @param userId Handle of the participant.
+ * @return True if there was one.
+ */
+bool ReadStateTable::erase(UserId userId) {
+  std::size_t cell = findCell(userId);
+  if (cell == _entries.size())
+    return false;
+  eraseCell(cell);
+  return true;
+}
+
+/**
+ * @brief Drops the entries of users no longer present in the user table.
+ */
+void ReadStateTable::removeStale() {
+  for (const auto &entry : _entries) {
+    if (entry._userId.isValid() && !_userTable->get(entry._userId)) {
+      rehash(_entries.size());
+      return;
+    }
+  }
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "user/user_id.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class UserTable;
+
+/**
+ * @brief Last read message index of every participant of a chat.
+ * @details Open addressing with linear probing over one flat array of (UserId, index)
+ * pairs. The key is the handle itself, so hashing never touches the user and an entry
+ * keeps its hash for its whole life. Entries of users that were removed from the
+ * UserTable are dropped whenever the table would otherwise grow.
+ */
+class ReadStateTable {
+private:
+  /**
+   * @brief One cell of the table; a cell with an invalid UserId is free.
+   */
+  struct Entry {
+    UserId _userId;                       ///< Participant.
+    std::size_t _lastReadMessageIndex = 0; ///< Watermark of the participant.
+  };
+
+  std::vector<Entry> _entries;  ///< Cells; the size is zero or a power of two.
+  std::size_t _count = 0;       ///< Occupied cells.
+  const UserTable *_userTable;  ///< Decides which entries are stale (not owned).
+
+  /**
+   * @brief Gets the first cell to probe for a handle.
+   */
+  std::size_t homeCell(UserId userId) const;
+
+  /**
+   * @brief Finds the cell holding a handle.
+   * @return Index of the cell, or _entries.size() if absent.
+   */
+  std::size_t findCell(UserId userId) const;
+
+  /**
+   * @brief Rebuilds the table with the given number of cells, dropping stale entries.
+   */
+  void rehash(std::size_t cellCount);
+
+  /**
+   * @brief Frees a cell and moves the following entries of its probe chain back.
+   */
+  void eraseCell(std::size_t cell);
+
+public:
+  /**
+   * @brief Constructor for an empty table.
+   * @param userTable User table of the chat system; must outlive this table.
+   */
+  explicit ReadStateTable(const UserTable &userTable);
+
+  /**
+   * @brief Gets the watermark of a participant.
+   * @param userId Handle of the participant.
+   * @return Pointer to the index, or nullptr if the participant has none.
+   */
+  const std::size_t *find(UserId userId) const;
+
+  /**
+   * @brief Sets the watermark of a participant.
+   * @param userId Handle of the participant.
+   * @param lastReadMessageIndex New index.
+   */
+  void set(UserId userId, std::size_t lastReadMessageIndex);
+
+  /**
+   * @brief Removes the watermark of a participant.
+   * @param userId Handle of the participant.
+   * @return True if there was one.
+   */
+  bool erase(UserId userId);
+
+  /**
+   * @brief Drops the entries of users no longer present in the user table.
+   */
+  void removeStale();
+
+  /**
+   * @brief Gets the number of stored watermarks.
+   */
+  std::size_t size() const { return _count; }
+};
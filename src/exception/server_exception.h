@@ -0,0 +1,33 @@
+#pragma once
+#include "my_exception.h"
+#include <cstring>
+
+/**
+ * @class ServerException
+ * @brief Base exception class for errors of the network front end.
+ * @details Inherits from MyException and prepends "Server Exception: " to the provided message.
+ */
+class ServerException : public MyException {
+public:
+  /**
+   * @brief Constructor for ServerException.
+   * @param message The error message describing the server issue.
+   */
+  explicit ServerException(const std::string &message) : MyException("Server Exception: " + message) {};
+};
+
+/**
+ * @class SocketException
+ * @brief Exception thrown when a socket or the event loop cannot be set up.
+ * @details Inherits from ServerException and includes the failed call and the system error.
+ */
+class SocketException : public ServerException {
+public:
+  /**
+   * @brief Constructor for SocketException.
+   * @param operation Description of the failed call.
+   * @param error Value of errno after the call.
+   */
+  SocketException(const std::string &operation, int error)
+      : ServerException("!!!Ошибка сокета: " + operation + " - " + std::strerror(error)) {};
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include "my_exception.h"
+
+/**
+ * @class StorageException
+ * @brief Base exception class for persistence-related errors.
+ * @details Inherits from MyException and prepends "Storage Exception: " to the provided message.
+ */
+class StorageException : public MyException {
+public:
+  /**
+   * @brief Constructor for StorageException.
+   * @param message The error message describing the storage issue.
+   */
+  explicit StorageException(const std::string &message) : MyException("Storage Exception: " + message) {};
+};
+
+/**
+ * @class StorageIOException
+ * @brief Exception thrown when a file of the data directory cannot be opened, written or synced.
+ * @details Inherits from StorageException and includes the file path in the message.
+ */
+class StorageIOException : public StorageException {
+public:
+  /**
+   * @brief Constructor for StorageIOException.
+   * @param path Path of the file that caused the error.
+   */
+  explicit StorageIOException(const std::string &path)
+      : StorageException("!!!Ошибка ввода-вывода. Файл: " + path) {};
+};
+
+/**
+ * @class CorruptedDataException
+ * @brief Exception thrown when persisted data cannot be decoded.
+ * @details Inherits from StorageException and includes the place where decoding failed.
+ */
+class CorruptedDataException : public StorageException {
+public:
+  /**
+   * @brief Constructor for CorruptedDataException.
+   * @param where Description of the damaged data.
+   */
+  explicit CorruptedDataException(const std::string &where)
+      : StorageException("!!!Данные повреждены. " + where) {};
+};
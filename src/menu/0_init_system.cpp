@@ -20,7 +20,7 @@
  * @param messageId Unique message ID.
  */
 
-InitDataArray::InitDataArray(std::string messageText, std::string timeStamp, std::shared_ptr<User> sender,
+InitDataArray::InitDataArray(std::string messageText, TimeStamp timeStamp, std::shared_ptr<User> sender,
                              std::vector<std::shared_ptr<User>> _recipients, std::size_t messageId)
     : _messageText(messageText), _timeStamp(timeStamp), _sender(sender), _recipients(_recipients),
       _messageId(messageId) {}
@@ -119,7 +119,7 @@ void systemInitTest(ChatSystem &_chatsystem) {
   participants.push_back(Elena1510_ptr);
   participants.push_back(Alex2104_ptr);
 
-  auto chat_ptr = std::make_shared<Chat>();
+  auto chat_ptr = std::make_shared<Chat>(_chatsystem.getUserTable());
   chat_ptr->addParticipant(Elena1510_ptr);
   chat_ptr->addParticipant(Alex2104_ptr);
 
@@ -143,20 +143,20 @@ void systemInitTest(ChatSystem &_chatsystem) {
 
   _chatsystem.addChat(chat_ptr);
 
-  InitDataArray Elena_Alex1("Привет", "01-04-2025,12:00:00", Elena1510_ptr, recipients, _chatsystem.getNewMessageId());
+  InitDataArray Elena_Alex1("Привет", makeTimeStamp(2025, 4, 1, 12, 0, 0), Elena1510_ptr, recipients, _chatsystem.getNewMessageId());
 
   addMessageToChat(Elena_Alex1, chat_ptr);
 
   recipients.clear();
   recipients.push_back(Elena1510_ptr);
 
-  InitDataArray Elena_Alex2("Хай! как делишки?", "01-04-2025,12:05:00", Alex2104_ptr, recipients, _chatsystem.getNewMessageId());
+  InitDataArray Elena_Alex2("Хай! как делишки?", makeTimeStamp(2025, 4, 1, 12, 5, 0), Alex2104_ptr, recipients, _chatsystem.getNewMessageId());
   addMessageToChat(Elena_Alex2, chat_ptr);
 
   recipients.clear();
   recipients.push_back(Alex2104_ptr);
 
-  InitDataArray Elena_Alex3("Хорошо, как насчет кофе?", "01-04-2025,12:07:00", Elena1510_ptr, recipients, _chatsystem.getNewMessageId());
+  InitDataArray Elena_Alex3("Хорошо, как насчет кофе?", makeTimeStamp(2025, 4, 1, 12, 7, 0), Elena1510_ptr, recipients, _chatsystem.getNewMessageId());
   addMessageToChat(Elena_Alex3, chat_ptr);
 
   changeLastReadIndexForSender(Elena1510_ptr, chat_ptr);
@@ -179,7 +179,7 @@ void systemInitTest(ChatSystem &_chatsystem) {
   participants.push_back(mar1980_ptr);
   participants.push_back(yak1980_ptr);
 
-  chat_ptr = std::make_shared<Chat>();
+  chat_ptr = std::make_shared<Chat>(_chatsystem.getUserTable());
   chat_ptr->addParticipant(Elena1510_ptr);
   chat_ptr->addParticipant(Alex2104_ptr);
   chat_ptr->addParticipant(Serg0101_ptr);
@@ -201,7 +201,7 @@ void systemInitTest(ChatSystem &_chatsystem) {
   }
   _chatsystem.addChat(chat_ptr);
 
-  InitDataArray Elena_Alex_Serg1("Всем Привееет!?", "01-04-2025,13:00:00", Elena1510_ptr, recipients, _chatsystem.getNewMessageId());
+  InitDataArray Elena_Alex_Serg1("Всем Привееет!?", makeTimeStamp(2025, 4, 1, 13, 0, 0), Elena1510_ptr, recipients, _chatsystem.getNewMessageId());
   addMessageToChat(Elena_Alex_Serg1, chat_ptr);
 
   recipients.clear();
@@ -210,7 +210,7 @@ void systemInitTest(ChatSystem &_chatsystem) {
   recipients.push_back(mar1980_ptr);
   recipients.push_back(yak1980_ptr);
 
-  InitDataArray Elena_Alex_Serg2("И тебе не хворать!?", "01-04-2025,13:02:00", Alex2104_ptr, recipients, _chatsystem.getNewMessageId());
+  InitDataArray Elena_Alex_Serg2("И тебе не хворать!?", makeTimeStamp(2025, 4, 1, 13, 2, 0), Alex2104_ptr, recipients, _chatsystem.getNewMessageId());
   addMessageToChat(Elena_Alex_Serg2, chat_ptr);
 
   recipients.clear();
@@ -219,7 +219,7 @@ void systemInitTest(ChatSystem &_chatsystem) {
   recipients.push_back(mar1980_ptr);
   recipients.push_back(yak1980_ptr);
 
-  InitDataArray Elena_Alex_Serg3("Всем здрассьте.", "01-04-2025,13:10:15", Serg0101_ptr, recipients, _chatsystem.getNewMessageId());
+  InitDataArray Elena_Alex_Serg3("Всем здрассьте.", makeTimeStamp(2025, 4, 1, 13, 10, 15), Serg0101_ptr, recipients, _chatsystem.getNewMessageId());
   addMessageToChat(Elena_Alex_Serg3, chat_ptr);
 
   recipients.clear();
@@ -228,7 +228,7 @@ void systemInitTest(ChatSystem &_chatsystem) {
   recipients.push_back(mar1980_ptr);
   recipients.push_back(yak1980_ptr);
 
-  InitDataArray Elena_Alex_Serg4("Куда идем?", "01-04-2025,13:12:09", Elena1510_ptr, recipients, _chatsystem.getNewMessageId());
+  InitDataArray Elena_Alex_Serg4("Куда идем?", makeTimeStamp(2025, 4, 1, 13, 12, 9), Elena1510_ptr, recipients, _chatsystem.getNewMessageId());
   addMessageToChat(Elena_Alex_Serg4, chat_ptr);
 
   recipients.clear();
@@ -237,7 +237,7 @@ void systemInitTest(ChatSystem &_chatsystem) {
   recipients.push_back(mar1980_ptr);
   recipients.push_back(yak1980_ptr);
 
-  InitDataArray Elena_Alex_Serg5("В кино!", "01-04-2025,13:33:00", Serg0101_ptr, recipients, _chatsystem.getNewMessageId());
+  InitDataArray Elena_Alex_Serg5("В кино!", makeTimeStamp(2025, 4, 1, 13, 33, 0), Serg0101_ptr, recipients, _chatsystem.getNewMessageId());
   addMessageToChat(Elena_Alex_Serg5, chat_ptr);
 
   chat_ptr->updateLastReadMessageIndex(Elena1510_ptr, chat_ptr->getMessages().size() - 1);
@@ -2,6 +2,7 @@
 #include "ChatBot/chat_system.h"
 #include "exception/login_exception.h"
 #include "exception/validation_exception.h"
+#include "service/chat_service.h"
 #include "system/picosha2.h"
 #include "system/system_function.h"
 #include "user/user.h"
@@ -11,66 +12,6 @@
 #include <iostream>
 #include <string>
 
-/**
- * @brief Validates a login or password string against defined constraints.
- * @param inputData The input string to validate.
- * @param contentLengthMin The minimum allowed length.
- * @param contentLengthMax The maximum allowed length.
- * @param isPassword Set to true if the input is a password, false if it's a login.
- * @return True if the input passes all validation checks.
- * @throws InvalidQuantityCharacterException If the length is outside the allowed range.
- * @throws InvalidCharacterException If non-ASCII or invalid characters are found.
- * @throws NonCapitalCharacterException If the password lacks an uppercase letter.
- * @throws NonDigitalCharacterException If the password lacks a numeric digit.
- */
-bool checkNewDataInputForLimits(const std::string &inputData, std::size_t contentLengthMin,
-                                std::size_t contentLengthMax, bool isPassword) {
-
-  bool isCapital = false, isNumber = false;
-  std::size_t utf8SymbolCount = 0;
-
-  for (std::size_t i = 0; i < inputData.size();) {
-
-    std::size_t charLen = getUtf8CharLen(static_cast<unsigned char>(inputData[i]));
-
-    if (i + charLen > inputData.size())
-      throw InvalidCharacterException("");
-
-    std::string utf8Char = inputData.substr(i, charLen);
-
-    ++utf8SymbolCount;
-
-    if (charLen == 1) {
-      char ch = utf8Char[0];
-      if (std::isdigit(ch))
-        isNumber = true;
-
-      if (std::isupper(ch))
-        isCapital = true;
-    } else
-      throw InvalidCharacterException(""); // std::cout << "DEBUG NewUser:" << std::endl;
-    // std::cout << "Login: " << user->getLogin() << std::endl;
-    // std::cout << "Name: " << user->getUserName() << std::endl;
-    // std::cout << "PassHash: " << user->getPassword() << std::endl;
-    // std::cout << "Email: " << user->getEmail() << std::endl;
-    // std::cout << "Phone: " << user->getPhone() << std::endl;
-
-    i += charLen;
-  }
-
-  if (utf8SymbolCount < contentLengthMin || utf8SymbolCount > contentLengthMax)
-    throw InvalidQuantityCharacterException();
-
-  if (isPassword) {
-    if (!isCapital)
-      throw NonCapitalCharacterException();
-    if (!isNumber)
-      throw NonDigitalCharacterException();
-  }
-
-  return true;
-}
-
 /**
  * @brief Prompts the user for input and validates it according to specified rules.
  * @param prompt The message shown to the user.
@@ -115,11 +56,7 @@ std::string inputDataValidation(const std::string &prompt, std::size_t dataLengt
  */
 std::shared_ptr<User> findUserbyLogin(const std::string &userLogin, const ChatSystem &chatSystem) {
 
-  auto it = chatSystem.getLoginUserMap().find(userLogin);
-  if (it == chatSystem.getLoginUserMap().end())
-    return nullptr;
-  else
-    return it->second;
+  return chatSystem.findUserByLogin(userLogin);
 }
 
 /**
@@ -162,8 +99,8 @@ bool checkPasswordValidForUser(const std::string &userPasswordHash, const std::s
  */
 std::string inputNewLogin(const ChatSystem &chatSystem) {
   while (true) {
-    std::size_t dataLengthMin = 5;
-    std::size_t dataLengthMax = 15;
+    std::size_t dataLengthMin = LOGIN_LENGTH_MIN;
+    std::size_t dataLengthMax = LOGIN_LENGTH_MAX;
     std::string prompt;
 
     prompt = "Введите новый Логин либо 0 для выхода. Не менее " + std::to_string(dataLengthMin) +
@@ -192,8 +129,8 @@ std::string inputNewLogin(const ChatSystem &chatSystem) {
  */
 std::string inputNewPassword(const ChatSystem &chatSystem) {
 
-  std::size_t dataLengthMin = 5;
-  std::size_t dataLengthMax = 10;
+  std::size_t dataLengthMin = PASSWORD_LENGTH_MIN;
+  std::size_t dataLengthMax = PASSWORD_LENGTH_MAX;
   std::string prompt;
 
   prompt = "Введите новый Пароль либо 0 для выхода. Не менее " + std::to_string(dataLengthMin) +
@@ -216,8 +153,8 @@ std::string inputNewPassword(const ChatSystem &chatSystem) {
  * @return A valid name string, or empty if canceled.
  */
 std::string inputNewName(const ChatSystem &chatSystem) {
-  std::size_t dataLengthMin = 3;
-  std::size_t dataLengthMax = 10;
+  std::size_t dataLengthMin = USER_NAME_LENGTH_MIN;
+  std::size_t dataLengthMax = USER_NAME_LENGTH_MAX;
   std::string prompt;
 
   prompt = "Введите желаемое Имя для отображениялибо 0 для выхода. Не менее " + std::to_string(dataLengthMin) +
@@ -253,38 +190,26 @@ void userRegistration(ChatSystem &chatSystem) {
   if (newName.empty())
     return;
 
-  const auto &userPasswordHash = picosha2::hash256_hex_string(newPassword);
-
-  auto newUser = std::make_shared<User>(UserData(newLogin, newName, userPasswordHash, "...@gmail.com", "+111"));
-
-  chatSystem.addUser(newUser);
-  newUser->createChatList(std::make_shared<UserChatList>(newUser));
-
-  const auto &user = findUserbyLogin(newLogin, chatSystem);
-
-  if (user == nullptr)
-    std::cout << "user = nullptr";
-  else {
-    user->showUserData();
-
-    // для проверки
-    // std::cout << "DEBUG NewUser:" << std::endl;
-    // std::cout << "Login: " << user->getLogin() << std::endl;
-    // std::cout << "Name: " << user->getUserName() << std::endl;
-    // std::cout << "PassHash: " << user->getPassword() << std::endl;
-    // std::cout << "Email: " << user->getEmail() << std::endl;
-    // std::cout << "Phone: " << user->getPhone() << std::endl;
+  ChatService chatService(chatSystem);
+  UserId userId;
+  ServiceStatus status = chatService.registerUser(newLogin, newPassword, newName, userId);
+  if (status != ServiceStatus::Ok) {
+    std::cout << " ! " << getStatusText(status) << std::endl;
+    return;
   }
+
+  chatSystem.getUserTable().get(userId)->showUserData();
 }
 
 /**
  * @brief Handles user login procedure in the chat system.
  * @param chatSystem Reference to the chat system.
+ * @param sessionId Receives the session of the logged-in user.
  * @return True if login is successful; false if canceled or failed.
  * @throws UserNotFoundException If the login does not exist.
  * @throws IncorrectPasswordException If the password is incorrect.
  */
-bool userLoginInsystem(ChatSystem &chatSystem) {
+bool userLoginInsystem(ChatSystem &chatSystem, SessionId &sessionId) {
   UserData userDataForLogin;
   std::string userLogin = "";
   std::string userPassword = "";
@@ -304,22 +229,15 @@ bool userLoginInsystem(ChatSystem &chatSystem) {
     break;
   }
 
-  auto user = findUserbyLogin(userLogin, chatSystem);
-  chatSystem.setActiveUser(user);
-
   while (true) {
     try {
       userPassword = inputDataValidation("Введите пароль (или 0 для выхода):", 0, 0, true, false, chatSystem);
       if (userPassword == "0")
         return false;
 
-      const auto &userPasswordHash = picosha2::hash256_hex_string(userPassword);
-
-      if (!checkPasswordValidForUser(userPasswordHash, userLogin, chatSystem))
+      ChatService chatService(chatSystem);
+      if (chatService.login(userLogin, userPassword, sessionId) != ServiceStatus::Ok)
         throw IncorrectPasswordException();
-
-      auto user = findUserbyLogin(userLogin, chatSystem);
-      chatSystem.setActiveUser(user);
       return true;
     } catch (const ValidationException &ex) {
       std::cout << " ! " << ex.what() << " Попробуйте еще раз." << std::endl;
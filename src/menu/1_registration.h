@@ -1,5 +1,6 @@
 #pragma once
 #include "ChatBot/chat_system.h"
+#include "service/chat_service.h"
 #include <cstddef>
 #include <memory>
 #include <string>
@@ -8,18 +9,6 @@
 // and user lookup by login:
 // unordered_map<std::string, std::shared_ptr<User>> in ChatSystem
 
-/**
- * @brief Validates a login or password string against defined constraints.
- * @param inputData The input string to validate.
- * @param contentLengthMin The minimum allowed length.
- * @param contentLengthMax The maximum allowed length.
- * @param isPassword True if validating a password, false if validating a login.
- * @return True if the input passes all validation checks.
- * @throws std::invalid_argument If the input does not meet requirements.
- */
-bool checkNewDataInputForLimits(const std::string &inputData, std::size_t contentLengthMin,
-                                std::size_t contentLengthMax, bool isPassword);
-
 /**
  * @brief Prompts the user for input and validates it according to specified rules.
  * @param prompt The message shown to the user.
@@ -93,4 +82,4 @@ void userRegistration(ChatSystem &chatSystem);
  * @param chatSystem Reference to the chat system.
  * @return True if login is successful, false if canceled or failed.
  */
-bool userLoginInsystem(ChatSystem &chatSystem);
+bool userLoginInsystem(ChatSystem &chatSystem, SessionId &sessionId);
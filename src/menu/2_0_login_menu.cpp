@@ -5,6 +5,7 @@
 #include "menu/2_4_user_profile.h"
 #include "ChatBot/chat_system.h"
 #include "system/system_function.h"
+#include "user/user_chat_list.h"
 #include <cctype>
 #include <iostream>
 #include <ostream>
@@ -57,25 +58,38 @@ short authMenu() { // вывод главного меню
 /**
  * @brief Handles menu navigation and user choices after successful login.
  * @param chatSystem Reference to the chat system.
+ * @param sessionId Session of the logged-in user.
  * @throws EmptyInputException If the input is empty.
  * @throws IndexOutOfRangeException If the input is not 0, 1, 2, 3, or 4.
  * @details Displays the post-login menu, processes user input, and calls corresponding menu handlers
  * such as creating a new chat, viewing the chat list, or accessing the user profile.
  */
-void loginMenuChoice(ChatSystem &chatSystem) { // вывод главного меню
+void loginMenuChoice(ChatSystem &chatSystem, SessionId sessionId) { // вывод главного меню
   int userChoiceNumber;
   std::string userChoice;
 
   while (true) {
-    std::cout << std::endl;
-    std::cout << "Добрый день, пользователь " << chatSystem.getActiveUser()->getUserName() << std::endl;
-    std::cout << std::endl;
-    std::cout << "Выберите пункт меню: " << std::endl;
-    std::cout << "1 - Создать новый чат" << std::endl;
-    std::cout << "2 - Показать список чатов" << std::endl;
-    std::cout << "3 - Показать список папок - Under constraction." << std::endl;
-    std::cout << "4 - Показать Профиль пользователя" << std::endl;
-    std::cout << "0 - Выйти в предыдущее меню" << std::endl;
+    auto activeUser = chatSystem.getSessionUser(sessionId);
+    if (!activeUser)
+      return;
+
+    // приветствие и меню выводятся на экран одной записью
+    auto &screen = chatSystem.getScreen();
+    screen << "\nДобрый день, пользователь " << activeUser->getUserName() << '\n';
+
+    // счетчик ведется списком чатов, перебирать чаты не нужно
+    auto totalUnread = activeUser->getUserChatList()->getInbox().getTotalUnread();
+    if (totalUnread != 0)
+      screen << ANSI_GREEN << "Непрочитанных сообщений - " << totalUnread << '\n' << ANSI_RESET;
+
+    screen << '\n';
+    screen << "Выберите пункт меню: \n";
+    screen << "1 - Создать новый чат\n";
+    screen << "2 - Показать список чатов\n";
+    screen << "3 - Показать список папок - Under constraction.\n";
+    screen << "4 - Показать Профиль пользователя\n";
+    screen << "0 - Выйти в предыдущее меню\n";
+    screen.flush();
 
     bool exit2 = true;
     while (exit2) {
@@ -94,18 +108,18 @@ void loginMenuChoice(ChatSystem &chatSystem) { // вывод главного м
 
         switch (userChoiceNumber) {
         case 1:
-          LoginMenu_1NewChat(chatSystem);
+          LoginMenu_1NewChat(chatSystem, sessionId);
           exit2 = false;
           continue; // case 1 MainMenu
         case 2:
-          loginMenu_2ChatList(chatSystem);
+          loginMenu_2ChatList(chatSystem, sessionId);
           exit2 = false;
           continue; // case 2 MainMenu
         case 3:
           std::cout << "Показать список папок - Under constraction." << std::endl;
           break; // case 3 MainMenu
         case 4:
-          loginMenu_4UserProfile(chatSystem);
+          loginMenu_4UserProfile(chatSystem, sessionId);
           exit2 = false;
           continue; // case 4 MainMenu
         default:
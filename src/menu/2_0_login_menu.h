@@ -11,4 +11,4 @@ short authMenu();
  * @brief Handles the login menu flow and user input.
  * @param chatSystem Reference to the chat system.
  */
-void loginMenuChoice(ChatSystem &chatSystem);
\ No newline at end of file
+void loginMenuChoice(ChatSystem &chatSystem, SessionId sessionId);
\ No newline at end of file
@@ -2,7 +2,9 @@
 #include "chat/chat.h"
 #include "exception/login_exception.h"
 #include "exception/validation_exception.h"
+#include "service/chat_service.h"
 #include "system/system_function.h"
+#include "system/utf8_scan.h"
 #include "user/user_chat_list.h"
 #include <algorithm>
 #include <cctype>
@@ -11,10 +13,52 @@
 #include <string>
 #include <vector>
 
+namespace {
+
+/**
+ * @brief Prints one page of user search results.
+ * @param users Users of the page.
+ * @param hasMorePages True if there is a next page.
+ * @return Number of the first free position after the printed list.
+ */
+int printFoundUsers(const std::vector<std::shared_ptr<User>> &users, bool hasMorePages) {
+  int index = 1;
+  std::cout << "Вот, кого мы нашли (Имя : Логин), выберите одного:" << std::endl;
+  for (const auto &user : users) {
+    std::cout << index << ". " << user->getUserName() << " : " << user->getLogin() << std::endl;
+    ++index;
+  }
+  if (hasMorePages)
+    std::cout << "+ - следующие " << USER_SEARCH_PAGE_SIZE << " пользователей" << std::endl;
+  return index;
+}
+
+/**
+ * @brief Prints the chosen participants of a new chat, the active user first.
+ * @param chatSystem Reference to the chat system.
+ * @param activeUserId Handle of the active user.
+ * @param participants Handles of the other participants.
+ */
+void printNewChatParticipants(const ChatSystem &chatSystem, UserId activeUserId,
+                              const std::vector<UserId> &participants) {
+  std::cout << "Участники чата: " << std::endl;
+  const User *activeUser = chatSystem.getUserTable().get(activeUserId);
+  if (activeUser)
+    std::cout << activeUser->getLogin() << " ака " << activeUser->getUserName() << std::endl;
+  for (auto userId : participants) {
+    const User *user_ptr = chatSystem.getUserTable().get(userId);
+    if (user_ptr)
+      std::cout << user_ptr->getLogin() << " ака " << user_ptr->getUserName() << std::endl;
+  }
+}
+
+} // namespace
+
 /**
  * @brief Creates a new chat by selecting participants.
  * @param chatSystem Reference to the chat system.
- * @param chat Shared pointer to the chat being created.
+ * @param sessionId Session of the active user.
+ * @param participants Receives the handles of the chosen users (without the active user).
  * @param activeUserIndex Index of the active user.
  * @param target Target type for the message (e.g., individual, several, or all).
  * @throws EmptyInputException If input is empty.
@@ -23,17 +67,16 @@
  * @throws IndexOutOfRangeException If selected index is out of range.
  * @details Handles user selection for adding participants to a new chat based on the target type.
  */
-void LoginMenu_1NewChatMakeParticipants(ChatSystem &chatSystem, std::shared_ptr<Chat> &chat,
-                                        std::size_t activeUserIndex,
+void LoginMenu_1NewChatMakeParticipants(ChatSystem &chatSystem, SessionId sessionId,
+                                        std::vector<UserId> &participants, std::size_t activeUserIndex,
                                         MessageTarget target) { // создение нового сообщения путем выбора пользователей
 
+  const UserId activeUserId = chatSystem.getSessions().getUserId(sessionId);
   std::string inputData;
   std::string userChoice;
   int userChoiceNumber;
 
-  // добавляем отправителя в вектор участников
-  chat->addParticipant(chatSystem.getActiveUser());
-
+  // отправитель добавляется в чат сервисом при создании
   switch (target) {
 
   case MessageTarget::One: {
@@ -56,44 +99,22 @@ void LoginMenu_1NewChatMakeParticipants(ChatSystem &chatSystem, std::shared_ptr<
           continue;
         }
 
-        // проверяем на наличие недопустимых символов
-        std::size_t utf8SymbolCount = 0;
-        for (int i = 0; i < inputData.size();) {
-
-          std::size_t charLen = getUtf8CharLen(static_cast<unsigned char>(inputData[i]));
-
-          if (i + charLen > inputData.size())
-            throw InvalidCharacterException("");
-
-          std::string utf8Char = inputData.substr(i, charLen);
-
-          ++utf8SymbolCount;
+        // только буквы (латиница или кириллица) и цифры
+        Utf8ScanResult scan = scanUtf8(inputData, UTF8_CLASS_LETTERS | UTF8_CLASS_DIGIT);
+        if (!scan.isValid())
+          throw InvalidCharacterException(std::string(scan.rejectedChar(inputData)));
 
-          if (charLen == 1) {
-            char ch = utf8Char[0];
-            if (!std::isdigit(ch) && !std::isalpha(ch))
-              throw InvalidCharacterException(utf8Char);
-          } // if
-          else
-            throw InvalidCharacterException(utf8Char);
-
-          i += charLen;
-        }
-
-        // найти пользователей
+        // найти пользователей - первая страница
+        const std::string textToFind = inputData;
+        std::size_t pageOffset = 0;
         std::vector<std::shared_ptr<User>> users;
-        chatSystem.findUserByTextPart(users, inputData);
+        bool hasMorePages = chatSystem.findUserByTextPart(users, textToFind, activeUserId, pageOffset);
 
         if (users.size() == 0)
           throw UserNotFoundException();
 
         // выводим найденных пользователей на экран
-        int index = 1;
-        std::cout << "Вот, кого мы нашли (Имя : Логин), выберите одного:" << std::endl;
-        for (const auto &user : users) {
-          std::cout << index << ". " << user->getUserName() << " : " << user->getLogin() << std::endl;
-          ++index;
-        }
+        int index = printFoundUsers(users, hasMorePages);
 
         // выбрать нужного из списка
         bool exit2 = true;
@@ -112,9 +133,18 @@ void LoginMenu_1NewChatMakeParticipants(ChatSystem &chatSystem, std::shared_ptr<
               break;
             }
 
+            // следующая страница результатов
+            if (inputData == "+" && hasMorePages) {
+              pageOffset += users.size();
+              users.clear();
+              hasMorePages = chatSystem.findUserByTextPart(users, textToFind, activeUserId, pageOffset);
+              index = printFoundUsers(users, hasMorePages);
+              continue;
+            }
+
             userChoiceNumber = parseGetlineToInt(inputData);
 
-            if (userChoiceNumber > index)
+            if (userChoiceNumber < 1 || userChoiceNumber >= index)
               throw IndexOutOfRangeException(inputData);
 
             break;
@@ -133,14 +163,10 @@ void LoginMenu_1NewChatMakeParticipants(ChatSystem &chatSystem, std::shared_ptr<
         }
 
         // заполнить вектор участников
-        chat->addParticipant(users[userChoiceNumber - 1]);
+        participants.push_back(users[userChoiceNumber - 1]->getUserId());
 
         // проверки
-        std::cout << "Участники чата: " << std::endl;
-        for (const auto &user : chat->getParticipants()) {
-          auto user_ptr = user._user.lock();
-          std::cout << user_ptr->getLogin() << " ака " << user_ptr->getUserName() << std::endl;
-        }
+        printNewChatParticipants(chatSystem, activeUserId, participants);
 
       } // try
       catch (const ValidationException &ex) {
@@ -173,29 +199,10 @@ void LoginMenu_1NewChatMakeParticipants(ChatSystem &chatSystem, std::shared_ptr<
           continue;
         }
 
-        // проверяем на наличие недопустимых символов
-        std::size_t utf8SymbolCount = 0;
-        for (int i = 0; i < inputData.size();) {
-
-          std::size_t charLen = getUtf8CharLen(static_cast<unsigned char>(inputData[i]));
-
-          if (i + charLen > inputData.size())
-            throw InvalidCharacterException("");
-
-          std::string utf8Char = inputData.substr(i, charLen);
-
-          ++utf8SymbolCount;
-
-          if (charLen == 1) {
-            char ch = utf8Char[0];
-            if (!std::isdigit(ch) && static_cast<unsigned char>(ch) != ',')
-              throw InvalidCharacterException(utf8Char);
-          } // if
-          else
-            throw InvalidCharacterException(utf8Char);
-
-          i += charLen;
-        }
+        // только цифры и запятые
+        Utf8ScanResult scan = scanUtf8(inputData, UTF8_CLASS_DIGIT, ",");
+        if (!scan.isValid())
+          throw InvalidCharacterException(std::string(scan.rejectedChar(inputData)));
 
         // проверки
         // std::cout << activeUserIndex << std::endl;
@@ -254,16 +261,11 @@ void LoginMenu_1NewChatMakeParticipants(ChatSystem &chatSystem, std::shared_ptr<
 
         // заполняем вектор участников
         for (const auto &recipient : recipientIndex) {
-          chat->addParticipant(chatSystem.getUsers()[recipient]);
+          participants.push_back(chatSystem.getUsers()[recipient]->getUserId());
         }
 
         // проверки
-
-        std::cout << "Участники чата: " << std::endl;
-        for (const auto &user : chat->getParticipants()) {
-          auto user_ptr = user._user.lock();
-          std::cout << user_ptr->getLogin() << " ака " << user_ptr->getUserName() << std::endl;
-        }
+        printNewChatParticipants(chatSystem, activeUserId, participants);
       } // try
       catch (const ValidationException &ex) {
         std::cout << " ! " << ex.what() << " Попробуйте еще раз." << std::endl;
@@ -276,8 +278,8 @@ void LoginMenu_1NewChatMakeParticipants(ChatSystem &chatSystem, std::shared_ptr<
   case MessageTarget::All: {
     // заполняем вектор участников чата
     for (const auto &user : chatSystem.getUsers())
-      if (user != chatSystem.getActiveUser()) {
-        chat->addParticipant(user);
+      if (user->getUserId() != activeUserId) {
+        participants.push_back(user->getUserId());
       }
 
     return; // case All
@@ -289,70 +291,57 @@ void LoginMenu_1NewChatMakeParticipants(ChatSystem &chatSystem, std::shared_ptr<
 /**
  * @brief Creates and sends a message to a new chat.
  * @param chatSystem Reference to the chat system.
- * @param chat Shared pointer to the new chat.
+ * @param sessionId Session of the active user.
  * @param activeUserIndex Index of the active user.
  * @param target Target type for the message (e.g., individual, several, or all).
- * @throws BadWeakException If a weak_ptr cannot be locked.
- * @throws ValidationException If message input fails validation.
- * @details Manages participant selection, message input, and chat integration into the system.
+ * @details Manages participant selection and message input; the chat is created through
+ * ChatService only when the first message is typed, so a cancelled chat leaves no trace.
  */
-void CreateAndSendNewChat(ChatSystem &chatSystem, std::shared_ptr<Chat> &chat, std::size_t activeUserIndex,
+void CreateAndSendNewChat(ChatSystem &chatSystem, SessionId sessionId, std::size_t activeUserIndex,
                           MessageTarget target) {
 
-  LoginMenu_1NewChatMakeParticipants(chatSystem, chat, activeUserIndex, target);
+  std::vector<UserId> participants;
+  LoginMenu_1NewChatMakeParticipants(chatSystem, sessionId, participants, activeUserIndex, target);
 
   // создаем сообщение
   std::cout << std::endl << "Вот твой чат. В нем всего 0 сообщения(ий). " << std::endl;
 
-  bool exitCase2 = true;
-  std::size_t unReadCount = 0;
+  ChatService chatService(chatSystem);
+  bool chatCreated = false;
+  std::size_t chatId = 0;
+  std::size_t messageId;
+  std::string inputData;
 
-  while (exitCase2) {
-    try {
-      if (inputNewMessage(chatSystem, chat) == false) { // пользователь решмил не вводить сообщение
-        exitCase2 = false;
-      } else { // пользователь ввел сообщение
-        if (unReadCount == 0) {
-          // добавили в головную систему чтобы не потерять чат при выходе из метода
-          chatSystem.addChat(chat);
-
-          // добавили каждому участнику чат в чат-лист
-          for (const auto &user : chat->getParticipants()) {
-            auto user_ptr = user._user.lock();
-            if (user_ptr) {
-              user_ptr->getUserChatList()->addChat(chat);
-            } else
-              throw BadWeakException("LoginMenu_1NewChat");
-          }
-        }
-        ++unReadCount;
+  while (inputMessageText(inputData)) {
+    ServiceStatus status = ServiceStatus::Ok;
+    if (!chatCreated) {
+      status = chatService.createChat(sessionId, participants, chatId);
+      chatCreated = status == ServiceStatus::Ok;
+    }
+    if (status == ServiceStatus::Ok)
+      status = chatService.sendMessage(sessionId, chatId, inputData, messageId);
 
-        // проверки
-        // chat->printChat(chatSystem.getActiveUser());
-        // std::cout << std::endl;
-      }; // else
-    } // try
-    catch (const ValidationException &ex) {
-      std::cout << " ! " << ex.what() << std::endl;
+    if (status != ServiceStatus::Ok) {
+      std::cout << " ! " << getStatusText(status) << std::endl;
+      if (!chatCreated)
+        return; // без участников чат не создать
     }
-  } // while case 2
+  } // while
 }
 
 /**
  * @brief Initiates the creation of a new chat.
  * @param chatSystem Reference to the chat system.
+ * @param sessionId Session of the active user.
  * @throws EmptyInputException If input is empty.
  * @throws IndexOutOfRangeException If input is not 0, 1, 2, or 3.
  * @details Provides a menu for selecting the type of new chat (one user, several users, or all users).
  */
-void LoginMenu_1NewChat(ChatSystem &chatSystem) { // создание нового сообщения
+void LoginMenu_1NewChat(ChatSystem &chatSystem, SessionId sessionId) { // создание нового сообщения
 
   std::string userChoice;
   size_t userChoiceNumber;
   bool exit = true;
-  // создали новый чат
-  auto chat = std::make_shared<Chat>();
-
   while (exit) {
     std::cout << "Хотите: " << std::endl
               << "1. Найти пользователя и отправить ему сообщение" << std::endl
@@ -378,7 +367,7 @@ void LoginMenu_1NewChat(ChatSystem &chatSystem) { // создание новог
       switch (userChoiceNumber) {
 
       case 1: { // 1. Найти пользователя и отправить ему сообщение
-        CreateAndSendNewChat(chatSystem, chat, 0, MessageTarget::One);
+        CreateAndSendNewChat(chatSystem, sessionId, 0, MessageTarget::One);
 
         exit = false; // выход в верхнее меню так как новый чат уже не новый
         break;        // case 1
@@ -386,16 +375,16 @@ void LoginMenu_1NewChat(ChatSystem &chatSystem) { // создание новог
       case 2: { // 2. Вывести список пользователей и отправить нескольким пользователям
 
         // запомнили номер активного пользователя
-        auto activeUserIndex = chatSystem.showUserList(false);
+        auto activeUserIndex = chatSystem.showUserList(chatSystem.getSessions().getUserId(sessionId), false);
 
-        CreateAndSendNewChat(chatSystem, chat, activeUserIndex, MessageTarget::Several);
+        CreateAndSendNewChat(chatSystem, sessionId, activeUserIndex, MessageTarget::Several);
 
         exit = false; // выход в верхнее меню так как новый чат уже не новый
         break;        // case 2
       }
       case 3: { // 3. Отправить сообщение всем пользователям
 
-        CreateAndSendNewChat(chatSystem, chat, 0, MessageTarget::All);
+        CreateAndSendNewChat(chatSystem, sessionId, 0, MessageTarget::All);
         exit = false; // выход в верхнее меню так как новый чат уже не новый
         break;        // case 3
       }
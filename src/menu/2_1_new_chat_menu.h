@@ -1,32 +1,33 @@
 #pragma once
 #include "ChatBot/chat_system.h"
 #include "system/system_function.h"
+#include <vector>
 
 /**
  * @brief Creates a new chat by selecting participants.
  * @param chatSystem Reference to the chat system.
- * @param chat Shared pointer to the chat being created.
+ * @param participants Receives the handles of the chosen users (without the active user).
  * @param activeUserIndex Index of the active user.
  * @param target Target type for the message (e.g., individual or group).
  * @details Facilitates the selection of users to add as participants to a new chat.
  */
-void LoginMenu_1NewChatMakeParticipants(ChatSystem &chatSystem, std::shared_ptr<Chat> &chat,
-                                        std::size_t activeUserIndex,
+void LoginMenu_1NewChatMakeParticipants(ChatSystem &chatSystem, SessionId sessionId,
+                                        std::vector<UserId> &participants, std::size_t activeUserIndex,
                                         MessageTarget target); // создение нового сообщения путем выбора пользователей
 
 /**
  * @brief Creates and sends a message to a new chat.
  * @param chatSystem Reference to the chat system.
  * @param activeUserIndex Index of the active user.
- * @param sendToAll True if the message should be sent to all users.
+ * @param target Target type for the message (e.g., individual, several, or all).
  * @details Handles the creation of a new chat and sending a message, supporting different sending modes.
  */
-void CreateAndSendNewChat(ChatSystem &chatSystem, std::size_t activeUserIndex,
-                          bool sendToAll); // общая функция для отправки сообщения в новый чат тремя способами
+void CreateAndSendNewChat(ChatSystem &chatSystem, SessionId sessionId, std::size_t activeUserIndex,
+                          MessageTarget target); // общая функция для отправки сообщения в новый чат тремя способами
 
 /**
  * @brief Initiates the creation of a new chat.
  * @param chatSystem Reference to the chat system.
  * @details Provides the interface for starting the process of creating a new chat.
  */
-void LoginMenu_1NewChat(ChatSystem &chatSystem); // создание нового сообщения
+void LoginMenu_1NewChat(ChatSystem &chatSystem, SessionId sessionId); // создание нового сообщения
@@ -1,44 +1,164 @@
 #include "ChatBot/chat_system.h"
 #include "exception/validation_exception.h"
 #include "system/system_function.h"
+#include "message/message_search_index.h"
+#include "service/chat_service.h"
 #include "user/user_chat_list.h"
 #include <iostream>
 
+namespace {
+
+const std::size_t MESSAGE_SEARCH_SHOWN = 20; ///< Сколько последних найденных сообщений выводить.
+
+/**
+ * @brief Asks for a message search query.
+ * @param query Receives the parsed query.
+ * @return False if the user cancelled with 0.
+ */
+bool inputMessageQuery(MessageQuery &query) {
+  std::string inputData;
+  while (true) {
+    std::cout << "Введите слова для поиска (слово* - начало слова, \"фраза\" - слова подряд) или 0 для отмены: "
+              << std::endl;
+    std::getline(std::cin, inputData);
+
+    try {
+      if (inputData.empty())
+        throw EmptyInputException();
+      if (inputData == "0")
+        return false;
+
+      query = parseMessageQuery(inputData);
+      return true;
+    } catch (const ValidationException &ex) {
+      std::cout << " ! " << ex.what() << " Попробуйте еще раз." << std::endl;
+    }
+  }
+}
+
+} // namespace
+
 void deleteLastMessage(ChatSystem &chatSystem, std::shared_ptr<Chat> chat) {
   //  if (chat->getMessages().size() == 0)
   // };
 }
 
+/**
+ * @brief Searches the messages of one chat.
+ * @param chatSystem Reference to the chat system.
+ * @param sessionId Session of the active user.
+ * @param chat Shared pointer to the chat to search.
+ */
+void loginMenu_2SearchChat(ChatSystem &chatSystem, SessionId sessionId, const std::shared_ptr<Chat> &chat) {
+  MessageQuery query;
+  if (!inputMessageQuery(query))
+    return;
+
+  std::vector<std::size_t> messageIndexes;
+  chat->findMessages(query, messageIndexes);
+
+  if (messageIndexes.empty()) {
+    std::cout << "Сообщений не найдено." << std::endl;
+    return;
+  }
+
+  auto activeUser = chatSystem.getSessionUser(sessionId);
+  auto &screen = chatSystem.getScreen();
+  std::size_t first = messageIndexes.size() > MESSAGE_SEARCH_SHOWN ? messageIndexes.size() - MESSAGE_SEARCH_SHOWN : 0;
+  screen << "Найдено сообщений: " << messageIndexes.size() << ". Последние " << messageIndexes.size() - first << ":\n";
+  const auto &messages = chat->getMessages();
+  for (std::size_t i = first; i < messageIndexes.size(); ++i)
+    messages[messageIndexes[i]].printMessage(screen, chat->getUserTable(), activeUser);
+  screen.flush();
+}
+
+/**
+ * @brief Searches the messages of all chats of the active user.
+ * @param chatSystem Reference to the chat system.
+ * @param sessionId Session of the active user.
+ */
+void loginMenu_2SearchAllChats(ChatSystem &chatSystem, SessionId sessionId) {
+  MessageQuery query;
+  if (!inputMessageQuery(query))
+    return;
+
+  auto activeUser = chatSystem.getSessionUser(sessionId);
+  std::vector<MessageSearchHit> hits;
+  chatSystem.findMessagesInUserChats(activeUser, query, hits);
+
+  if (hits.empty()) {
+    std::cout << "Сообщений не найдено." << std::endl;
+    return;
+  }
+
+  // из каждого чата выводим не больше MESSAGE_SEARCH_SHOWN последних
+  auto &screen = chatSystem.getScreen();
+  screen << "Найдено сообщений: " << hits.size() << '\n';
+  std::size_t chatBegin = 0;
+  while (chatBegin < hits.size()) {
+    const auto &chat = hits[chatBegin]._chat;
+    std::size_t chatEnd = chatBegin;
+    while (chatEnd < hits.size() && hits[chatEnd]._chat == chat)
+      ++chatEnd;
+
+    std::size_t first = chatEnd - chatBegin > MESSAGE_SEARCH_SHOWN ? chatEnd - MESSAGE_SEARCH_SHOWN : chatBegin;
+    screen << "\nchatId чата: " << chat->getChatId() << ", найдено " << chatEnd - chatBegin << ":\n";
+    const auto &messages = chat->getMessages();
+    for (std::size_t i = first; i < chatEnd; ++i)
+      messages[hits[i]._messageIndex].printMessage(screen, chat->getUserTable(), activeUser);
+
+    chatBegin = chatEnd;
+  }
+  screen.flush();
+}
+
 /**
  * @brief Manages interactions with a specific chat.
  * @param chatSystem Reference to the chat system.
+ * @param sessionId Session of the active user; remembers the shown window.
  * @param chat Shared pointer to the chat to be edited.
  * @throws EmptyInputException If input is empty.
- * @throws IndexOutOfRangeException If input is not 0, 1, 2, 3, 4, or 5.
- * @details Displays chat details, participants, and messages, and provides options to send messages or perform other
- * actions (some under construction).
+ * @throws IndexOutOfRangeException If input is not a number from 0 to 8.
+ * @details Displays chat details, participants, and a window of messages starting at the first unread one, and
+ * provides options to send messages, page through the chat or perform other actions (some under construction).
  */
-void loginMenu_2EditChat(ChatSystem &chatSystem, const std::shared_ptr<Chat> &chat /*, std::size_t unReadCountIndex*/) {
+void loginMenu_2EditChat(ChatSystem &chatSystem, SessionId sessionId,
+                         const std::shared_ptr<Chat> &chat /*, std::size_t unReadCountIndex*/) {
 
   std::string userChoice;
   size_t userChoiceNumber;
   bool exit = true;
 
-  while (exit) {
-    auto messageCount = chat->getMessages().size();
+  auto activeUser = chatSystem.getSessionUser(sessionId);
+  if (!activeUser)
+    return;
+  auto &screen = chatSystem.getScreen();
+  ChatService chatService(chatSystem);
 
-    chat->printChat(chatSystem.getActiveUser());
-    chat->updateLastReadMessageIndex(chatSystem.getActiveUser(), messageCount);
-    std::cout << std::endl;
+  // чат открывается на первом непрочитанном сообщении
+  std::size_t windowFirst = chat->getFirstUnreadWindow(activeUser);
 
-    std::cout << std::endl;
-    std::cout << "Что будем делать? " << std::endl;
-    std::cout << "1 - написать сообщение" << std::endl;
-    std::cout << "2 - удалить последнее отправленное сообщение - Under constraction" << std::endl;
-    std::cout << "3 - очистить чат (удвлить все сообщения) - Under constraction" << std::endl;
-    std::cout << "4 - выйти из чата - Under constraction" << std::endl;
-    std::cout << "5 - поиск сообщений внутри чата - Under constraction" << std::endl;
-    std::cout << "0 - Выйти в предыдущее меню" << std::endl;
+  while (exit) {
+    // окно чата и меню выводятся на экран одной записью
+    auto windowEnd = chat->printChat(screen, activeUser, windowFirst);
+    chatSystem.getSessions().setChatWindow(sessionId, chat->getChatId(), windowFirst);
+
+    // прочитанными считаются только показанные сообщения
+    if (windowEnd > chat->getLastReadMessageIndex(activeUser))
+      chatService.markRead(sessionId, chat->getChatId(), windowEnd);
+
+    screen << "\n\n";
+    screen << "Что будем делать? \n";
+    screen << "1 - написать сообщение\n";
+    screen << "2 - удалить последнее отправленное сообщение - Under constraction\n";
+    screen << "3 - очистить чат (удвлить все сообщения) - Under constraction\n";
+    screen << "4 - выйти из чата - Under constraction\n";
+    screen << "5 - поиск сообщений внутри чата\n";
+    screen << "6 - предыдущие " << CHAT_WINDOW_SIZE << " сообщений\n";
+    screen << "7 - перейти к первому непрочитанному\n";
+    screen << "8 - последние сообщения\n";
+    screen << "0 - Выйти в предыдущее меню\n";
+    screen.flush();
 
     bool exit2 = true;
     while (exit2) {
@@ -49,23 +169,22 @@ void loginMenu_2EditChat(ChatSystem &chatSystem, const std::shared_ptr<Chat> &ch
         if (userChoice.empty())
           throw EmptyInputException();
 
-        if (userChoice == "0")
+        if (userChoice == "0") {
+          chatSystem.getSessions().setChatWindow(sessionId, 0, 0);
           return;
+        }
 
         userChoiceNumber = parseGetlineToInt(userChoice);
 
-        if (userChoiceNumber < 1 || userChoiceNumber > 5)
+        if (userChoiceNumber < 1 || userChoiceNumber > 8)
           throw IndexOutOfRangeException(userChoice);
 
         switch (userChoiceNumber) {
         case 1:
-          inputNewMessage(chatSystem, chat);
-          chat->updateLastReadMessageIndex(chatSystem.getActiveUser(), messageCount + 1);
-          std::cout << std::endl;
-
-          chat->printChat(chatSystem.getActiveUser());
+          inputNewMessage(chatSystem, sessionId, chat);
           std::cout << std::endl;
 
+          windowFirst = chat->getLastWindow();
           exit2 = false;
           break; // case 1
         case 2:
@@ -79,8 +198,26 @@ void loginMenu_2EditChat(ChatSystem &chatSystem, const std::shared_ptr<Chat> &ch
           break; // case 4
         }
         case 5:
-          std::cout << "5 - поиск сообщений внутри чата - Under constraction" << std::endl;
+          loginMenu_2SearchChat(chatSystem, sessionId, chat);
+          std::cout << std::endl << "Выберите пункт меню (0 - выйти в предыдущее меню):" << std::endl;
           break; // case 5
+        case 6:
+          if (windowFirst == 0) {
+            std::cout << "Это начало чата." << std::endl;
+            break;
+          }
+          // листаем назад от первого показанного сообщения
+          windowFirst = chat->getWindowBefore(chat->getMessages()[windowFirst].getMessageId());
+          exit2 = false;
+          break; // case 6
+        case 7:
+          windowFirst = chat->getFirstUnreadWindow(activeUser);
+          exit2 = false;
+          break; // case 7
+        case 8:
+          windowFirst = chat->getLastWindow();
+          exit2 = false;
+          break; // case 8
         default:
           break; // default
         } // switch
@@ -96,40 +233,50 @@ void loginMenu_2EditChat(ChatSystem &chatSystem, const std::shared_ptr<Chat> &ch
 /**
  * @brief Displays the list of chats for the active user.
  * @param chatSystem Reference to the chat system.
+ * @param sessionId Session of the active user.
  * @throws EmptyInputException If input is empty.
  * @throws IndexOutOfRangeException If input is not a valid chat index or 0.
  * @throws ChatNotFoundException If the selected chat cannot be accessed.
  * @details Shows the user's chat list and allows selection of a chat to edit or view.
  */
-void loginMenu_2ChatList(ChatSystem &chatSystem) { // показать список чатов
+void loginMenu_2ChatList(ChatSystem &chatSystem, SessionId sessionId) { // показать список чатов
 
-  auto chatCount = chatSystem.getActiveUser()
-                       ->getUserChatList()
-                       ->getChatFromList()
-                       .size(); // количество чатов у пользователя
+  auto activeUser = chatSystem.getSessionUser(sessionId);
+  if (!activeUser)
+    return;
+  auto &screen = chatSystem.getScreen();
+  auto chatCount = activeUser->getUserChatList()->getInbox().size(); // количество чатов у пользователя
 
   std::cout << std::endl;
 
-  if (chatSystem.getActiveUser()->getUserChatList()->getChatFromList().empty()) {
+  if (chatCount == 0) {
     std::cout << "У пользователя пока нет чатов" << std::endl;
     return;
-  } else {
-    chatSystem.getActiveUser()->printChatList(chatSystem.getActiveUser()); // определяем текущего пользователя
-    std::cout << std::endl;
   }
 
+  // страница списка: чаты с последней активностью сверху
+  std::size_t pageOffset = 0;
+  std::vector<std::shared_ptr<Chat>> shownChats;
+  bool hasMorePages = activeUser->printChatList(screen, activeUser, pageOffset, shownChats);
+  screen << '\n';
+
   std::string userChoice;
   int userChoiceNumber;
   bool exit2 = true;
 
   while (true) {
 
-    std::cout << "Выберите пункт меню: " << std::endl;
-    std::cout << "От 1 до " << chatCount << " - Чтобы открыть чат введите его номер (всего " << chatCount
-              << " чата(ов)): " << std::endl;
-    std::cout << "f - Поиск по чатам. Under constraction." << std::endl;
-    std::cout << "0 - Выйти в предыдущее меню" << std::endl;
-
+    // список чатов и меню выводятся на экран одной записью
+    screen << "Выберите пункт меню: \n";
+    screen << "От " << pageOffset + 1 << " до " << pageOffset + shownChats.size()
+           << " - Чтобы открыть чат введите его номер (всего " << chatCount << " чата(ов)): \n";
+    if (hasMorePages)
+      screen << "+ - Следующие " << INBOX_PAGE_SIZE << " чатов\n";
+    screen << "f - Поиск сообщений по всем чатам\n";
+    screen << "0 - Выйти в предыдущее меню\n";
+    screen.flush();
+
+    exit2 = true;
     while (exit2) {
       std::getline(std::cin, userChoice);
 
@@ -142,7 +289,17 @@ void loginMenu_2ChatList(ChatSystem &chatSystem) { // показать спис
           return;
 
         if (userChoice == "f") {
-          std::cout << "f - Поиск по чатам. Under constraction." << std::endl;
+          loginMenu_2SearchAllChats(chatSystem, sessionId);
+          std::cout << std::endl;
+          exit2 = false;
+          continue;
+        }
+
+        // следующая страница списка
+        if (userChoice == "+" && hasMorePages) {
+          pageOffset += shownChats.size();
+          hasMorePages = activeUser->printChatList(screen, activeUser, pageOffset, shownChats);
+          screen << '\n';
           exit2 = false;
           continue;
         }
@@ -150,19 +307,16 @@ void loginMenu_2ChatList(ChatSystem &chatSystem) { // показать спис
         // вход в конкретный чат
         userChoiceNumber = parseGetlineToInt(userChoice);
 
-        if (userChoiceNumber < 0 || userChoiceNumber > static_cast<int>(chatCount))
+        if (userChoiceNumber <= static_cast<int>(pageOffset) ||
+            userChoiceNumber > static_cast<int>(pageOffset + shownChats.size()))
           throw IndexOutOfRangeException(userChoice);
 
-        // здесь мы достаем из вектора количество непрочитанных сообщениотображения на экране
-        auto chatList = chatSystem.getActiveUser()->getUserChatList()->getChatFromList(); // weak указатель на вектор
-
-        auto activeChat_weak = chatList[userChoiceNumber - 1];
-        auto activeChat_ptr = activeChat_weak.lock();
+        auto activeChat_ptr = shownChats[userChoiceNumber - pageOffset - 1];
 
         if (!activeChat_ptr)
           throw ChatNotFoundException();
         else
-          loginMenu_2EditChat(chatSystem, activeChat_ptr);
+          loginMenu_2EditChat(chatSystem, sessionId, activeChat_ptr);
         return;
       } catch (const ValidationException &ex) {
         std::cout << " ! " << ex.what() << " Попробуйте еще раз." << std::endl;
@@ -171,4 +325,4 @@ void loginMenu_2ChatList(ChatSystem &chatSystem) { // показать спис
     } // second while
 
   } // первый while
-}
\ No newline at end of file
+}
@@ -14,7 +14,22 @@ void deleteLastMessage(ChatSystem &chatSystem, std::shared_ptr<Chat> chat);
  * @param chatSystem Reference to the chat system.
  * @details Shows available chats and allows the user to interact with them.
  */
-void loginMenu_2ChatList(ChatSystem &chatSystem);
+void loginMenu_2ChatList(ChatSystem &chatSystem, SessionId sessionId);
+
+/**
+ * @brief Searches the messages of one chat.
+ * @param chatSystem Reference to the chat system.
+ * @param chat Shared pointer to the chat to search.
+ * @details Asks for a query until it is valid or cancelled with 0 and prints the latest matches.
+ */
+void loginMenu_2SearchChat(ChatSystem &chatSystem, SessionId sessionId, const std::shared_ptr<Chat> &chat);
+
+/**
+ * @brief Searches the messages of all chats of the active user.
+ * @param chatSystem Reference to the chat system.
+ * @details Asks for a query until it is valid or cancelled with 0 and prints the latest matches.
+ */
+void loginMenu_2SearchAllChats(ChatSystem &chatSystem, SessionId sessionId);
 
 /**
  * @brief Edits or manages a specific chat.
@@ -22,4 +37,5 @@ void loginMenu_2ChatList(ChatSystem &chatSystem);
  * @param chat Shared pointer to the chat to be edited.
  * @details Provides options to modify or interact with the specified chat.
  */
-void loginMenu_2EditChat(ChatSystem &chatSystem, const std::shared_ptr<Chat> &chat /*, std::size_t unReadCountIndex*/);
\ No newline at end of file
+void loginMenu_2EditChat(ChatSystem &chatSystem, SessionId sessionId,
+                         const std::shared_ptr<Chat> &chat /*, std::size_t unReadCountIndex*/);
\ No newline at end of file
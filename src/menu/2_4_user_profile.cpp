@@ -9,42 +9,46 @@
 /**
  * @brief Changes the username of the active user.
  * @param chatSystem Reference to the chat system.
+ * @param sessionId Session of the active user.
  * @details Prompts for a new username, validates it, and updates the user's name.
  */
-void userNameChange(ChatSystem &chatSystem) { // смена имени пользователя
+void userNameChange(ChatSystem &chatSystem, SessionId sessionId) { // смена имени пользователя
 
   UserData userData;
 
   std::string newName = inputNewName(chatSystem);
-  if (newName.empty())
+  auto activeUser = chatSystem.getSessionUser(sessionId);
+  if (newName.empty() || !activeUser)
     return;
 
-  chatSystem.getActiveUser()->setUserName(newName);
+  activeUser->setUserName(newName);
 
-  std::cout << "Имя изменено. Логин  = " << chatSystem.getActiveUser()->getLogin()
-            << " и Имя = " << chatSystem.getActiveUser()->getUserName() << std::endl;
+  std::cout << "Имя изменено. Логин  = " << activeUser->getLogin()
+            << " и Имя = " << activeUser->getUserName() << std::endl;
 }
 
 /**
  * @brief Changes the password of the active user.
  * @param chatSystem Reference to the chat system.
+ * @param sessionId Session of the active user.
  * @details Prompts for a new password, validates it, and updates the user's password.
  */
-void userPasswordChange(ChatSystem &chatSystem) { // смена пароля пользователя
+void userPasswordChange(ChatSystem &chatSystem, SessionId sessionId) { // смена пароля пользователя
 
   UserData userData;
 
   std::string newPassword = inputNewPassword(chatSystem);
-  if (newPassword.empty())
+  auto activeUser = chatSystem.getSessionUser(sessionId);
+  if (newPassword.empty() || !activeUser)
     return;
 
   const auto &userPasswordHash = picosha2::hash256_hex_string(newPassword);
 
-  chatSystem.getActiveUser()->setPassword(userPasswordHash);
+  activeUser->setPassword(userPasswordHash);
 
-  std::cout << "Пароль изменен. Логин = " << chatSystem.getActiveUser()->getLogin()
-            << " и Имя = " << chatSystem.getActiveUser()->getUserName()
-            << " и Пароль = " << chatSystem.getActiveUser()->getPassword() << std::endl;
+  std::cout << "Пароль изменен. Логин = " << activeUser->getLogin()
+            << " и Имя = " << activeUser->getUserName()
+            << " и Пароль = " << activeUser->getPassword() << std::endl;
 }
 
 /**
@@ -85,18 +89,23 @@ void userChatDeleteAll(ChatSystem &chatSystem) {
 /**
  * @brief Displays and manages the user profile menu.
  * @param chatSystem Reference to the chat system.
+ * @param sessionId Session of the active user.
  * @throws EmptyInputException If input is empty.
  * @throws IndexOutOfRangeException If input is not 0, 1, 2, 3, 4, 5, or 6.
  * @details Shows profile options and handles user actions like changing name or password; some features are under
  * construction.
  */
-void loginMenu_4UserProfile(ChatSystem &chatSystem) {
+void loginMenu_4UserProfile(ChatSystem &chatSystem, SessionId sessionId) {
   int userChoiceNumber;
   std::string userChoice;
 
   while (true) {
+    auto activeUser = chatSystem.getSessionUser(sessionId);
+    if (!activeUser)
+      return;
+
     std::cout << std::endl;
-    std::cout << "Добрый день, пользователь " << chatSystem.getActiveUser()->getUserName() << std::endl;
+    std::cout << "Добрый день, пользователь " << activeUser->getUserName() << std::endl;
     std::cout << std::endl;
     std::cout << "Выберите пункт меню: " << std::endl;
     std::cout << "1 - Сменить имя пользователя (не логин)" << std::endl;
@@ -125,11 +134,11 @@ void loginMenu_4UserProfile(ChatSystem &chatSystem) {
 
         switch (userChoiceNumber) {
         case 1:
-          userNameChange(chatSystem); // 2 - Сменить пароль
+          userNameChange(chatSystem, sessionId); // 2 - Сменить пароль
           exit2 = false;
           break; // case 1 MainMenu
         case 2:
-          userPasswordChange(chatSystem);
+          userPasswordChange(chatSystem, sessionId);
           exit2 = false;
           break; // case 2 MainMenu
         case 3:  // 3 - Удалить все чаты пользователя - Under constraction.
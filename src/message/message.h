@@ -1,5 +1,6 @@
 #pragma once
 #include "message/message_content.h"
+#include "system/date_time_utils.h"
 #include "user/user.h"
 #include <memory>
 #include <string>
@@ -21,20 +22,20 @@ public:
  */
 class Message : public IMessage {
 private:
-  std::vector<std::shared_ptr<IMessageContent>> _content; ///< Vector of message content.
-  std::weak_ptr<User> _sender;                            ///< Sender of the message.
-  std::string _time_stamp;                                ///< Timestamp of the message (to be implemented).
+  std::vector<MessageContent> _content; ///< Content parts, stored inline.
+  UserId _sender;                       ///< Sender of the message.
+  TimeStamp _timeStamp;                 ///< Time the message was sent.
   std::size_t _messageId;
 
 public:
   /**
    * @brief Constructor for Message.
-   * @param content Vector of shared pointers to message content.
-   * @param sender Weak pointer to the sender user.
+   * @param content Content parts of the message.
+   * @param sender Handle of the sender.
    * @param timeStamp Timestamp of the message.
    */
-  Message(const std::vector<std::shared_ptr<IMessageContent>> &content, const std::weak_ptr<User> &sender,
-          const std::string &timeStamp, std::size_t messageId);
+  Message(std::vector<MessageContent> content, UserId sender,
+          TimeStamp timeStamp, std::size_t messageId);
 
   /**
    * @brief Default destructor.
@@ -50,38 +51,31 @@ public:
    * @brief Gets the content of the message.
    * @return Const reference to the vector of message content.
    */
-  const std::vector<std::shared_ptr<IMessageContent>> &getContent() const;
+  const std::vector<MessageContent> &getContent() const;
 
   /**
    * @brief Gets the sender of the message.
-   * @return Weak pointer to the sender user.
+   * @return Handle of the sender.
    */
-  std::weak_ptr<User> getSender() const;
+  UserId getSender() const;
 
   /**
    * @brief Gets the timestamp of the message.
-   * @return Const reference to the timestamp string.
+   * @return Milliseconds since the epoch.
    */
-  const std::string &getTimeStamp() const;
+  TimeStamp getTimeStamp() const;
 
   /**
    * @brief Adds content to the message.
-   * @param content Shared pointer to the content to be added.
+   * @param content The content part to be added.
    */
-  void addContent(const std::shared_ptr<IMessageContent> &content);
+  void addContent(MessageContent content);
 
   /**
    * @brief Adds messageId to the message.
    */
   void addMessageId(std::size_t messageId);
 
-  /**
-   * @brief Prints the message for a specific user.
-   * @param currentUser Shared pointer to the user viewing the message.
-   * @note Contains a typo in the parameter name (¤tUser).
-   */
-  void printMessage(const std::shared_ptr<User> &currentUser);
-
   // add content to the message
   // delete message will be realized further
 
@@ -1,48 +1,58 @@
 #pragma once
+#include "message/message_content_struct.h"
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <variant>
 
 /**
- * @brief Interface for message content types.
+ * @brief Kinds of message content parts.
+ * @details The value of a kind is the index of its type in MessageContent plus one.
  */
-class IMessageContent { // interface for template MessageContent
-public:
-  /**
-   * @brief Default virtual destructor.
-   */
-  virtual ~IMessageContent() = default;
-};
+enum class ContentKind : std::uint8_t { Text = 1, File = 2, Image = 3 };
 
 /**
- * @brief Template class for message content of a specific type.
- * @tparam T The type of content (e.g., TextContent, FileContent, ImageContent).
+ * @brief Closed set of message content types, stored inline without a heap node per part.
+ * @details Adding a type here makes every std::visit over it fail to compile until the
+ * new type is handled, instead of silently skipping it at run time.
  */
-template <typename T> class MessageContent : public IMessageContent {
-private:
-  T _content; // will take type according to the used struct of message content
-
-public:
-  /**
-   * @brief Constructor for MessageContent.
-   * @param content The content of type T to initialize the message.
-   */
-  explicit MessageContent(const T &content) : _content(content) {}; // constructor
+using MessageContent = std::variant<TextContent, FileContent, ImageContent>;
 
-  /**
-   * @brief Gets the message content.
-   * @return Reference to the content of type T.
-   */
-  T &getMessageContent() { return _content; };
+/**
+ * @brief Builds a visitor from a set of lambdas.
+ */
+template <typename... Ts> struct Overloaded : Ts... {
+  using Ts::operator()...;
+};
+template <typename... Ts> Overloaded(Ts...) -> Overloaded<Ts...>;
 
-  /**
-   * @brief Gets the message content (const version).
-   * @return Const reference to the content of type T.
-   */
-  const T &getMessageContent() const { return _content; };
+/**
+ * @brief Gets the kind of a content part.
+ * @param content The content part.
+ * @return Kind used in storage and rendering.
+ */
+inline ContentKind getContentKind(const MessageContent &content) {
+  return static_cast<ContentKind>(content.index() + 1);
+}
 
-  /**
-   * @brief Sets the message content (to be implemented).
-   * @param content The new content of type T.
-   * @details Placeholder for future message editing functionality.
-   */
-  void setMessageContent(const T &content) {}; // for edit of message, will be realized further
-};
+/**
+ * @brief Gets the stored string of a content part (text, file name or image).
+ * @param content The content part.
+ * @return View of the string inside the part.
+ */
+inline std::string_view getContentValue(const MessageContent &content) {
+  return std::visit(Overloaded{[](const TextContent &text) -> std::string_view { return text._text; },
+                               [](const FileContent &file) -> std::string_view { return file._fileName; },
+                               [](const ImageContent &image) -> std::string_view { return image._image; }},
+                    content);
+}
 
+static_assert(std::is_same_v<std::variant_alternative_t<static_cast<std::size_t>(ContentKind::Text) - 1, MessageContent>,
+                             TextContent>,
+              "ContentKind must follow the order of MessageContent");
+static_assert(std::is_same_v<std::variant_alternative_t<static_cast<std::size_t>(ContentKind::File) - 1, MessageContent>,
+                             FileContent>,
+              "ContentKind must follow the order of MessageContent");
+static_assert(std::is_same_v<std::variant_alternative_t<static_cast<std::size_t>(ContentKind::Image) - 1, MessageContent>,
+                             ImageContent>,
+              "ContentKind must follow the order of MessageContent");
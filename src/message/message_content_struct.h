@@ -1,4 +1,5 @@
 #pragma once
+#include "system/date_time_utils.h"
 #include "user/user.h"
 #include <memory>
 #include <string>
@@ -9,7 +10,7 @@
  */
 struct InitDataArray {
   std::string _messageText;                       ///< Text content of the message.
-  std::string _timeStamp;                         ///< Timestamp of the message.
+  TimeStamp _timeStamp;                           ///< Timestamp of the message.
   std::shared_ptr<User> _sender;                  ///< Sender of the message.
   std::vector<std::shared_ptr<User>> _recipients; ///< List of message recipients.
   std::size_t _messageId;
@@ -21,7 +22,7 @@ struct InitDataArray {
    * @param sender Shared pointer to the sender user.
    * @param _recipients Vector of shared pointers to recipient users.
    */
-  InitDataArray(std::string messageText, std::string timeStamp, std::shared_ptr<User> sender,
+  InitDataArray(std::string messageText, TimeStamp timeStamp, std::shared_ptr<User> sender,
                 std::vector<std::shared_ptr<User>> _recipients, std::size_t messageId);
 
   /**
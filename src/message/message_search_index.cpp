@@ -0,0 +1,239 @@
+#include "message/message_search_index.h"
+#include "exception/validation_exception.h"
+#include "message/message_store.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+/**
+ * @brief Appends the lowercased form of a Cyrillic code point (U+0400..U+04FF).
+ */
+void appendFoldedCyrillic(std::uint32_t codePoint, std::string &word) {
+  if (codePoint >= 0x0410 && codePoint <= 0x042F) // А..Я
+    codePoint += 0x20;
+  else if (codePoint >= 0x0400 && codePoint <= 0x040F) // Ѐ..Џ, в том числе Ё
+    codePoint += 0x50;
+  if (codePoint == 0x0451) // ё ищется как е
+    codePoint = 0x0435;
+
+  word.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+  word.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+}
+
+/**
+ * @brief Gets the length of the UTF-8 sequence starting with a byte.
+ */
+std::size_t sequenceLength(unsigned char lead) {
+  if (lead < 0x80)
+    return 1;
+  if ((lead & 0xE0) == 0xC0)
+    return 2;
+  if ((lead & 0xF0) == 0xE0)
+    return 3;
+  if ((lead & 0xF8) == 0xF0)
+    return 4;
+  return 1;
+}
+
+} // namespace
+
+/**
+ * @brief Splits text into normalized words.
+ * @param text UTF-8 text.
+ * @param onWord Called with every word in order.
+ */
+void tokenizeMessageText(std::string_view text, const std::function<void(const std::string &)> &onWord) {
+  std::string word;
+  std::size_t i = 0;
+  while (i < text.size()) {
+    auto lead = static_cast<unsigned char>(text[i]);
+    std::size_t length = std::min(sequenceLength(lead), text.size() - i);
+    bool letter = false;
+
+    if (length == 1 && ((lead >= '0' && lead <= '9') || (lead >= 'a' && lead <= 'z'))) {
+      word.push_back(static_cast<char>(lead));
+      letter = true;
+    } else if (length == 1 && lead >= 'A' && lead <= 'Z') {
+      word.push_back(static_cast<char>(lead - 'A' + 'a'));
+      letter = true;
+    } else if (length == 2 && (lead == 0xD0 || lead == 0xD1) && (static_cast<unsigned char>(text[i + 1]) & 0xC0) == 0x80) {
+      appendFoldedCyrillic(((lead & 0x1Fu) << 6) | (static_cast<unsigned char>(text[i + 1]) & 0x3Fu), word);
+      letter = true;
+    }
+
+    // любой другой символ заканчивает слово
+    if (!letter && !word.empty()) {
+      onWord(word);
+      word.clear();
+    }
+    i += length;
+  }
+  if (!word.empty())
+    onWord(word);
+}
+
+/**
+ * @brief Parses a search string into a query.
+ * @param text Words, "prefix*" words and "quoted phrases", separated by spaces.
+ * @return The query.
+ * @throws EmptyInputException If the string contains no words.
+ */
+MessageQuery parseMessageQuery(const std::string &text) {
+  MessageQuery query;
+  std::vector<std::string> words;
+  auto collect = [&words](const std::string &word) { words.push_back(word); };
+
+  std::size_t i = 0;
+  while (i < text.size()) {
+    if (text[i] == ' ' || text[i] == '\t') {
+      ++i;
+      continue;
+    }
+
+    std::size_t end;
+    bool quoted = text[i] == '"';
+    if (quoted) {
+      ++i;
+      end = text.find('"', i);
+      if (end == std::string::npos)
+        end = text.size();
+    } else {
+      end = text.find_first_of(" \t", i);
+      if (end == std::string::npos)
+        end = text.size();
+    }
+
+    std::string_view chunk(text.data() + i, end - i);
+    bool prefix = !quoted && !chunk.empty() && chunk.back() == '*';
+    if (prefix)
+      chunk.remove_suffix(1);
+
+    words.clear();
+    tokenizeMessageText(chunk, collect);
+    if (!words.empty()) {
+      MessageQueryClause clause;
+      if (words.size() > 1)
+        clause._kind = MessageQueryClause::Kind::Phrase; // "слово-слово" ищется как фраза
+      else
+        clause._kind = prefix ? MessageQueryClause::Kind::Prefix : MessageQueryClause::Kind::Term;
+      clause._terms = words;
+      query._clauses.push_back(std::move(clause));
+    }
+    i = quoted ? end + 1 : end;
+  }
+
+  if (query._clauses.empty())
+    throw EmptyInputException();
+  return query;
+}
+
+/**
+ * @brief Indexes a message appended to the chat.
+ * @param messageIndex Index of the message in the chat.
+ * @param message The message.
+ */
+void MessageSearchIndex::addMessage(std::size_t messageIndex, const MessageView &message) {
+  std::uint32_t position = 0;
+  auto addWord = [this, messageIndex, &position](const std::string &word) {
+    auto it = _terms.find(word);
+    if (it == _terms.end())
+      it = _terms.emplace(word, PostingList()).first;
+    it->second.push_back({static_cast<std::uint32_t>(messageIndex), position++});
+  };
+
+  for (std::size_t i = 0; i < message.getPartCount(); ++i) {
+    auto part = message.getPart(i);
+    if (part._kind != ContentKind::Text)
+      continue;
+    tokenizeMessageText(part._value, addWord);
+    ++position; // фраза не продолжается в следующей части
+  }
+}
+
+/**
+ * @brief Collects the messages matching one clause.
+ * @param clause The clause.
+ * @param messages Receives the sorted distinct message indexes.
+ */
+void MessageSearchIndex::findClause(const MessageQueryClause &clause, std::vector<std::uint32_t> &messages) const {
+  messages.clear();
+
+  switch (clause._kind) {
+  case MessageQueryClause::Kind::Term: {
+    auto it = _terms.find(clause._terms.front());
+    if (it != _terms.end())
+      for (const auto &posting : it->second)
+        if (messages.empty() || messages.back() != posting._message)
+          messages.push_back(posting._message);
+    return;
+  }
+  case MessageQueryClause::Kind::Prefix: {
+    const std::string &prefix = clause._terms.front();
+    for (auto it = _terms.lower_bound(prefix); it != _terms.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+         ++it)
+      for (const auto &posting : it->second)
+        messages.push_back(posting._message);
+    std::sort(messages.begin(), messages.end());
+    messages.erase(std::unique(messages.begin(), messages.end()), messages.end());
+    return;
+  }
+  case MessageQueryClause::Kind::Phrase: {
+    std::vector<const PostingList *> lists;
+    for (const auto &term : clause._terms) {
+      auto it = _terms.find(term);
+      if (it == _terms.end())
+        return;
+      lists.push_back(&it->second);
+    }
+
+    // перебираем вхождения самого редкого слова и проверяем соседей на своих местах
+    std::size_t anchor = 0;
+    for (std::size_t k = 1; k < lists.size(); ++k)
+      if (lists[k]->size() < lists[anchor]->size())
+        anchor = k;
+
+    for (const auto &posting : *lists[anchor]) {
+      if (posting._position < anchor || (!messages.empty() && messages.back() == posting._message))
+        continue;
+      std::uint32_t start = posting._position - static_cast<std::uint32_t>(anchor);
+
+      bool matched = true;
+      for (std::size_t k = 0; k < lists.size() && matched; ++k)
+        if (k != anchor)
+          matched = std::binary_search(lists[k]->begin(), lists[k]->end(),
+                                       Posting{posting._message, start + static_cast<std::uint32_t>(k)});
+      if (matched)
+        messages.push_back(posting._message);
+    }
+    return;
+  }
+  }
+}
+
+/**
+ * @brief Finds the messages matching a query.
+ * @param query The query.
+ * @param messageIndexes Receives the indexes of the matching messages in ascending order.
+ */
+void MessageSearchIndex::find(const MessageQuery &query, std::vector<std::size_t> &messageIndexes) const {
+  messageIndexes.clear();
+
+  std::vector<std::uint32_t> result;
+  std::vector<std::uint32_t> clauseMessages;
+  std::vector<std::uint32_t> intersection;
+  for (std::size_t c = 0; c < query._clauses.size(); ++c) {
+    findClause(query._clauses[c], clauseMessages);
+    if (c == 0) {
+      result.swap(clauseMessages);
+    } else {
+      intersection.clear();
+      std::set_intersection(result.begin(), result.end(), clauseMessages.begin(), clauseMessages.end(),
+                            std::back_inserter(intersection));
+      result.swap(intersection);
+    }
+    if (result.empty())
+      return;
+  }
+  messageIndexes.assign(result.begin(), result.end());
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class MessageView;
+
+/**
+ * @brief One condition of a message query; all conditions of a query must hold.
+ */
+struct MessageQueryClause {
+  /**
+   * @brief How the terms of a clause are matched.
+   */
+  enum class Kind : std::uint8_t {
+    Term,   ///< The message contains the word.
+    Prefix, ///< The message contains a word starting with the term.
+    Phrase  ///< The message contains the words one after another.
+  };
+
+  Kind _kind = Kind::Term;         ///< Kind of the clause.
+  std::vector<std::string> _terms; ///< Normalized words; one for Term and Prefix.
+};
+
+/**
+ * @brief Parsed message query.
+ */
+struct MessageQuery {
+  std::vector<MessageQueryClause> _clauses; ///< Conditions joined with AND.
+};
+
+/**
+ * @brief Splits text into normalized words.
+ * @param text UTF-8 text.
+ * @param onWord Called with every word in order.
+ * @details A word is a run of Latin letters, digits and Cyrillic letters; anything else
+ * separates words. Words are lowercased, and "ё" is folded into "е".
+ */
+void tokenizeMessageText(std::string_view text, const std::function<void(const std::string &)> &onWord);
+
+/**
+ * @brief Parses a search string into a query.
+ * @param text Words, "prefix*" words and "quoted phrases", separated by spaces.
+ * @return The query.
+ * @throws EmptyInputException If the string contains no words.
+ */
+MessageQuery parseMessageQuery(const std::string &text);
+
+/**
+ * @brief Inverted index over the text parts of the messages of one chat.
+ * @details Every word maps to the list of its (message, position) occurrences. Messages
+ * are only ever appended, so the lists stay sorted without extra work. The dictionary is
+ * ordered, so a prefix query is one range of it.
+ */
+class MessageSearchIndex {
+private:
+  /**
+   * @brief One occurrence of a word.
+   */
+  struct Posting {
+    std::uint32_t _message = 0;  ///< Index of the message in the chat.
+    std::uint32_t _position = 0; ///< Number of the word inside the message.
+
+    bool operator<(const Posting &other) const {
+      return _message < other._message || (_message == other._message && _position < other._position);
+    }
+  };
+
+  using PostingList = std::vector<Posting>;
+
+  std::map<std::string, PostingList, std::less<>> _terms; ///< Word -> occurrences.
+
+  /**
+   * @brief Collects the messages matching one clause.
+   * @param clause The clause.
+   * @param messages Receives the sorted distinct message indexes.
+   */
+  void findClause(const MessageQueryClause &clause, std::vector<std::uint32_t> &messages) const;
+
+public:
+  /**
+   * @brief Indexes a message appended to the chat.
+   * @param messageIndex Index of the message in the chat.
+   * @param message The message.
+   */
+  void addMessage(std::size_t messageIndex, const MessageView &message);
+
+  /**
+   * @brief Finds the messages matching a query.
+   * @param query The query.
+   * @param messageIndexes Receives the indexes of the matching messages in ascending order.
+   */
+  void find(const MessageQuery &query, std::vector<std::size_t> &messageIndexes) const;
+
+  /**
+   * @brief Gets the number of distinct indexed words.
+   */
+  std::size_t getTermCount() const { return _terms.size(); }
+};
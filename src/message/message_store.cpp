@@ -0,0 +1,208 @@
+#include "message/message_store.h"
+#include "message/message.h"
+#include "message/message_content_struct.h"
+#include "user/user_table.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr std::string_view INCOMING_CAPTION = "\033[32m     <- Входящее от Логин/Имя:    "; ///< Зеленый + подпись.
+constexpr std::string_view OUTGOING_CAPTION = "\033[37m-> Исходящее от тебя: ";              ///< Белый + подпись.
+
+} // namespace
+
+/**
+ * @brief Copies a string into the arena.
+ * @param value The string.
+ * @return View of the copy.
+ * @details Strings longer than a regular block get a block of their own.
+ */
+std::string_view TextArena::store(std::string_view value) {
+  if (value.empty())
+    return std::string_view();
+
+  if (value.size() > _available) {
+    std::size_t blockSize = std::max(_nextBlockSize, value.size());
+    _blocks.push_back(std::make_unique<char[]>(blockSize));
+    _allocatedBytes += blockSize;
+    _nextBlockSize = std::min(_nextBlockSize * 2, MAX_BLOCK_SIZE);
+
+    if (blockSize - value.size() < _available) { // в текущем блоке места осталось больше - пишем в новый и не переключаемся
+      std::memcpy(_blocks.back().get(), value.data(), value.size());
+      return std::string_view(_blocks.back().get(), value.size());
+    }
+    _cursor = _blocks.back().get();
+    _available = blockSize;
+  }
+
+  std::memcpy(_cursor, value.data(), value.size());
+  std::string_view copy(_cursor, value.size());
+  _cursor += value.size();
+  _available -= value.size();
+  return copy;
+}
+
+/**
+ * @brief Makes room for strings of a known total size in one block.
+ * @param bytes Total size of the strings that follow.
+ */
+void TextArena::reserve(std::size_t bytes) {
+  if (bytes <= _available)
+    return;
+
+  _blocks.push_back(std::make_unique<char[]>(bytes));
+  _allocatedBytes += bytes;
+  _cursor = _blocks.back().get();
+  _available = bytes;
+}
+
+/**
+ * @brief Gets the total size of the allocated blocks.
+ */
+std::size_t TextArena::getAllocatedBytes() const { return _allocatedBytes; }
+
+/**
+ * @brief Gets a content part.
+ * @param index Index of the part, less than getPartCount().
+ */
+MessagePart MessageView::getPart(std::size_t index) const {
+  std::size_t partIndex = _header->_firstPart + index;
+  const auto &part = _store->_partChunks[partIndex >> MessageStore::CHUNK_SHIFT][partIndex & MessageStore::CHUNK_MASK];
+  return {part._kind, std::string_view(part._value, part._size)};
+}
+
+/**
+ * @brief Prints the message for a specific user.
+ * @param screen Buffer of the screen being composed.
+ * @param users Table resolving the sender.
+ * @param currentUser Shared pointer to the user viewing the message.
+ * @details Displays the message with formatting based on whether it is incoming or outgoing, including sender details
+ * and content. The color and the caption are written as one precomputed piece.
+ */
+void MessageView::printMessage(ScreenBuffer &screen, const UserTable &users,
+                               const std::shared_ptr<User> &currentUser) const {
+
+  // определили отправителя
+  const User *sender_ptr = users.get(getSender());
+
+  // определили направление сообщения
+  bool messageDirection;
+
+  if (sender_ptr == nullptr) {
+    messageDirection = false;
+  } else
+    messageDirection = (sender_ptr == currentUser.get());
+
+  if (!messageDirection) { // income Message
+
+    if (sender_ptr != nullptr) {
+      screen << INCOMING_CAPTION << sender_ptr->getLogin() << '/' << sender_ptr->getUserName() << "    "
+             << formatTimeStamp(getTimeStamp()) << ", messageId: " << _header->_messageId << '\n';
+    } else {
+      screen << INCOMING_CAPTION << "Пользователь удален.    " << formatTimeStamp(getTimeStamp())
+             << ", messageId: " << _header->_messageId << '\n';
+    }
+  } else {
+    screen << OUTGOING_CAPTION << currentUser->getUserName() << "    " << formatTimeStamp(getTimeStamp())
+           << " messageId: " << _header->_messageId << '\n';
+  }
+  for (std::size_t i = 0; i < getPartCount(); ++i) {
+    auto part = getPart(i);
+    if (part._kind == ContentKind::Text || part._kind == ContentKind::Image)
+      screen << part._value << '\n';
+  }
+
+  screen << ANSI_RESET;
+}
+
+/**
+ * @brief Appends a message.
+ * @param messageId Message ID.
+ * @param sender Sender of the message.
+ * @param timeStamp Timestamp of the message.
+ * @param parts Content parts; their strings are copied into the arena.
+ * @param partCount Number of parts.
+ * @return View of the stored message.
+ */
+MessageView MessageStore::append(std::size_t messageId, UserId sender, TimeStamp timeStamp,
+                                 const MessagePart *parts, std::size_t partCount) {
+  MessageHeader record;
+  record._messageId = messageId;
+  record._timeStamp = timeStamp;
+  record._sender = sender;
+  record._firstPart = static_cast<std::uint32_t>(_partCount);
+  record._partCount = static_cast<std::uint32_t>(partCount);
+
+  for (std::size_t i = 0; i < partCount; ++i) {
+    if ((_partCount & CHUNK_MASK) == 0 && (_partCount >> CHUNK_SHIFT) == _partChunks.size()) {
+      _partChunks.emplace_back();
+      if (_partChunks.size() > 1) // первый блок растет постепенно, остальные сразу полные
+        _partChunks.back().reserve(CHUNK_SIZE);
+    }
+    _partChunks.back().push_back({_arena.store(parts[i]._value).data(),
+                                  static_cast<std::uint32_t>(parts[i]._value.size()), parts[i]._kind});
+    ++_partCount;
+  }
+
+  if ((_size & CHUNK_MASK) == 0 && (_size >> CHUNK_SHIFT) == _headerChunks.size()) {
+    _headerChunks.emplace_back();
+    if (_headerChunks.size() > 1)
+      _headerChunks.back().reserve(CHUNK_SIZE);
+  }
+  _headerChunks.back().push_back(record);
+  ++_size;
+  return back();
+}
+
+/**
+ * @brief Appends a copy of a message.
+ * @param message The message.
+ * @return View of the stored message.
+ */
+MessageView MessageStore::append(const Message &message) {
+  std::vector<MessagePart> parts;
+  parts.reserve(message.getContent().size());
+  for (const auto &content : message.getContent())
+    parts.push_back({getContentKind(content), getContentValue(content)});
+  return append(message.getMessagetId(), message.getSender(), message.getTimeStamp(), parts.data(), parts.size());
+}
+
+/**
+ * @brief Allocates the store for a known number of messages at once.
+ * @param messageCount Number of messages that follow, one part each.
+ * @param textBytes Total size of their text.
+ */
+void MessageStore::reserve(std::size_t messageCount, std::size_t textBytes) {
+  _arena.reserve(textBytes);
+
+  std::size_t chunkCount = (_size + messageCount + CHUNK_MASK) >> CHUNK_SHIFT;
+  _headerChunks.reserve(chunkCount);
+  _partChunks.reserve(chunkCount);
+
+  // растущим может быть только первый блок; следующие и так выделяются целиком
+  if (_size < CHUNK_SIZE && messageCount > 0) {
+    if (_headerChunks.empty())
+      _headerChunks.emplace_back();
+    _headerChunks.front().reserve(std::min(_size + messageCount, CHUNK_SIZE));
+  }
+  if (_partCount < CHUNK_SIZE && messageCount > 0) {
+    if (_partChunks.empty())
+      _partChunks.emplace_back();
+    _partChunks.front().reserve(std::min(_partCount + messageCount, CHUNK_SIZE));
+  }
+}
+
+/**
+ * @brief Gets the number of bytes allocated by the store.
+ */
+std::size_t MessageStore::getAllocatedBytes() const {
+  std::size_t bytes = _arena.getAllocatedBytes();
+  bytes += _headerChunks.capacity() * sizeof(std::vector<MessageHeader>);
+  bytes += _partChunks.capacity() * sizeof(std::vector<MessagePart>);
+  for (const auto &chunk : _headerChunks)
+    bytes += chunk.capacity() * sizeof(MessageHeader);
+  for (const auto &chunk : _partChunks)
+    bytes += chunk.capacity() * sizeof(StoredPart);
+  return bytes;
+}
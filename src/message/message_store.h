@@ -0,0 +1,251 @@
+#pragma once
+#include "message/message_content.h"
+#include "system/screen_buffer.h"
+#include "system/date_time_utils.h"
+#include "user/user.h"
+#include "user/user_id.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+class Message;
+class MessageStore;
+class UserTable;
+
+/**
+ * @brief Bump allocator for message text.
+ * @details Strings are copied one after another into large blocks that are never
+ * moved or freed individually, so the returned views stay valid for the arena's lifetime.
+ */
+class TextArena {
+private:
+  static constexpr std::size_t FIRST_BLOCK_SIZE = 256;     ///< Size of the first block.
+  static constexpr std::size_t MAX_BLOCK_SIZE = 64 * 1024; ///< Blocks double up to this size.
+
+  std::vector<std::unique_ptr<char[]>> _blocks;    ///< Allocated blocks.
+  char *_cursor = nullptr;                         ///< Free space in the current block.
+  std::size_t _available = 0;                      ///< Bytes left in the current block.
+  std::size_t _nextBlockSize = FIRST_BLOCK_SIZE;   ///< Size of the next regular block.
+  std::size_t _allocatedBytes = 0;                 ///< Total size of all blocks.
+
+public:
+  /**
+   * @brief Copies a string into the arena.
+   * @param value The string.
+   * @return View of the copy.
+   */
+  std::string_view store(std::string_view value);
+
+  /**
+   * @brief Makes room for strings of a known total size in one block.
+   * @param bytes Total size of the strings that follow.
+   */
+  void reserve(std::size_t bytes);
+
+  /**
+   * @brief Gets the total size of the allocated blocks.
+   */
+  std::size_t getAllocatedBytes() const;
+};
+
+/**
+ * @brief One content part of a message.
+ */
+struct MessagePart {
+  ContentKind _kind = ContentKind::Text; ///< Kind of the part.
+  std::string_view _value;               ///< Text, file name or image.
+};
+
+/**
+ * @brief Packed content part inside a MessageStore.
+ */
+struct StoredPart {
+  const char *_value = nullptr;          ///< Bytes in the arena.
+  std::uint32_t _size = 0;               ///< Length of the value.
+  ContentKind _kind = ContentKind::Text; ///< Kind of the part.
+};
+
+/**
+ * @brief Fixed-size (32 bytes) header of a stored message.
+ */
+struct MessageHeader {
+  std::size_t _messageId = 0;   ///< Message ID.
+  TimeStamp _timeStamp = 0;     ///< Time the message was sent.
+  UserId _sender;               ///< Sender of the message.
+  std::uint32_t _firstPart = 0; ///< Index of the first part in the store.
+  std::uint32_t _partCount = 0; ///< Number of parts.
+};
+
+/**
+ * @brief Read-only handle of a message inside a MessageStore.
+ * @details Cheap to copy; valid until the next append to the store. The string views
+ * it returns stay valid while the store is alive.
+ */
+class MessageView {
+private:
+  const MessageStore *_store;    ///< Owner of the message.
+  const MessageHeader *_header;  ///< Header of the message.
+
+public:
+  /**
+   * @brief Constructor for MessageView.
+   * @param store Owner of the message.
+   * @param header Header of the message.
+   */
+  MessageView(const MessageStore *store, const MessageHeader *header) : _store(store), _header(header) {}
+
+  /**
+   * @brief Retrieves the messageId.
+   */
+  std::size_t getMessageId() const { return _header->_messageId; }
+
+  /**
+   * @brief Gets the sender of the message.
+   * @return Handle of the sender.
+   */
+  UserId getSender() const { return _header->_sender; }
+
+  /**
+   * @brief Gets the timestamp of the message.
+   */
+  TimeStamp getTimeStamp() const { return _header->_timeStamp; }
+
+  /**
+   * @brief Gets the number of content parts.
+   */
+  std::size_t getPartCount() const { return _header->_partCount; }
+
+  /**
+   * @brief Gets a content part.
+   * @param index Index of the part, less than getPartCount().
+   */
+  MessagePart getPart(std::size_t index) const;
+
+  /**
+   * @brief Prints the message for a specific user.
+   * @param screen Buffer of the screen being composed.
+   * @param users Table resolving the sender.
+   * @param currentUser Shared pointer to the user viewing the message.
+   */
+  void printMessage(ScreenBuffer &screen, const UserTable &users, const std::shared_ptr<User> &currentUser) const;
+};
+
+/**
+ * @brief Append-only message storage of one chat.
+ *
+ * Headers and content parts are kept in chunks of CHUNK_SIZE elements (only the first
+ * chunk grows, so small chats stay small), and all strings go to a TextArena. Walking
+ * the messages of a chat is a linear scan over a few large allocations instead of
+ * chasing a shared_ptr, a content vector and a heap string for every message.
+ */
+class MessageStore {
+private:
+  static constexpr std::size_t CHUNK_SHIFT = 10;              ///< log2 of the chunk size.
+  static constexpr std::size_t CHUNK_SIZE = 1u << CHUNK_SHIFT; ///< Elements per chunk.
+  static constexpr std::size_t CHUNK_MASK = CHUNK_SIZE - 1;    ///< Index inside a chunk.
+
+  std::vector<std::vector<MessageHeader>> _headerChunks; ///< Message headers.
+  std::vector<std::vector<StoredPart>> _partChunks;      ///< Content parts.
+  std::size_t _size = 0;                                 ///< Number of messages.
+  std::size_t _partCount = 0;                            ///< Number of parts.
+  TextArena _arena;                                      ///< Storage of all strings.
+
+  /**
+   * @brief Gets the header of a message.
+   */
+  const MessageHeader &header(std::size_t index) const {
+    return _headerChunks[index >> CHUNK_SHIFT][index & CHUNK_MASK];
+  }
+
+  friend class MessageView;
+
+public:
+  /**
+   * @brief Forward iterator yielding MessageView.
+   */
+  class const_iterator {
+  private:
+    const MessageStore *_store; ///< Iterated store.
+    std::size_t _index;         ///< Current message.
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = MessageView;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = MessageView;
+
+    const_iterator(const MessageStore *store, std::size_t index) : _store(store), _index(index) {}
+    MessageView operator*() const { return (*_store)[_index]; }
+    const_iterator &operator++() {
+      ++_index;
+      return *this;
+    }
+    bool operator==(const const_iterator &other) const { return _index == other._index; }
+    bool operator!=(const const_iterator &other) const { return _index != other._index; }
+  };
+
+  MessageStore() = default;
+  MessageStore(const MessageStore &) = delete;
+  MessageStore &operator=(const MessageStore &) = delete;
+
+  /**
+   * @brief Appends a message.
+   * @param messageId Message ID.
+   * @param sender Sender of the message.
+   * @param timeStamp Timestamp of the message.
+   * @param parts Content parts; their strings are copied into the arena.
+   * @param partCount Number of parts.
+   * @return View of the stored message.
+   */
+  MessageView append(std::size_t messageId, UserId sender, TimeStamp timeStamp,
+                     const MessagePart *parts, std::size_t partCount);
+
+  /**
+   * @brief Appends a copy of a message.
+   * @param message The message.
+   * @return View of the stored message.
+   */
+  MessageView append(const Message &message);
+
+  /**
+   * @brief Allocates the store for a known number of messages at once.
+   * @param messageCount Number of messages that follow, one part each.
+   * @param textBytes Total size of their text.
+   * @details Without it the first chunk and the text blocks grow step by step, which
+   * costs small chats more than the messages themselves.
+   */
+  void reserve(std::size_t messageCount, std::size_t textBytes);
+
+  /**
+   * @brief Gets the number of messages.
+   */
+  std::size_t size() const { return _size; }
+
+  /**
+   * @brief Checks whether the store has no messages.
+   */
+  bool empty() const { return _size == 0; }
+
+  /**
+   * @brief Gets a message by its position in the chat.
+   * @param index Position, less than size().
+   */
+  MessageView operator[](std::size_t index) const { return MessageView(this, &header(index)); }
+
+  /**
+   * @brief Gets the last message. The store must not be empty.
+   */
+  MessageView back() const { return (*this)[_size - 1]; }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, _size); }
+
+  /**
+   * @brief Gets the number of bytes allocated by the store.
+   */
+  std::size_t getAllocatedBytes() const;
+};
@@ -0,0 +1,655 @@
+#include "server/chat_server.h"
+#include "chat/chat.h"
+#include "exception/server_exception.h"
+#include "user/user.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <shared_mutex>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+const std::size_t EPOLL_BATCH_SIZE = 256; ///< Events taken by one epoll_wait.
+
+/**
+ * @brief Closes a socket and throws the error of the failed call.
+ * @param socket The socket, -1 - nothing to close.
+ * @param operation Description of the failed call.
+ * @throws SocketException Always.
+ */
+[[noreturn]] void failSocket(int socket, const std::string &operation) {
+  int error = errno;
+  if (socket >= 0)
+    ::close(socket);
+  throw SocketException(operation, error);
+}
+
+} // namespace
+
+/**
+ * @brief Constructor; creates the event loop.
+ * @param chatSystem The chat system to serve.
+ * @param config Server settings.
+ * @throws SocketException If the event loop cannot be created.
+ */
+ChatServer::ChatServer(ChatSystem &chatSystem, const ChatServerConfig &config)
+    : _chatSystem(chatSystem), _chatService(chatSystem), _config(config), _readBuffer(config._readChunkSize) {
+  _epoll = ::epoll_create1(EPOLL_CLOEXEC);
+  if (_epoll < 0)
+    failSocket(-1, "epoll_create1");
+
+  _wakeup = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (_wakeup < 0) {
+    int error = errno;
+    ::close(_epoll);
+    throw SocketException("eventfd", error);
+  }
+
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = _wakeup;
+  if (::epoll_ctl(_epoll, EPOLL_CTL_ADD, _wakeup, &event) < 0) {
+    int error = errno;
+    ::close(_wakeup);
+    ::close(_epoll);
+    throw SocketException("epoll_ctl", error);
+  }
+}
+
+/**
+ * @brief Destructor; closes all connections and sockets and removes the socket files.
+ */
+ChatServer::~ChatServer() {
+  while (!_connections.empty())
+    closeConnection(_connections.begin()->first);
+  for (int listener : _listeners)
+    ::close(listener);
+  for (const auto &path : _unixPaths)
+    ::unlink(path.c_str());
+  ::close(_wakeup);
+  ::close(_epoll);
+}
+
+/**
+ * @brief Registers a listening socket in the event loop.
+ * @param listener The socket, bound and non-blocking.
+ */
+void ChatServer::addListener(int listener) {
+  if (::listen(listener, SOMAXCONN) < 0)
+    failSocket(listener, "listen");
+
+  // edge-triggered: после события принимаются все ждущие подключения
+  epoll_event event{};
+  event.events = EPOLLIN | EPOLLET;
+  event.data.fd = listener;
+  if (::epoll_ctl(_epoll, EPOLL_CTL_ADD, listener, &event) < 0)
+    failSocket(listener, "epoll_ctl");
+  _listeners.push_back(listener);
+}
+
+/**
+ * @brief Starts listening on a Unix domain socket.
+ * @param path Path of the socket file.
+ * @throws SocketException If the socket cannot be bound.
+ */
+void ChatServer::listenUnix(const std::string &path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(address.sun_path))
+    throw SocketException("bind " + path, ENAMETOOLONG);
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+  int listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listener < 0)
+    failSocket(-1, "socket");
+
+  // сокет прошлого запуска удаляется, обычный файл - нет (bind вернет ошибку)
+  struct stat status;
+  if (::stat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+    ::unlink(path.c_str());
+
+  if (::bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0)
+    failSocket(listener, "bind " + path);
+  addListener(listener);
+  _unixPaths.push_back(path);
+}
+
+/**
+ * @brief Starts listening on a TCP port of the loopback interface.
+ * @param port Port number, 0 - any free port.
+ * @return The port listened on.
+ * @throws SocketException If the socket cannot be bound.
+ */
+std::uint16_t ChatServer::listenTcp(std::uint16_t port) {
+  int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listener < 0)
+    failSocket(-1, "socket");
+
+  int enable = 1;
+  ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  if (::bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0)
+    failSocket(listener, "bind 127.0.0.1:" + std::to_string(port));
+
+  socklen_t length = sizeof(address);
+  if (::getsockname(listener, reinterpret_cast<sockaddr *>(&address), &length) < 0)
+    failSocket(listener, "getsockname");
+  addListener(listener);
+  return ntohs(address.sin_port);
+}
+
+/**
+ * @brief Accepts all pending connections of a listening socket.
+ * @param listener The socket.
+ */
+void ChatServer::acceptConnections(int listener) {
+  while (true) {
+    int client = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      // EAGAIN - очередь пуста; при EMFILE клиент ждет в очереди до следующего подключения
+      return;
+    }
+
+    if (_connections.size() >= _config._maxConnections) {
+      ::close(client);
+      continue;
+    }
+
+    // короткие ответы уходят сразу, без алгоритма Нейгла; для Unix-сокета вызов просто не сработает
+    int enable = 1;
+    ::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    // EPOLLOUT тоже edge-triggered: событие приходит, только когда переполненный буфер освободился
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.fd = client;
+    if (::epoll_ctl(_epoll, EPOLL_CTL_ADD, client, &event) < 0) {
+      ::close(client);
+      continue;
+    }
+
+    auto connection = std::make_unique<Connection>();
+    connection->_socket = client;
+    _connections.emplace(client, std::move(connection));
+  }
+}
+
+/**
+ * @brief Reads, answers and writes as much as a connection allows without blocking.
+ * @param connection The connection.
+ * @return False if the connection must be closed.
+ */
+bool ChatServer::serveConnection(Connection &connection) {
+  while (true) {
+    bool more = false;
+    if (!connection._peerClosed && !readInput(connection, more))
+      return false;
+
+    bool blocked = false;
+    if (!processFrames(connection, blocked))
+      return false;
+    // очередь не будит цикл, пока не пуста: отложенное из-за полного вывода уходит здесь
+    pushDeliveries(connection);
+    if (!flushOutput(connection))
+      return false;
+
+    // дальше ждать события: сокет пуст, либо ответы не уходят и их слишком много
+    if (connection._output.size() - connection._outputStart >= _config._maxOutputBytes || (!more && !blocked))
+      break;
+  }
+
+  // клиент закрыл свою сторону - соединение закрывается, когда ушли все ответы
+  return !connection._peerClosed || connection._outputStart < connection._output.size();
+}
+
+/**
+ * @brief Reads from a socket until it would block or the input buffer is full.
+ * @param connection The connection.
+ * @param more Receives true if the read stopped with data possibly left in the socket.
+ * @return False on a socket error.
+ */
+bool ChatServer::readInput(Connection &connection, bool &more) {
+  more = false;
+
+  // обработанное начало буфера отбрасывается до чтения
+  if (connection._inputStart > 0) {
+    connection._input.erase(0, connection._inputStart);
+    connection._inputStart = 0;
+  }
+
+  while (true) {
+    // полный буфер содержит хотя бы один целый кадр - сначала он должен быть обработан
+    if (connection._input.size() >= FRAME_HEADER_SIZE_MAX + FRAME_BODY_SIZE_MAX) {
+      more = true;
+      return true;
+    }
+
+    ssize_t received = ::recv(connection._socket, _readBuffer.data(), _readBuffer.size(), 0);
+    if (received > 0) {
+      connection._input.append(_readBuffer.data(), static_cast<std::size_t>(received));
+      continue;
+    }
+    if (received == 0) {
+      connection._peerClosed = true;
+      return true;
+    }
+    if (errno == EINTR)
+      continue;
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+  }
+}
+
+/**
+ * @brief Answers the complete frames of the input buffer while the output has room.
+ * @param connection The connection.
+ * @param blocked Receives true if frames were left because the output is full.
+ * @return False on a malformed frame.
+ */
+bool ChatServer::processFrames(Connection &connection, bool &blocked) {
+  blocked = false;
+  std::string_view input(connection._input);
+  std::string_view body;
+  std::size_t frameSize = 0;
+  while (true) {
+    FrameStatus frameStatus = extractFrame(input.substr(connection._inputStart), body, frameSize);
+    if (frameStatus == FrameStatus::Incomplete)
+      break;
+    // ошибка разбора - поток кадров потерян, соединение закрывается
+    if (frameStatus == FrameStatus::Malformed || !decodeRequest(body, _request))
+      return false;
+
+    if (connection._output.size() - connection._outputStart >= _config._maxOutputBytes) {
+      blocked = true;
+      break;
+    }
+    handleRequest(connection, _request);
+    connection._inputStart += frameSize;
+  }
+
+  if (connection._inputStart == connection._input.size()) {
+    connection._input.clear();
+    connection._inputStart = 0;
+  }
+  return true;
+}
+
+/**
+ * @brief Writes the output buffer until the socket would block.
+ * @param connection The connection.
+ * @return False on a socket error.
+ */
+bool ChatServer::flushOutput(Connection &connection) {
+  while (connection._outputStart < connection._output.size()) {
+    ssize_t sent = ::send(connection._socket, connection._output.data() + connection._outputStart,
+                          connection._output.size() - connection._outputStart, MSG_NOSIGNAL);
+    if (sent > 0) {
+      connection._outputStart += static_cast<std::size_t>(sent);
+      continue;
+    }
+    if (sent < 0 && errno == EINTR)
+      continue;
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    return false;
+  }
+
+  // отправленное начало отбрасывается, когда его больше, чем ждущего
+  if (connection._outputStart == connection._output.size()) {
+    connection._output.clear();
+    connection._outputStart = 0;
+  } else if (connection._outputStart > connection._output.size() / 2) {
+    connection._output.erase(0, connection._outputStart);
+    connection._outputStart = 0;
+  }
+  return true;
+}
+
+/**
+ * @brief Executes a decoded request and appends the response.
+ * @param connection The connection the request came from.
+ * @param request The request.
+ */
+void ChatServer::handleRequest(Connection &connection, const Request &request) {
+  if (request._type == RequestType::Fetch) {
+    handleFetch(connection, request);
+    return;
+  }
+
+  ServiceStatus status = ServiceStatus::Ok;
+  std::size_t id = 0;
+  bool hasMore = false;
+  _response.reset(request._type, status);
+
+  switch (request._type) {
+  case RequestType::Register: {
+    UserId userId;
+    status = _chatService.registerUser(std::string(request._login), std::string(request._password),
+                                       std::string(request._name), userId);
+    break;
+  }
+  case RequestType::Login:
+    // новый вход в том же соединении закрывает прежний сеанс
+    if (connection._sessionId.isValid())
+      closeSession(connection);
+    status = _chatService.login(std::string(request._login), std::string(request._password), connection._sessionId);
+    if (status == ServiceStatus::Ok)
+      openDelivery(connection);
+    break;
+  case RequestType::Logout:
+    status = closeSession(connection);
+    break;
+  case RequestType::CreateChat:
+    // клиенты знают друг друга по логинам, ChatService - по UserId
+    _participants.clear();
+    for (auto login : request._participants) {
+      auto user_ptr = _chatSystem.findUserByLogin(std::string(login));
+      if (!user_ptr) {
+        status = ServiceStatus::UserNotFound;
+        break;
+      }
+      _participants.push_back(user_ptr->getUserId());
+    }
+    if (status == ServiceStatus::Ok)
+      status = _chatService.createChat(connection._sessionId, _participants, id);
+    break;
+  case RequestType::Send:
+    // текст передается видом на буфер приема и копируется только в хранилище чата;
+    // предел длины гарантирует, что сообщение войдет в кадр Fetch и Push
+    if (request._text.size() > MESSAGE_TEXT_SIZE_MAX)
+      status = ServiceStatus::MessageTooLarge;
+    else
+      status = _chatService.sendMessage(connection._sessionId, request._chatId, request._text, id);
+    break;
+  case RequestType::ListChats:
+    status = _chatService.listChats(connection._sessionId, request._first, std::min(request._count, LIST_CHATS_LIMIT_MAX),
+                                    _response._chats, hasMore);
+    break;
+  case RequestType::MarkRead:
+    status = _chatService.markRead(connection._sessionId, request._chatId, request._first);
+    break;
+  case RequestType::Fetch:
+  case RequestType::Push:
+    break;
+  }
+
+  _response._status = status;
+  _response._id = id;
+  _response._hasMore = hasMore;
+  encodeResponse(connection._output, _response);
+}
+
+/**
+ * @brief Appends the response to a Fetch request.
+ * @param connection The connection the request came from.
+ * @param request The request.
+ */
+void ChatServer::handleFetch(Connection &connection, const Request &request) {
+  ChatWindow window;
+  std::vector<MessageView> messages;
+  ServiceStatus status = _chatService.readChat(connection._sessionId, request._chatId, request._first,
+                                               std::min(request._count, FETCH_COUNT_MAX), window, messages);
+
+  _response.reset(RequestType::Fetch, status);
+  _response._first = window._first;
+  _response._messageCount = window._messageCount;
+  _response._lastRead = window._lastRead;
+
+  // строки логинов заводятся заранее: виды на них не должны сдвинуться при росте вектора
+  if (_senderLogins.size() < messages.size())
+    _senderLogins.resize(messages.size());
+
+  // части сообщений - виды на хранилище чата, действительны под блокировкой окна
+  for (const auto &message : messages)
+    addWireMessage(message);
+
+  // окно обрезается вдвое, пока не войдет в кадр; неудачное кодирование ничего не добавляет
+  while (!encodeResponse(connection._output, _response)) {
+    // одно сообщение больше кадра (добавлено из консоли или журнала) - только статус
+    if (_response._messages.size() <= 1) {
+      _response.reset(RequestType::Fetch, ServiceStatus::MessageTooLarge);
+      encodeResponse(connection._output, _response);
+      break;
+    }
+    _response._messages.resize(_response._messages.size() / 2);
+  }
+}
+
+/**
+ * @brief Appends a message to _response; _senderLogins must have room for it.
+ * @param message The message.
+ */
+void ChatServer::addWireMessage(const MessageView &message) {
+  std::size_t index = _response._messages.size();
+  const User *sender = _chatSystem.getUserTable().get(message.getSender());
+  _senderLogins[index] = sender ? sender->getLogin() : std::string();
+
+  WireMessage wireMessage;
+  wireMessage._messageId = message.getMessageId();
+  wireMessage._timeStamp = message.getTimeStamp();
+  wireMessage._sender = _senderLogins[index];
+  wireMessage._firstPart = _response._parts.size();
+  wireMessage._partCount = message.getPartCount();
+  for (std::size_t part = 0; part < message.getPartCount(); ++part)
+    _response._parts.push_back(message.getPart(part));
+  _response._messages.push_back(wireMessage);
+}
+
+/**
+ * @brief Subscribes the new session of a connection to its messages.
+ * @param connection The connection, just logged in.
+ */
+void ChatServer::openDelivery(Connection &connection) {
+  // уведомление приходит из потока отправителя и только ставит сеанс в список готовых
+  _chatService.subscribe(
+      connection._sessionId, [this](SessionId sessionId) { notifyDelivery(sessionId); }, connection._delivery);
+  _sessionSockets[connection._sessionId._value] = connection._socket;
+}
+
+/**
+ * @brief Closes the session of a connection and its subscription.
+ * @param connection The connection.
+ * @return Ok or SessionNotFound.
+ */
+ServiceStatus ChatServer::closeSession(Connection &connection) {
+  _sessionSockets.erase(connection._sessionId._value);
+  connection._delivery.reset();
+  ServiceStatus status = _chatService.logout(connection._sessionId);
+  connection._sessionId = SessionId();
+  return status;
+}
+
+/**
+ * @brief Puts a session into the ready list; called by its queue from any thread.
+ * @param sessionId The session.
+ */
+void ChatServer::notifyDelivery(SessionId sessionId) {
+  bool wasEmpty;
+  {
+    std::lock_guard<std::mutex> lock(_readyMutex);
+    wasEmpty = _readySessions.empty();
+    _readySessions.push_back(sessionId._value);
+  }
+
+  // поток цикла разберет список сам после пачки событий, другой поток должен его разбудить
+  if (wasEmpty && std::this_thread::get_id() != _loopThread.load(std::memory_order_relaxed)) {
+    std::uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = ::write(_wakeup, &one, sizeof(one));
+  }
+}
+
+/**
+ * @brief Sends the new messages of the sessions of the ready list.
+ */
+void ChatServer::deliverReady() {
+  _deliverySessions.clear();
+  {
+    std::lock_guard<std::mutex> lock(_readyMutex);
+    _deliverySessions.swap(_readySessions);
+  }
+
+  for (auto session : _deliverySessions) {
+    // сеанс мог закрыться после уведомления
+    auto socket_it = _sessionSockets.find(session);
+    if (socket_it == _sessionSockets.end())
+      continue;
+    int socket = socket_it->second;
+    auto &connection = *_connections.at(socket);
+
+    pushDeliveries(connection);
+    if (!flushOutput(connection) || (connection._peerClosed && connection._outputStart == connection._output.size()))
+      closeConnection(socket);
+  }
+}
+
+/**
+ * @brief Appends the Push frames of the queue of a connection unless its output is full.
+ * @param connection The connection.
+ */
+void ChatServer::pushDeliveries(Connection &connection) {
+  // медленный клиент: пока вывод полон, очередь сливает новые сообщения в диапазоны
+  if (!connection._delivery || connection._output.size() - connection._outputStart >= _config._maxOutputBytes)
+    return;
+
+  // переполненная очередь потеряла чаты - клиент перечитывает список чатов
+  if (connection._delivery->take(_pendingChats)) {
+    _response.reset(RequestType::Push, ServiceStatus::Ok);
+    encodeResponse(connection._output, _response);
+  }
+  if (_pendingChats.empty())
+    return;
+
+  UserId userId = _chatSystem.getSessions().getUserId(connection._sessionId);
+  for (const auto &pending : _pendingChats)
+    pushChat(connection, userId, pending);
+}
+
+/**
+ * @brief Appends the Push frame of the new messages of one chat.
+ * @param connection The connection.
+ * @param userId Handle of the user of the connection.
+ * @param pending The new messages.
+ */
+void ChatServer::pushChat(Connection &connection, UserId userId, const PendingChat &pending) {
+  auto chat_ptr = _chatSystem.getChatById(pending._chatId);
+  if (!chat_ptr)
+    return;
+
+  // части сообщений - виды на хранилище чата: кадр кодируется под блокировкой
+  std::shared_lock<std::shared_mutex> lock(chat_ptr->getMutex());
+  const auto &messages = chat_ptr->getMessages();
+  std::size_t end = std::min(pending._end, messages.size());
+  if (pending._first >= end)
+    return;
+
+  _response.reset(RequestType::Push, ServiceStatus::Ok);
+  _response._id = pending._chatId;
+  _response._first = pending._first;
+  _response._messageCount = messages.size();
+  _response._lastRead = chat_ptr->getLastReadMessageIndex(userId);
+
+  // много сообщений или полный вывод - только извещение, остальное клиент прочитает через Fetch
+  if (end - pending._first <= PUSH_MESSAGES_MAX &&
+      connection._output.size() - connection._outputStart < _config._maxOutputBytes) {
+    if (_senderLogins.size() < end - pending._first)
+      _senderLogins.resize(end - pending._first);
+    for (std::size_t i = pending._first; i < end; ++i)
+      addWireMessage(messages[i]);
+  }
+
+  // сообщения не вошли в кадр - вместо них извещение
+  if (!encodeResponse(connection._output, _response)) {
+    _response._messages.clear();
+    _response._parts.clear();
+    encodeResponse(connection._output, _response);
+  }
+}
+
+/**
+ * @brief Closes a connection and its session.
+ * @param socket Socket of the connection.
+ */
+void ChatServer::closeConnection(int socket) {
+  auto it = _connections.find(socket);
+  if (it == _connections.end())
+    return;
+
+  if (it->second->_sessionId.isValid())
+    closeSession(*it->second);
+  // закрытие дескриптора убирает его и из epoll
+  ::close(socket);
+  _connections.erase(it);
+}
+
+/**
+ * @brief Serves clients until stop() is called.
+ * @throws SocketException If waiting for events fails.
+ */
+void ChatServer::run() {
+  _loopThread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+  std::vector<epoll_event> events(EPOLL_BATCH_SIZE);
+  while (!_stopRequested.load(std::memory_order_acquire)) {
+    int count = ::epoll_wait(_epoll, events.data(), static_cast<int>(events.size()), -1);
+    if (count < 0) {
+      if (errno == EINTR)
+        continue;
+      throw SocketException("epoll_wait", errno);
+    }
+
+    for (int i = 0; i < count; ++i) {
+      int socket = events[i].data.fd;
+      if (socket == _wakeup) {
+        std::uint64_t value;
+        while (::read(_wakeup, &value, sizeof(value)) > 0) {
+        }
+        continue;
+      }
+      if (std::find(_listeners.begin(), _listeners.end(), socket) != _listeners.end()) {
+        acceptConnections(socket);
+        continue;
+      }
+
+      // соединение могло быть закрыто раньше в этой же пачке событий
+      auto it = _connections.find(socket);
+      if (it == _connections.end())
+        continue;
+      if ((events[i].events & EPOLLERR) || !serveConnection(*it->second))
+        closeConnection(socket);
+    }
+
+    // сообщения, добавленные этой пачкой или другими потоками
+    deliverReady();
+  }
+  _loopThread.store(std::thread::id(), std::memory_order_relaxed);
+  _stopRequested.store(false, std::memory_order_release);
+}
+
+/**
+ * @brief Makes run() return; safe to call from another thread or a signal handler.
+ */
+void ChatServer::stop() {
+  _stopRequested.store(true, std::memory_order_release);
+  std::uint64_t one = 1;
+  // write в eventfd допустим в обработчике сигнала
+  [[maybe_unused]] ssize_t written = ::write(_wakeup, &one, sizeof(one));
+}
+
+/**
+ * @brief Gets the number of open connections.
+ * @return Number of connections.
+ */
+std::size_t ChatServer::getConnectionCount() const { return _connections.size(); }
@@ -0,0 +1,240 @@
+#pragma once
+#include "server/server_protocol.h"
+#include "service/chat_service.h"
+#include "user/delivery_table.h"
+#include "user/session_table.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Settings of a ChatServer.
+ */
+struct ChatServerConfig {
+  std::size_t _maxConnections = 16384;   ///< Open connections; further clients are disconnected at once.
+  std::size_t _maxOutputBytes = 1 << 20; ///< Unsent responses after which a connection is not served.
+  std::size_t _readChunkSize = 64 << 10; ///< Bytes read from a socket in one call.
+};
+
+/**
+ * @brief Network front end of a ChatService: clients over a Unix socket or loopback TCP.
+ *
+ * One thread runs an edge-triggered epoll loop over all sockets. Every connection has
+ * its own input and output buffers and at most one session: a Login request opens it
+ * (closing the previous one), disconnecting closes it. Requests and responses are the
+ * frames of server_protocol.h, one request per ChatService operation; requests are decoded
+ * in place in the input buffer, so message text is copied once - into the chat. All
+ * complete frames of one read are answered with one write.
+ *
+ * A client that stops reading its responses is not served further once
+ * _maxOutputBytes are waiting: its requests stay in the input buffer and the socket
+ * is not read until the output drains, so a slow client costs memory of two buffers.
+ *
+ * A logged-in connection is subscribed to the new messages of its user and receives
+ * them as Push frames. Whoever adds a message - this thread or another one using the
+ * same ChatSystem - only puts its position into the queue of the session; the first
+ * position in an empty queue puts the session into the ready list, and the loop sends
+ * the ready sessions their messages after each batch of events, reading them from the
+ * chats. A client with a full output gets nothing until it drains: its queue meanwhile
+ * merges the messages of one chat into one range, which is sent as a notice when it
+ * outgrows PUSH_MESSAGES_MAX.
+ */
+class ChatServer {
+private:
+  /**
+   * @brief State of one client connection.
+   */
+  struct Connection {
+    int _socket = -1;                         ///< Client socket.
+    std::string _input;                       ///< Received bytes, processed from _inputStart.
+    std::size_t _inputStart = 0;              ///< First unprocessed byte of _input.
+    std::string _output;                      ///< Responses, sent from _outputStart.
+    std::size_t _outputStart = 0;             ///< First unsent byte of _output.
+    SessionId _sessionId;                     ///< Session of the logged-in user, invalid before Login.
+    std::shared_ptr<DeliveryQueue> _delivery; ///< New messages for the session, null before Login.
+    bool _peerClosed = false;                 ///< The client closed its side.
+  };
+
+  ChatSystem &_chatSystem;                                           ///< The served chat system (not owned).
+  ChatService _chatService;                                          ///< Operations on the chat system.
+  ChatServerConfig _config;                                          ///< Server settings.
+  int _epoll = -1;                                                   ///< Event loop descriptor.
+  int _wakeup = -1;                                                  ///< eventfd that interrupts run().
+  std::vector<int> _listeners;                                       ///< Listening sockets.
+  std::vector<std::string> _unixPaths;                               ///< Socket files to remove at the end.
+  std::unordered_map<int, std::unique_ptr<Connection>> _connections; ///< Connections by socket.
+  std::vector<char> _readBuffer;                                     ///< Buffer of one read call.
+  Request _request;                                                  ///< Request being handled.
+  Response _response;                                                ///< Response being built.
+  std::vector<std::string> _senderLogins;                            ///< Logins the Fetch response points to.
+  std::vector<UserId> _participants;                                 ///< Participants of CreateChat.
+  std::unordered_map<std::uint64_t, int> _sessionSockets;            ///< Sockets by session number.
+  std::mutex _readyMutex;                                            ///< Guards _readySessions.
+  std::vector<std::uint64_t> _readySessions;                         ///< Sessions with new messages.
+  std::vector<std::uint64_t> _deliverySessions;                      ///< Ready sessions being served.
+  std::vector<PendingChat> _pendingChats;                            ///< Queue of the session being served.
+  std::atomic<std::thread::id> _loopThread;                          ///< Thread of run().
+  std::atomic<bool> _stopRequested{false};                           ///< Set by stop().
+
+  /**
+   * @brief Registers a listening socket in the event loop.
+   * @param listener The socket, bound and non-blocking.
+   */
+  void addListener(int listener);
+
+  /**
+   * @brief Accepts all pending connections of a listening socket.
+   * @param listener The socket.
+   */
+  void acceptConnections(int listener);
+
+  /**
+   * @brief Reads, answers and writes as much as a connection allows without blocking.
+   * @param connection The connection.
+   * @return False if the connection must be closed.
+   */
+  bool serveConnection(Connection &connection);
+
+  /**
+   * @brief Reads from a socket until it would block or the input buffer is full.
+   * @param connection The connection.
+   * @param more Receives true if the read stopped with data possibly left in the socket.
+   * @return False on a socket error.
+   */
+  bool readInput(Connection &connection, bool &more);
+
+  /**
+   * @brief Answers the complete frames of the input buffer while the output has room.
+   * @param connection The connection.
+   * @param blocked Receives true if frames were left because the output is full.
+   * @return False on a malformed frame.
+   */
+  bool processFrames(Connection &connection, bool &blocked);
+
+  /**
+   * @brief Writes the output buffer until the socket would block.
+   * @param connection The connection.
+   * @return False on a socket error.
+   */
+  bool flushOutput(Connection &connection);
+
+  /**
+   * @brief Executes a decoded request and appends the response.
+   * @param connection The connection the request came from.
+   * @param request The request; its strings point into the input buffer of the connection.
+   */
+  void handleRequest(Connection &connection, const Request &request);
+
+  /**
+   * @brief Appends the response to a Fetch request.
+   * @param connection The connection the request came from.
+   * @param request The request.
+   */
+  void handleFetch(Connection &connection, const Request &request);
+
+  /**
+   * @brief Appends a message to _response; _senderLogins must have room for it.
+   * @param message The message; its parts stay views into the chat.
+   */
+  void addWireMessage(const MessageView &message);
+
+  /**
+   * @brief Subscribes the new session of a connection to its messages.
+   * @param connection The connection, just logged in.
+   */
+  void openDelivery(Connection &connection);
+
+  /**
+   * @brief Closes the session of a connection and its subscription.
+   * @param connection The connection.
+   * @return Ok or SessionNotFound.
+   */
+  ServiceStatus closeSession(Connection &connection);
+
+  /**
+   * @brief Puts a session into the ready list; called by its queue from any thread.
+   * @param sessionId The session.
+   */
+  void notifyDelivery(SessionId sessionId);
+
+  /**
+   * @brief Sends the new messages of the sessions of the ready list.
+   */
+  void deliverReady();
+
+  /**
+   * @brief Appends the Push frames of the queue of a connection unless its output is full.
+   * @param connection The connection.
+   */
+  void pushDeliveries(Connection &connection);
+
+  /**
+   * @brief Appends the Push frame of the new messages of one chat.
+   * @param connection The connection.
+   * @param userId Handle of the user of the connection.
+   * @param pending The new messages.
+   */
+  void pushChat(Connection &connection, UserId userId, const PendingChat &pending);
+
+  /**
+   * @brief Closes a connection and its session.
+   * @param socket Socket of the connection.
+   */
+  void closeConnection(int socket);
+
+public:
+  /**
+   * @brief Constructor; creates the event loop.
+   * @param chatSystem The chat system to serve; must outlive the server.
+   * @param config Server settings.
+   * @throws SocketException If the event loop cannot be created.
+   */
+  explicit ChatServer(ChatSystem &chatSystem, const ChatServerConfig &config = ChatServerConfig());
+
+  /**
+   * @brief Destructor; closes all connections and sockets and removes the socket files.
+   */
+  ~ChatServer();
+
+  ChatServer(const ChatServer &) = delete;
+  ChatServer &operator=(const ChatServer &) = delete;
+
+  /**
+   * @brief Starts listening on a Unix domain socket; a stale socket file at the path is replaced.
+   * @param path Path of the socket file.
+   * @throws SocketException If the socket cannot be bound.
+   */
+  void listenUnix(const std::string &path);
+
+  /**
+   * @brief Starts listening on a TCP port of the loopback interface.
+   * @param port Port number, 0 - any free port.
+   * @return The port listened on.
+   * @throws SocketException If the socket cannot be bound.
+   */
+  std::uint16_t listenTcp(std::uint16_t port);
+
+  /**
+   * @brief Serves clients until stop() is called.
+   * @throws SocketException If waiting for events fails.
+   */
+  void run();
+
+  /**
+   * @brief Makes run() return; safe to call from another thread or a signal handler.
+   */
+  void stop();
+
+  /**
+   * @brief Gets the number of open connections; call from the thread of run() or after it returned.
+   * @return Number of connections.
+   */
+  std::size_t getConnectionCount() const;
+};
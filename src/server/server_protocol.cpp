@@ -0,0 +1,535 @@
+#include "server/server_protocol.h"
+#include "system/utf8_scan.h"
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief Appends varints and strings to a frame body.
+ */
+class WireWriter {
+private:
+  std::string &_out; ///< Target buffer.
+
+public:
+  /**
+   * @brief Constructor for WireWriter.
+   * @param out Buffer the data is appended to.
+   */
+  explicit WireWriter(std::string &out) : _out(out) {}
+
+  /**
+   * @brief Appends one byte.
+   */
+  void putU8(std::uint8_t value) { _out.push_back(static_cast<char>(value)); }
+
+  /**
+   * @brief Appends an unsigned LEB128 varint.
+   */
+  void putVarint(std::uint64_t value) {
+    char bytes[10];
+    std::size_t size = 0;
+    while (value >= 0x80) {
+      bytes[size++] = static_cast<char>((value & 0x7F) | 0x80);
+      value >>= 7;
+    }
+    bytes[size++] = static_cast<char>(value);
+    _out.append(bytes, size);
+  }
+
+  /**
+   * @brief Appends a signed value as a zigzag varint: small magnitudes stay short.
+   */
+  void putSigned(std::int64_t value) {
+    putVarint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+  }
+
+  /**
+   * @brief Appends a string prefixed with its varint length.
+   */
+  void putString(std::string_view value) {
+    putVarint(value.size());
+    _out.append(value.data(), value.size());
+  }
+};
+
+/**
+ * @brief Reads a frame body written by WireWriter.
+ * @details Never reads past the end and never throws: the first error makes the reader
+ * fail, later reads return zeros, and the caller checks isValid() once at the end.
+ */
+class WireReader {
+private:
+  const char *_pos;     ///< Next byte.
+  const char *_end;     ///< End of the body.
+  bool _failed = false; ///< An error was found.
+
+public:
+  /**
+   * @brief Constructor for WireReader.
+   * @param body The body.
+   */
+  explicit WireReader(std::string_view body) : _pos(body.data()), _end(body.data() + body.size()) {}
+
+  /**
+   * @brief Marks the body as malformed.
+   */
+  void fail() {
+    _failed = true;
+    _pos = _end;
+  }
+
+  /**
+   * @brief Gets the number of unread bytes.
+   */
+  std::size_t remaining() const { return static_cast<std::size_t>(_end - _pos); }
+
+  /**
+   * @brief Checks that no error was found and the whole body was read.
+   */
+  bool isValid() const { return !_failed && _pos == _end; }
+
+  /**
+   * @brief Reads one byte.
+   */
+  std::uint8_t getU8() {
+    if (_pos == _end) {
+      fail();
+      return 0;
+    }
+    return static_cast<std::uint8_t>(*_pos++);
+  }
+
+  /**
+   * @brief Reads an unsigned LEB128 varint in its shortest form.
+   */
+  std::uint64_t getVarint() {
+    std::uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      if (_pos == _end)
+        break;
+      auto byte = static_cast<std::uint8_t>(*_pos++);
+      // десятый байт может нести только старший бит значения
+      if (shift == 63 && byte > 1)
+        break;
+      value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+      if (byte < 0x80) {
+        // лишний нулевой байт в конце - не кратчайшая форма
+        if (byte == 0 && shift > 0)
+          break;
+        return value;
+      }
+    }
+    fail();
+    return 0;
+  }
+
+  /**
+   * @brief Reads a zigzag varint.
+   */
+  std::int64_t getSigned() {
+    std::uint64_t value = getVarint();
+    return static_cast<std::int64_t>((value >> 1) ^ (~(value & 1) + 1));
+  }
+
+  /**
+   * @brief Reads a count of items of at least minItemSize bytes each.
+   * @details A count that cannot fit into the rest of the body fails at once, before
+   * the caller reserves anything for it.
+   */
+  std::size_t getCount(std::size_t minItemSize) {
+    std::uint64_t count = getVarint();
+    if (count > remaining() / minItemSize) {
+      fail();
+      return 0;
+    }
+    return static_cast<std::size_t>(count);
+  }
+
+  /**
+   * @brief Reads a length-prefixed string without copying it.
+   * @param checkUtf8 Fail if the bytes are not valid UTF-8.
+   */
+  std::string_view getString(bool checkUtf8 = true) {
+    std::uint64_t length = getVarint();
+    if (length > remaining()) {
+      fail();
+      return std::string_view();
+    }
+    std::string_view value(_pos, static_cast<std::size_t>(length));
+    _pos += length;
+    if (checkUtf8 && !scanUtf8(value, UTF8_CLASS_ANY).isValid())
+      fail();
+    return value;
+  }
+};
+
+/**
+ * @brief Gets the length of the varint of a value.
+ */
+std::size_t varintSize(std::uint64_t value) {
+  std::size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+/**
+ * @brief Starts a frame: reserves room for the longest length prefix.
+ * @return Offset of the frame in the buffer.
+ */
+std::size_t beginFrame(std::string &out) {
+  std::size_t frameStart = out.size();
+  out.append(FRAME_HEADER_SIZE_MAX, '\0');
+  return frameStart;
+}
+
+/**
+ * @brief Finishes a frame: writes the length prefix and moves the body up to it.
+ * @param out Buffer with the frame.
+ * @param frameStart Offset returned by beginFrame.
+ * @return False if the body is larger than FRAME_BODY_SIZE_MAX; the frame is removed then.
+ */
+bool endFrame(std::string &out, std::size_t frameStart) {
+  std::size_t bodyStart = frameStart + FRAME_HEADER_SIZE_MAX;
+  std::size_t bodySize = out.size() - bodyStart;
+
+  // префикс длиннее зарезервированного затер бы начало тела, а extractFrame отклонит такой кадр
+  if (bodySize > FRAME_BODY_SIZE_MAX) {
+    out.resize(frameStart);
+    return false;
+  }
+  std::size_t headerSize = varintSize(bodySize);
+
+  // короткий префикс - тело сдвигается к нему; длинные тела (от 16 КБ) остаются на месте
+  if (headerSize < FRAME_HEADER_SIZE_MAX) {
+    std::memmove(&out[frameStart + headerSize], &out[bodyStart], bodySize);
+    out.resize(frameStart + headerSize + bodySize);
+  }
+  std::size_t value = bodySize;
+  for (std::size_t i = 0; i < headerSize; ++i, value >>= 7)
+    out[frameStart + i] = static_cast<char>((value & 0x7F) | (i + 1 < headerSize ? 0x80 : 0));
+  return true;
+}
+
+/**
+ * @brief Checks that a byte is a type a client may request.
+ */
+bool isRequestType(std::uint8_t value) {
+  return value >= static_cast<std::uint8_t>(RequestType::Register) &&
+         value <= static_cast<std::uint8_t>(RequestType::MarkRead);
+}
+
+/**
+ * @brief Checks that a byte is a type the server may send.
+ */
+bool isResponseType(std::uint8_t value) {
+  return value >= static_cast<std::uint8_t>(RequestType::Register) &&
+         value <= static_cast<std::uint8_t>(RequestType::Push);
+}
+
+} // namespace
+
+/**
+ * @brief Resets the response keeping the capacity of the lists.
+ * @param type Operation answered.
+ * @param status Result.
+ */
+void Response::reset(RequestType type, ServiceStatus status) {
+  _type = type;
+  _status = status;
+  _id = 0;
+  _hasMore = false;
+  _chats.clear();
+  _first = 0;
+  _messageCount = 0;
+  _lastRead = 0;
+  _messages.clear();
+  _parts.clear();
+}
+
+/**
+ * @brief Finds the first frame in received data.
+ * @param input Received bytes not yet processed.
+ * @param body Receives the body of the frame if it is complete.
+ * @param frameSize Receives the size of the frame with its length prefix.
+ * @return Complete, Incomplete or Malformed.
+ */
+FrameStatus extractFrame(std::string_view input, std::string_view &body, std::size_t &frameSize) {
+  std::size_t bodySize = 0;
+  std::size_t headerSize = 0;
+  while (true) {
+    if (headerSize == input.size())
+      return FrameStatus::Incomplete;
+    if (headerSize == FRAME_HEADER_SIZE_MAX)
+      return FrameStatus::Malformed;
+
+    auto byte = static_cast<std::uint8_t>(input[headerSize]);
+    bodySize |= static_cast<std::size_t>(byte & 0x7F) << (7 * headerSize);
+    ++headerSize;
+    if (byte < 0x80) {
+      if (byte == 0 && headerSize > 1)
+        return FrameStatus::Malformed;
+      break;
+    }
+  }
+
+  // длина проверяется до ожидания тела - иначе клиент заставит копить мегабайты
+  if (bodySize > FRAME_BODY_SIZE_MAX)
+    return FrameStatus::Malformed;
+  if (input.size() - headerSize < bodySize)
+    return FrameStatus::Incomplete;
+
+  body = input.substr(headerSize, bodySize);
+  frameSize = headerSize + bodySize;
+  return FrameStatus::Complete;
+}
+
+/**
+ * @brief Appends a request as a frame.
+ * @param out Buffer the frame is appended to.
+ * @param request The request.
+ * @return False if the body would exceed FRAME_BODY_SIZE_MAX.
+ */
+bool encodeRequest(std::string &out, const Request &request) {
+  std::size_t frameStart = beginFrame(out);
+  WireWriter writer(out);
+  writer.putU8(static_cast<std::uint8_t>(request._type));
+
+  switch (request._type) {
+  case RequestType::Register:
+    writer.putString(request._login);
+    writer.putString(request._password);
+    writer.putString(request._name);
+    break;
+  case RequestType::Login:
+    writer.putString(request._login);
+    writer.putString(request._password);
+    break;
+  case RequestType::Logout:
+    break;
+  case RequestType::CreateChat:
+    writer.putVarint(request._participants.size());
+    for (auto login : request._participants)
+      writer.putString(login);
+    break;
+  case RequestType::Send:
+    writer.putVarint(request._chatId);
+    writer.putString(request._text);
+    break;
+  case RequestType::ListChats:
+    writer.putVarint(request._first);
+    writer.putVarint(request._count);
+    break;
+  case RequestType::Fetch:
+    writer.putVarint(request._chatId);
+    writer.putVarint(request._first);
+    writer.putVarint(request._count);
+    break;
+  case RequestType::MarkRead:
+    writer.putVarint(request._chatId);
+    writer.putVarint(request._first);
+    break;
+  case RequestType::Push:
+    break;
+  }
+  return endFrame(out, frameStart);
+}
+
+/**
+ * @brief Decodes the body of a request frame.
+ * @param body The body.
+ * @param request Receives the request.
+ * @return False if the body is malformed.
+ */
+bool decodeRequest(std::string_view body, Request &request) {
+  WireReader reader(body);
+  std::uint8_t type = reader.getU8();
+  if (!isRequestType(type))
+    return false;
+  request._type = static_cast<RequestType>(type);
+
+  switch (request._type) {
+  case RequestType::Register:
+    request._login = reader.getString();
+    request._password = reader.getString();
+    request._name = reader.getString();
+    break;
+  case RequestType::Login:
+    request._login = reader.getString();
+    request._password = reader.getString();
+    break;
+  case RequestType::Logout:
+    break;
+  case RequestType::CreateChat: {
+    request._participants.clear();
+    std::size_t count = reader.getCount(1);
+    for (std::size_t i = 0; i < count; ++i)
+      request._participants.push_back(reader.getString());
+    break;
+  }
+  case RequestType::Send:
+    request._chatId = reader.getVarint();
+    request._text = reader.getString();
+    break;
+  case RequestType::ListChats:
+    request._first = reader.getVarint();
+    request._count = reader.getVarint();
+    break;
+  case RequestType::Fetch:
+    request._chatId = reader.getVarint();
+    request._first = reader.getVarint();
+    request._count = reader.getVarint();
+    break;
+  case RequestType::MarkRead:
+    request._chatId = reader.getVarint();
+    request._first = reader.getVarint();
+    break;
+  case RequestType::Push:
+    break;
+  }
+  return reader.isValid();
+}
+
+/**
+ * @brief Appends a response as a frame.
+ * @param out Buffer the frame is appended to.
+ * @param response The response.
+ * @return False if the body would exceed FRAME_BODY_SIZE_MAX.
+ */
+bool encodeResponse(std::string &out, const Response &response) {
+  std::size_t frameStart = beginFrame(out);
+  WireWriter writer(out);
+  writer.putU8(static_cast<std::uint8_t>(response._type));
+  writer.putU8(static_cast<std::uint8_t>(response._status));
+
+  if (response._status == ServiceStatus::Ok) {
+    switch (response._type) {
+    case RequestType::CreateChat:
+    case RequestType::Send:
+      writer.putVarint(response._id);
+      break;
+    case RequestType::ListChats:
+      writer.putU8(response._hasMore ? 1 : 0);
+      writer.putVarint(response._chats.size());
+      for (const auto &chat : response._chats) {
+        writer.putVarint(chat._chatId);
+        writer.putSigned(chat._lastActivity);
+        writer.putVarint(chat._messageCount);
+        writer.putVarint(chat._unreadCount);
+      }
+      break;
+    case RequestType::Push:
+      writer.putVarint(response._id);
+      [[fallthrough]];
+    case RequestType::Fetch: {
+      writer.putVarint(response._first);
+      writer.putVarint(response._messageCount);
+      writer.putVarint(response._lastRead);
+      writer.putVarint(response._messages.size());
+
+      // ID внутри чата возрастают, время почти всегда - разности короче самих значений
+      std::size_t previousId = 0;
+      TimeStamp previousTime = 0;
+      for (const auto &message : response._messages) {
+        writer.putVarint(message._messageId - previousId);
+        writer.putSigned(static_cast<std::int64_t>(static_cast<std::uint64_t>(message._timeStamp) -
+                                                   static_cast<std::uint64_t>(previousTime)));
+        writer.putString(message._sender);
+        writer.putVarint(message._partCount);
+        for (std::size_t part = 0; part < message._partCount; ++part) {
+          const auto &messagePart = response._parts[message._firstPart + part];
+          writer.putU8(static_cast<std::uint8_t>(messagePart._kind));
+          writer.putString(messagePart._value);
+        }
+        previousId = message._messageId;
+        previousTime = message._timeStamp;
+      }
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  return endFrame(out, frameStart);
+}
+
+/**
+ * @brief Decodes the body of a response frame.
+ * @param body The body.
+ * @param response Receives the response.
+ * @return False if the body is malformed.
+ */
+bool decodeResponse(std::string_view body, Response &response) {
+  WireReader reader(body);
+  std::uint8_t type = reader.getU8();
+  std::uint8_t status = reader.getU8();
+  if (!isResponseType(type) || status > static_cast<std::uint8_t>(ServiceStatus::MessageTooLarge))
+    return false;
+  response.reset(static_cast<RequestType>(type), static_cast<ServiceStatus>(status));
+  if (response._status != ServiceStatus::Ok)
+    return reader.isValid();
+
+  switch (response._type) {
+  case RequestType::CreateChat:
+  case RequestType::Send:
+    response._id = reader.getVarint();
+    break;
+  case RequestType::ListChats: {
+    std::uint8_t hasMore = reader.getU8();
+    if (hasMore > 1)
+      reader.fail();
+    response._hasMore = hasMore == 1;
+
+    std::size_t count = reader.getCount(4);
+    response._chats.resize(count);
+    for (auto &chat : response._chats) {
+      chat._chatId = reader.getVarint();
+      chat._lastActivity = reader.getSigned();
+      chat._messageCount = reader.getVarint();
+      chat._unreadCount = reader.getVarint();
+    }
+    break;
+  }
+  case RequestType::Push:
+    response._id = reader.getVarint();
+    [[fallthrough]];
+  case RequestType::Fetch: {
+    response._first = reader.getVarint();
+    response._messageCount = reader.getVarint();
+    response._lastRead = reader.getVarint();
+
+    std::size_t count = reader.getCount(4);
+    response._messages.resize(count);
+    std::size_t previousId = 0;
+    TimeStamp previousTime = 0;
+    for (auto &message : response._messages) {
+      message._messageId = previousId + reader.getVarint();
+      message._timeStamp = static_cast<TimeStamp>(static_cast<std::uint64_t>(previousTime) +
+                                                  static_cast<std::uint64_t>(reader.getSigned()));
+      message._sender = reader.getString();
+      message._firstPart = response._parts.size();
+      message._partCount = reader.getCount(2);
+      for (std::size_t part = 0; part < message._partCount; ++part) {
+        std::uint8_t kind = reader.getU8();
+        if (kind < static_cast<std::uint8_t>(ContentKind::Text) || kind > static_cast<std::uint8_t>(ContentKind::Image))
+          reader.fail();
+
+        // проверка UTF-8 - только для текста; имя файла и изображение передаются как есть
+        MessagePart messagePart;
+        messagePart._kind = static_cast<ContentKind>(kind);
+        messagePart._value = reader.getString(messagePart._kind == ContentKind::Text);
+        response._parts.push_back(messagePart);
+      }
+      previousId = message._messageId;
+      previousTime = message._timeStamp;
+    }
+    break;
+  }
+  default:
+    break;
+  }
+  return reader.isValid();
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include "message/message_store.h"
+#include "service/chat_service.h"
+#include "system/date_time_utils.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+const std::size_t FRAME_HEADER_SIZE_MAX = 3;                         ///< Longest length prefix: a varint up to FRAME_BODY_SIZE_MAX.
+const std::size_t FRAME_BODY_SIZE_MAX = 64 << 10;                    ///< Largest frame body, sent or accepted.
+const std::size_t MESSAGE_TEXT_SIZE_MAX = FRAME_BODY_SIZE_MAX - 256; ///< Longest Send text: such a message fits into a Fetch or Push frame.
+const std::size_t FETCH_COUNT_MAX = 256;                             ///< Largest window of a Fetch request.
+const std::size_t LIST_CHATS_LIMIT_MAX = 256;                        ///< Largest page of a ListChats request.
+const std::size_t PUSH_MESSAGES_MAX = 20;                            ///< Most messages of a Push; more new messages make a notice.
+
+/**
+ * @brief Requests a client may send to ChatServer, one per ChatService operation.
+ * @details Wire format. A frame is the body length as a varint (unsigned LEB128, shortest
+ * form only) followed by the body. Integers in bodies are varints, strings are a varint
+ * length and UTF-8 bytes, booleans and kinds are one byte. A request body is the type
+ * and then its fields:
+ * - Register: login, password, name;
+ * - Login: login, password;
+ * - Logout: -;
+ * - CreateChat: number of participants, their logins;
+ * - Send: chat ID, text of at most MESSAGE_TEXT_SIZE_MAX bytes (longer - MessageTooLarge);
+ * - ListChats: offset, limit;
+ * - Fetch: chat ID, first message (past the end - the last window), count;
+ * - MarkRead: chat ID, number of read messages.
+ *
+ * A response body is the request type and the ServiceStatus (one byte each); only with
+ * ServiceStatus::Ok follow the fields:
+ * - CreateChat: chat ID; Send: message ID;
+ * - ListChats: has more (bool), number of chats, per chat: ID, last activity, message count, unread count;
+ * - Fetch: first message, message count of the chat, read index, number of messages, per message:
+ *   ID minus the previous ID in the window, time minus the previous time (zigzag), sender
+ *   login, number of parts, per part: kind and value. The window is cut to fit into a
+ *   frame; a first message that alone does not fit (added not through the server) gives
+ *   MessageTooLarge, the client fetches from the next one.
+ *
+ * Responses come in the order of the requests, so a client may send several requests
+ * without waiting. Between them the server sends Push frames of its own, with status Ok:
+ * - Push: chat ID, then the fields of Fetch for the new messages of the chat, the
+ *   sender's own included. A Push without messages is a notice: more messages arrived
+ *   than fit, the client fetches them from the first message. Chat ID 0 means pushes
+ *   were dropped; the client reloads its chat list.
+ */
+enum class RequestType : std::uint8_t {
+  Register = 1,
+  Login = 2,
+  Logout = 3,
+  CreateChat = 4,
+  Send = 5,
+  ListChats = 6,
+  Fetch = 7,
+  MarkRead = 8,
+  Push = 9 ///< Sent only by the server.
+};
+
+/**
+ * @brief Result of looking for a frame in received data.
+ */
+enum class FrameStatus : std::uint8_t {
+  Complete,   ///< A whole frame is available.
+  Incomplete, ///< More bytes are needed.
+  Malformed   ///< The length prefix is broken or too large; the stream cannot be resynchronized.
+};
+
+/**
+ * @brief A decoded request.
+ * @details The strings are views into the decoded frame and are valid while the frame
+ * is, so a request is handled without copying its text. Fields a type does not use are
+ * left as they are; reuse one object so the participant list keeps its capacity.
+ */
+struct Request {
+  RequestType _type = RequestType::Logout;     ///< Operation.
+  std::string_view _login;                     ///< Register, Login: login.
+  std::string_view _password;                  ///< Register, Login: password.
+  std::string_view _name;                      ///< Register: display name.
+  std::vector<std::string_view> _participants; ///< CreateChat: logins of the other participants.
+  std::size_t _chatId = 0;                     ///< Send, Fetch, MarkRead: chat ID.
+  std::string_view _text;                      ///< Send: message text.
+  std::size_t _first = 0;                      ///< ListChats: offset; Fetch: first message; MarkRead: read index.
+  std::size_t _count = 0;                      ///< ListChats: limit; Fetch: window size.
+};
+
+/**
+ * @brief A message of a Fetch or Push response.
+ */
+struct WireMessage {
+  std::size_t _messageId = 0; ///< Message ID.
+  TimeStamp _timeStamp = 0;   ///< Time the message was sent.
+  std::string_view _sender;   ///< Login of the sender, empty if the user is gone.
+  std::size_t _firstPart = 0; ///< Index of the first part in Response::_parts.
+  std::size_t _partCount = 0; ///< Number of parts.
+};
+
+/**
+ * @brief A response; strings are views, like in Request.
+ */
+struct Response {
+  RequestType _type = RequestType::Logout;   ///< Operation answered.
+  ServiceStatus _status = ServiceStatus::Ok; ///< Result; the fields below are sent only with Ok.
+  std::size_t _id = 0;                       ///< CreateChat, Push: chat ID; Send: message ID.
+  bool _hasMore = false;                     ///< ListChats: more chats after the page.
+  std::vector<ChatSummary> _chats;           ///< ListChats: the page.
+  std::size_t _first = 0;                    ///< Fetch, Push: position of the first message.
+  std::size_t _messageCount = 0;             ///< Fetch, Push: number of messages in the chat.
+  std::size_t _lastRead = 0;                 ///< Fetch, Push: read index of the user.
+  std::vector<WireMessage> _messages;        ///< Fetch: the window; Push: the new messages.
+  std::vector<MessagePart> _parts;           ///< Fetch, Push: parts of all messages.
+
+  /**
+   * @brief Resets the response keeping the capacity of the lists.
+   * @param type Operation answered.
+   * @param status Result.
+   */
+  void reset(RequestType type, ServiceStatus status);
+};
+
+/**
+ * @brief Finds the first frame in received data.
+ * @param input Received bytes not yet processed.
+ * @param body Receives the body of the frame (a view into input) if it is complete.
+ * @param frameSize Receives the size of the frame with its length prefix.
+ * @return Complete, Incomplete or Malformed.
+ */
+FrameStatus extractFrame(std::string_view input, std::string_view &body, std::size_t &frameSize);
+
+/**
+ * @brief Appends a request as a frame.
+ * @param out Buffer the frame is appended to.
+ * @param request The request; its strings must be valid UTF-8.
+ * @return False if the body would exceed FRAME_BODY_SIZE_MAX; nothing is appended then.
+ */
+bool encodeRequest(std::string &out, const Request &request);
+
+/**
+ * @brief Decodes the body of a request frame.
+ * @param body The body; the views of the request point into it.
+ * @param request Receives the request.
+ * @return False if the body is malformed: unknown type (Push included), truncated or extra bytes,
+ * varints longer than needed, invalid UTF-8.
+ * @details Every length and count is checked against the remaining bytes before use,
+ * so any input is accepted or rejected in time linear in its size.
+ */
+bool decodeRequest(std::string_view body, Request &request);
+
+/**
+ * @brief Appends a response as a frame.
+ * @param out Buffer the frame is appended to.
+ * @param response The response; Fetch message IDs must increase.
+ * @return False if the body would exceed FRAME_BODY_SIZE_MAX; nothing is appended then.
+ */
+bool encodeResponse(std::string &out, const Response &response);
+
+/**
+ * @brief Decodes the body of a response frame.
+ * @param body The body; the views of the response point into it.
+ * @param response Receives the response.
+ * @return False if the body is malformed.
+ */
+bool decodeResponse(std::string_view body, Response &response);
@@ -0,0 +1,365 @@
+#include "service/batch_runner.h"
+#include "chat/chat.h"
+#include "user/user_inbox.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <istream>
+#include <ostream>
+#include <string_view>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const std::size_t BATCH_ERRORS_SHOWN = 20; ///< Сколько ошибок выводить построчно.
+
+/**
+ * @brief Names of the commands in the script, in BatchCommandKind order.
+ */
+const char *const COMMAND_NAMES[] = {"register", "login", "chat", "send", "read", "mark", "list"};
+
+/**
+ * @brief Minimum and maximum number of arguments of each command.
+ */
+const std::size_t COMMAND_ARGS[][2] = {{3, 3}, {2, 2}, {3, SIZE_MAX}, {3, 3}, {2, 4}, {2, 3}, {1, 2}};
+
+/**
+ * @brief Positions of the numeric arguments of each command (first, last + 1).
+ */
+const std::size_t COMMAND_NUMBERS[][2] = {{0, 0}, {0, 0}, {0, 0}, {0, 0}, {2, 4}, {2, 3}, {1, 2}};
+
+/**
+ * @brief Cuts the next whitespace-separated token from the front of a line.
+ */
+std::string_view nextToken(std::string_view &rest) {
+  std::size_t begin = rest.find_first_not_of(" \t");
+  if (begin == std::string_view::npos) {
+    rest = std::string_view();
+    return rest;
+  }
+  std::size_t end = rest.find_first_of(" \t", begin);
+  if (end == std::string_view::npos)
+    end = rest.size();
+
+  std::string_view token = rest.substr(begin, end - begin);
+  rest.remove_prefix(end);
+  return token;
+}
+
+/**
+ * @brief Checks that a token is a decimal number.
+ */
+bool isNumber(const std::string &token) {
+  return !token.empty() && token.size() <= 19 &&
+         std::all_of(token.begin(), token.end(), [](char ch) { return ch >= '0' && ch <= '9'; });
+}
+
+/**
+ * @brief Reads a numeric argument already checked by isNumber.
+ */
+std::size_t toNumber(const std::string &token) { return std::strtoull(token.c_str(), nullptr, 10); }
+
+/**
+ * @brief Gets a percentile of latencies.
+ * @param latencies Latencies, reordered by the call.
+ * @param percent Percentile, 0-100.
+ */
+std::uint32_t percentile(std::vector<std::uint32_t> &latencies, double percent) {
+  std::size_t position = static_cast<std::size_t>(percent / 100.0 * (latencies.size() - 1));
+  std::nth_element(latencies.begin(), latencies.begin() + static_cast<std::ptrdiff_t>(position), latencies.end());
+  return latencies[position];
+}
+
+} // namespace
+
+/**
+ * @brief Constructor.
+ * @param chatSystem The chat system to drive; must outlive the runner.
+ */
+BatchRunner::BatchRunner(ChatSystem &chatSystem) : _chatSystem(chatSystem), _chatService(chatSystem) {}
+
+/**
+ * @brief Parses a script and appends its commands.
+ * @param input Stream with the script.
+ * @param errors Receives one line per unparsable script line.
+ * @return Number of parsed commands.
+ */
+std::size_t BatchRunner::load(std::istream &input, std::ostream &errors) {
+  std::string lineText;
+  std::size_t lineNumber = 0;
+  std::size_t loaded = 0;
+
+  while (std::getline(input, lineText)) {
+    ++lineNumber;
+    if (!lineText.empty() && lineText.back() == '\r')
+      lineText.pop_back();
+
+    std::string_view rest = lineText;
+    std::string_view name = nextToken(rest);
+    if (name.empty() || name.front() == '#')
+      continue;
+
+    auto kindIt = std::find(std::begin(COMMAND_NAMES), std::end(COMMAND_NAMES), name);
+    if (kindIt == std::end(COMMAND_NAMES)) {
+      errors << "строка " << lineNumber << ": неизвестная команда '" << name << "'\n";
+      ++_parseErrors;
+      continue;
+    }
+
+    BatchCommand command;
+    command._kind = static_cast<BatchCommandKind>(kindIt - std::begin(COMMAND_NAMES));
+    command._line = lineNumber;
+    std::size_t kind = static_cast<std::size_t>(command._kind);
+
+    // у send текст сообщения - весь остаток строки
+    std::size_t tokenCount = command._kind == BatchCommandKind::Send ? 2 : SIZE_MAX;
+    while (command._args.size() < tokenCount) {
+      std::string_view token = nextToken(rest);
+      if (token.empty())
+        break;
+      command._args.emplace_back(token);
+    }
+    if (command._kind == BatchCommandKind::Send) {
+      std::size_t textBegin = rest.find_first_not_of(" \t");
+      if (textBegin != std::string_view::npos)
+        command._args.emplace_back(rest.substr(textBegin));
+    }
+
+    bool valid = command._args.size() >= COMMAND_ARGS[kind][0] && command._args.size() <= COMMAND_ARGS[kind][1];
+    for (std::size_t i = COMMAND_NUMBERS[kind][0]; valid && i < COMMAND_NUMBERS[kind][1] && i < command._args.size();
+         ++i)
+      valid = isNumber(command._args[i]);
+
+    if (!valid) {
+      errors << "строка " << lineNumber << ": неверные аргументы команды " << name << '\n';
+      ++_parseErrors;
+      continue;
+    }
+
+    _commands.push_back(std::move(command));
+    ++loaded;
+  }
+  return loaded;
+}
+
+/**
+ * @brief Resolves a login.
+ * @param login The login.
+ * @param userId Receives the handle.
+ * @return True if the user exists.
+ */
+bool BatchRunner::findUser(const std::string &login, UserId &userId) const {
+  auto user_ptr = _chatSystem.findUserByLogin(login);
+  if (!user_ptr)
+    return false;
+
+  userId = user_ptr->getUserId();
+  return true;
+}
+
+/**
+ * @brief Gets the session of a login, opening it on first use.
+ * @param login The login.
+ * @param sessionId Receives the handle.
+ * @return True if the user exists.
+ */
+bool BatchRunner::findSession(const std::string &login, SessionId &sessionId) {
+  auto it = _sessions.find(login);
+  if (it != _sessions.end()) {
+    sessionId = it->second;
+    return true;
+  }
+
+  UserId userId;
+  if (!findUser(login, userId))
+    return false;
+
+  sessionId = _chatSystem.getSessions().open(userId);
+  _sessions.emplace(login, sessionId);
+  return true;
+}
+
+/**
+ * @brief Resolves a chat alias or chat ID.
+ * @param alias The alias.
+ * @param chatId Receives the chat ID.
+ * @return True if the alias is known or is a number.
+ */
+bool BatchRunner::findChat(const std::string &alias, std::size_t &chatId) const {
+  auto it = _chatAliases.find(alias);
+  if (it != _chatAliases.end()) {
+    chatId = it->second;
+    return true;
+  }
+  if (!isNumber(alias))
+    return false;
+
+  chatId = toNumber(alias);
+  return true;
+}
+
+/**
+ * @brief Executes one command.
+ * @param command The command.
+ * @return Result of the service call; UserNotFound or ChatNotFound for unknown names.
+ */
+ServiceStatus BatchRunner::execute(const BatchCommand &command) {
+  const auto &args = command._args;
+  UserId userId;
+  SessionId sessionId;
+  std::size_t chatId = 0;
+
+  switch (command._kind) {
+  case BatchCommandKind::Register:
+    return _chatService.registerUser(args[0], args[1], args[2], userId);
+
+  case BatchCommandKind::Login: {
+    ServiceStatus status = _chatService.login(args[0], args[1], sessionId);
+    if (status != ServiceStatus::Ok)
+      return status;
+
+    // повторный вход заменяет прошлый сеанс
+    auto it = _sessions.find(args[0]);
+    if (it != _sessions.end()) {
+      _chatService.logout(it->second);
+      it->second = sessionId;
+    } else {
+      _sessions.emplace(args[0], sessionId);
+    }
+    return ServiceStatus::Ok;
+  }
+
+  case BatchCommandKind::Chat: {
+    if (!findSession(args[1], sessionId))
+      return ServiceStatus::UserNotFound;
+
+    std::vector<UserId> participants;
+    for (std::size_t i = 2; i < args.size(); ++i) {
+      UserId participant;
+      if (!findUser(args[i], participant))
+        return ServiceStatus::UserNotFound;
+      participants.push_back(participant);
+    }
+
+    ServiceStatus status = _chatService.createChat(sessionId, participants, chatId);
+    if (status == ServiceStatus::Ok)
+      _chatAliases[args[0]] = chatId;
+    return status;
+  }
+
+  default:
+    break;
+  }
+
+  // остальные команды - от имени пользователя в чате или в списке чатов
+  if (!findSession(args[0], sessionId))
+    return ServiceStatus::UserNotFound;
+
+  if (command._kind == BatchCommandKind::List) {
+    std::vector<ChatSummary> chats;
+    bool hasMore;
+    return _chatService.listChats(sessionId, args.size() > 1 ? toNumber(args[1]) : 0, INBOX_PAGE_SIZE, chats,
+                                  hasMore);
+  }
+
+  if (!findChat(args[1], chatId))
+    return ServiceStatus::ChatNotFound;
+
+  switch (command._kind) {
+  case BatchCommandKind::Send: {
+    std::size_t messageId;
+    return _chatService.sendMessage(sessionId, chatId, args[2], messageId);
+  }
+  case BatchCommandKind::Read: {
+    ChatWindow window;
+    std::vector<MessageView> messages;
+    return _chatService.readChat(sessionId, chatId, args.size() > 2 ? toNumber(args[2]) : SIZE_MAX,
+                                 args.size() > 3 ? toNumber(args[3]) : CHAT_WINDOW_SIZE, window, messages);
+  }
+  case BatchCommandKind::Mark: {
+    // без индекса - прочитано все
+    std::size_t lastRead = SIZE_MAX;
+    if (args.size() > 2) {
+      lastRead = toNumber(args[2]);
+    } else {
+      auto chat_ptr = _chatSystem.getChatById(chatId);
+      if (!chat_ptr)
+        return ServiceStatus::ChatNotFound;
+      std::shared_lock<std::shared_mutex> lock(chat_ptr->getMutex());
+      lastRead = chat_ptr->getMessageCount();
+    }
+    return _chatService.markRead(sessionId, chatId, lastRead);
+  }
+  default:
+    return ServiceStatus::Ok;
+  }
+}
+
+/**
+ * @brief Executes all loaded commands in order.
+ * @param errors Receives one line per failed command.
+ * @return Number of failed commands.
+ */
+std::size_t BatchRunner::run(std::ostream &errors) {
+  for (auto &stats : _stats)
+    stats._latencies.reserve(_commands.size() / _stats.size());
+
+  std::size_t failures = 0;
+  auto runStart = Clock::now();
+  for (const auto &command : _commands) {
+    auto start = Clock::now();
+    ServiceStatus status = execute(command);
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+    auto &stats = _stats[static_cast<std::size_t>(command._kind)];
+    stats._latencies.push_back(static_cast<std::uint32_t>(std::min<long long>(elapsed, UINT32_MAX)));
+    if (status == ServiceStatus::Ok)
+      continue;
+
+    ++stats._failures;
+    if (++failures <= BATCH_ERRORS_SHOWN)
+      errors << "строка " << command._line << ": " << getStatusText(status) << '\n';
+  }
+  _runSeconds = std::chrono::duration<double>(Clock::now() - runStart).count();
+
+  if (failures > BATCH_ERRORS_SHOWN)
+    errors << "... и еще " << failures - BATCH_ERRORS_SHOWN << " ошибок\n";
+  return failures;
+}
+
+/**
+ * @brief Prints operations per second and latency percentiles of each command kind.
+ * @param out Stream for the report.
+ */
+void BatchRunner::printReport(std::ostream &out) const {
+  // заголовок выровнен вручную: printf считает ширину кириллицы в байтах
+  out << "команда        всего   ошибок         оп/с   p50 мкс   p90 мкс   p99 мкс  макс мкс\n";
+
+  char line[160];
+
+  std::size_t total = 0;
+  std::vector<std::uint32_t> latencies;
+  for (std::size_t kind = 0; kind < _stats.size(); ++kind) {
+    const auto &stats = _stats[kind];
+    if (stats._latencies.empty())
+      continue;
+
+    latencies = stats._latencies;
+    double busyNs = 0;
+    for (auto latency : latencies)
+      busyNs += latency;
+    total += latencies.size();
+
+    std::snprintf(line, sizeof(line), "%-9s %10zu %8zu %12.0f %9.2f %9.2f %9.2f %9.2f\n", COMMAND_NAMES[kind],
+                  latencies.size(), stats._failures, busyNs > 0 ? latencies.size() * 1e9 / busyNs : 0.0,
+                  percentile(latencies, 50) / 1e3, percentile(latencies, 90) / 1e3, percentile(latencies, 99) / 1e3,
+                  *std::max_element(latencies.begin(), latencies.end()) / 1e3);
+    out << line;
+  }
+
+  std::snprintf(line, sizeof(line), "Всего %zu команд за %.3f с - %.0f оп/с; не разобрано строк: %zu\n", total,
+                _runSeconds, _runSeconds > 0 ? total / _runSeconds : 0.0, _parseErrors);
+  out << line;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "service/chat_service.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Command of a batch script.
+ */
+enum class BatchCommandKind : unsigned char {
+  Register = 0, ///< register <login> <password> <name>
+  Login,        ///< login <login> <password>
+  Chat,         ///< chat <alias> <creator login> <login> [<login> ...]
+  Send,         ///< send <login> <alias> <text to the end of the line>
+  Read,         ///< read <login> <alias> [<first> [<count>]]
+  Mark,         ///< mark <login> <alias> [<read index>]
+  List,         ///< list <login> [<offset>]
+  Count         ///< Number of kinds.
+};
+
+/**
+ * @brief One parsed line of a batch script.
+ */
+struct BatchCommand {
+  BatchCommandKind _kind = BatchCommandKind::Register; ///< Command.
+  std::size_t _line = 0;                              ///< Line in the script, for error messages.
+  std::vector<std::string> _args;                     ///< Arguments; for send the last one is the whole text.
+};
+
+/**
+ * @brief Runs a command script against ChatService without prompts or screen output.
+ * @details The script is parsed completely before the run, so only the operations
+ * themselves are timed. Chats are named by aliases given in the chat command; an alias
+ * that was not defined and is a number is taken as a chat ID, so scripts can also
+ * address chats restored from storage. Blank lines and lines starting with # are skipped.
+ * Each login named in the script acts in its own session: the login command opens it
+ * with the password, any other command opens it on first use without one.
+ */
+class BatchRunner {
+private:
+  /**
+   * @brief Results of one command kind.
+   */
+  struct KindStats {
+    std::vector<std::uint32_t> _latencies; ///< Time of each call, ns.
+    std::size_t _failures = 0;             ///< Calls that did not return Ok.
+  };
+
+  ChatSystem &_chatSystem;                                       ///< The driven chat system (not owned).
+  ChatService _chatService;                                      ///< Operations on the chat system.
+  std::vector<BatchCommand> _commands;                           ///< Parsed script.
+  std::unordered_map<std::string, std::size_t> _chatAliases;     ///< Alias -> chat ID.
+  std::unordered_map<std::string, SessionId> _sessions;          ///< Login -> session.
+  std::array<KindStats, static_cast<std::size_t>(BatchCommandKind::Count)> _stats; ///< Per command kind.
+  std::size_t _parseErrors = 0;                                  ///< Lines that could not be parsed.
+  double _runSeconds = 0;                                        ///< Wall time of the last run.
+
+  /**
+   * @brief Executes one command.
+   * @param command The command.
+   * @return Result of the service call; UserNotFound or ChatNotFound for unknown names.
+   */
+  ServiceStatus execute(const BatchCommand &command);
+
+  /**
+   * @brief Resolves a login.
+   * @param login The login.
+   * @param userId Receives the handle.
+   * @return True if the user exists.
+   */
+  bool findUser(const std::string &login, UserId &userId) const;
+
+  /**
+   * @brief Gets the session of a login, opening it on first use.
+   * @param login The login.
+   * @param sessionId Receives the handle.
+   * @return True if the user exists.
+   */
+  bool findSession(const std::string &login, SessionId &sessionId);
+
+  /**
+   * @brief Resolves a chat alias or chat ID.
+   * @param alias The alias.
+   * @param chatId Receives the chat ID.
+   * @return True if the alias is known or is a number.
+   */
+  bool findChat(const std::string &alias, std::size_t &chatId) const;
+
+public:
+  /**
+   * @brief Constructor.
+   * @param chatSystem The chat system to drive; must outlive the runner.
+   */
+  explicit BatchRunner(ChatSystem &chatSystem);
+
+  /**
+   * @brief Parses a script and appends its commands.
+   * @param input Stream with the script.
+   * @param errors Receives one line per unparsable script line.
+   * @return Number of parsed commands.
+   */
+  std::size_t load(std::istream &input, std::ostream &errors);
+
+  /**
+   * @brief Executes all loaded commands in order.
+   * @param errors Receives one line per failed command.
+   * @return Number of failed commands.
+   */
+  std::size_t run(std::ostream &errors);
+
+  /**
+   * @brief Prints operations per second and latency percentiles of each command kind.
+   * @param out Stream for the report.
+   */
+  void printReport(std::ostream &out) const;
+};
@@ -0,0 +1,401 @@
+#include "service/chat_service.h"
+#include "chat/chat.h"
+#include "exception/validation_exception.h"
+#include "system/picosha2.h"
+#include "system/utf8_scan.h"
+#include "user/user.h"
+#include "user/user_chat_list.h"
+#include <algorithm>
+#include <memory>
+
+/**
+ * @brief Validates a login or password string against defined constraints.
+ * @param inputData The input string to validate.
+ * @param contentLengthMin The minimum allowed length.
+ * @param contentLengthMax The maximum allowed length.
+ * @param isPassword Set to true if the input is a password, false if it's a login.
+ * @return True if the input passes all validation checks.
+ * @throws InvalidQuantityCharacterException If the length is outside the allowed range.
+ * @throws InvalidCharacterException If non-ASCII or invalid characters are found.
+ * @throws NonCapitalCharacterException If the password lacks an uppercase letter.
+ * @throws NonDigitalCharacterException If the password lacks a numeric digit.
+ */
+bool checkNewDataInputForLimits(const std::string &inputData, std::size_t contentLengthMin,
+                                std::size_t contentLengthMax, bool isPassword) {
+
+  // логин, пароль и имя - только ASCII
+  Utf8ScanResult scan = scanUtf8(inputData, UTF8_CLASS_ASCII);
+  if (!scan.isValid())
+    throw InvalidCharacterException(std::string(scan.rejectedChar(inputData)));
+
+  std::size_t utf8SymbolCount = scan._codePoints;
+  bool isCapital = (scan._classes & UTF8_CLASS_LATIN_UPPER) != 0;
+  bool isNumber = (scan._classes & UTF8_CLASS_DIGIT) != 0;
+
+  if (utf8SymbolCount < contentLengthMin || utf8SymbolCount > contentLengthMax)
+    throw InvalidQuantityCharacterException();
+
+  if (isPassword) {
+    if (!isCapital)
+      throw NonCapitalCharacterException();
+    if (!isNumber)
+      throw NonDigitalCharacterException();
+  }
+
+  return true;
+}
+
+namespace {
+
+/**
+ * @brief Checks a registration field without throwing.
+ * @return True if the value passes checkNewDataInputForLimits.
+ */
+bool isValidUserData(const std::string &value, std::size_t lengthMin, std::size_t lengthMax, bool isPassword) {
+  try {
+    return checkNewDataInputForLimits(value, lengthMin, lengthMax, isPassword);
+  } catch (const ValidationException &) {
+    return false;
+  }
+}
+
+} // namespace
+
+/**
+ * @brief Gets the text shown to the user for a status.
+ * @param status The status.
+ * @return Message in Russian, empty for ServiceStatus::Ok.
+ */
+const char *getStatusText(ServiceStatus status) {
+  switch (status) {
+  case ServiceStatus::Ok:
+    return "";
+  case ServiceStatus::InvalidLogin:
+    return "!!!Недопустимый логин.";
+  case ServiceStatus::InvalidPassword:
+    return "!!!Недопустимый пароль.";
+  case ServiceStatus::InvalidName:
+    return "!!!Недопустимое имя.";
+  case ServiceStatus::LoginTaken:
+    return "!!!Логин уже занят.";
+  case ServiceStatus::UserNotFound:
+    return "!!!Такой пользователь не найден.";
+  case ServiceStatus::WrongPassword:
+    return "!!!Неверный пароль.";
+  case ServiceStatus::NoParticipants:
+    return "!!!В чате нет других участников.";
+  case ServiceStatus::ChatNotFound:
+    return "!!!Чат не найден.";
+  case ServiceStatus::NotParticipant:
+    return "!!!Пользователя нет среди участников чата.";
+  case ServiceStatus::EmptyMessage:
+    return "!!!Вы ничего не ввели.";
+  case ServiceStatus::OutOfRange:
+    return "!!!Номер сообщения вне допустимого диапазона.";
+  case ServiceStatus::SessionNotFound:
+    return "!!!Сеанс завершен, войдите снова.";
+  case ServiceStatus::MessageTooLarge:
+    return "!!!Сообщение слишком длинное.";
+  }
+  return "";
+}
+
+/**
+ * @brief Constructor.
+ * @param chatSystem The chat system to operate on; must outlive the service.
+ */
+ChatService::ChatService(ChatSystem &chatSystem) : _chatSystem(chatSystem) {}
+
+/**
+ * @brief Finds a chat of the user of a session.
+ * @param sessionId Handle of the session.
+ * @param chatId ID of the chat.
+ * @param userId Receives the handle of the user.
+ * @param status Receives SessionNotFound, ChatNotFound, NotParticipant or Ok.
+ * @return Shared pointer to the chat, nullptr unless status is Ok.
+ */
+std::shared_ptr<Chat> ChatService::findUserChat(SessionId sessionId, std::size_t chatId, UserId &userId,
+                                                ServiceStatus &status) const {
+  userId = _chatSystem.getSessions().getUserId(sessionId);
+  if (!userId.isValid()) {
+    status = ServiceStatus::SessionNotFound;
+    return nullptr;
+  }
+
+  auto chat_ptr = _chatSystem.getChatById(chatId);
+  if (!chat_ptr) {
+    status = ServiceStatus::ChatNotFound;
+    return nullptr;
+  }
+
+  const auto &participants = chat_ptr->getParticipants();
+  auto it = std::find_if(participants.begin(), participants.end(),
+                         [userId](const Participant &participant) { return participant._userId == userId; });
+  if (it == participants.end() || it->_deletedFromChat) {
+    status = ServiceStatus::NotParticipant;
+    return nullptr;
+  }
+
+  status = ServiceStatus::Ok;
+  return chat_ptr;
+}
+
+/**
+ * @brief Registers a new user.
+ * @param login Login, LOGIN_LENGTH_MIN..LOGIN_LENGTH_MAX ASCII characters.
+ * @param password Password in clear text; stored as a hash.
+ * @param userName Display name.
+ * @param userId Receives the handle of the new user.
+ * @return Ok, InvalidLogin, InvalidPassword, InvalidName or LoginTaken.
+ */
+ServiceStatus ChatService::registerUser(const std::string &login, const std::string &password,
+                                        const std::string &userName, UserId &userId) {
+  if (!isValidUserData(login, LOGIN_LENGTH_MIN, LOGIN_LENGTH_MAX, false))
+    return ServiceStatus::InvalidLogin;
+  if (!isValidUserData(password, PASSWORD_LENGTH_MIN, PASSWORD_LENGTH_MAX, true))
+    return ServiceStatus::InvalidPassword;
+  if (!isValidUserData(userName, USER_NAME_LENGTH_MIN, USER_NAME_LENGTH_MAX, false))
+    return ServiceStatus::InvalidName;
+  if (_chatSystem.findUserByLogin(login))
+    return ServiceStatus::LoginTaken;
+
+  const auto &passwordHash = picosha2::hash256_hex_string(password);
+  auto newUser = std::make_shared<User>(UserData(login, userName, passwordHash, "...@gmail.com", "+111"));
+
+  // логин мог занять другой поток, пока считался хеш
+  if (!_chatSystem.addUser(newUser))
+    return ServiceStatus::LoginTaken;
+
+  userId = newUser->getUserId();
+  return ServiceStatus::Ok;
+}
+
+/**
+ * @brief Checks the credentials of a user and opens a session.
+ * @param login Login.
+ * @param password Password in clear text.
+ * @param sessionId Receives the handle of the new session.
+ * @return Ok, UserNotFound or WrongPassword.
+ */
+ServiceStatus ChatService::login(const std::string &login, const std::string &password, SessionId &sessionId) {
+  auto user_ptr = _chatSystem.findUserByLogin(login);
+  if (!user_ptr)
+    return ServiceStatus::UserNotFound;
+
+  if (!user_ptr->checkPassword(picosha2::hash256_hex_string(password)))
+    return ServiceStatus::WrongPassword;
+
+  sessionId = _chatSystem.getSessions().open(user_ptr->getUserId());
+  return ServiceStatus::Ok;
+}
+
+/**
+ * @brief Closes a session and cancels its subscription.
+ * @param sessionId Handle of the session.
+ * @return Ok or SessionNotFound.
+ */
+ServiceStatus ChatService::logout(SessionId sessionId) {
+  UserId userId = _chatSystem.getSessions().getUserId(sessionId);
+  if (!userId.isValid())
+    return ServiceStatus::SessionNotFound;
+
+  _chatSystem.getDelivery().unsubscribe(userId, sessionId);
+  return _chatSystem.getSessions().close(sessionId) ? ServiceStatus::Ok : ServiceStatus::SessionNotFound;
+}
+
+/**
+ * @brief Subscribes a session to the new messages of the chats of its user.
+ * @param sessionId Handle of the session.
+ * @param notify Called when a message arrives into the empty queue of the session.
+ * @param queue Receives the queue of the session.
+ * @return Ok or SessionNotFound.
+ */
+ServiceStatus ChatService::subscribe(SessionId sessionId, std::function<void(SessionId)> notify,
+                                     std::shared_ptr<DeliveryQueue> &queue) {
+  UserId userId = _chatSystem.getSessions().getUserId(sessionId);
+  if (!userId.isValid())
+    return ServiceStatus::SessionNotFound;
+
+  queue = _chatSystem.getDelivery().subscribe(userId, sessionId, std::move(notify));
+  return ServiceStatus::Ok;
+}
+
+/**
+ * @brief Creates a chat and adds it to the chat lists of its participants.
+ * @param creator Session of the user creating the chat.
+ * @param participants Handles of the other participants; duplicates and the creator are skipped.
+ * @param chatId Receives the ID of the new chat.
+ * @return Ok, SessionNotFound, UserNotFound or NoParticipants.
+ */
+ServiceStatus ChatService::createChat(SessionId creator, const std::vector<UserId> &participants,
+                                      std::size_t &chatId) {
+  const auto &userTable = _chatSystem.getUserTable();
+  UserId creatorId = _chatSystem.getSessions().getUserId(creator);
+  if (!creatorId.isValid())
+    return ServiceStatus::SessionNotFound;
+
+  auto creator_ptr = userTable.getShared(creatorId);
+  if (!creator_ptr)
+    return ServiceStatus::UserNotFound;
+
+  // проверяем всех участников до создания чата
+  std::vector<std::shared_ptr<User>> users;
+  users.push_back(creator_ptr);
+  for (auto userId : participants) {
+    auto user_ptr = userTable.getShared(userId);
+    if (!user_ptr)
+      return ServiceStatus::UserNotFound;
+    if (std::find(users.begin(), users.end(), user_ptr) == users.end())
+      users.push_back(user_ptr);
+  }
+  if (users.size() < 2)
+    return ServiceStatus::NoParticipants;
+
+  auto chat = std::make_shared<Chat>(userTable);
+  for (const auto &user : users)
+    chat->addParticipant(user);
+
+  _chatSystem.addChat(chat);
+
+  // участники уже могут писать в чат - список чатов читает его под блокировкой
+  std::shared_lock<std::shared_mutex> lock(chat->getMutex());
+  for (const auto &user : users)
+    user->getUserChatList()->addChat(chat);
+
+  chatId = chat->getChatId();
+  return ServiceStatus::Ok;
+}
+
+/**
+ * @brief Sends a text message; the sender's read index moves past it.
+ * @param sessionId Session of the sender.
+ * @param chatId ID of the chat.
+ * @param text Message text.
+ * @param messageId Receives the ID of the new message.
+ * @return Ok, EmptyMessage, SessionNotFound, ChatNotFound or NotParticipant.
+ */
+ServiceStatus ChatService::sendMessage(SessionId sessionId, std::size_t chatId, std::string_view text,
+                                       std::size_t &messageId) {
+  if (text.empty())
+    return ServiceStatus::EmptyMessage;
+
+  ServiceStatus status;
+  UserId sender;
+  auto chat_ptr = findUserChat(sessionId, chatId, sender, status);
+  if (!chat_ptr)
+    return status;
+
+  // текст копируется сразу в хранилище сообщений чата, без промежуточного Message
+  MessagePart part;
+  part._kind = ContentKind::Text;
+  part._value = text;
+  const User *sender_ptr = _chatSystem.getUserTable().get(sender);
+
+  // ID берется под блокировкой чата: внутри чата ID возрастают
+  std::unique_lock<std::shared_mutex> lock(chat_ptr->getMutex());
+  messageId = _chatSystem.getNewMessageId();
+  chat_ptr->addMessage(messageId, sender, getCurrentTimeStamp(), &part, 1);
+  if (sender_ptr)
+    chat_ptr->updateLastReadMessageIndex(*sender_ptr, chat_ptr->getMessageCount());
+  return ServiceStatus::Ok;
+}
+
+/**
+ * @brief Gets one page of the chats of a user, most recently active first.
+ * @param sessionId Session of the user.
+ * @param offset Number of chats to skip.
+ * @param limit Maximum number of chats.
+ * @param chats Receives the chats.
+ * @param hasMore Receives true if there are more chats after this page.
+ * @return Ok, SessionNotFound or UserNotFound.
+ */
+ServiceStatus ChatService::listChats(SessionId sessionId, std::size_t offset, std::size_t limit,
+                                     std::vector<ChatSummary> &chats, bool &hasMore) const {
+  chats.clear();
+  UserId userId = _chatSystem.getSessions().getUserId(sessionId);
+  if (!userId.isValid())
+    return ServiceStatus::SessionNotFound;
+
+  const User *user_ptr = _chatSystem.getUserTable().get(userId);
+  if (!user_ptr || !user_ptr->getUserChatList())
+    return ServiceStatus::UserNotFound;
+
+  auto &chatList = *user_ptr->getUserChatList();
+  std::lock_guard<std::mutex> lock(chatList.getMutex());
+  std::vector<const InboxEntry *> page;
+  hasMore = chatList.getInbox().getPage(offset, limit, page);
+
+  for (const auto *entry : page) {
+    auto chat_ptr = entry->_chat.lock();
+    if (!chat_ptr)
+      continue;
+
+    ChatSummary summary;
+    summary._chatId = chat_ptr->getChatId();
+    summary._lastActivity = entry->_lastActivity;
+    summary._messageCount = entry->_messageCount;
+    summary._unreadCount = entry->getUnreadCount();
+    chats.push_back(summary);
+  }
+  return ServiceStatus::Ok;
+}
+
+/**
+ * @brief Reads a window of messages of a chat without changing the read index.
+ * @param sessionId Session of the reader; remembers the chat and the window.
+ * @param chatId ID of the chat.
+ * @param first Position of the first message; past the end means the last window.
+ * @param count Size of the window.
+ * @param window Receives the position of the window.
+ * @param messages Receives the messages; valid while the window holds the lock of the chat.
+ * @return Ok, SessionNotFound, ChatNotFound or NotParticipant.
+ */
+ServiceStatus ChatService::readChat(SessionId sessionId, std::size_t chatId, std::size_t first, std::size_t count,
+                                    ChatWindow &window, std::vector<MessageView> &messages) {
+  messages.clear();
+  // блокировка прошлого окна снимается до поиска чата - это может быть тот же чат
+  window = ChatWindow();
+  ServiceStatus status;
+  UserId userId;
+  auto chat_ptr = findUserChat(sessionId, chatId, userId, status);
+  if (!chat_ptr)
+    return status;
+
+  window._lock = std::shared_lock<std::shared_mutex>(chat_ptr->getMutex());
+
+  const auto &chatMessages = chat_ptr->getMessages();
+  window._messageCount = chatMessages.size();
+  window._lastRead = chat_ptr->getLastReadMessageIndex(userId);
+  window._first = first < window._messageCount ? first : chat_ptr->getLastWindow(count);
+  window._end = std::min(window._first + count, window._messageCount);
+
+  for (std::size_t i = window._first; i < window._end; ++i)
+    messages.push_back(chatMessages[i]);
+
+  _chatSystem.getSessions().setChatWindow(sessionId, chatId, window._first);
+  return ServiceStatus::Ok;
+}
+
+/**
+ * @brief Sets the read index of a user in a chat.
+ * @param sessionId Session of the reader.
+ * @param chatId ID of the chat.
+ * @param lastReadMessageIndex Number of messages read from the start of the chat.
+ * @return Ok, SessionNotFound, ChatNotFound, NotParticipant or OutOfRange.
+ */
+ServiceStatus ChatService::markRead(SessionId sessionId, std::size_t chatId, std::size_t lastReadMessageIndex) {
+  ServiceStatus status;
+  UserId userId;
+  auto chat_ptr = findUserChat(sessionId, chatId, userId, status);
+  if (!chat_ptr)
+    return status;
+
+  const User *user_ptr = _chatSystem.getUserTable().get(userId);
+  std::unique_lock<std::shared_mutex> lock(chat_ptr->getMutex());
+  if (lastReadMessageIndex > chat_ptr->getMessageCount())
+    return ServiceStatus::OutOfRange;
+
+  if (user_ptr)
+    chat_ptr->updateLastReadMessageIndex(*user_ptr, lastReadMessageIndex);
+  return ServiceStatus::Ok;
+}
@@ -0,0 +1,213 @@
+#pragma once
+#include "ChatBot/chat_system.h"
+#include "message/message_store.h"
+#include "system/date_time_utils.h"
+#include "user/delivery_table.h"
+#include "user/user_id.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+const std::size_t LOGIN_LENGTH_MIN = 5;      ///< Минимальная длина логина.
+const std::size_t LOGIN_LENGTH_MAX = 15;     ///< Максимальная длина логина.
+const std::size_t PASSWORD_LENGTH_MIN = 5;   ///< Минимальная длина пароля.
+const std::size_t PASSWORD_LENGTH_MAX = 10;  ///< Максимальная длина пароля.
+const std::size_t USER_NAME_LENGTH_MIN = 3;  ///< Минимальная длина имени.
+const std::size_t USER_NAME_LENGTH_MAX = 10; ///< Максимальная длина имени.
+
+/**
+ * @brief Validates a login or password string against defined constraints.
+ * @param inputData The input string to validate.
+ * @param contentLengthMin The minimum allowed length.
+ * @param contentLengthMax The maximum allowed length.
+ * @param isPassword Set to true if the input is a password, false if it's a login.
+ * @return True if the input passes all validation checks.
+ * @throws InvalidQuantityCharacterException If the length is outside the allowed range.
+ * @throws InvalidCharacterException If non-ASCII or invalid characters are found.
+ * @throws NonCapitalCharacterException If the password lacks an uppercase letter.
+ * @throws NonDigitalCharacterException If the password lacks a numeric digit.
+ */
+bool checkNewDataInputForLimits(const std::string &inputData, std::size_t contentLengthMin,
+                                std::size_t contentLengthMax, bool isPassword);
+
+/**
+ * @brief Result of a ChatService operation.
+ */
+enum class ServiceStatus : unsigned char {
+  Ok = 0,          ///< Operation done.
+  InvalidLogin,    ///< Login breaks the length or character rules.
+  InvalidPassword, ///< Password breaks the length or character rules.
+  InvalidName,     ///< Display name breaks the length or character rules.
+  LoginTaken,      ///< Another user has this login.
+  UserNotFound,    ///< No user with this login or handle.
+  WrongPassword,   ///< Password does not match.
+  NoParticipants,  ///< A chat needs at least one other participant.
+  ChatNotFound,    ///< No chat with this ID.
+  NotParticipant,  ///< The user is not a participant of the chat.
+  EmptyMessage,    ///< Message text is empty.
+  OutOfRange,      ///< Message index past the end of the chat.
+  SessionNotFound, ///< The session is not open.
+  MessageTooLarge  ///< The message does not fit into a frame of ChatServer.
+};
+
+/**
+ * @brief Gets the text shown to the user for a status.
+ * @param status The status.
+ * @return Message in Russian, empty for ServiceStatus::Ok.
+ */
+const char *getStatusText(ServiceStatus status);
+
+/**
+ * @brief A chat in the list of a user.
+ */
+struct ChatSummary {
+  std::size_t _chatId = 0;       ///< ID of the chat.
+  TimeStamp _lastActivity = 0;   ///< Time of the last message, 0 without messages.
+  std::size_t _messageCount = 0; ///< Number of messages.
+  std::size_t _unreadCount = 0;  ///< Messages the user has not read.
+};
+
+/**
+ * @brief Position of a window of messages returned by ChatService::readChat.
+ * @details Holds a shared lock of the chat, so the returned messages stay valid while
+ * other threads write to it; reset the window before changing the same chat.
+ */
+struct ChatWindow {
+  std::size_t _first = 0;        ///< Position of the first message of the window.
+  std::size_t _end = 0;          ///< Position after the last message of the window.
+  std::size_t _messageCount = 0; ///< Number of messages in the chat.
+  std::size_t _lastRead = 0;     ///< Last read message index of the user.
+  std::shared_lock<std::shared_mutex> _lock; ///< Lock of the read chat.
+};
+
+/**
+ * @brief Typed operations of the chat system without console input or output.
+ * @details Every operation returns a ServiceStatus and reports its results through
+ * output parameters, so the interactive menus, a batch driver or benchmarks call the
+ * same code. Operations of a logged-in user take the handle of the session opened by
+ * login(), other users are addressed by UserId and chats by chat ID; the service keeps
+ * no state of its own besides the chat system and its session table.
+ * The operations may be called from several threads: writes to a chat take its lock
+ * exclusively, reads take it shared, so threads working in different chats do not wait
+ * for each other.
+ */
+class ChatService {
+private:
+  ChatSystem &_chatSystem; ///< The served chat system (not owned).
+
+  /**
+   * @brief Finds a chat of the user of a session.
+   * @param sessionId Handle of the session.
+   * @param chatId ID of the chat.
+   * @param userId Receives the handle of the user.
+   * @param status Receives SessionNotFound, ChatNotFound, NotParticipant or Ok.
+   * @return Shared pointer to the chat, nullptr unless status is Ok.
+   */
+  std::shared_ptr<Chat> findUserChat(SessionId sessionId, std::size_t chatId, UserId &userId,
+                                     ServiceStatus &status) const;
+
+public:
+  /**
+   * @brief Constructor.
+   * @param chatSystem The chat system to operate on; must outlive the service.
+   */
+  explicit ChatService(ChatSystem &chatSystem);
+
+  /**
+   * @brief Registers a new user.
+   * @param login Login, LOGIN_LENGTH_MIN..LOGIN_LENGTH_MAX ASCII characters.
+   * @param password Password in clear text; stored as a hash.
+   * @param userName Display name.
+   * @param userId Receives the handle of the new user.
+   * @return Ok, InvalidLogin, InvalidPassword, InvalidName or LoginTaken.
+   */
+  ServiceStatus registerUser(const std::string &login, const std::string &password, const std::string &userName,
+                             UserId &userId);
+
+  /**
+   * @brief Checks the credentials of a user and opens a session.
+   * @param login Login.
+   * @param password Password in clear text.
+   * @param sessionId Receives the handle of the new session.
+   * @return Ok, UserNotFound or WrongPassword.
+   * @details Every call opens another session, so one user may be logged in from
+   * several clients at once.
+   */
+  ServiceStatus login(const std::string &login, const std::string &password, SessionId &sessionId);
+
+  /**
+   * @brief Closes a session and cancels its subscription.
+   * @param sessionId Handle of the session.
+   * @return Ok or SessionNotFound.
+   */
+  ServiceStatus logout(SessionId sessionId);
+
+  /**
+   * @brief Subscribes a session to the new messages of the chats of its user.
+   * @param sessionId Handle of the session.
+   * @param notify Called, possibly from the thread of the sender, when a message arrives
+   * into the empty queue; must be cheap and must not call the service.
+   * @param queue Receives the queue of the session; logout() cancels the subscription.
+   * @return Ok or SessionNotFound.
+   */
+  ServiceStatus subscribe(SessionId sessionId, std::function<void(SessionId)> notify,
+                          std::shared_ptr<DeliveryQueue> &queue);
+
+  /**
+   * @brief Creates a chat and adds it to the chat lists of its participants.
+   * @param creator Session of the user creating the chat.
+   * @param participants Handles of the other participants; duplicates and the creator are skipped.
+   * @param chatId Receives the ID of the new chat.
+   * @return Ok, SessionNotFound, UserNotFound or NoParticipants.
+   */
+  ServiceStatus createChat(SessionId creator, const std::vector<UserId> &participants, std::size_t &chatId);
+
+  /**
+   * @brief Sends a text message; the sender's read index moves past it.
+   * @param sender Session of the sender.
+   * @param chatId ID of the chat.
+   * @param text Message text; copied only into the storage of the chat.
+   * @param messageId Receives the ID of the new message.
+   * @return Ok, EmptyMessage, SessionNotFound, ChatNotFound or NotParticipant.
+   */
+  ServiceStatus sendMessage(SessionId sender, std::size_t chatId, std::string_view text, std::size_t &messageId);
+
+  /**
+   * @brief Gets one page of the chats of a user, most recently active first.
+   * @param sessionId Session of the user.
+   * @param offset Number of chats to skip.
+   * @param limit Maximum number of chats.
+   * @param chats Receives the chats.
+   * @param hasMore Receives true if there are more chats after this page.
+   * @return Ok, SessionNotFound or UserNotFound.
+   */
+  ServiceStatus listChats(SessionId sessionId, std::size_t offset, std::size_t limit, std::vector<ChatSummary> &chats,
+                          bool &hasMore) const;
+
+  /**
+   * @brief Reads a window of messages of a chat without changing the read index.
+   * @param sessionId Session of the reader; remembers the chat and the window.
+   * @param chatId ID of the chat.
+   * @param first Position of the first message; past the end means the last window.
+   * @param count Size of the window.
+   * @param window Receives the position of the window.
+   * @param messages Receives the messages; valid while the window holds the lock of the chat.
+   * @return Ok, SessionNotFound, ChatNotFound or NotParticipant.
+   */
+  ServiceStatus readChat(SessionId sessionId, std::size_t chatId, std::size_t first, std::size_t count,
+                         ChatWindow &window, std::vector<MessageView> &messages);
+
+  /**
+   * @brief Sets the read index of a user in a chat.
+   * @param sessionId Session of the reader.
+   * @param chatId ID of the chat.
+   * @param lastReadMessageIndex Number of messages read from the start of the chat.
+   * @return Ok, SessionNotFound, ChatNotFound, NotParticipant or OutOfRange.
+   */
+  ServiceStatus markRead(SessionId sessionId, std::size_t chatId, std::size_t lastReadMessageIndex);
+};
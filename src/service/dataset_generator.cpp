@@ -0,0 +1,356 @@
+#include "service/dataset_generator.h"
+#include "chat/chat.h"
+#include "system/picosha2.h"
+#include "user/user.h"
+#include "user/user_chat_list.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char *const USER_NAMES[] = {"Саша",  "Елена", "Сергей", "Виталий", "Мария", "Федор", "Вера",    "Яков",
+                                  "Ольга", "Иван",  "Анна",   "Петр",    "Ирина", "Борис", "Наталья", "Дмитрий"};
+
+const std::string_view MESSAGE_WORDS[] = {"привет", "как",     "дела",    "встречаемся", "завтра", "в",      "кино",
+                                           "кофе",   "отлично", "спасибо", "когда",       "где",    "давай",  "позже",
+                                           "сегодня", "вечером", "у",      "входа",       "жду",    "ответа", "ок",
+                                           "хорошо", "не",      "могу",    "созвонимся",  "пришли", "фото",   "документ"};
+
+const std::size_t MESSAGE_WORDS_MIN = 2;  ///< Минимум слов в сообщении.
+const std::size_t MESSAGE_WORDS_MAX = 12; ///< Максимум слов в сообщении.
+const double FULLY_READ_SHARE = 0.7;      ///< Доля участников, прочитавших чат до конца.
+
+/**
+ * @brief Mixes the seed with a number into an independent seed.
+ */
+std::uint64_t mixSeed(std::uint64_t seed, std::uint64_t value) {
+  std::uint64_t z = seed + 0x9e3779b97f4a7c15ULL * (value + 1);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/**
+ * @brief Small random generator (splitmix64).
+ * @details Several times faster than std::mt19937_64 with the standard distributions, which
+ * took most of the time of writing a message; the sequence is the same on every platform.
+ */
+class DatasetRandom {
+private:
+  std::uint64_t _state; ///< Current state.
+
+public:
+  explicit DatasetRandom(std::uint64_t seed) : _state(seed) {}
+
+  /**
+   * @brief Gets the next 64 random bits.
+   */
+  std::uint64_t next() {
+    _state += 0x9e3779b97f4a7c15ULL;
+    return mixSeed(_state, 0);
+  }
+
+  /**
+   * @brief Gets a number in [0, 1).
+   */
+  double unit() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+  /**
+   * @brief Gets a number in [0, bound).
+   */
+  std::size_t below(std::size_t bound) { return static_cast<std::size_t>(unit() * bound); }
+};
+
+/**
+ * @brief Gets the expected size of a generated message text.
+ */
+std::size_t getAverageMessageBytes() {
+  std::size_t wordBytes = 0;
+  for (auto word : MESSAGE_WORDS)
+    wordBytes += word.size() + 1; // слово и пробел или точка
+  return wordBytes * (MESSAGE_WORDS_MIN + MESSAGE_WORDS_MAX) / 2 / std::size(MESSAGE_WORDS);
+}
+
+/**
+ * @brief Builds the cumulative Zipf weights 1/(i+1)^s of count ranks.
+ */
+std::vector<double> makeZipfCdf(std::size_t count, double exponent) {
+  std::vector<double> cdf(count);
+  double sum = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    sum += 1.0 / std::pow(static_cast<double>(i + 1), exponent);
+    cdf[i] = sum;
+  }
+  return cdf;
+}
+
+/**
+ * @brief Draws a rank from cumulative weights.
+ */
+std::size_t drawRank(const std::vector<double> &cdf, DatasetRandom &random) {
+  double point = random.unit() * cdf.back();
+  auto it = std::upper_bound(cdf.begin(), cdf.end(), point);
+  return std::min(static_cast<std::size_t>(it - cdf.begin()), cdf.size() - 1);
+}
+
+/**
+ * @brief Splits total messages among the chats in proportion to the Zipf weights.
+ */
+std::vector<std::size_t> splitMessages(std::size_t total, const std::vector<double> &cdf) {
+  std::vector<std::size_t> counts(cdf.size());
+  if (cdf.empty())
+    return counts;
+
+  std::size_t assigned = 0;
+  for (std::size_t i = 0; i < cdf.size(); ++i) {
+    double weight = cdf[i] - (i > 0 ? cdf[i - 1] : 0);
+    counts[i] = static_cast<std::size_t>(total * weight / cdf.back());
+    assigned += counts[i];
+  }
+  // остаток от округления - самым активным чатам
+  for (std::size_t i = 0; assigned < total; i = (i + 1) % counts.size(), ++assigned)
+    ++counts[i];
+  return counts;
+}
+
+/**
+ * @brief Runs work(thread number) in threadCount threads, one of them the calling thread.
+ */
+template <typename Work> void runInThreads(std::size_t threadCount, const Work &work) {
+  std::vector<std::thread> threads;
+  for (std::size_t t = 1; t < threadCount; ++t)
+    threads.emplace_back(work, t);
+  work(0);
+  for (auto &thread : threads)
+    thread.join();
+}
+
+/**
+ * @brief A chat being generated.
+ */
+struct ChatPlan {
+  std::shared_ptr<Chat> _chat;              ///< The chat, not yet in the chat system.
+  std::vector<std::size_t> _participants;   ///< User numbers of the participants.
+  std::size_t _firstMessageId = 0;          ///< ID of the first message; the others follow.
+  std::size_t _messageCount = 0;            ///< Number of messages.
+};
+
+/**
+ * @brief Writes the messages of a chat and sets the read indexes of its participants.
+ */
+void fillChat(ChatPlan &plan, std::size_t chatNumber, const DatasetConfig &config,
+              const std::vector<std::shared_ptr<User>> &users) {
+  DatasetRandom random(mixSeed(config._seed, chatNumber));
+
+  // сообщения равномерно в среднем распределены по периоду, последнее - не позже _endTime
+  TimeStamp period = static_cast<TimeStamp>(config._days) * 24 * 60 * 60 * 1000;
+  TimeStamp meanGap = plan._messageCount > 0 ? period / static_cast<TimeStamp>(plan._messageCount) : 0;
+  TimeStamp timeStamp = config._endTime - period;
+
+  static const std::size_t averageMessageBytes = getAverageMessageBytes();
+  plan._chat->reserveMessages(plan._messageCount, plan._messageCount * averageMessageBytes);
+
+  std::vector<std::size_t> afterOwn(plan._participants.size(), 0);
+  std::string text;
+
+  for (std::size_t m = 0; m < plan._messageCount; ++m) {
+    std::size_t sender = random.below(plan._participants.size());
+    timeStamp = std::min(timeStamp + static_cast<TimeStamp>(random.below(2 * meanGap + 1)), config._endTime);
+
+    text.clear();
+    for (std::size_t w = MESSAGE_WORDS_MIN + random.below(MESSAGE_WORDS_MAX - MESSAGE_WORDS_MIN + 1); w > 0; --w) {
+      text += MESSAGE_WORDS[random.below(std::size(MESSAGE_WORDS))];
+      text += w > 1 ? ' ' : '.';
+    }
+
+    MessagePart part;
+    part._value = text;
+    plan._chat->restoreMessage(plan._firstMessageId + m, users[plan._participants[sender]]->getUserId(), timeStamp,
+                               &part, 1);
+    afterOwn[sender] = m + 1;
+  }
+
+  // чат еще не в списках чатов участников - их списки только просматриваются
+  for (std::size_t p = 0; p < plan._participants.size(); ++p)
+    plan._chat->updateLastReadMessageIndex(users[plan._participants[p]],
+                                           random.unit() < FULLY_READ_SHARE ? plan._messageCount : afterOwn[p]);
+}
+
+/**
+ * @brief Reads a number from a spec value.
+ */
+bool parseNumber(const std::string &value, std::size_t &number) {
+  if (value.empty() || !std::all_of(value.begin(), value.end(), [](char ch) { return ch >= '0' && ch <= '9'; }))
+    return false;
+  number = std::strtoull(value.c_str(), nullptr, 10);
+  return true;
+}
+
+/**
+ * @brief Reads a non-negative fraction from a spec value.
+ */
+bool parseReal(const std::string &value, double &number) {
+  char *end = nullptr;
+  number = std::strtod(value.c_str(), &end);
+  return !value.empty() && *end == '\0' && number >= 0 && std::isfinite(number);
+}
+
+} // namespace
+
+/**
+ * @brief Reads a data set description like "users=100000,chats=200000,messages=50".
+ * @param spec Comma-separated key=value pairs.
+ * @param config Receives the values.
+ * @return False if a key is unknown or a value is invalid.
+ */
+bool parseDatasetSpec(const std::string &spec, DatasetConfig &config) {
+  std::size_t begin = 0;
+  while (begin < spec.size()) {
+    std::size_t end = spec.find(',', begin);
+    if (end == std::string::npos)
+      end = spec.size();
+
+    std::string item = spec.substr(begin, end - begin);
+    begin = end + 1;
+    std::size_t equals = item.find('=');
+    if (equals == std::string::npos)
+      return false;
+
+    std::string key = item.substr(0, equals);
+    std::string value = item.substr(equals + 1);
+    std::size_t number = 0;
+    bool valid;
+
+    if (key == "users") {
+      valid = parseNumber(value, config._userCount);
+    } else if (key == "chats") {
+      valid = parseNumber(value, config._chatCount);
+    } else if (key == "messages") {
+      valid = parseNumber(value, config._messagesPerChat);
+    } else if (key == "groups") {
+      valid = parseReal(value, config._groupShare) && config._groupShare <= 1;
+    } else if (key == "group") {
+      std::size_t dash = value.find('-');
+      valid = dash != std::string::npos && parseNumber(value.substr(0, dash), config._groupSizeMin) &&
+              parseNumber(value.substr(dash + 1), config._groupSizeMax);
+    } else if (key == "zipf") {
+      valid = parseReal(value, config._zipfExponent);
+    } else if (key == "seed") {
+      valid = parseNumber(value, number);
+      config._seed = number;
+    } else if (key == "threads") {
+      valid = parseNumber(value, config._threadCount);
+    } else if (key == "password") {
+      valid = !value.empty();
+      config._password = value;
+    } else if (key == "days") {
+      valid = parseNumber(value, config._days) && config._days > 0;
+    } else {
+      valid = false;
+    }
+
+    if (!valid)
+      return false;
+  }
+
+  // групповой чат - минимум трое, и участников должно хватать
+  return config._userCount >= 2 && config._groupSizeMin >= 3 && config._groupSizeMin <= config._groupSizeMax &&
+         (config._groupShare == 0 || config._groupSizeMin <= config._userCount);
+}
+
+/**
+ * @brief Fills an empty chat system with a synthetic data set.
+ * @param chatSystem The chat system; must have no users.
+ * @param config Shape of the data set.
+ * @return Number of generated messages.
+ */
+std::size_t generateDataset(ChatSystem &chatSystem, const DatasetConfig &config) {
+  // журнал на миллионы записей не нужен - данные сохраняет снимок
+  auto mutationLog = chatSystem.getMutationLog();
+  chatSystem.attachMutationLog(nullptr);
+
+  DatasetRandom random(config._seed);
+
+  // пользователи
+  std::size_t loginDigits = std::to_string(config._userCount > 0 ? config._userCount - 1 : 0).size();
+  std::string passwordHash = picosha2::hash256_hex_string(config._password);
+  std::vector<std::shared_ptr<User>> users;
+  users.reserve(config._userCount);
+  for (std::size_t i = 0; i < config._userCount; ++i) {
+    std::string number = std::to_string(i);
+    std::string login = "user" + std::string(loginDigits - number.size(), '0') + number;
+    auto user = std::make_shared<User>(
+        UserData(login, USER_NAMES[i % std::size(USER_NAMES)], passwordHash, login + "@example.com", "+111"));
+    chatSystem.addUser(user);
+    users.push_back(user);
+  }
+
+  // чаты и участники; сообщения и ID сообщений - по распределению Ципфа от номера чата
+  std::vector<double> userCdf = makeZipfCdf(config._userCount, config._zipfExponent);
+  std::vector<std::size_t> messageCounts =
+      splitMessages(config._chatCount * config._messagesPerChat, makeZipfCdf(config._chatCount, config._zipfExponent));
+
+  const std::size_t firstMessageId = chatSystem.getIdMessageManager().peekNextMessageId();
+  std::size_t nextMessageId = firstMessageId;
+
+  // в чате минимум двое
+  std::vector<ChatPlan> plans(config._userCount >= 2 ? config._chatCount : 0);
+  for (std::size_t c = 0; c < plans.size(); ++c) {
+    auto &plan = plans[c];
+    std::size_t size = 2;
+    if (random.unit() < config._groupShare)
+      size = std::min(config._groupSizeMin + random.below(config._groupSizeMax - config._groupSizeMin + 1),
+                      config._userCount);
+
+    // повторы перевыбираются; при сильном перекосе - равномерно
+    for (std::size_t attempt = 0; plan._participants.size() < size; ++attempt) {
+      std::size_t userNumber = attempt < 8 * size ? drawRank(userCdf, random) : random.below(config._userCount);
+      if (std::find(plan._participants.begin(), plan._participants.end(), userNumber) == plan._participants.end())
+        plan._participants.push_back(userNumber);
+    }
+
+    plan._chat = std::make_shared<Chat>(chatSystem.getUserTable());
+    for (auto userNumber : plan._participants)
+      plan._chat->addParticipant(users[userNumber]);
+
+    plan._firstMessageId = nextMessageId;
+    plan._messageCount = messageCounts[c];
+    nextMessageId += plan._messageCount;
+  }
+
+  // сообщения - параллельно, первыми берутся самые большие чаты
+  std::size_t threadCount = config._threadCount ? config._threadCount : std::thread::hardware_concurrency();
+  threadCount = std::max<std::size_t>(1, std::min(threadCount, plans.size()));
+
+  std::atomic<std::size_t> nextChat{0};
+  runInThreads(threadCount, [&](std::size_t) {
+    for (std::size_t c = nextChat++; c < plans.size(); c = nextChat++)
+      fillChat(plans[c], c, config, users);
+  });
+
+  for (auto &plan : plans)
+    chatSystem.addChat(plan._chat);
+
+  // списки чатов: каждый поток - своим пользователям, чаты только читаются
+  runInThreads(threadCount, [&](std::size_t thread) {
+    for (auto &plan : plans) {
+      for (auto userNumber : plan._participants) {
+        if (userNumber % threadCount == thread)
+          users[userNumber]->getUserChatList()->addChat(plan._chat);
+      }
+    }
+  });
+
+  auto &idMessageManager = chatSystem.getIdMessageManager();
+  idMessageManager.restore(nextMessageId, std::set<std::size_t>(idMessageManager.getFreeMessageIds()));
+  chatSystem.attachMutationLog(mutationLog);
+  return nextMessageId - firstMessageId;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "ChatBot/chat_system.h"
+#include "system/date_time_utils.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Shape of a generated data set.
+ */
+struct DatasetConfig {
+  std::size_t _userCount = 10000;        ///< Number of users.
+  std::size_t _chatCount = 20000;        ///< Number of chats.
+  std::size_t _messagesPerChat = 50;     ///< Average number of messages per chat.
+  double _groupShare = 0.2;              ///< Share of group chats; the others are one to one.
+  std::size_t _groupSizeMin = 3;         ///< Minimum number of participants of a group chat.
+  std::size_t _groupSizeMax = 10;        ///< Maximum number of participants of a group chat.
+  double _zipfExponent = 1.0;            ///< Skew of user and chat activity, 0 - uniform.
+  std::uint64_t _seed = 1;               ///< Seed; the same seed gives the same data set.
+  std::size_t _threadCount = 0;          ///< Threads filling the chats, 0 - one per core.
+  std::string _password = "Passw0rd";    ///< Password of all users.
+  TimeStamp _endTime = makeTimeStamp(2025, 4, 1, 0, 0, 0); ///< Time of the latest message.
+  std::size_t _days = 30;                ///< Length of the period the messages are spread over.
+};
+
+/**
+ * @brief Reads a data set description like "users=100000,chats=200000,messages=50".
+ * @param spec Comma-separated key=value pairs; keys: users, chats, messages, groups (share of
+ * group chats, 0-1), group (min-max participants), zipf, seed, threads, password, days.
+ * Missing keys keep their values in config.
+ * @param config Receives the values.
+ * @return False if a key is unknown or a value is invalid.
+ */
+bool parseDatasetSpec(const std::string &spec, DatasetConfig &config);
+
+/**
+ * @brief Fills an empty chat system with a synthetic data set.
+ * @param chatSystem The chat system; must have no users.
+ * @param config Shape of the data set.
+ * @return Number of generated messages.
+ * @details User i gets the login "user<i>" (zero-padded) and the activity weight 1/(i+1)^s
+ * of a Zipf distribution, so active users take part in more chats; the message counts of
+ * the chats follow the same distribution over the chat number. Senders are drawn evenly
+ * from the participants of a chat.
+ * Users, chats and participants are created in one thread; the messages of the chats are
+ * then written by several threads, each chat with its own random generator seeded from
+ * the seed and the chat number, and the chat lists are filled by several threads split by
+ * user, so the result does not depend on the number of threads.
+ * Each participant has read the chat up to its own last message, most of them to the end.
+ * Mutations are not journaled; with storage write a checkpoint afterwards.
+ */
+std::size_t generateDataset(ChatSystem &chatSystem, const DatasetConfig &config);
@@ -0,0 +1,150 @@
+#include "storage/binary_codec.h"
+#include "exception/storage_exception.h"
+#include <array>
+
+namespace {
+
+/**
+ * @brief Builds the lookup table for the reflected CRC-32 polynomial 0xEDB88320.
+ */
+std::array<std::uint32_t, 256> makeCrcTable() {
+  std::array<std::uint32_t, 256> table{};
+  for (std::uint32_t i = 0; i < 256; ++i) {
+    std::uint32_t value = i;
+    for (int bit = 0; bit < 8; ++bit)
+      value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+    table[i] = value;
+  }
+  return table;
+}
+
+} // namespace
+
+/**
+ * @brief Computes the CRC-32 checksum of a byte range.
+ * @param data Pointer to the first byte.
+ * @param size Number of bytes.
+ * @return Checksum value.
+ */
+std::uint32_t crc32(const char *data, std::size_t size) {
+  static const std::array<std::uint32_t, 256> table = makeCrcTable();
+
+  std::uint32_t crc = 0xFFFFFFFFu;
+  for (std::size_t i = 0; i < size; ++i)
+    crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+  return crc ^ 0xFFFFFFFFu;
+}
+
+/**
+ * @brief Constructor for BinaryWriter.
+ * @param buffer Buffer the data is appended to.
+ */
+BinaryWriter::BinaryWriter(std::string &buffer) : _buffer(buffer) {}
+
+/**
+ * @brief Appends one byte.
+ */
+void BinaryWriter::putU8(std::uint8_t value) { _buffer.push_back(static_cast<char>(value)); }
+
+/**
+ * @brief Appends a 32-bit little-endian integer.
+ */
+void BinaryWriter::putU32(std::uint32_t value) {
+  char bytes[4];
+  for (int i = 0; i < 4; ++i)
+    bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  _buffer.append(bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Appends a 64-bit little-endian integer.
+ */
+void BinaryWriter::putU64(std::uint64_t value) {
+  char bytes[8];
+  for (int i = 0; i < 8; ++i)
+    bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  _buffer.append(bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Appends a string prefixed with its 32-bit length.
+ */
+void BinaryWriter::putString(std::string_view value) {
+  putU32(static_cast<std::uint32_t>(value.size()));
+  _buffer.append(value);
+}
+
+/**
+ * @brief Constructor for BinaryReader.
+ * @param data Pointer to the first byte.
+ * @param size Number of bytes available.
+ */
+BinaryReader::BinaryReader(const char *data, std::size_t size) : _data(data), _size(size) {}
+
+/**
+ * @brief Checks that count more bytes are available.
+ * @throws CorruptedDataException If the range is too short.
+ */
+void BinaryReader::require(std::size_t count) const {
+  if (count > _size - _pos)
+    throw CorruptedDataException("Неожиданный конец записи.");
+}
+
+/**
+ * @brief Reads one byte.
+ */
+std::uint8_t BinaryReader::getU8() {
+  require(1);
+  return static_cast<std::uint8_t>(_data[_pos++]);
+}
+
+/**
+ * @brief Reads a 32-bit little-endian integer.
+ */
+std::uint32_t BinaryReader::getU32() {
+  require(4);
+  std::uint32_t value = 0;
+  for (int i = 0; i < 4; ++i)
+    value |= static_cast<std::uint32_t>(static_cast<unsigned char>(_data[_pos + i])) << (8 * i);
+  _pos += 4;
+  return value;
+}
+
+/**
+ * @brief Reads a 64-bit little-endian integer.
+ */
+std::uint64_t BinaryReader::getU64() {
+  require(8);
+  std::uint64_t value = 0;
+  for (int i = 0; i < 8; ++i)
+    value |= static_cast<std::uint64_t>(static_cast<unsigned char>(_data[_pos + i])) << (8 * i);
+  _pos += 8;
+  return value;
+}
+
+/**
+ * @brief Reads a length-prefixed string.
+ */
+std::string BinaryReader::getString() {
+  std::uint32_t length = getU32();
+  require(length);
+  std::string value(_data + _pos, length);
+  _pos += length;
+  return value;
+}
+
+/**
+ * @brief Reads a length-prefixed string without copying it.
+ */
+std::string_view BinaryReader::getStringView() {
+  std::uint32_t length = getU32();
+  require(length);
+  std::string_view value(_data + _pos, length);
+  _pos += length;
+  return value;
+}
+
+/**
+ * @brief Checks whether all bytes were consumed.
+ */
+bool BinaryReader::atEnd() const { return _pos == _size; }
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Computes the CRC-32 (IEEE 802.3) checksum of a byte range.
+ * @param data Pointer to the first byte.
+ * @param size Number of bytes.
+ * @return Checksum value.
+ */
+std::uint32_t crc32(const char *data, std::size_t size);
+
+/**
+ * @brief Appends little-endian integers and length-prefixed strings to a byte buffer.
+ * @details Used by the mutation log and the snapshot writer. The buffer is not owned.
+ */
+class BinaryWriter {
+private:
+  std::string &_buffer; ///< Target buffer.
+
+public:
+  /**
+   * @brief Constructor for BinaryWriter.
+   * @param buffer Buffer the data is appended to.
+   */
+  explicit BinaryWriter(std::string &buffer);
+
+  /**
+   * @brief Appends one byte.
+   * @param value Value to append.
+   */
+  void putU8(std::uint8_t value);
+
+  /**
+   * @brief Appends a 32-bit little-endian integer.
+   * @param value Value to append.
+   */
+  void putU32(std::uint32_t value);
+
+  /**
+   * @brief Appends a 64-bit little-endian integer.
+   * @param value Value to append.
+   */
+  void putU64(std::uint64_t value);
+
+  /**
+   * @brief Appends a string prefixed with its 32-bit length.
+   * @param value String to append.
+   */
+  void putString(std::string_view value);
+};
+
+/**
+ * @brief Reads values written by BinaryWriter from a byte range.
+ * @details Every read is bounds-checked; reading past the end throws CorruptedDataException.
+ */
+class BinaryReader {
+private:
+  const char *_data;    ///< Start of the range (not owned).
+  std::size_t _size;    ///< Size of the range.
+  std::size_t _pos = 0; ///< Current read position.
+
+  /**
+   * @brief Checks that count more bytes are available.
+   * @param count Number of bytes to be read.
+   * @throws CorruptedDataException If the range is too short.
+   */
+  void require(std::size_t count) const;
+
+public:
+  /**
+   * @brief Constructor for BinaryReader.
+   * @param data Pointer to the first byte.
+   * @param size Number of bytes available.
+   */
+  BinaryReader(const char *data, std::size_t size);
+
+  /**
+   * @brief Reads one byte.
+   * @return The value read.
+   */
+  std::uint8_t getU8();
+
+  /**
+   * @brief Reads a 32-bit little-endian integer.
+   * @return The value read.
+   */
+  std::uint32_t getU32();
+
+  /**
+   * @brief Reads a 64-bit little-endian integer.
+   * @return The value read.
+   */
+  std::uint64_t getU64();
+
+  /**
+   * @brief Reads a length-prefixed string.
+   * @return The string read.
+   */
+  std::string getString();
+
+  /**
+   * @brief Reads a length-prefixed string without copying it.
+   * @return View into the source range.
+   */
+  std::string_view getStringView();
+
+  /**
+   * @brief Checks whether all bytes were consumed.
+   * @return True if the read position is at the end of the range.
+   */
+  bool atEnd() const;
+};
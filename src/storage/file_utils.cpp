@@ -0,0 +1,33 @@
+#include "storage/file_utils.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * @brief Writes the whole range to a descriptor, retrying on partial writes and EINTR.
+ * @return True on success, false on error.
+ */
+bool writeAll(int fd, const char *data, std::size_t size) {
+  while (size > 0) {
+    ssize_t written = ::write(fd, data, size);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data += written;
+    size -= static_cast<std::size_t>(written);
+  }
+  return true;
+}
+
+/**
+ * @brief Makes created, renamed or removed file names of a directory durable.
+ */
+void syncDirectory(const std::string &directory) {
+  int dirFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dirFd < 0)
+    return;
+  ::fsync(dirFd);
+  ::close(dirFd);
+}
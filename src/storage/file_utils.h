@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Writes the whole range to a descriptor, retrying on partial writes and EINTR.
+ * @param fd Open file descriptor.
+ * @param data Pointer to the first byte.
+ * @param size Number of bytes.
+ * @return True on success, false on error.
+ */
+bool writeAll(int fd, const char *data, std::size_t size);
+
+/**
+ * @brief Makes created, renamed or removed file names of a directory durable.
+ * @param directory Path of the directory to sync.
+ */
+void syncDirectory(const std::string &directory);
@@ -0,0 +1,81 @@
+#include "storage/log_compactor.h"
+#include "ChatBot/chat_system.h"
+#include "exception/storage_exception.h"
+#include "storage/mutation_codec.h"
+#include "storage/snapshot.h"
+#include <iostream>
+
+/**
+ * @brief Starts the compaction thread.
+ * @param directory Data directory with the snapshot and the log.
+ * @param mutationLog Log of the live system.
+ * @param config Compaction settings.
+ * @param snapshotLsn LSN stored in the snapshot loaded at startup.
+ */
+LogCompactor::LogCompactor(const std::string &directory, const std::shared_ptr<MutationLog> &mutationLog,
+                           const LogCompactorConfig &config, std::uint64_t snapshotLsn)
+    : _directory(directory), _mutationLog(mutationLog), _config(config), _snapshotLsn(snapshotLsn) {
+  _worker = std::thread(&LogCompactor::workerLoop, this);
+}
+
+/**
+ * @brief Stops the compaction thread.
+ */
+LogCompactor::~LogCompactor() { stop(); }
+
+/**
+ * @brief Stops the thread, waiting for a running compaction to finish.
+ */
+void LogCompactor::stop() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _cv.notify_one();
+  if (_worker.joinable())
+    _worker.join();
+}
+
+/**
+ * @brief Body of the compaction thread.
+ * @details Errors are reported and the compaction is retried on the next interval:
+ * the log stays complete, so a failed compaction loses nothing.
+ */
+void LogCompactor::workerLoop() {
+  std::unique_lock<std::mutex> lock(_mutex);
+
+  while (!_cv.wait_for(lock, _config._interval, [this] { return _stop; })) {
+    if (_mutationLog->getLastLsn() - _snapshotLsn < _config._minRecords)
+      continue;
+
+    lock.unlock();
+    try {
+      compact();
+    } catch (const StorageException &ex) {
+      std::cerr << " ! " << ex.what() << std::endl;
+    }
+    lock.lock();
+  }
+}
+
+/**
+ * @brief Folds all sealed log records into a new snapshot and removes their segments.
+ * @throws StorageException If the log or the snapshot cannot be read or written.
+ */
+void LogCompactor::compact() {
+  std::uint64_t sealedLsn = _mutationLog->rotate();
+  if (sealedLsn <= _snapshotLsn)
+    return;
+
+  // теневая система собирается только из файлов, живая система не блокируется
+  ChatSystem shadow;
+  const std::string path = snapshotPath(_directory);
+  std::uint64_t lsn = loadSnapshot(path, shadow);
+  lsn = replayMutationLog(_directory, shadow, lsn, sealedLsn);
+  if (lsn != sealedLsn)
+    throw CorruptedDataException("Журнал обрывается на LSN " + std::to_string(lsn));
+
+  writeSnapshot(shadow, path, sealedLsn);
+  MutationLog::removeSegmentsUpTo(_directory, sealedLsn);
+  _snapshotLsn = sealedLsn;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "storage/mutation_log.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Tuning of the background compaction.
+ */
+struct LogCompactorConfig {
+  std::chrono::seconds _interval{30};   ///< How often the log size is checked.
+  std::uint64_t _minRecords = 10000;    ///< Records since the last snapshot that trigger a compaction.
+};
+
+/**
+ * @brief Background thread that folds the mutation log into a fresh snapshot.
+ *
+ * A compaction never touches the live ChatSystem. It seals the current log segment
+ * (MutationLog::rotate, which costs appenders nothing beyond the usual append lock),
+ * loads the previous snapshot and the sealed segments into a private shadow ChatSystem,
+ * writes the shadow as the new snapshot and deletes the segments it covers. Startup
+ * then replays at most _minRecords plus whatever arrived during one interval.
+ */
+class LogCompactor {
+private:
+  std::string _directory;                   ///< Data directory with the snapshot and the log.
+  std::shared_ptr<MutationLog> _mutationLog; ///< Log of the live system.
+  LogCompactorConfig _config;               ///< Compaction settings.
+  std::uint64_t _snapshotLsn;               ///< LSN covered by the current snapshot.
+
+  std::mutex _mutex;          ///< Protects _stop.
+  std::condition_variable _cv; ///< Wakes the thread on stop.
+  bool _stop = false;         ///< Set by stop().
+  std::thread _worker;        ///< Compaction thread.
+
+  /**
+   * @brief Body of the compaction thread.
+   */
+  void workerLoop();
+
+public:
+  /**
+   * @brief Starts the compaction thread.
+   * @param directory Data directory with the snapshot and the log.
+   * @param mutationLog Log of the live system.
+   * @param config Compaction settings.
+   * @param snapshotLsn LSN stored in the snapshot loaded at startup.
+   */
+  LogCompactor(const std::string &directory, const std::shared_ptr<MutationLog> &mutationLog,
+               const LogCompactorConfig &config, std::uint64_t snapshotLsn);
+  LogCompactor(const LogCompactor &) = delete;
+  LogCompactor &operator=(const LogCompactor &) = delete;
+
+  /**
+   * @brief Stops the compaction thread.
+   */
+  ~LogCompactor();
+
+  /**
+   * @brief Stops the thread, waiting for a running compaction to finish.
+   */
+  void stop();
+
+  /**
+   * @brief Folds all sealed log records into a new snapshot and removes their segments.
+   * @throws StorageException If the log or the snapshot cannot be read or written.
+   */
+  void compact();
+};
@@ -0,0 +1,216 @@
+#include "storage/mutation_codec.h"
+#include "ChatBot/chat_system.h"
+#include "chat/chat.h"
+#include "exception/storage_exception.h"
+#include "message/message_store.h"
+#include "storage/binary_codec.h"
+#include "user/user.h"
+#include "user/user_chat_list.h"
+#include <memory>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Finds a user by login or throws if the log refers to an unknown one.
+ */
+std::shared_ptr<User> requireUser(const ChatSystem &chatSystem, const std::string &login) {
+  auto user = chatSystem.findUserByLogin(login);
+  if (!user)
+    throw CorruptedDataException("В журнале неизвестный пользователь " + login);
+  return user;
+}
+
+/**
+ * @brief Finds a chat by ID or throws if the log refers to an unknown one.
+ */
+std::shared_ptr<Chat> requireChat(const ChatSystem &chatSystem, std::size_t chatId) {
+  auto chat = chatSystem.getChatById(chatId);
+  if (!chat)
+    throw CorruptedDataException("В журнале неизвестный чат " + std::to_string(chatId));
+  return chat;
+}
+
+} // namespace
+
+/**
+ * @brief Encodes the body of an AddUser record.
+ */
+void encodeAddUser(std::string &out, const User &user) {
+  BinaryWriter writer(out);
+  writer.putString(user.getLogin());
+  writer.putString(user.getUserName());
+  writer.putString(user.getPassword());
+  writer.putString(user.getEmail());
+  writer.putString(user.getPhone());
+}
+
+/**
+ * @brief Encodes the body of an AddChat record (chat ID and participants).
+ */
+void encodeAddChat(std::string &out, const Chat &chat) {
+  BinaryWriter writer(out);
+  writer.putU64(chat.getChatId());
+
+  const auto &participants = chat.getParticipants();
+  writer.putU32(static_cast<std::uint32_t>(participants.size()));
+  for (const auto &participant : participants) {
+    const User *user_ptr = chat.getUser(participant._userId);
+    writer.putString(user_ptr ? user_ptr->getLogin() : std::string());
+    writer.putU8(participant._deletedFromChat ? 1 : 0);
+  }
+}
+
+/**
+ * @brief Encodes the body of an AddMessage record.
+ */
+void encodeAddMessage(std::string &out, const Chat &chat, const MessageView &message) {
+  BinaryWriter writer(out);
+  writer.putU64(chat.getChatId());
+  writer.putU64(message.getMessageId());
+
+  const User *sender_ptr = chat.getUser(message.getSender());
+  writer.putString(sender_ptr ? sender_ptr->getLogin() : std::string());
+  writer.putU64(static_cast<std::uint64_t>(message.getTimeStamp()));
+
+  writer.putU32(static_cast<std::uint32_t>(message.getPartCount()));
+  for (std::size_t i = 0; i < message.getPartCount(); ++i) {
+    auto part = message.getPart(i);
+    writer.putU8(static_cast<std::uint8_t>(part._kind));
+    writer.putString(part._value);
+  }
+}
+
+/**
+ * @brief Encodes the body of a SetLastRead record.
+ */
+void encodeSetLastRead(std::string &out, std::size_t chatId, const std::string &login,
+                       std::size_t lastReadMessageIndex) {
+  BinaryWriter writer(out);
+  writer.putU64(chatId);
+  writer.putString(login);
+  writer.putU64(lastReadMessageIndex);
+}
+
+/**
+ * @brief Encodes the body of a SetUserField record.
+ */
+void encodeSetUserField(std::string &out, const std::string &login, UserField field, const std::string &value) {
+  BinaryWriter writer(out);
+  writer.putString(login);
+  writer.putU8(static_cast<std::uint8_t>(field));
+  writer.putString(value);
+}
+
+/**
+ * @brief Applies one log record to the chat system.
+ * @throws CorruptedDataException If the record refers to unknown users or chats.
+ */
+void applyMutation(ChatSystem &chatSystem, const MutationRecord &record) {
+  BinaryReader reader(record._body, record._bodySize);
+
+  switch (record._type) {
+  case MutationType::AddUser: {
+    UserData userData;
+    userData._login = reader.getString();
+    userData._userName = reader.getString();
+    userData._passwordHash = reader.getString();
+    userData._email = reader.getString();
+    userData._phone = reader.getString();
+
+    auto user = std::make_shared<User>(userData);
+    chatSystem.addUser(user);
+    break;
+  }
+  case MutationType::AddChat: {
+    std::size_t chatId = reader.getU64();
+    std::uint32_t participantCount = reader.getU32();
+
+    auto chat = std::make_shared<Chat>(chatSystem.getUserTable());
+    std::vector<std::shared_ptr<User>> participants;
+    for (std::uint32_t i = 0; i < participantCount; ++i) {
+      auto user = requireUser(chatSystem, reader.getString());
+      bool deletedFromChat = reader.getU8() != 0;
+
+      chat->addParticipant(user);
+      if (deletedFromChat)
+        chat->setDeletedFromChat(user);
+      participants.push_back(user);
+    }
+
+    chatSystem.restoreChat(chat, chatId);
+    for (const auto &user : participants)
+      user->getUserChatList()->addChat(chat);
+    break;
+  }
+  case MutationType::AddMessage: {
+    auto chat = requireChat(chatSystem, reader.getU64());
+    std::size_t messageId = reader.getU64();
+    std::string senderLogin = reader.getString();
+    auto timeStamp = static_cast<TimeStamp>(reader.getU64());
+
+    // части ссылаются на тело записи и копируются в хранилище чата
+    std::uint32_t partCount = reader.getU32();
+    std::vector<MessagePart> parts(partCount);
+    for (std::uint32_t i = 0; i < partCount; ++i) {
+      auto kind = static_cast<ContentKind>(reader.getU8());
+      if (kind != ContentKind::Text && kind != ContentKind::File && kind != ContentKind::Image)
+        throw CorruptedDataException("Неизвестный тип содержимого сообщения.");
+      parts[i] = {kind, reader.getStringView()};
+    }
+
+    UserId sender;
+    if (!senderLogin.empty())
+      sender = requireUser(chatSystem, senderLogin)->getUserId();
+
+    chatSystem.reserveMessageId(messageId);
+    chat->addMessage(messageId, sender, timeStamp, parts.data(), parts.size());
+    break;
+  }
+  case MutationType::SetLastRead: {
+    auto chat = requireChat(chatSystem, reader.getU64());
+    auto user = requireUser(chatSystem, reader.getString());
+    chat->updateLastReadMessageIndex(user, reader.getU64());
+    break;
+  }
+  case MutationType::SetUserField: {
+    auto user = requireUser(chatSystem, reader.getString());
+    auto field = static_cast<UserField>(reader.getU8());
+    std::string value = reader.getString();
+
+    switch (field) {
+    case UserField::Login:
+      user->setLogin(value);
+      break;
+    case UserField::UserName:
+      user->setUserName(value);
+      break;
+    case UserField::Password:
+      user->setPassword(value);
+      break;
+    case UserField::Email:
+      user->setEmail(value);
+      break;
+    case UserField::Phone:
+      user->setPhone(value);
+      break;
+    default:
+      throw CorruptedDataException("Неизвестное поле профиля.");
+    }
+    break;
+  }
+  default:
+    throw CorruptedDataException("Неизвестный тип записи журнала " + std::to_string(record._lsn));
+  }
+}
+
+/**
+ * @brief Restores the chat system from the mutation log.
+ * @return LSN of the last applied record.
+ */
+std::uint64_t replayMutationLog(const std::string &directory, ChatSystem &chatSystem, std::uint64_t afterLsn,
+                                std::uint64_t uptoLsn) {
+  return MutationLog::readRecords(
+      directory, afterLsn, [&chatSystem](const MutationRecord &record) { applyMutation(chatSystem, record); },
+      uptoLsn);
+}
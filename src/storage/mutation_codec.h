@@ -0,0 +1,72 @@
+#pragma once
+#include "message/message_content.h"
+#include "storage/mutation_log.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class ChatSystem;
+class Chat;
+class MessageView;
+class User;
+enum class UserField : unsigned char;
+
+/**
+ * @brief Encodes the body of an AddUser record.
+ * @param out Buffer the body is appended to.
+ * @param user The new user.
+ */
+void encodeAddUser(std::string &out, const User &user);
+
+/**
+ * @brief Encodes the body of an AddChat record (chat ID and participants).
+ * @param out Buffer the body is appended to.
+ * @param chat The new chat with its ID already assigned.
+ */
+void encodeAddChat(std::string &out, const Chat &chat);
+
+/**
+ * @brief Encodes the body of an AddMessage record.
+ * @param out Buffer the body is appended to.
+ * @param chat The chat that received the message; resolves the sender.
+ * @param message The new message.
+ */
+void encodeAddMessage(std::string &out, const Chat &chat, const MessageView &message);
+
+/**
+ * @brief Encodes the body of a SetLastRead record.
+ * @param out Buffer the body is appended to.
+ * @param chatId ID of the chat.
+ * @param login Login of the participant.
+ * @param lastReadMessageIndex The new index.
+ */
+void encodeSetLastRead(std::string &out, std::size_t chatId, const std::string &login,
+                       std::size_t lastReadMessageIndex);
+
+/**
+ * @brief Encodes the body of a SetUserField record.
+ * @param out Buffer the body is appended to.
+ * @param login Login identifying the user before the change.
+ * @param field The changed field.
+ * @param value The new value.
+ */
+void encodeSetUserField(std::string &out, const std::string &login, UserField field, const std::string &value);
+
+/**
+ * @brief Applies one log record to the chat system.
+ * @param chatSystem The system being restored.
+ * @param record The record to apply.
+ * @throws CorruptedDataException If the record refers to unknown users or chats.
+ */
+void applyMutation(ChatSystem &chatSystem, const MutationRecord &record);
+
+/**
+ * @brief Restores the chat system from the mutation log.
+ * @param directory Log directory.
+ * @param chatSystem The system to fill; must not have a mutation log attached.
+ * @param afterLsn Records up to this LSN are already reflected in chatSystem.
+ * @param uptoLsn Records after this LSN are not applied.
+ * @return LSN of the last applied record.
+ */
+std::uint64_t replayMutationLog(const std::string &directory, ChatSystem &chatSystem, std::uint64_t afterLsn = 0,
+                                std::uint64_t uptoLsn = UINT64_MAX);
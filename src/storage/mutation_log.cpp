@@ -0,0 +1,368 @@
+#include "storage/mutation_log.h"
+#include "exception/storage_exception.h"
+#include "storage/binary_codec.h"
+#include "storage/file_utils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+
+namespace {
+
+const char SEGMENT_MAGIC[8] = {'C', 'B', 'W', 'A', 'L', '0', '0', '2'}; ///< First bytes of every segment.
+const std::size_t RECORD_HEADER_SIZE = 8;                                ///< [u32 size][u32 crc].
+const std::size_t RECORD_PREFIX_SIZE = 9;                                ///< [u64 lsn][u8 type].
+
+/**
+ * @brief Builds the file name of a segment from its first LSN.
+ */
+std::string segmentPath(const std::string &directory, std::uint64_t firstLsn) {
+  char name[48];
+  std::snprintf(name, sizeof(name), "mutation-%020llu.log", static_cast<unsigned long long>(firstLsn));
+  return (std::filesystem::path(directory) / name).string();
+}
+
+/**
+ * @brief Extracts the first LSN from a segment file name.
+ */
+std::uint64_t segmentFirstLsn(const std::string &path) {
+  const std::string name = std::filesystem::path(path).stem().string();
+  return std::stoull(name.substr(std::string("mutation-").size()));
+}
+
+} // namespace
+
+/**
+ * @brief Opens the log for appending.
+ * @param directory Directory with the segment files; created if missing.
+ * @param config Group commit settings.
+ * @param nextLsn LSN given to the first appended record.
+ * @throws StorageIOException If the directory cannot be created.
+ */
+MutationLog::MutationLog(const std::string &directory, const MutationLogConfig &config, std::uint64_t nextLsn)
+    : _directory(directory), _config(config), _lastLsn(nextLsn - 1), _durableLsn(nextLsn - 1) {
+  std::error_code error;
+  std::filesystem::create_directories(_directory, error);
+  if (error)
+    throw StorageIOException(_directory);
+
+  _flusher = std::thread(&MutationLog::flusherLoop, this);
+}
+
+/**
+ * @brief Flushes everything appended so far and stops the flusher.
+ */
+MutationLog::~MutationLog() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _flushCv.notify_one();
+  _flusher.join();
+
+  if (_fd >= 0)
+    ::close(_fd);
+}
+
+/**
+ * @brief Throws StorageIOException if the flusher has failed. Caller holds _mutex.
+ */
+void MutationLog::checkFailed() const {
+  if (_failed)
+    throw StorageIOException(_failedPath);
+}
+
+/**
+ * @brief Appends a record to the current batch.
+ * @param type Record kind.
+ * @param body Type-specific payload.
+ * @return LSN assigned to the record.
+ */
+std::uint64_t MutationLog::append(MutationType type, const std::string &body) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  checkFailed();
+
+  std::uint64_t lsn = ++_lastLsn;
+  bool wasEmpty = _pending.empty();
+  if (wasEmpty)
+    _pendingFirstLsn = lsn;
+
+  // [u32 size][u32 crc] дописываем после тела, когда crc уже известен
+  std::size_t headerPos = _pending.size();
+  _pending.append(RECORD_HEADER_SIZE, '\0');
+  std::size_t payloadPos = _pending.size();
+
+  BinaryWriter writer(_pending);
+  writer.putU64(lsn);
+  writer.putU8(static_cast<std::uint8_t>(type));
+  _pending.append(body);
+
+  std::string header;
+  BinaryWriter headerWriter(header);
+  headerWriter.putU32(static_cast<std::uint32_t>(_pending.size() - payloadPos));
+  headerWriter.putU32(crc32(_pending.data() + payloadPos, _pending.size() - payloadPos));
+  _pending.replace(headerPos, RECORD_HEADER_SIZE, header);
+
+  bool overflow = _pending.size() >= _config._maxPendingBytes;
+  lock.unlock();
+
+  // будим флашер только на первой записи пачки или при переполнении
+  if (wasEmpty || overflow)
+    _flushCv.notify_one();
+  return lsn;
+}
+
+/**
+ * @brief Blocks until every record appended before the call is on disk.
+ */
+void MutationLog::sync() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  checkFailed();
+
+  std::uint64_t target = _lastLsn;
+  if (_durableLsn >= target)
+    return;
+
+  _flushRequested = true;
+  _flushCv.notify_one();
+  _durableCv.wait(lock, [this, target] { return _durableLsn >= target || _failed; });
+  checkFailed();
+}
+
+/**
+ * @brief Flushes the current batch and seals the current segment.
+ * @return LSN up to which all records are in sealed segments.
+ */
+std::uint64_t MutationLog::rotate() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  checkFailed();
+
+  _rotateRequested = true;
+  _flushRequested = true;
+  _flushCv.notify_one();
+  _durableCv.wait(lock, [this] { return !_rotateRequested || _failed; });
+  checkFailed();
+  return _rotatedLsn;
+}
+
+/**
+ * @brief Gets the LSN of the last appended record.
+ */
+std::uint64_t MutationLog::getLastLsn() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _lastLsn;
+}
+
+/**
+ * @brief Gets the LSN of the last record known to be on disk.
+ */
+std::uint64_t MutationLog::getDurableLsn() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _durableLsn;
+}
+
+/**
+ * @brief Body of the flusher thread.
+ * @details Waits for the first record of a batch, then lets the batch grow for at most one
+ * durability window before writing it with a single write() + fdatasync().
+ */
+void MutationLog::flusherLoop() {
+  std::string batch;
+  std::unique_lock<std::mutex> lock(_mutex);
+
+  while (true) {
+    _flushCv.wait(lock, [this] { return _stop || _rotateRequested || !_pending.empty(); });
+    _flushCv.wait_for(lock, _config._durabilityWindow, [this] {
+      return _stop || _flushRequested || _pending.size() >= _config._maxPendingBytes;
+    });
+    _flushRequested = false;
+
+    if (_pending.empty()) {
+      if (_rotateRequested) { // пачки нет - просто закрываем сегмент
+        sealSegment();
+        _rotatedLsn = _durableLsn;
+        _rotateRequested = false;
+        _durableCv.notify_all();
+      }
+      if (_stop)
+        break;
+      continue;
+    }
+
+    batch.swap(_pending);
+    std::uint64_t firstLsn = _pendingFirstLsn;
+    std::uint64_t lastLsn = _lastLsn;
+    bool rotate = _rotateRequested;
+    lock.unlock();
+
+    bool written = true;
+    try {
+      writeBatch(batch, firstLsn);
+    } catch (const StorageIOException &) {
+      written = false;
+    }
+    batch.clear();
+
+    if (written && rotate)
+      sealSegment();
+
+    lock.lock();
+    if (written) {
+      _durableLsn = lastLsn;
+      if (rotate) {
+        _rotatedLsn = lastLsn;
+        _rotateRequested = false;
+      }
+    } else {
+      _failed = true;
+      _failedPath = segmentPath(_directory, firstLsn);
+    }
+    _durableCv.notify_all();
+
+    if (_failed)
+      break;
+  }
+}
+
+/**
+ * @brief Writes a batch to the current segment and syncs it.
+ * @throws StorageIOException On write or sync errors.
+ */
+void MutationLog::writeBatch(const std::string &batch, std::uint64_t firstLsn) {
+  if (_fd < 0 || _segmentBytes >= _config._segmentSizeLimit)
+    openSegment(firstLsn);
+
+  if (!writeAll(_fd, batch.data(), batch.size()) || ::fdatasync(_fd) != 0)
+    throw StorageIOException(_directory);
+
+  _segmentBytes += batch.size();
+}
+
+/**
+ * @brief Closes the current segment; the next batch starts a new one.
+ */
+void MutationLog::sealSegment() {
+  if (_fd >= 0)
+    ::close(_fd);
+  _fd = -1;
+}
+
+/**
+ * @brief Closes the current segment and creates a new one.
+ * @throws StorageIOException If the file cannot be created.
+ */
+void MutationLog::openSegment(std::uint64_t firstLsn) {
+  if (_fd >= 0)
+    ::close(_fd);
+
+  std::string path = segmentPath(_directory, firstLsn);
+  _fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+  if (_fd < 0 || !writeAll(_fd, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)))
+    throw StorageIOException(path);
+
+  syncDirectory(_directory);
+  _segmentBytes = sizeof(SEGMENT_MAGIC);
+}
+
+/**
+ * @brief Lists segment files of a directory ordered by their first LSN.
+ */
+std::vector<std::string> MutationLog::listSegments(const std::string &directory) {
+  std::vector<std::string> segments;
+  std::error_code error;
+
+  for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+    const std::string name = entry.path().filename().string();
+    if (name.rfind("mutation-", 0) == 0 && entry.path().extension() == ".log")
+      segments.push_back(entry.path().string());
+  }
+
+  // номер LSN в имени дополнен нулями, поэтому лексикографический порядок совпадает с числовым
+  std::sort(segments.begin(), segments.end());
+  return segments;
+}
+
+/**
+ * @brief Reads all valid records with LSN greater than afterLsn.
+ * @throws CorruptedDataException If a segment has a wrong header or records are missing.
+ * @details Reading of a segment stops at the first torn or damaged record: that is the tail
+ * that was being written when the process stopped.
+ */
+std::uint64_t MutationLog::readRecords(const std::string &directory, std::uint64_t afterLsn,
+                                       const std::function<void(const MutationRecord &)> &callback,
+                                       std::uint64_t uptoLsn) {
+  std::uint64_t lastLsn = afterLsn;
+  const auto segments = listSegments(directory);
+
+  for (std::size_t index = 0; index < segments.size(); ++index) {
+    const auto &path = segments[index];
+
+    // сегмент целиком покрыт снимком, если следующий начинается не дальше afterLsn + 1
+    if (index + 1 < segments.size() && segmentFirstLsn(segments[index + 1]) <= afterLsn + 1)
+      continue;
+    if (segmentFirstLsn(path) > uptoLsn)
+      break;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+      throw StorageIOException(path);
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (data.size() < sizeof(SEGMENT_MAGIC))
+      continue; // сегмент создан, но заголовок не успел записаться
+    if (std::memcmp(data.data(), SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0)
+      throw CorruptedDataException("Неверный заголовок сегмента " + path);
+
+    std::size_t pos = sizeof(SEGMENT_MAGIC);
+    while (data.size() - pos >= RECORD_HEADER_SIZE) {
+      BinaryReader header(data.data() + pos, RECORD_HEADER_SIZE);
+      std::uint32_t size = header.getU32();
+      std::uint32_t crc = header.getU32();
+
+      const char *payload = data.data() + pos + RECORD_HEADER_SIZE;
+      if (size < RECORD_PREFIX_SIZE || size > data.size() - pos - RECORD_HEADER_SIZE ||
+          crc32(payload, size) != crc)
+        break; // оборванный хвост
+
+      BinaryReader prefix(payload, RECORD_PREFIX_SIZE);
+      MutationRecord record;
+      record._lsn = prefix.getU64();
+      record._type = static_cast<MutationType>(prefix.getU8());
+      record._body = payload + RECORD_PREFIX_SIZE;
+      record._bodySize = size - RECORD_PREFIX_SIZE;
+      pos += RECORD_HEADER_SIZE + size;
+
+      if (record._lsn <= lastLsn)
+        continue;
+      if (record._lsn > uptoLsn)
+        return lastLsn;
+      if (lastLsn != 0 && record._lsn != lastLsn + 1)
+        throw CorruptedDataException("Пропущены записи журнала перед LSN " + std::to_string(record._lsn));
+
+      callback(record);
+      lastLsn = record._lsn;
+    }
+  }
+  return lastLsn;
+}
+
+/**
+ * @brief Removes the segments sealed by rotate() that hold only records up to lsn.
+ * @details rotate() guarantees that every record after the returned LSN is written to a
+ * segment whose first LSN is greater, so all segments starting at or before lsn are sealed.
+ */
+void MutationLog::removeSegmentsUpTo(const std::string &directory, std::uint64_t lsn) {
+  bool removed = false;
+  for (const auto &path : listSegments(directory)) {
+    if (segmentFirstLsn(path) > lsn)
+      break;
+    std::error_code error;
+    removed |= std::filesystem::remove(path, error);
+  }
+  if (removed)
+    syncDirectory(directory);
+}
@@ -0,0 +1,182 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Kinds of records stored in the mutation log.
+ */
+enum class MutationType : std::uint8_t {
+  AddUser = 1,      ///< ChatSystem::addUser.
+  AddChat = 2,      ///< ChatSystem::addChat (participants only).
+  AddMessage = 3,   ///< Chat::addMessage.
+  SetLastRead = 4,  ///< Chat::updateLastReadMessageIndex.
+  SetUserField = 5, ///< Profile setters of User.
+};
+
+/**
+ * @brief Tuning of the group commit.
+ */
+struct MutationLogConfig {
+  std::chrono::microseconds _durabilityWindow{2000}; ///< Max time a record stays only in memory.
+  std::size_t _maxPendingBytes = 1 << 20;            ///< Buffered bytes that trigger an early flush.
+  std::size_t _segmentSizeLimit = 64 << 20;          ///< Segment size after which a new file is started.
+};
+
+/**
+ * @brief A decoded record passed to the replay callback.
+ * @details The body points into the segment buffer and is valid only during the callback.
+ */
+struct MutationRecord {
+  std::uint64_t _lsn;    ///< Log sequence number.
+  MutationType _type;    ///< Record kind.
+  const char *_body;     ///< Type-specific payload.
+  std::size_t _bodySize; ///< Payload size in bytes.
+};
+
+/**
+ * @brief Append-only, segmented write-ahead log with group commit.
+ *
+ * append() only copies the record into an in-memory batch and returns. A background
+ * flusher writes the whole batch with one write() and one fdatasync() at most every
+ * durability window (or earlier when the batch grows past _maxPendingBytes), so the
+ * cost of a single record is a memcpy rather than a disk flush.
+ *
+ * On disk the log is a set of files "mutation-<first lsn>.log". Each record is
+ * [u32 size][u32 crc32][u64 lsn][u8 type][body]. A torn or damaged tail is
+ * ignored on replay.
+ */
+class MutationLog {
+private:
+  std::string _directory;    ///< Directory with the segment files.
+  MutationLogConfig _config; ///< Group commit settings.
+
+  int _fd = -1;                  ///< Descriptor of the current segment (flusher thread only).
+  std::size_t _segmentBytes = 0; ///< Bytes written to the current segment.
+
+  mutable std::mutex _mutex;           ///< Protects the fields below.
+  std::condition_variable _flushCv;    ///< Wakes the flusher.
+  std::condition_variable _durableCv;  ///< Signals sync() waiters.
+  std::string _pending;                ///< Records not yet handed to the flusher.
+  std::uint64_t _pendingFirstLsn = 0;  ///< LSN of the first record in _pending.
+  std::uint64_t _lastLsn = 0;          ///< LSN of the last appended record.
+  std::uint64_t _durableLsn = 0;       ///< LSN of the last record on disk.
+  bool _flushRequested = false;        ///< Set by sync() to skip the window wait.
+  bool _rotateRequested = false;       ///< Set by rotate(); cleared when the segment is sealed.
+  std::uint64_t _rotatedLsn = 0;       ///< Last LSN of the segments sealed by rotate().
+  bool _stop = false;                  ///< Set by the destructor.
+  bool _failed = false;                ///< Set when the flusher hit an I/O error.
+  std::string _failedPath;             ///< File that caused the error.
+
+  std::thread _flusher; ///< Background group-commit thread.
+
+  /**
+   * @brief Body of the flusher thread.
+   */
+  void flusherLoop();
+
+  /**
+   * @brief Writes a batch to the current segment and syncs it.
+   * @param batch Encoded records.
+   * @param firstLsn LSN of the first record in the batch.
+   */
+  void writeBatch(const std::string &batch, std::uint64_t firstLsn);
+
+  /**
+   * @brief Closes the current segment; the next batch starts a new one.
+   */
+  void sealSegment();
+
+  /**
+   * @brief Closes the current segment and creates a new one.
+   * @param firstLsn LSN of the first record of the new segment.
+   */
+  void openSegment(std::uint64_t firstLsn);
+
+  /**
+   * @brief Throws StorageIOException if the flusher has failed. Caller holds _mutex.
+   */
+  void checkFailed() const;
+
+public:
+  /**
+   * @brief Opens the log for appending.
+   * @param directory Directory with the segment files; created if missing.
+   * @param config Group commit settings.
+   * @param nextLsn LSN given to the first appended record (last replayed LSN + 1).
+   */
+  MutationLog(const std::string &directory, const MutationLogConfig &config, std::uint64_t nextLsn);
+  MutationLog(const MutationLog &) = delete;
+  MutationLog &operator=(const MutationLog &) = delete;
+
+  /**
+   * @brief Flushes everything appended so far and stops the flusher.
+   */
+  ~MutationLog();
+
+  /**
+   * @brief Appends a record to the current batch.
+   * @param type Record kind.
+   * @param body Type-specific payload.
+   * @return LSN assigned to the record.
+   * @throws StorageIOException If an earlier flush failed.
+   */
+  std::uint64_t append(MutationType type, const std::string &body);
+
+  /**
+   * @brief Blocks until every record appended before the call is on disk.
+   * @throws StorageIOException If the flush failed.
+   */
+  void sync();
+
+  /**
+   * @brief Flushes the current batch and seals the current segment.
+   * @return LSN up to which all records are in sealed segments; later records go to new segments.
+   * @throws StorageIOException If the flush failed.
+   * @details Appenders are blocked only for the usual append critical section; the caller
+   * waits for one flush.
+   */
+  std::uint64_t rotate();
+
+  /**
+   * @brief Gets the LSN of the last appended record.
+   */
+  std::uint64_t getLastLsn() const;
+
+  /**
+   * @brief Gets the LSN of the last record known to be on disk.
+   */
+  std::uint64_t getDurableLsn() const;
+
+  /**
+   * @brief Lists segment files of a directory ordered by their first LSN.
+   * @param directory Log directory.
+   * @return Full paths of the segments.
+   */
+  static std::vector<std::string> listSegments(const std::string &directory);
+
+  /**
+   * @brief Reads all valid records with LSN greater than afterLsn.
+   * @param directory Log directory.
+   * @param afterLsn Records up to this LSN are skipped.
+   * @param callback Called for each record in LSN order.
+   * @param uptoLsn Reading stops after this LSN.
+   * @return LSN of the last record read, or afterLsn if there were none.
+   */
+  static std::uint64_t readRecords(const std::string &directory, std::uint64_t afterLsn,
+                                   const std::function<void(const MutationRecord &)> &callback,
+                                   std::uint64_t uptoLsn = UINT64_MAX);
+
+  /**
+   * @brief Removes the segments sealed by rotate() that hold only records up to lsn.
+   * @param directory Log directory.
+   * @param lsn A value returned by rotate() and covered by a snapshot.
+   */
+  static void removeSegmentsUpTo(const std::string &directory, std::uint64_t lsn);
+};
@@ -0,0 +1,470 @@
+#include "storage/snapshot.h"
+#include "ChatBot/chat_system.h"
+#include "chat/chat.h"
+#include "exception/storage_exception.h"
+#include "message/message_store.h"
+#include "storage/binary_codec.h"
+#include "storage/file_utils.h"
+#include "storage/mutation_log.h"
+#include "user/user.h"
+#include "user/user_chat_list.h"
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <set>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'C', 'B', 'S', 'N', 'A', 'P', '\0', '\0'}; ///< First bytes of the file.
+const std::uint32_t BYTE_ORDER_MARK = 0x01020304;                          ///< Detects foreign byte order.
+
+/**
+ * @brief Rounds an offset up to the 8-byte alignment of the sections.
+ */
+std::uint64_t alignOffset(std::uint64_t offset) { return (offset + 7) & ~std::uint64_t(7); }
+
+/**
+ * @brief Computes the header checksum with the checksum field zeroed.
+ */
+std::uint32_t headerCrc(SnapshotHeader header) {
+  header._headerCrc = 0;
+  return crc32(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+/**
+ * @brief Checks that [first, first + count) lies inside a section of total elements.
+ * @throws CorruptedDataException If it does not.
+ */
+void checkRange(std::uint64_t first, std::uint64_t count, std::uint64_t total) {
+  if (first > total || count > total - first)
+    throw CorruptedDataException("Ссылка за пределы секции снимка.");
+}
+
+/**
+ * @brief Collects the sections of a snapshot before they are written out.
+ */
+struct SnapshotBuilder {
+  std::vector<SnapshotUser> _users;
+  std::vector<std::uint64_t> _chatRefs;
+  std::vector<SnapshotChat> _chats;
+  std::vector<SnapshotParticipant> _participants;
+  std::vector<SnapshotMessage> _messages;
+  std::vector<SnapshotContentPart> _contentParts;
+  std::vector<std::uint64_t> _freeChatIds;
+  std::vector<std::uint64_t> _freeMessageIds;
+  std::string _strings;
+
+  /**
+   * @brief Appends a string to the string section.
+   */
+  SnapshotString addString(std::string_view value) {
+    SnapshotString ref{_strings.size(), value.size()};
+    _strings.append(value);
+    return ref;
+  }
+
+  /**
+   * @brief Appends the content parts of a message.
+   */
+  void addContent(const MessageView &message, SnapshotMessage &record) {
+    record._firstPart = _contentParts.size();
+    for (std::size_t i = 0; i < message.getPartCount(); ++i) {
+      auto part = message.getPart(i);
+      _contentParts.push_back({static_cast<std::uint64_t>(part._kind), addString(part._value)});
+    }
+    record._partCount = _contentParts.size() - record._firstPart;
+  }
+};
+
+/**
+ * @brief Lays out a section after the previous one and returns its location.
+ */
+template <typename T> SnapshotSection placeSection(std::uint64_t &offset, const std::vector<T> &elements) {
+  offset = alignOffset(offset);
+  SnapshotSection section{offset, elements.size()};
+  offset += elements.size() * sizeof(T);
+  return section;
+}
+
+/**
+ * @brief Writes a section at its offset, padding the gap after the previous one.
+ */
+bool writeSection(int fd, std::uint64_t &written, const SnapshotSection &section, const char *data,
+                  std::size_t size) {
+  static const char padding[8] = {};
+  if (section._offset > written && !writeAll(fd, padding, section._offset - written))
+    return false;
+  written = section._offset + size;
+  return writeAll(fd, data, size);
+}
+
+} // namespace
+
+/**
+ * @brief Maps a snapshot file and validates its header and sections.
+ * @throws StorageIOException If the file cannot be mapped.
+ * @throws CorruptedDataException If the header or sections are invalid.
+ */
+SnapshotImage::SnapshotImage(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw StorageIOException(path);
+
+  struct stat fileStat;
+  if (::fstat(fd, &fileStat) != 0) {
+    ::close(fd);
+    throw StorageIOException(path);
+  }
+  _size = static_cast<std::size_t>(fileStat.st_size);
+  if (_size < sizeof(SnapshotHeader)) {
+    ::close(fd);
+    throw CorruptedDataException("Снимок слишком короткий: " + path);
+  }
+
+  void *mapping = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED)
+    throw StorageIOException(path);
+  _data = static_cast<const char *>(mapping);
+  _header = reinterpret_cast<const SnapshotHeader *>(_data);
+
+  try {
+    if (std::memcmp(_header->_magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        _header->_byteOrderMark != BYTE_ORDER_MARK || _header->_headerCrc != headerCrc(*_header))
+      throw CorruptedDataException("Неверный заголовок снимка " + path);
+    if (_header->_version != SNAPSHOT_VERSION)
+      throw CorruptedDataException("Неподдерживаемая версия снимка " + std::to_string(_header->_version));
+
+    checkSection(_header->_users, sizeof(SnapshotUser));
+    checkSection(_header->_chatRefs, sizeof(std::uint64_t));
+    checkSection(_header->_chats, sizeof(SnapshotChat));
+    checkSection(_header->_participants, sizeof(SnapshotParticipant));
+    checkSection(_header->_messages, sizeof(SnapshotMessage));
+    checkSection(_header->_contentParts, sizeof(SnapshotContentPart));
+    checkSection(_header->_freeChatIds, sizeof(std::uint64_t));
+    checkSection(_header->_freeMessageIds, sizeof(std::uint64_t));
+    checkSection(_header->_strings, 1);
+  } catch (...) {
+    ::munmap(const_cast<char *>(_data), _size);
+    throw;
+  }
+}
+
+/**
+ * @brief Unmaps the file.
+ */
+SnapshotImage::~SnapshotImage() {
+  if (_data)
+    ::munmap(const_cast<char *>(_data), _size);
+}
+
+/**
+ * @brief Checks that a section lies inside the file.
+ */
+void SnapshotImage::checkSection(const SnapshotSection &section, std::size_t elementSize) const {
+  if (section._offset % 8 != 0 || section._offset > _size || section._count > (_size - section._offset) / elementSize)
+    throw CorruptedDataException("Секция снимка за пределами файла.");
+}
+
+/**
+ * @brief Gets the header.
+ */
+const SnapshotHeader &SnapshotImage::getHeader() const { return *_header; }
+
+/**
+ * @brief Reads a string from the string section.
+ * @throws CorruptedDataException If the reference is out of range.
+ */
+std::string_view SnapshotImage::getString(const SnapshotString &value) const {
+  checkRange(value._offset, value._size, _header->_strings._count);
+  return std::string_view(_data + _header->_strings._offset + value._offset, value._size);
+}
+
+/**
+ * @brief Creates the users, chats and read indexes in the chat system.
+ * @param chatSystem An empty chat system without a mutation log.
+ * @param self Shared pointer to this image, kept by chats with unloaded messages.
+ */
+void SnapshotImage::restore(ChatSystem &chatSystem, const std::shared_ptr<const SnapshotImage> &self) {
+  const auto *users = section<SnapshotUser>(_header->_users);
+  const auto *chatRefs = section<std::uint64_t>(_header->_chatRefs);
+  const auto *chats = section<SnapshotChat>(_header->_chats);
+  const auto *participants = section<SnapshotParticipant>(_header->_participants);
+
+  // пользователи
+  std::vector<std::shared_ptr<User>> restoredUsers;
+  restoredUsers.reserve(_header->_users._count);
+  for (std::uint64_t i = 0; i < _header->_users._count; ++i) {
+    const auto &record = users[i];
+    auto user = std::make_shared<User>(
+        UserData(std::string(getString(record._login)), std::string(getString(record._userName)),
+                 std::string(getString(record._passwordHash)), std::string(getString(record._email)),
+                 std::string(getString(record._phone))));
+    chatSystem.addUser(user);
+    restoredUsers.push_back(user);
+    _users.push_back(user->getUserId());
+  }
+
+  // чаты, участники и индексы прочтения; сообщения загружаются при первом обращении
+  std::vector<std::shared_ptr<Chat>> restoredChats;
+  restoredChats.reserve(_header->_chats._count);
+  for (std::uint64_t i = 0; i < _header->_chats._count; ++i) {
+    const auto &record = chats[i];
+    checkRange(record._firstParticipant, record._participantCount, _header->_participants._count);
+    checkRange(record._firstMessage, record._messageCount, _header->_messages._count);
+
+    auto chat = std::make_shared<Chat>(chatSystem.getUserTable());
+    for (std::uint64_t p = 0; p < record._participantCount; ++p) {
+      const auto &participant = participants[record._firstParticipant + p];
+      checkRange(participant._userIndex, 1, restoredUsers.size());
+
+      const auto &user = restoredUsers[participant._userIndex];
+      chat->addParticipant(user);
+      if (participant._deletedFromChat)
+        chat->setDeletedFromChat(user);
+      chat->updateLastReadMessageIndex(user, participant._lastReadMessageIndex);
+    }
+
+    chatSystem.restoreChat(chat, record._chatId);
+    if (record._messageCount > 0)
+      chat->attachSnapshot(self, i);
+    restoredChats.push_back(chat);
+  }
+
+  // списки чатов пользователей в исходном порядке
+  for (std::uint64_t i = 0; i < _header->_users._count; ++i) {
+    const auto &record = users[i];
+    checkRange(record._firstChatRef, record._chatRefCount, _header->_chatRefs._count);
+    for (std::uint64_t r = 0; r < record._chatRefCount; ++r) {
+      std::uint64_t chatIndex = chatRefs[record._firstChatRef + r];
+      checkRange(chatIndex, 1, restoredChats.size());
+      restoredUsers[i]->getUserChatList()->addChat(restoredChats[chatIndex]);
+    }
+  }
+
+  // состояние генераторов ID
+  const auto *freeChatIds = section<std::uint64_t>(_header->_freeChatIds);
+  const auto *freeMessageIds = section<std::uint64_t>(_header->_freeMessageIds);
+  chatSystem.getIdChatManager().restore(
+      _header->_nextChatId, std::set<std::size_t>(freeChatIds, freeChatIds + _header->_freeChatIds._count));
+  chatSystem.getIdMessageManager().restore(
+      _header->_nextMessageId,
+      std::set<std::size_t>(freeMessageIds, freeMessageIds + _header->_freeMessageIds._count));
+}
+
+/**
+ * @brief Copies the messages of one chat from the mapping into its message store.
+ * @param chatIndex Index in the chat section.
+ * @param messages Store the messages are appended to.
+ */
+void SnapshotImage::loadChatMessages(std::size_t chatIndex, MessageStore &messages) const {
+  const auto &chat = section<SnapshotChat>(_header->_chats)[chatIndex];
+  const auto *records = section<SnapshotMessage>(_header->_messages);
+  const auto *parts = section<SnapshotContentPart>(_header->_contentParts);
+
+  std::vector<MessagePart> content;
+  for (std::uint64_t m = 0; m < chat._messageCount; ++m) {
+    const auto &record = records[chat._firstMessage + m];
+    checkRange(record._firstPart, record._partCount, _header->_contentParts._count);
+
+    content.clear();
+    for (std::uint64_t p = 0; p < record._partCount; ++p) {
+      const auto &part = parts[record._firstPart + p];
+      auto kind = static_cast<ContentKind>(part._kind);
+      if (kind != ContentKind::Text && kind != ContentKind::File && kind != ContentKind::Image)
+        throw CorruptedDataException("Неизвестный тип содержимого сообщения.");
+      content.push_back({kind, getString(part._value)});
+    }
+
+    UserId sender;
+    if (record._senderIndex != SNAPSHOT_NO_USER) {
+      checkRange(record._senderIndex, 1, _users.size());
+      sender = _users[record._senderIndex];
+    }
+
+    messages.append(record._messageId, sender, record._timeStamp, content.data(), content.size());
+  }
+}
+
+/**
+ * @brief Reads the message count and the time of the last message of one chat.
+ * @param chatIndex Index in the chat section.
+ * @param messageCount Receives the number of messages.
+ * @param lastTimeStamp Receives the time of the last message, 0 without messages.
+ */
+void SnapshotImage::getChatActivity(std::size_t chatIndex, std::size_t &messageCount, TimeStamp &lastTimeStamp) const {
+  const auto &chat = section<SnapshotChat>(_header->_chats)[chatIndex];
+  messageCount = chat._messageCount;
+  lastTimeStamp = chat._messageCount > 0
+                      ? section<SnapshotMessage>(_header->_messages)[chat._firstMessage + chat._messageCount - 1]._timeStamp
+                      : 0;
+}
+
+/**
+ * @brief Builds the path of the snapshot file in a data directory.
+ */
+std::string snapshotPath(const std::string &directory) {
+  return (std::filesystem::path(directory) / "snapshot.bin").string();
+}
+
+/**
+ * @brief Writes the whole state of the chat system to a snapshot file.
+ * @throws StorageIOException If the file cannot be written.
+ * @details The file is written next to the target under a temporary name, synced and
+ * renamed, so a crash never leaves a half-written snapshot in place.
+ */
+void writeSnapshot(ChatSystem &chatSystem, const std::string &path, std::uint64_t lastLsn) {
+  SnapshotBuilder builder;
+  const auto &users = chatSystem.getUsers();
+  const auto &chats = chatSystem.getChats();
+
+  std::unordered_map<UserId, std::uint64_t, UserIdHash> userIndex;
+  for (std::size_t i = 0; i < users.size(); ++i)
+    userIndex[users[i]->getUserId()] = i;
+
+  std::unordered_map<const Chat *, std::uint64_t> chatIndex;
+  for (std::size_t i = 0; i < chats.size(); ++i)
+    chatIndex[chats[i].get()] = i;
+
+  for (const auto &user : users) {
+    SnapshotUser record;
+    record._login = builder.addString(user->getLogin());
+    record._userName = builder.addString(user->getUserName());
+    record._passwordHash = builder.addString(user->getPassword());
+    record._email = builder.addString(user->getEmail());
+    record._phone = builder.addString(user->getPhone());
+    record._firstChatRef = builder._chatRefs.size();
+
+    if (user->getUserChatList()) {
+      for (const auto &weakChat : user->getUserChatList()->getChatFromList()) {
+        auto chat_ptr = weakChat.lock();
+        auto it = chat_ptr ? chatIndex.find(chat_ptr.get()) : chatIndex.end();
+        if (it != chatIndex.end())
+          builder._chatRefs.push_back(it->second);
+      }
+    }
+    record._chatRefCount = builder._chatRefs.size() - record._firstChatRef;
+    builder._users.push_back(record);
+  }
+
+  for (const auto &chat : chats) {
+    SnapshotChat record;
+    record._chatId = chat->getChatId();
+    record._firstParticipant = builder._participants.size();
+    for (const auto &participant : chat->getParticipants()) {
+      auto it = userIndex.find(participant._userId);
+      if (it == userIndex.end())
+        continue;
+      builder._participants.push_back({it->second, chat->getLastReadMessageIndex(users[it->second]),
+                                       participant._deletedFromChat ? 1ull : 0ull});
+    }
+    record._participantCount = builder._participants.size() - record._firstParticipant;
+
+    record._firstMessage = builder._messages.size();
+    for (const auto &message : chat->getMessages()) {
+      SnapshotMessage messageRecord;
+      messageRecord._messageId = message.getMessageId();
+      auto it = userIndex.find(message.getSender());
+      messageRecord._senderIndex = it != userIndex.end() ? it->second : SNAPSHOT_NO_USER;
+      messageRecord._timeStamp = message.getTimeStamp();
+      builder.addContent(message, messageRecord);
+      builder._messages.push_back(messageRecord);
+    }
+    record._messageCount = builder._messages.size() - record._firstMessage;
+    builder._chats.push_back(record);
+  }
+
+  for (auto id : chatSystem.getIdChatManager().getFreeChatIds())
+    builder._freeChatIds.push_back(id);
+  for (auto id : chatSystem.getIdMessageManager().getFreeMessageIds())
+    builder._freeMessageIds.push_back(id);
+
+  // раскладка секций
+  SnapshotHeader header{};
+  std::memcpy(header._magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header._version = SNAPSHOT_VERSION;
+  header._byteOrderMark = BYTE_ORDER_MARK;
+  header._lastLsn = lastLsn;
+  header._nextChatId = chatSystem.getIdChatManager().peekNextChatId();
+  header._nextMessageId = chatSystem.getIdMessageManager().peekNextMessageId();
+
+  std::uint64_t offset = sizeof(SnapshotHeader);
+  header._users = placeSection(offset, builder._users);
+  header._chatRefs = placeSection(offset, builder._chatRefs);
+  header._chats = placeSection(offset, builder._chats);
+  header._participants = placeSection(offset, builder._participants);
+  header._messages = placeSection(offset, builder._messages);
+  header._contentParts = placeSection(offset, builder._contentParts);
+  header._freeChatIds = placeSection(offset, builder._freeChatIds);
+  header._freeMessageIds = placeSection(offset, builder._freeMessageIds);
+  offset = alignOffset(offset);
+  header._strings = {offset, builder._strings.size()};
+  header._headerCrc = headerCrc(header);
+
+  // запись во временный файл и атомарная замена
+  const std::string tempPath = path + ".tmp";
+  int fd = ::open(tempPath.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+  if (fd < 0)
+    throw StorageIOException(tempPath);
+
+  auto bytes = [](const auto &elements) { return reinterpret_cast<const char *>(elements.data()); };
+  auto size = [](const auto &elements) { return elements.size() * sizeof(elements[0]); };
+
+  std::uint64_t written = sizeof(header);
+  bool ok = writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(header)) &&
+            writeSection(fd, written, header._users, bytes(builder._users), size(builder._users)) &&
+            writeSection(fd, written, header._chatRefs, bytes(builder._chatRefs), size(builder._chatRefs)) &&
+            writeSection(fd, written, header._chats, bytes(builder._chats), size(builder._chats)) &&
+            writeSection(fd, written, header._participants, bytes(builder._participants),
+                         size(builder._participants)) &&
+            writeSection(fd, written, header._messages, bytes(builder._messages), size(builder._messages)) &&
+            writeSection(fd, written, header._contentParts, bytes(builder._contentParts),
+                         size(builder._contentParts)) &&
+            writeSection(fd, written, header._freeChatIds, bytes(builder._freeChatIds), size(builder._freeChatIds)) &&
+            writeSection(fd, written, header._freeMessageIds, bytes(builder._freeMessageIds),
+                         size(builder._freeMessageIds)) &&
+            writeSection(fd, written, header._strings, builder._strings.data(), builder._strings.size()) &&
+            ::fsync(fd) == 0;
+  ::close(fd);
+
+  if (!ok || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+    std::remove(tempPath.c_str());
+    throw StorageIOException(path);
+  }
+  syncDirectory(std::filesystem::path(path).parent_path().string());
+}
+
+/**
+ * @brief Loads a snapshot into an empty chat system.
+ * @return LSN stored in the snapshot, or 0 if there is no snapshot file.
+ */
+std::uint64_t loadSnapshot(const std::string &path, ChatSystem &chatSystem) {
+  std::error_code error;
+  if (!std::filesystem::exists(path, error))
+    return 0;
+
+  auto image = std::make_shared<SnapshotImage>(path);
+  image->restore(chatSystem, image);
+  return image->getHeader()._lastLsn;
+}
+
+/**
+ * @brief Syncs the mutation log of the chat system, writes a snapshot covering it and
+ * removes the log segments the snapshot makes redundant.
+ */
+void writeCheckpoint(ChatSystem &chatSystem, const std::string &directory) {
+  const auto &mutationLog = chatSystem.getMutationLog();
+  if (!mutationLog) {
+    writeSnapshot(chatSystem, snapshotPath(directory), 0);
+    return;
+  }
+
+  // после rotate() все записи до lastLsn лежат в закрытых сегментах, их можно удалить
+  std::uint64_t lastLsn = mutationLog->rotate();
+  writeSnapshot(chatSystem, snapshotPath(directory), lastLsn);
+  MutationLog::removeSegmentsUpTo(directory, lastLsn);
+}
@@ -0,0 +1,222 @@
+#pragma once
+#include "system/date_time_utils.h"
+#include "user/user_id.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ChatSystem;
+class MessageStore;
+class User;
+
+/**
+ * @brief Location of a section inside the snapshot file.
+ */
+struct SnapshotSection {
+  std::uint64_t _offset; ///< Byte offset from the start of the file (8-byte aligned).
+  std::uint64_t _count;  ///< Number of elements (bytes for the string section).
+};
+
+/**
+ * @brief Reference to a string in the string section.
+ */
+struct SnapshotString {
+  std::uint64_t _offset; ///< Offset inside the string section.
+  std::uint64_t _size;   ///< Length in bytes.
+};
+
+/**
+ * @brief Fixed-size header at the start of the snapshot file.
+ */
+struct SnapshotHeader {
+  char _magic[8];                  ///< "CBSNAP\0\0".
+  std::uint32_t _version;          ///< SNAPSHOT_VERSION.
+  std::uint32_t _byteOrderMark;    ///< 0x01020304 written in host order.
+  std::uint64_t _lastLsn;          ///< Last mutation log record included in the snapshot.
+  std::uint64_t _nextChatId;       ///< State of idChatManager.
+  std::uint64_t _nextMessageId;    ///< State of idMessageManager.
+  SnapshotSection _users;          ///< SnapshotUser[].
+  SnapshotSection _chatRefs;       ///< u64[] chat indexes of the users' chat lists.
+  SnapshotSection _chats;          ///< SnapshotChat[].
+  SnapshotSection _participants;   ///< SnapshotParticipant[].
+  SnapshotSection _messages;       ///< SnapshotMessage[].
+  SnapshotSection _contentParts;   ///< SnapshotContentPart[].
+  SnapshotSection _freeChatIds;    ///< u64[] released chat IDs.
+  SnapshotSection _freeMessageIds; ///< u64[] released message IDs.
+  SnapshotSection _strings;        ///< Raw bytes of all strings.
+  std::uint32_t _headerCrc;        ///< CRC-32 of the header with this field set to zero.
+  std::uint32_t _reserved;         ///< Padding.
+};
+
+/**
+ * @brief A user with a slice of the chat reference section (its UserChatList).
+ */
+struct SnapshotUser {
+  SnapshotString _login;
+  SnapshotString _userName;
+  SnapshotString _passwordHash;
+  SnapshotString _email;
+  SnapshotString _phone;
+  std::uint64_t _firstChatRef;
+  std::uint64_t _chatRefCount;
+};
+
+/**
+ * @brief A chat with slices of the participant and message sections.
+ */
+struct SnapshotChat {
+  std::uint64_t _chatId;
+  std::uint64_t _firstParticipant;
+  std::uint64_t _participantCount;
+  std::uint64_t _firstMessage;
+  std::uint64_t _messageCount;
+};
+
+/**
+ * @brief A chat participant with its read index.
+ */
+struct SnapshotParticipant {
+  std::uint64_t _userIndex; ///< Index in the user section.
+  std::uint64_t _lastReadMessageIndex;
+  std::uint64_t _deletedFromChat;
+};
+
+/**
+ * @brief A message with a slice of the content part section.
+ */
+struct SnapshotMessage {
+  std::uint64_t _messageId;
+  std::uint64_t _senderIndex; ///< Index in the user section or SNAPSHOT_NO_USER.
+  std::int64_t _timeStamp;    ///< Milliseconds since the epoch.
+  std::uint64_t _firstPart;
+  std::uint64_t _partCount;
+};
+
+/**
+ * @brief One content part of a message.
+ */
+struct SnapshotContentPart {
+  std::uint64_t _kind; ///< ContentKind.
+  SnapshotString _value;
+};
+
+const std::uint32_t SNAPSHOT_VERSION = 2;     ///< Bumped on every layout change.
+const std::uint64_t SNAPSHOT_NO_USER = ~0ull;     ///< Sender index of a deleted user.
+
+/**
+ * @brief Read-only memory mapping of a snapshot file.
+ *
+ * All records have a fixed size, so loading is a bounds check of the sections and
+ * indexed access into the mapping; nothing is decoded up front. Users and chats are
+ * created at startup, while the messages of a chat are built from the mapping only
+ * when the chat is opened for the first time (see Chat::ensureMessagesLoaded).
+ */
+class SnapshotImage {
+private:
+  const char *_data = nullptr;             ///< Start of the mapping.
+  std::size_t _size = 0;                   ///< Size of the mapping.
+  const SnapshotHeader *_header = nullptr; ///< Header inside the mapping.
+  std::vector<UserId> _users;              ///< Users created from the user section, by index.
+
+  /**
+   * @brief Checks that a section lies inside the file.
+   * @param section Section to check.
+   * @param elementSize Size of one element.
+   * @throws CorruptedDataException If it does not.
+   */
+  void checkSection(const SnapshotSection &section, std::size_t elementSize) const;
+
+  /**
+   * @brief Gets a pointer to the first element of a section.
+   */
+  template <typename T> const T *section(const SnapshotSection &section) const {
+    return reinterpret_cast<const T *>(_data + section._offset);
+  }
+
+public:
+  /**
+   * @brief Maps a snapshot file and validates its header and sections.
+   * @param path Path of the snapshot file.
+   * @throws StorageIOException If the file cannot be mapped.
+   * @throws CorruptedDataException If the header or sections are invalid.
+   */
+  explicit SnapshotImage(const std::string &path);
+  SnapshotImage(const SnapshotImage &) = delete;
+  SnapshotImage &operator=(const SnapshotImage &) = delete;
+
+  /**
+   * @brief Unmaps the file.
+   */
+  ~SnapshotImage();
+
+  /**
+   * @brief Gets the header.
+   */
+  const SnapshotHeader &getHeader() const;
+
+  /**
+   * @brief Reads a string from the string section.
+   * @param value Reference to the string.
+   * @return View into the mapping, valid while the image is alive.
+   * @throws CorruptedDataException If the reference is out of range.
+   */
+  std::string_view getString(const SnapshotString &value) const;
+
+  /**
+   * @brief Creates the users, chats and read indexes in the chat system.
+   * @param chatSystem An empty chat system without a mutation log.
+   * @param self Shared pointer to this image, kept by chats with unloaded messages.
+   */
+  void restore(ChatSystem &chatSystem, const std::shared_ptr<const SnapshotImage> &self);
+
+  /**
+   * @brief Copies the messages of one chat from the mapping into its message store.
+   * @param chatIndex Index in the chat section.
+   * @param messages Store the messages are appended to.
+   */
+  void loadChatMessages(std::size_t chatIndex, MessageStore &messages) const;
+
+  /**
+   * @brief Reads the message count and the time of the last message of one chat.
+   * @param chatIndex Index in the chat section.
+   * @param messageCount Receives the number of messages.
+   * @param lastTimeStamp Receives the time of the last message, 0 without messages.
+   */
+  void getChatActivity(std::size_t chatIndex, std::size_t &messageCount, TimeStamp &lastTimeStamp) const;
+};
+
+/**
+ * @brief Builds the path of the snapshot file in a data directory.
+ * @param directory Data directory.
+ * @return Path of the snapshot file.
+ */
+std::string snapshotPath(const std::string &directory);
+
+/**
+ * @brief Writes the whole state of the chat system to a snapshot file.
+ * @param chatSystem The chat system.
+ * @param path Path of the snapshot; written to a temporary file and renamed.
+ * @param lastLsn Last mutation log record reflected in the state.
+ * @throws StorageIOException If the file cannot be written.
+ */
+void writeSnapshot(ChatSystem &chatSystem, const std::string &path, std::uint64_t lastLsn);
+
+/**
+ * @brief Loads a snapshot into an empty chat system.
+ * @param path Path of the snapshot.
+ * @param chatSystem The chat system to fill.
+ * @return LSN stored in the snapshot, or 0 if there is no snapshot file.
+ */
+std::uint64_t loadSnapshot(const std::string &path, ChatSystem &chatSystem);
+
+/**
+ * @brief Syncs the mutation log of the chat system, writes a snapshot covering it and
+ * removes the log segments the snapshot makes redundant.
+ * @param chatSystem The chat system; nothing else may mutate it during the call.
+ * @param directory Data directory.
+ * @details Must not run together with a LogCompactor of the same directory.
+ */
+void writeCheckpoint(ChatSystem &chatSystem, const std::string &directory);
@@ -1,22 +1,78 @@
 #include "date_time_utils.h"
+#include <chrono>
 #include <ctime>
 
+namespace {
+
 /**
- * @brief Retrieves the current date and time as a string.
- * @return String in the format "YYYY-MM-DD, HH:MM:SS".
- * @details Uses local time to format the current date and time.
+ * @brief Last formatted second of a thread.
  */
-std::string getCurrentDateTime() { // вернет строку с текущей датой и временем
+struct TimeStampFormatCache {
+  std::int64_t _second = INT64_MIN; ///< Epoch second of _text.
+  char _text[32] = {};              ///< Formatted local time.
+  std::size_t _size = 0;            ///< Length of _text.
+};
 
-  time_t mytime = time(NULL);
-  struct tm *now = localtime(&mytime);
+thread_local TimeStampFormatCache t_formatCache;
 
-  char date_stamp[20];
-  char time_stamp[20];
+/**
+ * @brief Thread-safe localtime.
+ */
+bool toLocalTime(std::time_t time, std::tm &local) {
+#ifdef _WIN32
+  return localtime_s(&local, &time) == 0;
+#else
+  return localtime_r(&time, &local) != nullptr;
+#endif
+}
 
-  std::strftime(date_stamp, sizeof(date_stamp), "%Y-%m-%d", now);
-  std::strftime(time_stamp, sizeof(time_stamp), "%H:%M:%S", now);
+} // namespace
+
+/**
+ * @brief Reads the current time from the coarse system clock.
+ * @return Current timestamp in milliseconds since the epoch.
+ */
+TimeStamp getCurrentTimeStamp() {
+#ifdef CLOCK_REALTIME_COARSE
+  timespec now;
+  if (clock_gettime(CLOCK_REALTIME_COARSE, &now) == 0)
+    return static_cast<TimeStamp>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+#endif
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
 
-  return std::string(date_stamp) + ", " + time_stamp;
+/**
+ * @brief Builds a timestamp from local calendar time.
+ * @return The timestamp.
+ */
+TimeStamp makeTimeStamp(int year, int month, int day, int hour, int minute, int second) {
+  std::tm local = {};
+  local.tm_year = year - 1900;
+  local.tm_mon = month - 1;
+  local.tm_mday = day;
+  local.tm_hour = hour;
+  local.tm_min = minute;
+  local.tm_sec = second;
+  local.tm_isdst = -1;
+  return static_cast<TimeStamp>(std::mktime(&local)) * 1000;
 }
 
+/**
+ * @brief Formats a timestamp as local time "YYYY-MM-DD, HH:MM:SS".
+ * @return View of a per-thread buffer, valid until the next call in the same thread.
+ */
+std::string_view formatTimeStamp(TimeStamp timeStamp) {
+  // округляем вниз и для отрицательных значений
+  std::int64_t second = timeStamp >= 0 ? timeStamp / 1000 : (timeStamp - 999) / 1000;
+
+  auto &cache = t_formatCache;
+  if (cache._second != second) {
+    std::tm local = {};
+    cache._size = 0;
+    if (toLocalTime(static_cast<std::time_t>(second), local))
+      cache._size = std::strftime(cache._text, sizeof(cache._text), "%Y-%m-%d, %H:%M:%S", &local);
+    cache._second = second;
+  }
+  return std::string_view(cache._text, cache._size);
+}
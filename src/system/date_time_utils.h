@@ -1,9 +1,35 @@
 #pragma once
-#include "string"
+#include <cstdint>
+#include <string_view>
 
 /**
- * @brief Retrieves the current date and time as a string.
- * @return String containing the current date and time.
+ * @brief Message timestamp: milliseconds since the Unix epoch (UTC).
  */
-std::string getCurrentDateTime(); // вернет строку с текущей датой и временем
+using TimeStamp = std::int64_t;
 
+/**
+ * @brief Reads the current time from the coarse system clock.
+ * @return Current timestamp; resolution is a few milliseconds, the cost is a vDSO read.
+ */
+TimeStamp getCurrentTimeStamp();
+
+/**
+ * @brief Builds a timestamp from local calendar time.
+ * @param year Year, e.g. 2025.
+ * @param month Month 1-12.
+ * @param day Day of month 1-31.
+ * @param hour Hour 0-23.
+ * @param minute Minute 0-59.
+ * @param second Second 0-59.
+ * @return The timestamp.
+ */
+TimeStamp makeTimeStamp(int year, int month, int day, int hour, int minute, int second);
+
+/**
+ * @brief Formats a timestamp as local time "YYYY-MM-DD, HH:MM:SS".
+ * @param timeStamp The timestamp.
+ * @return View of a per-thread buffer, valid until the next call in the same thread.
+ * @details The last formatted second is cached, so printing a run of messages sent in
+ * the same second calls localtime/strftime once.
+ */
+std::string_view formatTimeStamp(TimeStamp timeStamp);
@@ -31,6 +31,21 @@ void idChatManager::releaseChatId(std::size_t &chatId) {
     _freeChatId.insert(chatId);
 }
 
+/**
+ * @brief Marks a chat ID restored from storage as used.
+ *
+ * @param chatId The chat ID to reserve.
+ */
+void idChatManager::reserveChatId(std::size_t chatId) {
+  if (chatId < _nextChatId) {
+    _freeChatId.erase(chatId);
+    return;
+  }
+  for (std::size_t id = _nextChatId; id < chatId; ++id)
+    _freeChatId.insert(id);
+  _nextChatId = chatId + 1;
+}
+
 /**
  * @brief Returns the next available message ID.
  *
@@ -40,13 +55,16 @@ void idChatManager::releaseChatId(std::size_t &chatId) {
  * @return A unique message ID.
  */
 std::size_t idMessageManager::getNextMessageId() {
-  if (_freeMessageId.empty())
-    return _nextMessageId++;
-  else {
-    std::size_t value = *_freeMessageId.begin();
-    _freeMessageId.erase(_freeMessageId.begin());
-    return value;
+  if (_hasFreeMessageIds.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(_freeMutex);
+    if (!_freeMessageId.empty()) {
+      std::size_t value = *_freeMessageId.begin();
+      _freeMessageId.erase(_freeMessageId.begin());
+      _hasFreeMessageIds.store(!_freeMessageId.empty(), std::memory_order_release);
+      return value;
+    }
   }
+  return _nextMessageId.fetch_add(1, std::memory_order_relaxed);
 }
 
 /**
@@ -58,6 +76,65 @@ std::size_t idMessageManager::getNextMessageId() {
  * @param messageId The message ID to be released.
  */
 void idMessageManager::releaseMessageId(std::size_t &messageId) {
-  if (messageId < _nextMessageId)
+  std::lock_guard<std::mutex> lock(_freeMutex);
+  if (messageId < _nextMessageId.load(std::memory_order_relaxed)) {
     _freeMessageId.insert(messageId);
-}
\ No newline at end of file
+    _hasFreeMessageIds.store(true, std::memory_order_release);
+  }
+}
+
+/**
+ * @brief Marks a message ID restored from storage as used.
+ *
+ * @param messageId The message ID to reserve.
+ */
+void idMessageManager::reserveMessageId(std::size_t messageId) {
+  std::lock_guard<std::mutex> lock(_freeMutex);
+  std::size_t nextMessageId = _nextMessageId.load(std::memory_order_relaxed);
+  if (messageId < nextMessageId) {
+    _freeMessageId.erase(messageId);
+  } else {
+    for (std::size_t id = nextMessageId; id < messageId; ++id)
+      _freeMessageId.insert(id);
+    _nextMessageId.store(messageId + 1, std::memory_order_relaxed);
+  }
+  _hasFreeMessageIds.store(!_freeMessageId.empty(), std::memory_order_release);
+}
+
+/**
+ * @brief Gets the sequential counter without advancing it.
+ */
+std::size_t idChatManager::peekNextChatId() const { return _nextChatId; }
+
+/**
+ * @brief Gets the pool of released chat IDs.
+ */
+const std::set<std::size_t> &idChatManager::getFreeChatIds() const { return _freeChatId; }
+
+/**
+ * @brief Replaces the whole state, e.g. when loading a snapshot.
+ */
+void idChatManager::restore(std::size_t nextChatId, const std::set<std::size_t> &freeChatIds) {
+  _nextChatId = nextChatId;
+  _freeChatId = freeChatIds;
+}
+
+/**
+ * @brief Gets the sequential counter without advancing it.
+ */
+std::size_t idMessageManager::peekNextMessageId() const { return _nextMessageId.load(std::memory_order_relaxed); }
+
+/**
+ * @brief Gets the pool of released message IDs.
+ */
+const std::set<std::size_t> &idMessageManager::getFreeMessageIds() const { return _freeMessageId; }
+
+/**
+ * @brief Replaces the whole state, e.g. when loading a snapshot.
+ */
+void idMessageManager::restore(std::size_t nextMessageId, const std::set<std::size_t> &freeMessageIds) {
+  std::lock_guard<std::mutex> lock(_freeMutex);
+  _nextMessageId.store(nextMessageId, std::memory_order_relaxed);
+  _freeMessageId = freeMessageIds;
+  _hasFreeMessageIds.store(!_freeMessageId.empty(), std::memory_order_release);
+}
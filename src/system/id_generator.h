@@ -1,4 +1,7 @@
 #pragma once
+#include <atomic>
+#include <cstddef>
+#include <mutex>
 #include <set>
 
 /**
@@ -31,17 +34,50 @@ public:
    * @param chatId The chat ID to release.
    */
   void releaseChatId(std::size_t &chatId);
+
+  /**
+   * @brief Marks a chat ID restored from storage as used.
+   *
+   * IDs skipped between the sequential counter and chatId go to the released pool.
+   *
+   * @param chatId The chat ID to reserve.
+   */
+  void reserveChatId(std::size_t chatId);
+
+  /**
+   * @brief Gets the sequential counter without advancing it.
+   * @return The next sequential chat ID.
+   */
+  std::size_t peekNextChatId() const;
+
+  /**
+   * @brief Gets the pool of released chat IDs.
+   * @return Const reference to the set of free IDs.
+   */
+  const std::set<std::size_t> &getFreeChatIds() const;
+
+  /**
+   * @brief Replaces the whole state, e.g. when loading a snapshot.
+   * @param nextChatId The next sequential chat ID.
+   * @param freeChatIds The pool of released chat IDs.
+   */
+  void restore(std::size_t nextChatId, const std::set<std::size_t> &freeChatIds);
 };
 
 /**
  * @brief Manages unique identifiers for messages.
  *
- * Same mechanism as idChatManager but used for message ID tracking.
+ * Same mechanism as idChatManager but used for message ID tracking. Every send takes an
+ * ID, so getNextMessageId() and releaseMessageId() may be called from several threads:
+ * while no ID is released the next ID is one atomic increment. reserveMessageId() and
+ * restore() are used while loading, before other threads start.
  */
 class idMessageManager {
 private:
-  std::set<std::size_t> _freeMessageId; ///< Set of released message IDs available for reuse.
-  std::size_t _nextMessageId = 1;       ///< Next available sequential message ID.
+  std::set<std::size_t> _freeMessageId;           ///< Set of released message IDs available for reuse.
+  std::atomic<std::size_t> _nextMessageId{1};     ///< Next available sequential message ID.
+  std::atomic<bool> _hasFreeMessageIds{false};    ///< _freeMessageId is not empty, read without the lock.
+  mutable std::mutex _freeMutex;                  ///< Guards _freeMessageId.
 
 public:
   /**
@@ -62,4 +98,32 @@ public:
    * @param messageId The message ID to release.
    */
   void releaseMessageId(std::size_t &messageId);
+
+  /**
+   * @brief Marks a message ID restored from storage as used.
+   *
+   * IDs skipped between the sequential counter and messageId go to the released pool.
+   *
+   * @param messageId The message ID to reserve.
+   */
+  void reserveMessageId(std::size_t messageId);
+
+  /**
+   * @brief Gets the sequential counter without advancing it.
+   * @return The next sequential message ID.
+   */
+  std::size_t peekNextMessageId() const;
+
+  /**
+   * @brief Gets the pool of released message IDs.
+   * @return Const reference to the set of free IDs.
+   */
+  const std::set<std::size_t> &getFreeMessageIds() const;
+
+  /**
+   * @brief Replaces the whole state, e.g. when loading a snapshot.
+   * @param nextMessageId The next sequential message ID.
+   * @param freeMessageIds The pool of released message IDs.
+   */
+  void restore(std::size_t nextMessageId, const std::set<std::size_t> &freeMessageIds);
 };
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+class Chat;
+class MessageView;
+class User;
+enum class UserField : unsigned char;
+
+/**
+ * @brief Interface for receiving mutations of chats and users.
+ * @details Chats and users registered in ChatSystem report their changes through it,
+ * so the system can persist them and keep derived data up to date.
+ */
+class IMutationObserver { // interface for ChatSystem
+public:
+  /**
+   * @brief Default virtual destructor.
+   */
+  virtual ~IMutationObserver() = default;
+
+  /**
+   * @brief Called after a message has been appended to a chat.
+   * @param chat The chat that received the message.
+   * @param message The new message.
+   */
+  virtual void onMessageAdded(const Chat &chat, const MessageView &message) = 0;
+
+  /**
+   * @brief Called after the last read message index of a participant has changed.
+   * @param chat The chat.
+   * @param user The participant.
+   * @param lastReadMessageIndex The new index.
+   */
+  virtual void onLastReadMessageIndexChanged(const Chat &chat, const User &user, std::size_t lastReadMessageIndex) = 0;
+
+  /**
+   * @brief Called after a profile field of a user has changed.
+   * @param user The user with the new value already set.
+   * @param field The changed field.
+   * @param oldValue The value before the change.
+   */
+  virtual void onUserDataChanged(const User &user, UserField field, const std::string &oldValue) = 0;
+};
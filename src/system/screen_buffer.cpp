@@ -0,0 +1,30 @@
+#include "system/screen_buffer.h"
+#include "storage/file_utils.h"
+#include <cstdio>
+#include <iostream>
+#include <unistd.h>
+
+/**
+ * @brief Constructor reserving SCREEN_BUFFER_RESERVE bytes.
+ */
+ScreenBuffer::ScreenBuffer() { _buffer.reserve(SCREEN_BUFFER_RESERVE); }
+
+/**
+ * @brief Writes the composed text to standard output and empties the buffer.
+ * @return True if the whole text was written.
+ */
+bool ScreenBuffer::flush() {
+  if (_buffer.empty())
+    return true;
+
+  // то, что выведено через std::cout, должно оказаться на экране раньше
+  std::cout.flush();
+  std::fflush(stdout);
+
+  // буфер живёт всю сессию, поэтому текст не копится и при ошибке, она остаётся в std::cout
+  bool ok = writeAll(STDOUT_FILENO, _buffer.data(), _buffer.size());
+  _buffer.clear();
+  if (!ok)
+    std::cout.setstate(std::ios::badbit);
+  return ok;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+constexpr std::string_view ANSI_GREEN = "\033[32m"; ///< Входящие и непрочитанные.
+constexpr std::string_view ANSI_WHITE = "\033[37m"; ///< Исходящие.
+constexpr std::string_view ANSI_RESET = "\033[0m";  ///< Сброс цвета.
+
+const std::size_t SCREEN_BUFFER_RESERVE = 64 * 1024; ///< Initial capacity, enough for a chat window.
+
+/**
+ * @brief Composes a whole screen in memory and writes it to the terminal at once.
+ * @details The text is appended with operator<< instead of going through std::cout
+ * line by line; flush() writes the screen with a single write() and keeps the capacity
+ * for the next screen, so a window of 200 messages costs one system call.
+ */
+class ScreenBuffer {
+private:
+  std::string _buffer; ///< Text of the screen not written yet.
+
+public:
+  /**
+   * @brief Constructor reserving SCREEN_BUFFER_RESERVE bytes.
+   */
+  ScreenBuffer();
+  ScreenBuffer(const ScreenBuffer &) = delete;
+  ScreenBuffer &operator=(const ScreenBuffer &) = delete;
+
+  /**
+   * @brief Appends text.
+   * @param text The text.
+   * @return Reference to the buffer.
+   */
+  ScreenBuffer &operator<<(std::string_view text) {
+    _buffer.append(text.data(), text.size());
+    return *this;
+  }
+
+  /**
+   * @brief Appends a C string.
+   * @param text Null-terminated text.
+   * @return Reference to the buffer.
+   */
+  ScreenBuffer &operator<<(const char *text) { return *this << std::string_view(text); }
+
+  /**
+   * @brief Appends a string.
+   * @param text The string.
+   * @return Reference to the buffer.
+   */
+  ScreenBuffer &operator<<(const std::string &text) { return *this << std::string_view(text); }
+
+  /**
+   * @brief Appends one character.
+   * @param ch The character.
+   * @return Reference to the buffer.
+   */
+  ScreenBuffer &operator<<(char ch) {
+    _buffer.push_back(ch);
+    return *this;
+  }
+
+  /**
+   * @brief Appends an integer in decimal.
+   * @param value The number.
+   * @return Reference to the buffer.
+   */
+  template <typename Integer, typename = std::enable_if_t<std::is_integral_v<Integer> &&
+                                                          !std::is_same_v<Integer, char> && !std::is_same_v<Integer, bool>>>
+  ScreenBuffer &operator<<(Integer value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    _buffer.append(digits, static_cast<std::size_t>(result.ptr - digits));
+    return *this;
+  }
+
+  /**
+   * @brief Gets the size of the composed text.
+   * @return Number of bytes not written yet.
+   */
+  std::size_t size() const { return _buffer.size(); }
+
+  /**
+   * @brief Gets the composed text.
+   * @return View of the text not written yet.
+   */
+  std::string_view view() const { return _buffer; }
+
+  /**
+   * @brief Drops the composed text without writing it.
+   */
+  void clear() { _buffer.clear(); }
+
+  /**
+   * @brief Writes the composed text to standard output and empties the buffer.
+   * @details Pending std::cout output is flushed first, so the order of the screens is kept.
+   * A failed write sets badbit on std::cout, as if the text had gone through it.
+   * @return True if the whole text was written.
+   */
+  bool flush();
+};
@@ -5,6 +5,8 @@
 #include "message/message_content_struct.h"
 #include "ChatBot/chat_system.h"
 #include "date_time_utils.h"
+#include "service/chat_service.h"
+#include "system/utf8_case.h"
 #include <algorithm>
 #include <ctime>
 #include <iostream>
@@ -13,26 +15,77 @@
 #include <stdexcept>
 #include <string>
 
+namespace {
+
 /**
- * @brief Получает индекс символа в алфавите.
- * @param word Строка, содержащая символ (может быть многобайтный UTF-8).
- * @return Индекс символа в массиве alphabet или -1, если не найден.
+ * @brief Декодирует первый символ латиницы или кириллицы.
+ * @return Код символа или -1 для остальных символов.
  */
-int getCharIndex(const std::string &word) {
-  if (word.empty())
+constexpr long decodeAlphabetChar(std::string_view text) {
+  if (text.empty())
     return -1;
-  std::size_t charLen = getUtf8CharLen((unsigned char)word[0]);
-
-  if (charLen > word.size())
+  auto lead = static_cast<unsigned char>(text[0]);
+  if (lead < 0x80)
+    return lead;
+  if ((lead != 0xD0 && lead != 0xD1) || text.size() < 2 || (static_cast<unsigned char>(text[1]) & 0xC0) != 0x80)
     return -1;
+  return static_cast<long>((lead & 0x1Fu) << 6 | (static_cast<unsigned char>(text[1]) & 0x3Fu));
+}
 
-  std::string ch = word.substr(0, charLen);
+/**
+ * @brief Ячейка таблицы для кода: 0..127 - ASCII, 128..255 - U+0400..U+047F.
+ */
+constexpr int alphabetSlot(long codePoint) {
+  if (codePoint >= 0 && codePoint < 0x80)
+    return static_cast<int>(codePoint);
+  if (codePoint >= 0x400 && codePoint < 0x480)
+    return static_cast<int>(0x80 + codePoint - 0x400);
+  return -1;
+}
 
-  for (int i = 0; i < ALPHABET_SIZE; ++i)
-    if (ch == alphabet[i])
-      return i;
+/**
+ * @brief Таблица код символа -> индекс в alphabet, строится из самого alphabet.
+ */
+struct AlphabetIndexTable {
+  signed char _index[256] = {};
+
+  constexpr AlphabetIndexTable() {
+    for (int slot = 0; slot < 256; ++slot)
+      _index[slot] = -1;
+
+    for (int i = 0; i < ALPHABET_SIZE; ++i) {
+      long codePoint = decodeAlphabetChar(alphabet[i]);
+      _index[alphabetSlot(codePoint)] = static_cast<signed char>(i);
+
+      // заглавная буква получает индекс строчной
+      long upper = codePoint;
+      if (codePoint >= 'a' && codePoint <= 'z')
+        upper = codePoint - 0x20;
+      else if (codePoint >= 0x430 && codePoint <= 0x44F) // а..я
+        upper = codePoint - 0x20;
+      else if (codePoint >= 0x450 && codePoint <= 0x45F) // ё
+        upper = codePoint - 0x50;
+      _index[alphabetSlot(upper)] = static_cast<signed char>(i);
+    }
+  }
+};
 
-  return -1;
+constexpr AlphabetIndexTable ALPHABET_INDEX;
+
+static_assert(ALPHABET_INDEX._index[alphabetSlot('z')] == ENG_SIZE - 1, "латиница - первые ENG_SIZE символов");
+static_assert(ALPHABET_INDEX._index[alphabetSlot(0x44F)] == ALPHABET_SIZE - 1, "я - последний символ алфавита");
+static_assert(ALPHABET_INDEX._index[alphabetSlot(0x401)] == ALPHABET_INDEX._index[alphabetSlot(0x451)], "Ё = ё");
+
+} // namespace
+
+/**
+ * @brief Получает индекс первого символа строки в алфавите.
+ * @param text Строка UTF-8, важен только первый символ.
+ * @return Индекс символа в массиве alphabet (заглавная буква дает индекс строчной) или -1, если не найден.
+ */
+int getCharIndex(std::string_view text) {
+  int slot = alphabetSlot(decodeAlphabetChar(text));
+  return slot < 0 ? -1 : ALPHABET_INDEX._index[slot];
 }
 
 /**
@@ -161,21 +214,18 @@ void changeLastReadIndexForSender(const std::shared_ptr<User> &user,
 void addMessageToChat(const InitDataArray &initDataArray,
                       std::shared_ptr<Chat> &chat) {
 
-  std::vector<std::shared_ptr<IMessageContent>> iMessageContent;
-  TextContent textContent(initDataArray._messageText);
-  MessageContent<TextContent> messageContentText(textContent);
-  iMessageContent.push_back(
-      std::make_shared<MessageContent<TextContent>>(messageContentText));
+  std::vector<MessageContent> messageContent;
+  messageContent.emplace_back(TextContent(initDataArray._messageText));
 
   try {
     if (!initDataArray._sender) {
       throw UnknownException(" Отправитель отсутствует. Сообщение не будет "
                              "создано. addMessageToChat");
     } else {
-      Message message(iMessageContent, initDataArray._sender,
+      Message message(std::move(messageContent), initDataArray._sender->getUserId(),
                       initDataArray._timeStamp, initDataArray._messageId);
 
-      chat->addMessage(std::make_shared<Message>(message));
+      chat->addMessage(message);
 
       changeLastReadIndexForSender(initDataArray._sender, chat);
     };
@@ -185,58 +235,57 @@ void addMessageToChat(const InitDataArray &initDataArray,
 }
 
 /**
- * @brief Prompts the user to input a new message for a chat.
- * @param chatSystem Reference to the chat system.
- * @param chat Shared pointer to the chat.
- * @return True if a message was successfully added, false if the user cancels.
- * @throws EmptyInputException If the input is empty.
+ * @brief Prompts the user to type the text of a message.
+ * @param text Receives the text.
+ * @return True if a text was typed, false if the user cancels with 0.
  */
-bool inputNewMessage(ChatSystem &chatSystem, std::shared_ptr<Chat> chat) {
+bool inputMessageText(std::string &text) {
   std::cout << std::endl
             << "Наберите новое сообщение либо 0 для выхода:" << std::endl;
-  std::string inputData;
 
   while (true) {
-    try {
-      std::getline(std::cin, inputData);
-
-      if (inputData.empty())
-        throw EmptyInputException();
-
-      if (inputData == "0")
-        return false;
-
-      std::vector<std::shared_ptr<User>> recipients;
-      for (const auto &participant : chat->getParticipants()) {
-        auto user_ptr = participant._user.lock();
-        if (user_ptr) {
-          if (user_ptr != chatSystem.getActiveUser())
-            recipients.push_back(user_ptr);
-        }
-      }
-
-      InitDataArray newMessageStruct(inputData, getCurrentDateTime(),
-                                     chatSystem.getActiveUser(), recipients, chatSystem.getNewMessageId());
-      addMessageToChat(newMessageStruct, chat);
+    std::getline(std::cin, text);
+
+    if (text == "0")
+      return false;
+    if (!text.empty())
       return true;
-    } // try
-    catch (const ValidationException &ex) {
-      std::cout << " ! " << ex.what() << " Попробуйте еще раз." << std::endl;
-      continue;
-    }
-  } // while
+
+    std::cout << " ! " << EmptyInputException().what() << " Попробуйте еще раз." << std::endl;
+  }
+}
+
+/**
+ * @brief Prompts the user to input a new message for a chat.
+ * @param chatSystem Reference to the chat system.
+ * @param sessionId Session of the sender.
+ * @param chat Shared pointer to the chat.
+ * @return True if a message was successfully added, false if the user cancels.
+ * @details The message is sent through ChatService.
+ */
+bool inputNewMessage(ChatSystem &chatSystem, SessionId sessionId, std::shared_ptr<Chat> chat) {
+  std::string inputData;
+  if (!inputMessageText(inputData))
+    return false;
+
+  ChatService chatService(chatSystem);
+  std::size_t messageId;
+  ServiceStatus status = chatService.sendMessage(sessionId, chat->getChatId(), inputData, messageId);
+  if (status != ServiceStatus::Ok) {
+    std::cout << " ! " << getStatusText(status) << std::endl;
+    return false;
+  }
+  return true;
 }
 
 /**
  * @brief Converts a string to lowercase.
  * @param str The input string.
  * @return The lowercase version of the input string.
+ * @details Latin and Cyrillic letters are folded (see foldCaseUtf8).
  */
 std::string TextToLower(const std::string &str) {
-  std::string result = str;
-
-  // приводим всех к нижнему регистру
-  std::transform(result.begin(), result.end(), result.begin(),
-                 [](unsigned char c) { return std::tolower(c); });
+  std::string result(str.size(), '\0');
+  foldCaseUtf8(str, &result[0]);
   return result;
-}
\ No newline at end of file
+}
@@ -3,20 +3,22 @@
 #include "message/message_content_struct.h"
 #include <alloca.h>
 #include <string>
+#include <string_view>
 #include <cstddef>
 
 #if defined(_WIN32)
 #include <windows.h>
 #endif
 
-#define ALPHABET_SIZE 59 ///< Размер алфавита (латиница + кириллица)
 #define ENG_SIZE 26 ///< Кол-во символов в английском алфавите
-#define RUS_SIZE 32 ///< Кол-во символов в русском алфавите
+#define RUS_SIZE 33 ///< Кол-во символов в русском алфавите (с ё)
+#define ALPHABET_SIZE (ENG_SIZE + RUS_SIZE) ///< Размер алфавита (латиница + кириллица)
 
 /**
  * @brief Глобальный алфавит для UTF-8 символов (a-z, а-я).
+ * @details constexpr string_view - массив не создается заново при старте в каждой единице трансляции.
  */
-const std::string alphabet[ALPHABET_SIZE] = {
+constexpr std::string_view alphabet[ALPHABET_SIZE] = {
     "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m", "n", "o",
     "p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z", "а", "б", "в", "г",
     "д", "е", "ё", "ж", "з", "и", "й", "к", "л", "м", "н", "о", "п", "р", "с",
@@ -30,11 +32,12 @@ const std::string alphabet[ALPHABET_SIZE] = {
 std::size_t getUtf8CharLen(unsigned char ch);
 
 /**
- * @brief Получает индекс символа в алфавите.
- * @param ch UTF-8 символ
- * @return Индекс или -1, если символ не найден
+ * @brief Получает индекс первого символа строки в алфавите.
+ * @param text Строка UTF-8, важен только первый символ
+ * @return Индекс в alphabet (заглавная буква дает индекс строчной) или -1, если символа нет в алфавите
+ * @details Поиск по таблице, построенной при компиляции, - O(1) без выделений.
  */
-int getCharIndex(const std::string &ch);
+int getCharIndex(std::string_view text);
 
 /**
  * @brief Включает поддержку UTF-8 в консоли.
@@ -78,13 +81,21 @@ void changeLastReadIndexForSender(const std::shared_ptr<User> &user, const std::
  */
 void addMessageToChat(const InitDataArray &initDataArray, std::shared_ptr<Chat> &chat);
 
+/**
+ * @brief Prompts the user to type the text of a message.
+ * @param text Receives the text.
+ * @return True if a text was typed, false if the user cancels with 0.
+ */
+bool inputMessageText(std::string &text);
+
 /**
  * @brief Prompts the user to input a new message for a chat.
  * @param chatSystem Reference to the chat system.
+ * @param sessionId Session of the sender.
  * @param chat Shared pointer to the chat.
  * @return True if a message was successfully added, false otherwise.
  */
-bool inputNewMessage(ChatSystem &chatSystem, std::shared_ptr<Chat> chat);
+bool inputNewMessage(ChatSystem &chatSystem, SessionId sessionId, std::shared_ptr<Chat> chat);
 
 /**
  * @brief Converts a string to lowercase.
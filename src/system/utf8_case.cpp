@@ -0,0 +1,145 @@
+#include "system/utf8_case.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHATBOT_HAVE_SSE2 1
+#endif
+
+namespace {
+
+/**
+ * @brief Writes the lowercase form of the two-byte sequence 0xD0 next.
+ * @details 0xD0 0x80..0xAF are the capitals U+0400..U+042F; 0xD0 0xB0..0xBF is already
+ * lowercase.
+ */
+inline void foldCyrillicPair(unsigned char next, char *out) {
+  if (next >= 0x80 && next <= 0x8F) { // Ѐ..Џ -> ѐ..џ (U+0450..)
+    out[0] = static_cast<char>(0xD1);
+    out[1] = static_cast<char>(next + 0x10);
+  } else if (next >= 0x90 && next <= 0x9F) { // А..П -> а..п
+    out[0] = static_cast<char>(0xD0);
+    out[1] = static_cast<char>(next + 0x20);
+  } else if (next >= 0xA0 && next <= 0xAF) { // Р..Я -> р..я (U+0440..)
+    out[0] = static_cast<char>(0xD1);
+    out[1] = static_cast<char>(next - 0x20);
+  } else {
+    out[0] = static_cast<char>(0xD0);
+    out[1] = static_cast<char>(next);
+  }
+}
+
+/**
+ * @brief Checks that the byte after position is a continuation byte.
+ * @details Only then does 0xD0 start a letter; a broken sequence is copied byte by byte.
+ */
+inline bool continuesAt(std::string_view text, std::size_t position) {
+  return position + 1 < text.size() && (static_cast<unsigned char>(text[position + 1]) & 0xC0) == 0x80;
+}
+
+/**
+ * @brief Folds text[begin, end) one code point at a time.
+ * @return Index where folding stopped; end + 1 if the last letter started at end - 1.
+ * @details Only the lead byte 0xD0 starts a capital outside ASCII, and a lead byte never
+ * occurs inside a sequence, so every other byte is copied as is.
+ */
+std::size_t foldRange(std::string_view text, char *out, std::size_t begin, std::size_t end) {
+  std::size_t i = begin;
+  while (i < end) {
+    auto c = static_cast<unsigned char>(text[i]);
+
+    if (c == 0xD0 && continuesAt(text, i)) {
+      foldCyrillicPair(static_cast<unsigned char>(text[i + 1]), out + i);
+      i += 2;
+      continue;
+    }
+
+    out[i] = static_cast<char>(c >= 'A' && c <= 'Z' ? c + 0x20 : c);
+    ++i;
+  }
+  return i;
+}
+
+} // namespace
+
+/**
+ * @brief Lowercases UTF-8 text into a caller-provided buffer.
+ * @param text UTF-8 text.
+ * @param out Buffer of at least text.size() bytes.
+ * @return Number of bytes written (always text.size()).
+ */
+std::size_t foldCaseUtf8(std::string_view text, char *out) {
+  std::size_t i = 0;
+
+#ifdef CHATBOT_HAVE_SSE2
+  const __m128i beforeA = _mm_set1_epi8('A' - 1);
+  const __m128i afterZ = _mm_set1_epi8('Z' + 1);
+  const __m128i caseBit = _mm_set1_epi8(0x20);
+
+  const __m128i cyrillicLead = _mm_set1_epi8(static_cast<char>(0xD0));
+  const __m128i below90 = _mm_set1_epi8(static_cast<char>(0x90));
+  const __m128i belowA0 = _mm_set1_epi8(static_cast<char>(0xA0));
+  const __m128i belowB0 = _mm_set1_epi8(static_cast<char>(0xB0));
+  const __m128i belowC0 = _mm_set1_epi8(static_cast<char>(0xC0));
+  const __m128i one = _mm_set1_epi8(1);
+
+  while (i + 16 <= text.size()) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + i));
+
+    // байты вне ASCII отрицательны как signed char и в диапазон A..Z не попадают
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(block, beforeA), _mm_cmplt_epi8(block, afterZ));
+    __m128i folded = _mm_or_si128(block, _mm_and_si128(upper, caseBit));
+
+    __m128i leads = _mm_cmpeq_epi8(block, cyrillicLead);
+    int leadBits = _mm_movemask_epi8(leads);
+    if (leadBits != 0) {
+      // второй байт заглавной: после 0xD0 и в 0x80..0xAF (как signed char - меньше 0xB0)
+      __m128i second = _mm_and_si128(_mm_slli_si128(leads, 1), _mm_cmplt_epi8(block, belowC0));
+      __m128i lowRange = _mm_and_si128(second, _mm_cmplt_epi8(block, below90)); // Ѐ..Џ
+      __m128i midRange = _mm_andnot_si128(lowRange, _mm_and_si128(second, _mm_cmplt_epi8(block, belowA0))); // А..П
+      __m128i highRange =
+          _mm_andnot_si128(_mm_or_si128(lowRange, midRange), _mm_and_si128(second, _mm_cmplt_epi8(block, belowB0))); // Р..Я
+
+      __m128i delta = _mm_or_si128(_mm_and_si128(lowRange, _mm_set1_epi8(0x10)),
+                                   _mm_or_si128(_mm_and_si128(midRange, caseBit),
+                                                _mm_and_si128(highRange, _mm_set1_epi8(static_cast<char>(0xE0)))));
+      // Ѐ..Џ и Р..Я переходят под ведущий байт 0xD1
+      __m128i toD1 = _mm_srli_si128(_mm_or_si128(lowRange, highRange), 1);
+      folded = _mm_add_epi8(folded, _mm_add_epi8(delta, _mm_and_si128(toD1, one)));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), folded);
+
+    // пара на границе блока: второй байт еще не загружен
+    if ((leadBits & 0x8000) != 0 && continuesAt(text, i + 15)) {
+      foldCyrillicPair(static_cast<unsigned char>(text[i + 16]), out + i + 15);
+      i += 17;
+    } else {
+      i += 16;
+    }
+  }
+#endif
+
+  foldRange(text, out, i, text.size());
+  return text.size();
+}
+
+/**
+ * @brief Same as foldCaseUtf8, one code point at a time, without the vector path.
+ * @param text UTF-8 text.
+ * @param out Buffer of at least text.size() bytes.
+ * @return Number of bytes written.
+ */
+std::size_t foldCaseUtf8Scalar(std::string_view text, char *out) {
+  foldRange(text, out, 0, text.size());
+  return text.size();
+}
+
+/**
+ * @brief Appends lowercased UTF-8 text to a string.
+ * @param text UTF-8 text.
+ * @param out String the result is appended to.
+ */
+void appendFoldedUtf8(std::string_view text, std::string &out) {
+  std::size_t offset = out.size();
+  out.resize(offset + text.size());
+  foldCaseUtf8(text, &out[offset]);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Lowercases UTF-8 text into a caller-provided buffer.
+ * @param text UTF-8 text.
+ * @param out Buffer of at least text.size() bytes; may not overlap text except when equal.
+ * @return Number of bytes written (always text.size()).
+ * @details Folds A-Z and the Cyrillic capitals U+0400..U+042F (А-Я, Ё and the other
+ * letters of the block); every other byte is copied. Each folded letter keeps its byte
+ * length, so the output is exactly as long as the input. With SSE2 the text is processed
+ * 16 bytes at a time, Cyrillic pairs included; a broken sequence is copied unchanged.
+ */
+std::size_t foldCaseUtf8(std::string_view text, char *out);
+
+/**
+ * @brief Same as foldCaseUtf8, one code point at a time, without the vector path.
+ * @param text UTF-8 text.
+ * @param out Buffer of at least text.size() bytes.
+ * @return Number of bytes written.
+ */
+std::size_t foldCaseUtf8Scalar(std::string_view text, char *out);
+
+/**
+ * @brief Appends lowercased UTF-8 text to a string.
+ * @param text UTF-8 text.
+ * @param out String the result is appended to; allocates only if its capacity is exceeded.
+ */
+void appendFoldedUtf8(std::string_view text, std::string &out);
@@ -0,0 +1,318 @@
+#include "system/utf8_scan.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHATBOT_HAVE_SSE2 1
+#endif
+
+namespace {
+
+/**
+ * @brief Gets the class of an ASCII character.
+ */
+constexpr std::uint8_t asciiClass(unsigned char c) {
+  if (c >= '0' && c <= '9')
+    return UTF8_CLASS_DIGIT;
+  if (c >= 'A' && c <= 'Z')
+    return UTF8_CLASS_LATIN_UPPER;
+  if (c >= 'a' && c <= 'z')
+    return UTF8_CLASS_LATIN_LOWER;
+  if (c == ' ')
+    return UTF8_CLASS_SPACE;
+  if (c < 0x20 || c == 0x7F)
+    return UTF8_CLASS_CONTROL;
+  return UTF8_CLASS_PUNCTUATION;
+}
+
+/**
+ * @brief Classes of all ASCII characters.
+ */
+struct AsciiClassTable {
+  std::uint8_t _classes[128] = {};
+
+  constexpr AsciiClassTable() {
+    for (unsigned c = 0; c < 128; ++c)
+      _classes[c] = asciiClass(static_cast<unsigned char>(c));
+  }
+};
+
+constexpr AsciiClassTable ASCII_CLASSES;
+
+/**
+ * @brief Gets the class of a code point outside ASCII.
+ */
+inline std::uint32_t wideClass(std::uint32_t codePoint) {
+  if ((codePoint >= 0x0410 && codePoint <= 0x042F) || codePoint == 0x0401)
+    return UTF8_CLASS_CYRILLIC_UPPER;
+  if ((codePoint >= 0x0430 && codePoint <= 0x044F) || codePoint == 0x0451)
+    return UTF8_CLASS_CYRILLIC_LOWER;
+  return UTF8_CLASS_OTHER;
+}
+
+inline bool isContinuation(unsigned char c) { return (c & 0xC0) == 0x80; }
+
+/**
+ * @brief Checks one character outside ASCII at text[i] and moves past it.
+ * @return False if the character is broken or not allowed; the error is stored in result.
+ */
+bool scanWideCodePoint(std::string_view text, std::size_t &i, std::uint32_t allowedClasses, Utf8ScanResult &result) {
+  auto lead = static_cast<unsigned char>(text[i]);
+  std::size_t length;
+  std::uint32_t codePoint;
+  // допустимый диапазон второго байта отсекает длинные формы, суррогаты и > U+10FFFF
+  unsigned char secondMin = 0x80, secondMax = 0xBF;
+
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    length = 2;
+    codePoint = lead & 0x1Fu;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    length = 3;
+    codePoint = lead & 0x0Fu;
+    if (lead == 0xE0)
+      secondMin = 0xA0;
+    else if (lead == 0xED)
+      secondMax = 0x9F;
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    length = 4;
+    codePoint = lead & 0x07u;
+    if (lead == 0xF0)
+      secondMin = 0x90;
+    else if (lead == 0xF4)
+      secondMax = 0x8F;
+  } else {
+    length = 0; // продолжение без ведущего байта, C0, C1, F5..FF
+  }
+
+  bool broken = length == 0 || i + length > text.size();
+  for (std::size_t k = 1; k < length && !broken; ++k) {
+    auto c = static_cast<unsigned char>(text[i + k]);
+    broken = k == 1 ? (c < secondMin || c > secondMax) : !isContinuation(c);
+    codePoint = codePoint << 6 | (c & 0x3Fu);
+  }
+
+  if (broken) {
+    result._errorOffset = i;
+    result._errorLength = 1;
+    result._malformed = true;
+    return false;
+  }
+
+  std::uint32_t cls = wideClass(codePoint);
+  if ((cls & allowedClasses) == 0) {
+    result._errorOffset = i;
+    result._errorLength = length;
+    return false;
+  }
+  result._classes |= cls;
+  ++result._codePoints;
+  i += length;
+  return true;
+}
+
+/**
+ * @brief Checks one character at text[i] and moves past it.
+ * @return False if the character is broken or not allowed; the error is stored in result.
+ */
+inline bool scanCodePoint(std::string_view text, std::size_t &i, std::uint32_t allowedClasses,
+                          std::string_view allowedAscii, Utf8ScanResult &result) {
+  auto c = static_cast<unsigned char>(text[i]);
+  if (c >= 0x80)
+    return scanWideCodePoint(text, i, allowedClasses, result);
+
+  std::uint32_t cls = ASCII_CLASSES._classes[c];
+  if ((cls & allowedClasses) == 0 && allowedAscii.find(static_cast<char>(c)) == std::string_view::npos) {
+    result._errorOffset = i;
+    result._errorLength = 1;
+    return false;
+  }
+  result._classes |= cls;
+  ++result._codePoints;
+  ++i;
+  return true;
+}
+
+#ifdef CHATBOT_HAVE_SSE2
+
+/**
+ * @brief Checks text 16 bytes at a time and keeps the classes and counts in registers.
+ * @details Blocks of ASCII and two-byte sequences are accepted as a whole; anything else is
+ * left to scanCodePoint. Every class but UTF8_CLASS_OTHER is a bit of one byte, so the
+ * classes of a block are a single vector.
+ */
+class BlockScanner {
+public:
+  BlockScanner(std::uint32_t allowedClasses, std::string_view allowedAscii)
+      : _allowedAscii(allowedAscii),
+        _rejectedClasses(_mm_set1_epi8(static_cast<char>(~allowedClasses & 0xFF))),
+        _otherRejected((allowedClasses & UTF8_CLASS_OTHER) == 0) {}
+
+  /**
+   * @brief Checks the 16 bytes at data, which must start at a character boundary.
+   * @return Number of bytes accepted (15 or 16, a lead byte in the last position is left
+   * for the next block), or 0 if the block has to be checked one character at a time.
+   */
+  std::size_t scan(const char *data) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    const __m128i zero = _mm_setzero_si128();
+
+    // ASCII: 0-9 A-Z a-z пробел управляющие; остальное - знаки
+    __m128i digit = inRange(block, '0', '9');
+    __m128i latinUpper = inRange(block, 'A', 'Z');
+    __m128i latinLower = inRange(block, 'a', 'z');
+    __m128i space = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+    __m128i control = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(-1)),
+                                    _mm_or_si128(_mm_cmplt_epi8(block, _mm_set1_epi8(0x20)),
+                                                 _mm_cmpeq_epi8(block, _mm_set1_epi8(0x7F))));
+    __m128i classes = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(UTF8_CLASS_DIGIT)),
+                     _mm_and_si128(latinUpper, _mm_set1_epi8(UTF8_CLASS_LATIN_UPPER))),
+        _mm_or_si128(_mm_or_si128(_mm_and_si128(latinLower, _mm_set1_epi8(UTF8_CLASS_LATIN_LOWER)),
+                                  _mm_and_si128(space, _mm_set1_epi8(UTF8_CLASS_SPACE))),
+                     _mm_and_si128(control, _mm_set1_epi8(UTF8_CLASS_CONTROL))));
+
+    int highBits = _mm_movemask_epi8(block);
+    std::size_t length = 16;
+    __m128i continuation = zero;
+    if (highBits == 0) {
+      __m128i punctuation = _mm_cmpeq_epi8(classes, zero);
+      classes = _mm_or_si128(classes, _mm_and_si128(punctuation, _mm_set1_epi8(UTF8_CLASS_PUNCTUATION)));
+    } else {
+      // как signed char: продолжения 0x80..0xBF меньше 0xC0, ведущие 0xC2..0xDF
+      continuation = _mm_cmplt_epi8(block, _mm_set1_epi8(static_cast<char>(0xC0)));
+      __m128i lead = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(static_cast<char>(0xC1))),
+                                   _mm_cmplt_epi8(block, _mm_set1_epi8(static_cast<char>(0xE0))));
+      int continuationBits = _mm_movemask_epi8(continuation);
+      int leadBits = _mm_movemask_epi8(lead);
+
+      // C0, C1 и начала длинных последовательностей; каждое продолжение - сразу после ведущего
+      if ((continuationBits | leadBits) != highBits || continuationBits != ((leadBits << 1) & 0xFFFF))
+        return 0;
+      if ((leadBits & 0x8000) != 0)
+        length = 15;
+
+      __m128i ascii = _mm_cmpgt_epi8(block, _mm_set1_epi8(-1));
+      __m128i punctuation = _mm_and_si128(ascii, _mm_cmpeq_epi8(classes, zero));
+      classes = _mm_or_si128(classes, _mm_and_si128(punctuation, _mm_set1_epi8(UTF8_CLASS_PUNCTUATION)));
+
+      // класс двухбайтного символа ставится на его второй байт
+      __m128i afterD0 = _mm_slli_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(0xD0))), 1);
+      __m128i afterD1 = _mm_slli_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(0xD1))), 1);
+      __m128i below90 = _mm_cmplt_epi8(block, _mm_set1_epi8(static_cast<char>(0x90)));
+      __m128i belowB0 = _mm_cmplt_epi8(block, _mm_set1_epi8(static_cast<char>(0xB0)));
+      __m128i cyrillicUpper = _mm_and_si128(
+          afterD0, _mm_or_si128(_mm_andnot_si128(below90, belowB0),
+                                _mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(0x81))))); // А..Я, Ё
+      __m128i cyrillicLower = _mm_or_si128(
+          _mm_andnot_si128(belowB0, _mm_and_si128(afterD0, continuation)), // а..п
+          _mm_and_si128(afterD1, _mm_or_si128(below90, _mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(0x91)))))); // р..я, ё
+      __m128i other = _mm_andnot_si128(_mm_or_si128(cyrillicUpper, cyrillicLower), continuation);
+
+      if (_otherRejected && _mm_movemask_epi8(other) != 0)
+        return 0;
+      _otherSeen = _mm_or_si128(_otherSeen, other);
+      classes = _mm_or_si128(classes, _mm_or_si128(_mm_and_si128(cyrillicUpper, _mm_set1_epi8(static_cast<char>(UTF8_CLASS_CYRILLIC_UPPER))),
+                                                   _mm_and_si128(cyrillicLower, _mm_set1_epi8(static_cast<char>(UTF8_CLASS_CYRILLIC_LOWER)))));
+    }
+
+    // место и символ ошибки уточнит посимвольный разбор
+    __m128i rejected = _mm_and_si128(classes, _rejectedClasses);
+    for (char c : _allowedAscii)
+      rejected = _mm_andnot_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(c)), rejected);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(rejected, zero)) != 0xFFFF)
+      return 0;
+
+    _classesSeen = _mm_or_si128(_classesSeen, classes);
+    // байт 16 отбрасываемого ведущего - не продолжение, на счет не влияет
+    _continuations = _mm_add_epi64(_continuations, _mm_sad_epu8(_mm_and_si128(continuation, _mm_set1_epi8(1)), zero));
+    _bytes += length;
+    return length;
+  }
+
+  /**
+   * @brief Adds the classes and the character count of the accepted blocks to the result.
+   */
+  void flush(Utf8ScanResult &result) const {
+    alignas(16) unsigned char classes[16];
+    alignas(16) std::uint64_t continuations[2];
+    _mm_store_si128(reinterpret_cast<__m128i *>(classes), _classesSeen);
+    _mm_store_si128(reinterpret_cast<__m128i *>(continuations), _continuations);
+
+    for (unsigned char c : classes)
+      result._classes |= c;
+    if (_mm_movemask_epi8(_otherSeen) != 0)
+      result._classes |= UTF8_CLASS_OTHER;
+    result._codePoints += _bytes - static_cast<std::size_t>(continuations[0] + continuations[1]);
+  }
+
+private:
+  static __m128i inRange(__m128i block, char low, char high) {
+    return _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(static_cast<char>(low - 1))),
+                         _mm_cmplt_epi8(block, _mm_set1_epi8(static_cast<char>(high + 1))));
+  }
+
+  std::string_view _allowedAscii;
+  __m128i _rejectedClasses;
+  bool _otherRejected;
+  __m128i _classesSeen = _mm_setzero_si128();
+  __m128i _otherSeen = _mm_setzero_si128();
+  __m128i _continuations = _mm_setzero_si128();
+  std::size_t _bytes = 0;
+};
+
+#endif
+
+} // namespace
+
+/**
+ * @brief Validates and classifies UTF-8 text in one pass, without allocating.
+ * @param text Text to check.
+ * @param allowedClasses Mask of UTF8_CLASS_* characters that are allowed.
+ * @param allowedAscii ASCII characters allowed in addition to the classes (e.g. ",").
+ * @return Number of characters, classes seen and the first error.
+ */
+Utf8ScanResult scanUtf8(std::string_view text, std::uint32_t allowedClasses, std::string_view allowedAscii) {
+  Utf8ScanResult result;
+  std::size_t i = 0;
+
+#ifdef CHATBOT_HAVE_SSE2
+  BlockScanner scanner(allowedClasses, allowedAscii);
+  while (i + 16 <= text.size()) {
+    std::size_t accepted = scanner.scan(text.data() + i);
+    if (accepted != 0) {
+      i += accepted;
+      continue;
+    }
+
+    // блок не подошел - разбираем его посимвольно и продолжаем с границы символа
+    std::size_t blockEnd = i + 16;
+    while (i < blockEnd) {
+      if (!scanCodePoint(text, i, allowedClasses, allowedAscii, result)) {
+        scanner.flush(result);
+        return result;
+      }
+    }
+  }
+  scanner.flush(result);
+#endif
+
+  while (i < text.size())
+    if (!scanCodePoint(text, i, allowedClasses, allowedAscii, result))
+      return result;
+  return result;
+}
+
+/**
+ * @brief Same as scanUtf8, one character at a time, without the vector path.
+ * @param text Text to check.
+ * @param allowedClasses Mask of allowed UTF8_CLASS_* characters.
+ * @param allowedAscii ASCII characters allowed in addition to the classes.
+ * @return Number of characters, classes seen and the first error.
+ */
+Utf8ScanResult scanUtf8Scalar(std::string_view text, std::uint32_t allowedClasses, std::string_view allowedAscii) {
+  Utf8ScanResult result;
+  std::size_t i = 0;
+  while (i < text.size())
+    if (!scanCodePoint(text, i, allowedClasses, allowedAscii, result))
+      return result;
+  return result;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/// @name Классы символов для scanUtf8 (битовая маска)
+/// @{
+constexpr std::uint32_t UTF8_CLASS_DIGIT = 1u << 0;            ///< 0-9
+constexpr std::uint32_t UTF8_CLASS_LATIN_UPPER = 1u << 1;      ///< A-Z
+constexpr std::uint32_t UTF8_CLASS_LATIN_LOWER = 1u << 2;      ///< a-z
+constexpr std::uint32_t UTF8_CLASS_SPACE = 1u << 3;            ///< Пробел
+constexpr std::uint32_t UTF8_CLASS_PUNCTUATION = 1u << 4;      ///< Остальные печатные символы ASCII
+constexpr std::uint32_t UTF8_CLASS_CONTROL = 1u << 5;          ///< Управляющие символы ASCII
+constexpr std::uint32_t UTF8_CLASS_CYRILLIC_UPPER = 1u << 6;   ///< А-Я, Ё
+constexpr std::uint32_t UTF8_CLASS_CYRILLIC_LOWER = 1u << 7;   ///< а-я, ё
+constexpr std::uint32_t UTF8_CLASS_OTHER = 1u << 8;            ///< Любой другой символ вне ASCII
+
+constexpr std::uint32_t UTF8_CLASS_ASCII = UTF8_CLASS_DIGIT | UTF8_CLASS_LATIN_UPPER | UTF8_CLASS_LATIN_LOWER |
+                                           UTF8_CLASS_SPACE | UTF8_CLASS_PUNCTUATION | UTF8_CLASS_CONTROL;
+constexpr std::uint32_t UTF8_CLASS_LETTERS = UTF8_CLASS_LATIN_UPPER | UTF8_CLASS_LATIN_LOWER |
+                                             UTF8_CLASS_CYRILLIC_UPPER | UTF8_CLASS_CYRILLIC_LOWER;
+constexpr std::uint32_t UTF8_CLASS_ANY = UTF8_CLASS_ASCII | UTF8_CLASS_CYRILLIC_UPPER |
+                                         UTF8_CLASS_CYRILLIC_LOWER | UTF8_CLASS_OTHER;
+/// @}
+
+/**
+ * @brief Result of scanUtf8.
+ */
+struct Utf8ScanResult {
+  std::size_t _codePoints = 0;  ///< Число символов (до ошибки, если она есть)
+  std::uint32_t _classes = 0;   ///< Классы встреченных символов
+  std::size_t _errorOffset = 0; ///< Смещение первого битого или запрещенного символа
+  std::size_t _errorLength = 0; ///< Длина этого символа в байтах; 0 - ошибки нет
+  bool _malformed = false;      ///< Ошибка - битая последовательность UTF-8
+
+  /**
+   * @brief Checks that the whole text is valid and allowed.
+   * @return True if no error was found.
+   */
+  bool isValid() const { return _errorLength == 0; }
+
+  /**
+   * @brief Gets the rejected character for an error message.
+   * @param text The scanned text.
+   * @return The character, or an empty view for a broken sequence.
+   */
+  std::string_view rejectedChar(std::string_view text) const {
+    return _malformed || _errorLength == 0 ? std::string_view() : text.substr(_errorOffset, _errorLength);
+  }
+};
+
+/**
+ * @brief Validates and classifies UTF-8 text in one pass, without allocating.
+ * @param text Text to check.
+ * @param allowedClasses Mask of UTF8_CLASS_* characters that are allowed.
+ * @param allowedAscii ASCII characters allowed in addition to the classes (e.g. ",").
+ * @return Number of characters, classes seen and the first error.
+ * @details Rejects overlong forms, surrogates and code points above U+10FFFF. Stops at the
+ * first broken sequence or disallowed character. With SSE2, blocks of ASCII and two-byte
+ * sequences are checked 16 bytes at a time.
+ */
+Utf8ScanResult scanUtf8(std::string_view text, std::uint32_t allowedClasses, std::string_view allowedAscii = {});
+
+/**
+ * @brief Same as scanUtf8, one character at a time, without the vector path.
+ * @param text Text to check.
+ * @param allowedClasses Mask of allowed UTF8_CLASS_* characters.
+ * @param allowedAscii ASCII characters allowed in addition to the classes.
+ * @return Number of characters, classes seen and the first error.
+ */
+Utf8ScanResult scanUtf8Scalar(std::string_view text, std::uint32_t allowedClasses,
+                              std::string_view allowedAscii = {});
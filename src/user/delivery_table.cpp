@@ -0,0 +1,141 @@
+#include "user/delivery_table.h"
+#include <algorithm>
+
+/**
+ * @brief Constructor.
+ * @param sessionId The subscribed session.
+ * @param notify Called when a message arrives into an empty queue.
+ */
+DeliveryQueue::DeliveryQueue(SessionId sessionId, std::function<void(SessionId)> notify)
+    : _sessionId(sessionId), _notify(std::move(notify)) {}
+
+/**
+ * @brief Adds a new message.
+ * @param chatId ID of the chat.
+ * @param position Position of the message in the chat.
+ */
+void DeliveryQueue::push(std::size_t chatId, std::size_t position) {
+  bool wasEmpty;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    wasEmpty = _chats.empty() && !_overflow;
+
+    // очередь короткая - поиск чата перебором дешевле любой карты
+    auto it = std::find_if(_chats.begin(), _chats.end(),
+                           [chatId](const PendingChat &pending) { return pending._chatId == chatId; });
+    if (it != _chats.end()) {
+      it->_end = std::max(it->_end, position + 1);
+    } else if (_chats.size() < DELIVERY_QUEUE_CHATS_MAX) {
+      _chats.push_back(PendingChat{chatId, position, position + 1});
+    } else {
+      _overflow = true;
+    }
+  }
+
+  if (wasEmpty && _notify)
+    _notify(_sessionId);
+}
+
+/**
+ * @brief Takes everything queued; the queue becomes empty.
+ * @param chats Receives the chats with new messages.
+ * @return True if messages were dropped.
+ */
+bool DeliveryQueue::take(std::vector<PendingChat> &chats) {
+  chats.clear();
+  std::lock_guard<std::mutex> lock(_mutex);
+  // обмен сохраняет емкость обоих векторов - в установившемся режиме без выделений
+  chats.swap(_chats);
+  bool overflow = _overflow;
+  _overflow = false;
+  return overflow;
+}
+
+/**
+ * @brief Gets the shard of a user.
+ * @param userId Handle of the user.
+ * @return Reference to the shard.
+ */
+DeliveryTable::Shard &DeliveryTable::getShard(UserId userId) {
+  return _shards[userId._index % DELIVERY_SHARD_COUNT];
+}
+
+/**
+ * @brief Gets the shard of a user for lookups.
+ * @param userId Handle of the user.
+ * @return Reference to the shard.
+ */
+const DeliveryTable::Shard &DeliveryTable::getShard(UserId userId) const {
+  return _shards[userId._index % DELIVERY_SHARD_COUNT];
+}
+
+/**
+ * @brief Subscribes a session to the new messages of its user.
+ * @param userId Handle of the user of the session.
+ * @param sessionId Handle of the session.
+ * @param notify Called when a message arrives into the empty queue of the session.
+ * @return The queue of the session.
+ */
+std::shared_ptr<DeliveryQueue> DeliveryTable::subscribe(UserId userId, SessionId sessionId,
+                                                        std::function<void(SessionId)> notify) {
+  auto queue = std::make_shared<DeliveryQueue>(sessionId, std::move(notify));
+
+  auto &shard = getShard(userId);
+  std::unique_lock<std::shared_mutex> lock(shard._mutex);
+  shard._queues[userId].push_back(queue);
+  _queueCount.fetch_add(1, std::memory_order_relaxed);
+  return queue;
+}
+
+/**
+ * @brief Removes the subscription of a session.
+ * @param userId Handle of the user of the session.
+ * @param sessionId Handle of the session.
+ * @return True if the session was subscribed.
+ */
+bool DeliveryTable::unsubscribe(UserId userId, SessionId sessionId) {
+  auto &shard = getShard(userId);
+  std::unique_lock<std::shared_mutex> lock(shard._mutex);
+  auto it = shard._queues.find(userId);
+  if (it == shard._queues.end())
+    return false;
+
+  auto &queues = it->second;
+  auto queue = std::find_if(queues.begin(), queues.end(), [sessionId](const std::shared_ptr<DeliveryQueue> &queue) {
+    return queue->getSessionId() == sessionId;
+  });
+  if (queue == queues.end())
+    return false;
+
+  queues.erase(queue);
+  if (queues.empty())
+    shard._queues.erase(it);
+  _queueCount.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+/**
+ * @brief Pushes a new message into the queues of all subscribed sessions of a user.
+ * @param userId Handle of the user.
+ * @param chatId ID of the chat.
+ * @param position Position of the message in the chat.
+ */
+void DeliveryTable::deliver(UserId userId, std::size_t chatId, std::size_t position) const {
+  if (_queueCount.load(std::memory_order_relaxed) == 0)
+    return;
+
+  auto &shard = getShard(userId);
+  std::shared_lock<std::shared_mutex> lock(shard._mutex);
+  auto it = shard._queues.find(userId);
+  if (it == shard._queues.end())
+    return;
+
+  for (const auto &queue : it->second)
+    queue->push(chatId, position);
+}
+
+/**
+ * @brief Gets the number of subscribed sessions.
+ * @return Number of queues.
+ */
+std::size_t DeliveryTable::getQueueCount() const { return _queueCount.load(std::memory_order_relaxed); }
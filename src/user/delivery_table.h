@@ -0,0 +1,135 @@
+#pragma once
+#include "user/session_table.h"
+#include "user/user_id.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+const std::size_t DELIVERY_SHARD_COUNT = 64;     ///< Shards of the delivery table.
+const std::size_t DELIVERY_QUEUE_CHATS_MAX = 64; ///< Chats a queue tracks before it asks the client to resync.
+
+/**
+ * @brief New messages of one chat waiting for delivery to a session.
+ */
+struct PendingChat {
+  std::size_t _chatId = 0; ///< ID of the chat.
+  std::size_t _first = 0;  ///< Position of the first new message in the chat.
+  std::size_t _end = 0;    ///< Position after the last new message.
+};
+
+/**
+ * @brief Bounded queue of new messages for one subscribed session.
+ * @details Holds positions, not messages: the consumer reads the messages from the chat
+ * when it delivers them. New messages of a chat that is already queued only extend its
+ * range, so a slow consumer costs one entry per chat however many messages arrive. At
+ * most DELIVERY_QUEUE_CHATS_MAX chats are queued; a message of one more chat sets the
+ * overflow flag instead, which tells the client to reload its chat list.
+ */
+class DeliveryQueue {
+private:
+  std::mutex _mutex;                      ///< Guards _chats and _overflow.
+  std::vector<PendingChat> _chats;        ///< Chats with new messages, in order of the first message.
+  bool _overflow = false;                 ///< Messages were dropped since the last take().
+  SessionId _sessionId;                   ///< The subscribed session.
+  std::function<void(SessionId)> _notify; ///< Called when the queue stops being empty.
+
+public:
+  /**
+   * @brief Constructor.
+   * @param sessionId The subscribed session.
+   * @param notify Called, without locks of the queue, when a message arrives into an empty queue.
+   */
+  DeliveryQueue(SessionId sessionId, std::function<void(SessionId)> notify);
+
+  /**
+   * @brief Adds a new message.
+   * @param chatId ID of the chat.
+   * @param position Position of the message in the chat.
+   */
+  void push(std::size_t chatId, std::size_t position);
+
+  /**
+   * @brief Takes everything queued; the queue becomes empty.
+   * @param chats Receives the chats with new messages (replaced).
+   * @return True if messages were dropped because too many chats were queued.
+   */
+  bool take(std::vector<PendingChat> &chats);
+
+  /**
+   * @brief Gets the subscribed session.
+   */
+  SessionId getSessionId() const { return _sessionId; }
+};
+
+/**
+ * @brief Subscriptions of sessions to the new messages of their users.
+ * @details ChatSystem passes every committed message to deliver(), which pushes it into
+ * the queues of all subscribed sessions of the user, the sender's sessions included.
+ * The table is split into shards by user with their own locks; without subscriptions
+ * deliver() costs one atomic load.
+ */
+class DeliveryTable {
+private:
+  /**
+   * @brief Part of the table.
+   */
+  struct alignas(64) Shard {
+    mutable std::shared_mutex _mutex; ///< Guards _queues.
+    std::unordered_map<UserId, std::vector<std::shared_ptr<DeliveryQueue>>, UserIdHash> _queues; ///< Queues by user.
+  };
+
+  std::array<Shard, DELIVERY_SHARD_COUNT> _shards; ///< Queues by user.
+  std::atomic<std::size_t> _queueCount{0};         ///< Number of subscribed sessions.
+
+  /**
+   * @brief Gets the shard of a user.
+   * @param userId Handle of the user.
+   * @return Reference to the shard.
+   */
+  Shard &getShard(UserId userId);
+
+  /**
+   * @brief Gets the shard of a user for lookups.
+   * @param userId Handle of the user.
+   * @return Reference to the shard.
+   */
+  const Shard &getShard(UserId userId) const;
+
+public:
+  /**
+   * @brief Subscribes a session to the new messages of its user.
+   * @param userId Handle of the user of the session.
+   * @param sessionId Handle of the session.
+   * @param notify Called when a message arrives into the empty queue of the session.
+   * @return The queue of the session.
+   */
+  std::shared_ptr<DeliveryQueue> subscribe(UserId userId, SessionId sessionId, std::function<void(SessionId)> notify);
+
+  /**
+   * @brief Removes the subscription of a session.
+   * @param userId Handle of the user of the session.
+   * @param sessionId Handle of the session.
+   * @return True if the session was subscribed.
+   */
+  bool unsubscribe(UserId userId, SessionId sessionId);
+
+  /**
+   * @brief Pushes a new message into the queues of all subscribed sessions of a user.
+   * @param userId Handle of the user.
+   * @param chatId ID of the chat.
+   * @param position Position of the message in the chat.
+   */
+  void deliver(UserId userId, std::size_t chatId, std::size_t position) const;
+
+  /**
+   * @brief Gets the number of subscribed sessions.
+   * @return Number of queues.
+   */
+  std::size_t getQueueCount() const;
+};
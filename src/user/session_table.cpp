@@ -0,0 +1,107 @@
+#include "user/session_table.h"
+
+/**
+ * @brief Gets the shard of a session.
+ * @param sessionId Handle of the session.
+ * @return Reference to the shard.
+ */
+SessionTable::Shard &SessionTable::getShard(SessionId sessionId) {
+  return _shards[sessionId._value % SESSION_SHARD_COUNT];
+}
+
+/**
+ * @brief Gets the shard of a session for lookups.
+ * @param sessionId Handle of the session.
+ * @return Reference to the shard.
+ */
+const SessionTable::Shard &SessionTable::getShard(SessionId sessionId) const {
+  return _shards[sessionId._value % SESSION_SHARD_COUNT];
+}
+
+/**
+ * @brief Opens a session of a user.
+ * @param userId Handle of the logged-in user.
+ * @return Handle of the new session.
+ */
+SessionId SessionTable::open(UserId userId) {
+  SessionId sessionId{_nextSession.fetch_add(1, std::memory_order_relaxed)};
+
+  Session session;
+  session._userId = userId;
+  session._openedAt = getCurrentTimeStamp();
+
+  auto &shard = getShard(sessionId);
+  std::lock_guard<std::mutex> lock(shard._mutex);
+  shard._sessions.emplace(sessionId._value, session);
+  _sessionCount.fetch_add(1, std::memory_order_relaxed);
+  return sessionId;
+}
+
+/**
+ * @brief Closes a session.
+ * @param sessionId Handle of the session.
+ * @return True if the session was open.
+ */
+bool SessionTable::close(SessionId sessionId) {
+  auto &shard = getShard(sessionId);
+  std::lock_guard<std::mutex> lock(shard._mutex);
+  if (shard._sessions.erase(sessionId._value) == 0)
+    return false;
+
+  _sessionCount.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+/**
+ * @brief Gets the user of a session.
+ * @param sessionId Handle of the session.
+ * @return Handle of the user, or an invalid UserId if the session is not open.
+ */
+UserId SessionTable::getUserId(SessionId sessionId) const {
+  auto &shard = getShard(sessionId);
+  std::lock_guard<std::mutex> lock(shard._mutex);
+  auto it = shard._sessions.find(sessionId._value);
+  return it != shard._sessions.end() ? it->second._userId : UserId();
+}
+
+/**
+ * @brief Copies the state of a session.
+ * @param sessionId Handle of the session.
+ * @param session Receives the state.
+ * @return False if the session is not open.
+ */
+bool SessionTable::getSession(SessionId sessionId, Session &session) const {
+  auto &shard = getShard(sessionId);
+  std::lock_guard<std::mutex> lock(shard._mutex);
+  auto it = shard._sessions.find(sessionId._value);
+  if (it == shard._sessions.end())
+    return false;
+
+  session = it->second;
+  return true;
+}
+
+/**
+ * @brief Remembers the chat and the window shown in a session.
+ * @param sessionId Handle of the session.
+ * @param chatId ID of the chat, 0 - no chat open.
+ * @param windowFirst First message of the window.
+ * @return False if the session is not open.
+ */
+bool SessionTable::setChatWindow(SessionId sessionId, std::size_t chatId, std::size_t windowFirst) {
+  auto &shard = getShard(sessionId);
+  std::lock_guard<std::mutex> lock(shard._mutex);
+  auto it = shard._sessions.find(sessionId._value);
+  if (it == shard._sessions.end())
+    return false;
+
+  it->second._chatId = chatId;
+  it->second._windowFirst = windowFirst;
+  return true;
+}
+
+/**
+ * @brief Gets the number of open sessions.
+ * @return Number of sessions.
+ */
+std::size_t SessionTable::getSessionCount() const { return _sessionCount.load(std::memory_order_relaxed); }
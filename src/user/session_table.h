@@ -0,0 +1,117 @@
+#pragma once
+#include "system/date_time_utils.h"
+#include "user/user_id.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+const std::size_t SESSION_SHARD_COUNT = 64; ///< Shards of the session table.
+
+/**
+ * @brief Handle of a login session in a SessionTable.
+ * @details Session numbers are never reused, so a closed session stays closed.
+ */
+struct SessionId {
+  std::uint64_t _value = 0; ///< Number of the session; 0 means "no session".
+
+  /**
+   * @brief Checks whether the handle refers to some session (it may already be closed).
+   */
+  bool isValid() const { return _value != 0; }
+
+  bool operator==(const SessionId &other) const { return _value == other._value; }
+  bool operator!=(const SessionId &other) const { return !(*this == other); }
+};
+
+/**
+ * @brief State of one logged-in client.
+ */
+struct Session {
+  UserId _userId;               ///< The logged-in user.
+  std::size_t _chatId = 0;      ///< Chat open in the session, 0 - none.
+  std::size_t _windowFirst = 0; ///< First message of the window shown in the open chat.
+  TimeStamp _openedAt = 0;      ///< Time of the login.
+};
+
+/**
+ * @brief Open sessions of a ChatSystem: session -> user and per-session state.
+ * @details Any number of sessions may belong to one user, and all of them share the
+ * same users and chats. The table is split into shards by session number, each with
+ * its own mutex, so sessions may be opened, resolved and closed from several threads.
+ */
+class SessionTable {
+private:
+  /**
+   * @brief Part of the table.
+   */
+  struct alignas(64) Shard {
+    mutable std::mutex _mutex;                            ///< Guards _sessions.
+    std::unordered_map<std::uint64_t, Session> _sessions; ///< Session number -> state.
+  };
+
+  std::array<Shard, SESSION_SHARD_COUNT> _shards; ///< Sessions by session number.
+  std::atomic<std::uint64_t> _nextSession{1};     ///< Number of the next session.
+  std::atomic<std::size_t> _sessionCount{0};      ///< Number of open sessions.
+
+  /**
+   * @brief Gets the shard of a session.
+   * @param sessionId Handle of the session.
+   * @return Reference to the shard.
+   */
+  Shard &getShard(SessionId sessionId);
+
+  /**
+   * @brief Gets the shard of a session for lookups.
+   * @param sessionId Handle of the session.
+   * @return Reference to the shard.
+   */
+  const Shard &getShard(SessionId sessionId) const;
+
+public:
+  /**
+   * @brief Opens a session of a user.
+   * @param userId Handle of the logged-in user.
+   * @return Handle of the new session.
+   */
+  SessionId open(UserId userId);
+
+  /**
+   * @brief Closes a session.
+   * @param sessionId Handle of the session.
+   * @return True if the session was open.
+   */
+  bool close(SessionId sessionId);
+
+  /**
+   * @brief Gets the user of a session.
+   * @param sessionId Handle of the session.
+   * @return Handle of the user, or an invalid UserId if the session is not open.
+   */
+  UserId getUserId(SessionId sessionId) const;
+
+  /**
+   * @brief Copies the state of a session.
+   * @param sessionId Handle of the session.
+   * @param session Receives the state.
+   * @return False if the session is not open.
+   */
+  bool getSession(SessionId sessionId, Session &session) const;
+
+  /**
+   * @brief Remembers the chat and the window shown in a session.
+   * @param sessionId Handle of the session.
+   * @param chatId ID of the chat, 0 - no chat open.
+   * @param windowFirst First message of the window.
+   * @return False if the session is not open.
+   */
+  bool setChatWindow(SessionId sessionId, std::size_t chatId, std::size_t windowFirst);
+
+  /**
+   * @brief Gets the number of open sessions.
+   * @return Number of sessions.
+   */
+  std::size_t getSessionCount() const;
+};
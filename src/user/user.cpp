@@ -1,10 +1,14 @@
 #include "user.h"
 #include "exception/validation_exception.h"
+#include "system/date_time_utils.h"
+#include "system/mutation_observer.h"
+#include "system/screen_buffer.h"
 #include "user_chat_list.h"
 #include <cstddef>
 #include <iostream>
 #include <memory>
 #include <ostream>
+#include <utility>
 
 /**  auto Alex2104_ptr = std::make_shared<User>("alex1980", "Sasha", "User01");
 
@@ -26,6 +30,34 @@ User::User(const UserData &userData) : _userData(userData) {}
  */
 void User::createChatList(const std::shared_ptr<UserChatList> &userChats) { _userChats = userChats; }
 
+/**
+ * @brief Sets the receiver of profile changes.
+ * @param observer Observer pointer, or nullptr to detach.
+ */
+void User::setMutationObserver(IMutationObserver *observer) { _observer = observer; }
+
+/**
+ * @brief Sets the handle assigned by the chat system.
+ * @param userId Handle of the user.
+ */
+void User::setUserId(UserId userId) { _userId = userId; }
+
+/**
+ * @brief Gets the handle assigned by the chat system.
+ * @return Handle of the user.
+ */
+UserId User::getUserId() const { return _userId; }
+
+/**
+ * @brief Reports a changed field to the observer.
+ * @param field The changed field.
+ * @param oldValue The value before the change.
+ */
+void User::notifyChanged(UserField field, const std::string &oldValue) {
+  if (_observer)
+    _observer->onUserDataChanged(*this, field, oldValue);
+}
+
 /**
  * @brief Gets the user's login.
  * @return The user's login string.
@@ -60,37 +92,57 @@ std::string User::getPhone() const { return _userData._phone; }
  * @brief Gets the user's chat list.
  * @return Shared pointer to the user's chat list.
  */
-std::shared_ptr<UserChatList> User::getUserChatList() const { return _userChats; }
+const std::shared_ptr<UserChatList> &User::getUserChatList() const { return _userChats; }
 
 /**
  * @brief Sets the user's login.
  * @param login The new login string.
  */
-void User::setLogin(const std::string &login) { _userData._login = login; }
+void User::setLogin(const std::string &login) {
+  std::string oldValue = std::move(_userData._login);
+  _userData._login = login;
+  notifyChanged(UserField::Login, oldValue);
+}
 
 /**
  * @brief Sets the user's display name.
  * @param userName The new display name string.
  */
-void User::setUserName(const std::string &userName) { _userData._userName = userName; }
+void User::setUserName(const std::string &userName) {
+  std::string oldValue = std::move(_userData._userName);
+  _userData._userName = userName;
+  notifyChanged(UserField::UserName, oldValue);
+}
 
 /**
  * @brief Sets the user's password hash.
  * @param passwordHash The new password hash string.
  */
-void User::setPassword(const std::string &passwordHash) { _userData._passwordHash = passwordHash; }
+void User::setPassword(const std::string &passwordHash) {
+  std::string oldValue = std::move(_userData._passwordHash);
+  _userData._passwordHash = passwordHash;
+  notifyChanged(UserField::Password, oldValue);
+}
 
 /**
  * @brief Sets the user's email.
  * @param email The new email string.
  */
-void User::setEmail(const std::string &email) { _userData._email = email; }
+void User::setEmail(const std::string &email) {
+  std::string oldValue = std::move(_userData._email);
+  _userData._email = email;
+  notifyChanged(UserField::Email, oldValue);
+}
 
 /**
  * @brief Sets the user's phone number.
  * @param phone The new phone string.
  */
-void User::setPhone(const std::string &phone) { _userData._phone = phone; }
+void User::setPhone(const std::string &phone) {
+  std::string oldValue = std::move(_userData._phone);
+  _userData._phone = phone;
+  notifyChanged(UserField::Phone, oldValue);
+}
 
 /**
  * @brief Checks if the provided password hash matches the user's stored password hash.
@@ -119,90 +171,57 @@ void User::showUserData() const { std::cout << "Name: " << getUserName() << ", L
 void User::showUserDataInit() const { std::cout << "Name: " << getUserName() << ", Login: " << getLogin(); }
 
 /**
- * @brief Prints the user's chat list.
+ * @brief Prints one page of the user's chats, most recently active first.
+ * @param screen Buffer of the screen being composed.
  * @param user Shared pointer to the user whose chat list is to be printed.
- * @throws UnknownException If the message vector of a chat is empty.
- * @details Displays each chat with participant details, last message timestamp,
- * and unread message count.
- * @note Needs to handle deleted users in the list and display unread message
- * counts (marked as TODO).
- */
-void User::printChatList(const std::shared_ptr<User> &user) const {
-  // ДОДЕЛАТЬ ВЫВОД УДАЛЕННОГО ПОЛЬЗОВАТЕЛЯ В СПИСКЕ а также количество новых
-  // сообщений в списке
+ * @param offset Number of chats to skip; the page is numbered from offset + 1.
+ * @param shownChats Receives the printed chats in order (nullptr for a deleted chat).
+ * @return True if there are more chats after this page.
+ * @details Reads the page from the user's inbox: the time of the last message, the unread
+ * count and the names of the other participants are cached there, so neither the other
+ * chats nor the messages are touched.
+ */
+bool User::printChatList(ScreenBuffer &screen, const std::shared_ptr<User> &user, std::size_t offset,
+                         std::vector<std::shared_ptr<Chat>> &shownChats) const {
+  shownChats.clear();
+  const auto &inbox = user->getUserChatList()->getInbox();
+
+  if (inbox.size() == 0) {
+    screen << "У пользователя " << user->getUserName() << " нет чатов.\n";
+    return false;
+  }
+  screen << "\nВсего чатов = " << inbox.size() << ". Список чатов пользователя " << user->getUserName() << " :\n";
 
-  std::string date_stamp;
+  std::vector<const InboxEntry *> page;
+  bool hasMore = inbox.getPage(offset, INBOX_PAGE_SIZE, page);
 
-  // достаем чатлист
-  const auto &chatList = user->getUserChatList()->getChatFromList();
+  std::size_t index = offset + 1;
+  for (const auto *entry : page) {
+    auto chat_ptr = entry->_chat.lock();
+    shownChats.push_back(chat_ptr);
 
-  if (chatList.empty()) {
-    std::cout << "У пользователя " << user->getUserName() << " нет чатов." << std::endl;
-    return;
-  }
-  std::cout << std::endl
-            << "Всего чатов = " << user->getUserChatList()->getChatFromList().size() << ". Список чатов пользователя "
-            << user->getUserName() << " :" << std::endl;
-
-  std::size_t index = 1;
-  std::size_t activeUserMessageCount = 0;
-  std::size_t totalMessages = 0;
-
-  // перебираем чаты в списке
-  for (const auto &weakChat : chatList) {
-
-    date_stamp.clear();
-    totalMessages = 0;
-    activeUserMessageCount = 0;
-
-    if (auto chat_ptr = weakChat.lock()) {
-
-      std::cout << std::endl;
-      std::cout << index << ". chatId чата: " << chat_ptr->getChatId() << ", ";
-
-      const auto &messages = chat_ptr->getMessages();
-      try {
-        if (!messages.empty()) {
-          totalMessages = messages.size();
-          date_stamp = messages.back()->getTimeStamp();
-        } else
-          throw UnknownException("Вектор сообщений пуст. User::printChatList");
-      } catch (const ValidationException &ex) {
-        std::cout << " ! " << ex.what() << std::endl;
-      }
-      // перебираем участников чата
-      std::cout << "Имя/Логин: ";
-      for (const auto &participant : chat_ptr->getParticipants()) {
-        auto user_ptr = participant._user.lock();
-        if (user_ptr) {
-          if (user_ptr != user) {
-            std::cout << user_ptr->getUserName() << "/" << user_ptr->getLogin() << "; ";
-          } else {
-            try {
-              activeUserMessageCount = chat_ptr->getLastReadMessageIndex(user_ptr);
-            } // try
-            catch (const UserNotInListException &) {
-              activeUserMessageCount = 0;
-            } // catch
-          } // else if (user_ptr != user)
-        } // if (user_ptr)
-        else {
-          std::cout << "удал. пользователь";
-        }
-      } // for participant
-      // выводим на печать дату и время последнего сообщения
-      std::cout << "Последнее сообщение - " << date_stamp << ". ";
-
-      // вывод на печать количества новых сообщений
-      if (totalMessages > activeUserMessageCount)
-        std::cout << "новых сообщений - " << totalMessages - activeUserMessageCount;
-      std::cout << std::endl;
-
-    } // if auto chat_ptr
-    else {
-      std::cout << "Чат удален." << std::endl;
+    screen << '\n';
+    if (!chat_ptr) {
+      screen << index++ << ". Чат удален.\n";
+      continue;
     }
-    ++index;
 
-  } // for (const auto &weakChat
+    screen << index++ << ". chatId чата: " << chat_ptr->getChatId() << ", ";
+    screen << "Имя/Логин: " << inbox.getCounterparts(*entry);
+
+    // выводим на печать дату и время последнего сообщения
+    if (entry->_messageCount > 0)
+      screen << "Последнее сообщение - " << formatTimeStamp(entry->_lastActivity) << ". ";
+    else
+      screen << "Сообщений нет. ";
+
+    // вывод на печать количества новых сообщений
+    if (entry->getUnreadCount() > 0)
+      screen << "новых сообщений - " << entry->getUnreadCount();
+    screen << '\n';
+  }
+
+  if (hasMore)
+    screen << "\n+ - следующие " << INBOX_PAGE_SIZE << " чатов\n";
+  return hasMore;
 }
@@ -1,9 +1,20 @@
 #pragma once
 
+#include "user/user_id.h"
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <vector>
 
+class Chat;
+class ScreenBuffer;
 class UserChatList;
+class IMutationObserver;
+
+/**
+ * @brief Profile fields reported to IMutationObserver when changed.
+ */
+enum class UserField : unsigned char { Login = 1, UserName, Password, Email, Phone };
 
 /**
  * @brief Structure to store user input data for registration or login.
@@ -29,6 +40,15 @@ class User {
 private:
   UserData _userData;
   std::shared_ptr<UserChatList> _userChats; ///< User's chat list.
+  IMutationObserver *_observer = nullptr;   ///< Receiver of profile changes (not owned).
+  UserId _userId;                           ///< Handle in the UserTable of the chat system.
+
+  /**
+   * @brief Reports a changed field to the observer.
+   * @param field The changed field.
+   * @param oldValue The value before the change.
+   */
+  void notifyChanged(UserField field, const std::string &oldValue);
 
 public:
   /**
@@ -53,6 +73,24 @@ public:
    */
   void createChatList(const std::shared_ptr<UserChatList> &chats);
 
+  /**
+   * @brief Sets the receiver of profile changes.
+   * @param observer Observer pointer, or nullptr to detach.
+   */
+  void setMutationObserver(IMutationObserver *observer);
+
+  /**
+   * @brief Sets the handle assigned by the chat system.
+   * @param userId Handle of the user.
+   */
+  void setUserId(UserId userId);
+
+  /**
+   * @brief Gets the handle assigned by the chat system.
+   * @return Handle of the user; invalid until the user is added to a chat system.
+   */
+  UserId getUserId() const;
+
   /**
    * @brief Gets the user's login.
    * @return The user's login string.
@@ -85,9 +123,10 @@ public:
 
   /**
    * @brief Gets the user's chat list.
-   * @return Shared pointer to the user's chat list.
+   * @return Shared pointer to the user's chat list; a reference, so senders touching the
+   * inboxes of the participants do not bump the reference count.
    */
-  std::shared_ptr<UserChatList> getUserChatList() const;
+  const std::shared_ptr<UserChatList> &getUserChatList() const;
 
   /**
    * @brief Sets the user's login.
@@ -134,10 +173,15 @@ public:
   bool checkLogin(const std::string &login) const;
 
   /**
-   * @brief Prints the user's chat list.
+   * @brief Prints one page of the user's chats, most recently active first.
+   * @param screen Buffer of the screen being composed.
    * @param user Shared pointer to the user whose chat list is to be printed.
+   * @param offset Number of chats to skip; the page is numbered from offset + 1.
+   * @param shownChats Receives the printed chats in order (nullptr for a deleted chat).
+   * @return True if there are more chats after this page.
    */
-  void printChatList(const std::shared_ptr<User> &user) const;
+  bool printChatList(ScreenBuffer &screen, const std::shared_ptr<User> &user, std::size_t offset,
+                     std::vector<std::shared_ptr<Chat>> &shownChats) const;
 
   /**
    * @brief Displays the user's data.
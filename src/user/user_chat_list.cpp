@@ -6,34 +6,62 @@
  * @brief Constructor for the user's chat list.
  * @param owner Shared pointer to the user who owns the chat list.
  */
-UserChatList::UserChatList(const std::shared_ptr<User> &owner) : _owner(owner) {}
+UserChatList::UserChatList(const std::shared_ptr<User> &owner)
+    : _owner(owner->getUserId()), _inbox(owner->getUserId()) {}
 
 /**
  * @brief Gets the owner of the chat list.
- * @return Weak pointer to the user who owns the chat list.
+ * @return Handle of the user who owns the chat list.
  */
-std::weak_ptr<User> UserChatList::getOwner() const { return _owner; }
+UserId UserChatList::getOwner() const { return _owner; }
 
 /**
  * @brief Gets the list of chats for the user.
- * @return Vector of weak pointers to chats.
+ * @return Const reference to the weak pointers to chats, in the order they were added.
  */
-std::vector<std::weak_ptr<Chat>> UserChatList::getChatFromList() const { return _chatList; }
+const std::vector<std::weak_ptr<Chat>> &UserChatList::getChatFromList() const { return _chatList; }
+
+/**
+ * @brief Gets the chats ordered by last activity.
+ * @return Reference to the inbox.
+ */
+UserInbox &UserChatList::getInbox() { return _inbox; }
+
+/**
+ * @brief Gets the chats ordered by last activity.
+ * @return Const reference to the inbox.
+ */
+const UserInbox &UserChatList::getInbox() const { return _inbox; }
+
+/**
+ * @brief Gets the mutex guarding the list and the inbox.
+ * @return Reference to the mutex.
+ */
+std::mutex &UserChatList::getMutex() const { return _mutex; }
 
 /**
  * @brief Adds a chat to the user's chat list.
  * @param chat Weak pointer to the chat to add.
  */
 void UserChatList::addChat(const std::weak_ptr<Chat> &chat) {
+  std::lock_guard<std::mutex> lock(_mutex);
   _chatList.push_back(chat);
+  _inbox.add(chat.lock());
 }
 
+/**
+ * @brief Deletes a chat from the user's chat list.
+ * @param chat Weak pointer to the chat to delete.
+ */
 void UserChatList::deleteChatFromList(const std::weak_ptr<Chat> &chat) {
+  std::lock_guard<std::mutex> lock(_mutex);
   auto it = std::find_if(_chatList.begin(), _chatList.end(), [&chat](const std::weak_ptr<Chat> &item) {
     return !item.owner_before(chat) && !chat.owner_before(item);
   });
 
   if (it != _chatList.end()) {
+    if (auto chat_ptr = it->lock())
+      _inbox.remove(chat_ptr.get());
     _chatList.erase(it);
   }
 }
\ No newline at end of file
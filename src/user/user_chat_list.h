@@ -1,23 +1,31 @@
 #pragma once
 
 #include "chat/chat.h"
+#include "user/user_id.h"
+#include "user/user_inbox.h"
 #include <memory>
+#include <mutex>
 #include <vector>
 
 class User;
 
 /**
  * @brief Class for storing a user's chat list and their read states.
+ * @details Messages in different chats update the inbox of a shared participant from
+ * different threads, so the list and the inbox are guarded by a mutex. Chat code takes it
+ * while holding the lock of the chat, never the other way round.
  */
 class UserChatList {
 private:
-  std::weak_ptr<User> _owner;                 ///< Owner of the chat list (user).
+  UserId _owner;                              ///< Owner of the chat list (user).
   std::vector<std::weak_ptr<Chat>> _chatList; ///< List of user's chats.
+  UserInbox _inbox;                           ///< The same chats ordered by last activity.
+  mutable std::mutex _mutex;                  ///< Guards _chatList and _inbox.
 
 public:
   /**
    * @brief Constructor for the user's chat list.
-   * @param owner Shared pointer to the user who owns the chat list.
+   * @param owner Shared pointer to the user who owns the chat list; must be added to the chat system.
    */
   UserChatList(const std::shared_ptr<User> &owner);
 
@@ -28,19 +36,37 @@ public:
 
   /**
    * @brief Gets the owner of the chat list.
-   * @return Weak pointer to the user who owns the chat list.
+   * @return Handle of the user who owns the chat list.
    */
-  std::weak_ptr<User> getOwner() const;
+  UserId getOwner() const;
 
   /**
    * @brief Gets the list of chats for the user.
-   * @return Vector of weak pointers to chats.
+   * @return Const reference to the weak pointers to chats, in the order they were added.
    */
-  std::vector<std::weak_ptr<Chat>> getChatFromList() const;
+  const std::vector<std::weak_ptr<Chat>> &getChatFromList() const;
+
+  /**
+   * @brief Gets the chats ordered by last activity.
+   * @return Reference to the inbox.
+   */
+  UserInbox &getInbox();
+
+  /**
+   * @brief Gets the chats ordered by last activity.
+   * @return Const reference to the inbox.
+   */
+  const UserInbox &getInbox() const;
+
+  /**
+   * @brief Gets the mutex guarding the list and the inbox.
+   * @return Reference to the mutex; hold it while reading the inbox when other threads send.
+   */
+  std::mutex &getMutex() const;
 
   /**
    * @brief Adds a chat to the user's chat list.
-   * @param chat Weak pointer to the chat to add.
+   * @param chat Weak pointer to the chat to add; its state is read, so it must not change meanwhile.
    */
   void addChat(const std::weak_ptr<Chat> &chat);
 
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * @brief Handle of a user registered in a UserTable.
+ * @details An index into the slot table plus the generation of the slot at the time the
+ * user was added. When the user is removed the slot generation changes, so a stale
+ * handle no longer resolves instead of pointing at whoever reuses the slot.
+ */
+struct UserId {
+  std::uint32_t _index = 0;      ///< Slot in the table.
+  std::uint32_t _generation = 0; ///< Generation of the slot; 0 means "no user".
+
+  /**
+   * @brief Checks whether the handle refers to some user (it may still be stale).
+   */
+  bool isValid() const { return _generation != 0; }
+
+  bool operator==(const UserId &other) const { return _index == other._index && _generation == other._generation; }
+  bool operator!=(const UserId &other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Hash of UserId for unordered containers.
+ */
+struct UserIdHash {
+  std::size_t operator()(const UserId &id) const {
+    return std::hash<std::uint64_t>()((static_cast<std::uint64_t>(id._generation) << 32) | id._index);
+  }
+};
@@ -0,0 +1,139 @@
+#include "user/user_inbox.h"
+#include "chat/chat.h"
+#include "user/user.h"
+#include <iterator>
+
+/**
+ * @brief Constructor for an empty inbox.
+ * @param owner Handle of the user who owns the inbox.
+ */
+UserInbox::UserInbox(UserId owner) : _owner(owner) {}
+
+/**
+ * @brief Re-reads the activity and the read index of a chat into an entry.
+ * @param chat The chat.
+ * @param entry The entry of the chat.
+ * @details Keeps the total unread count in step with the entry.
+ */
+void UserInbox::readChat(const Chat &chat, InboxEntry &entry) {
+  _totalUnread -= entry.getUnreadCount();
+  entry._lastActivity = chat.getLastActivity();
+  entry._messageCount = chat.getMessageCount();
+  entry._lastRead = chat.getLastReadMessageIndex(_owner);
+  _totalUnread += entry.getUnreadCount();
+}
+
+/**
+ * @brief Adds a chat.
+ * @param chat Shared pointer to the chat.
+ */
+void UserInbox::add(const std::shared_ptr<Chat> &chat) {
+  if (!chat || _keys.count(chat.get()) != 0)
+    return;
+
+  InboxEntry entry;
+  entry._chat = chat;
+  readChat(*chat, entry);
+
+  Key key{entry._lastActivity, _nextSequence++};
+  _entries.emplace(key, std::move(entry));
+  _keys.emplace(chat.get(), key);
+}
+
+/**
+ * @brief Removes a chat.
+ * @param chat The chat.
+ */
+void UserInbox::remove(const Chat *chat) {
+  auto it = _keys.find(chat);
+  if (it == _keys.end())
+    return;
+
+  auto entry = _entries.find(it->second);
+  _totalUnread -= entry->second.getUnreadCount();
+  _entries.erase(entry);
+  _keys.erase(it);
+}
+
+/**
+ * @brief Takes the new message count, last activity and read index of a chat.
+ * @param chat The chat; ignored if it is not in the inbox.
+ */
+void UserInbox::update(const Chat &chat) {
+  auto it = _keys.find(&chat);
+  if (it == _keys.end())
+    return;
+
+  // узел переставляется без копирования записи
+  auto node = _entries.extract(it->second);
+  readChat(chat, node.mapped());
+  node.key()._lastActivity = node.mapped()._lastActivity;
+  it->second = node.key();
+  _entries.insert(std::move(node));
+}
+
+/**
+ * @brief Marks the participant names of a chat for rebuilding.
+ * @param chat The chat; ignored if it is not in the inbox.
+ */
+void UserInbox::invalidateCounterparts(const Chat &chat) {
+  auto it = _keys.find(&chat);
+  if (it != _keys.end())
+    _entries.find(it->second)->second._counterpartsStale = true;
+}
+
+/**
+ * @brief Gets the number of chats.
+ * @return Number of chats in the inbox.
+ */
+std::size_t UserInbox::size() const { return _entries.size(); }
+
+/**
+ * @brief Gets the number of unread messages in all chats.
+ * @return Total unread count, kept up to date on every change (O(1)).
+ */
+std::size_t UserInbox::getTotalUnread() const { return _totalUnread; }
+
+/**
+ * @brief Gets one page of chats in display order.
+ * @param offset Number of chats to skip.
+ * @param limit Maximum number of chats to return.
+ * @param page Receives the entries; valid until the inbox changes.
+ * @return True if there are more chats after this page.
+ */
+bool UserInbox::getPage(std::size_t offset, std::size_t limit, std::vector<const InboxEntry *> &page) const {
+  page.clear();
+  if (offset >= _entries.size())
+    return false;
+
+  auto it = std::next(_entries.begin(), static_cast<std::ptrdiff_t>(offset));
+  for (; it != _entries.end() && page.size() < limit; ++it)
+    page.push_back(&it->second);
+  return it != _entries.end();
+}
+
+/**
+ * @brief Gets the names of the other participants of a chat.
+ * @param entry Entry of the inbox.
+ * @return "Имя/логин; " of every other participant, rebuilt only after a change.
+ */
+const std::string &UserInbox::getCounterparts(const InboxEntry &entry) const {
+  if (!entry._counterpartsStale)
+    return entry._counterparts;
+
+  entry._counterparts.clear();
+  if (auto chat_ptr = entry._chat.lock()) {
+    for (const auto &participant : chat_ptr->getParticipants()) {
+      if (participant._userId == _owner)
+        continue;
+
+      const User *user_ptr = chat_ptr->getUser(participant._userId);
+      if (user_ptr)
+        entry._counterparts += user_ptr->getUserName() + "/" + user_ptr->getLogin() + "; ";
+      else
+        entry._counterparts += "удал. пользователь; ";
+    }
+  }
+  entry._counterpartsStale = false;
+  return entry._counterparts;
+}
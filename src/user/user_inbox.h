@@ -0,0 +1,130 @@
+#pragma once
+
+#include "system/date_time_utils.h"
+#include "user/user_id.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Chat;
+
+const std::size_t INBOX_PAGE_SIZE = 20; ///< Chats shown per page of the chat list.
+
+/**
+ * @brief A chat as seen in the inbox of one user.
+ */
+struct InboxEntry {
+  std::weak_ptr<Chat> _chat;                 ///< The chat.
+  TimeStamp _lastActivity = 0;               ///< Time of the last message, 0 without messages.
+  std::size_t _messageCount = 0;             ///< Number of messages in the chat.
+  std::size_t _lastRead = 0;                 ///< Last read message index of the owner.
+  mutable std::string _counterparts;         ///< "Имя/логин; " of the other participants.
+  mutable bool _counterpartsStale = true;    ///< The names must be rebuilt before printing.
+
+  /**
+   * @brief Gets the number of messages the owner has not read.
+   * @return Unread message count.
+   */
+  std::size_t getUnreadCount() const { return _messageCount > _lastRead ? _messageCount - _lastRead : 0; }
+};
+
+/**
+ * @brief Chats of a user ordered by last activity, newest first.
+ * @details Chat updates the entries of its participants when a message is added or read,
+ * so each change is one reorder in a balanced tree (O(log n)) and a page of the chat list
+ * is read from the front without touching the other chats. The total unread count is
+ * adjusted by the difference of the changed entry.
+ */
+class UserInbox {
+private:
+  /**
+   * @brief Position of a chat in the inbox.
+   */
+  struct Key {
+    TimeStamp _lastActivity; ///< Newer chats first.
+    std::uint64_t _sequence; ///< Among equal times the later added chat first.
+
+    bool operator<(const Key &other) const {
+      if (_lastActivity != other._lastActivity)
+        return _lastActivity > other._lastActivity;
+      return _sequence > other._sequence;
+    }
+  };
+
+  UserId _owner;                                  ///< Owner of the inbox.
+  std::map<Key, InboxEntry> _entries;             ///< Chats in display order.
+  std::unordered_map<const Chat *, Key> _keys;    ///< Position of each chat.
+  std::uint64_t _nextSequence = 0;                ///< Sequence of the next added chat.
+  std::size_t _totalUnread = 0;                   ///< Sum of the unread counts of all entries.
+
+  /**
+   * @brief Re-reads the activity and the read index of a chat into an entry.
+   * @param chat The chat.
+   * @param entry The entry of the chat.
+   * @details Keeps the total unread count in step with the entry.
+   */
+  void readChat(const Chat &chat, InboxEntry &entry);
+
+public:
+  /**
+   * @brief Constructor for an empty inbox.
+   * @param owner Handle of the user who owns the inbox.
+   */
+  explicit UserInbox(UserId owner);
+
+  /**
+   * @brief Adds a chat.
+   * @param chat Shared pointer to the chat.
+   */
+  void add(const std::shared_ptr<Chat> &chat);
+
+  /**
+   * @brief Removes a chat.
+   * @param chat The chat.
+   */
+  void remove(const Chat *chat);
+
+  /**
+   * @brief Takes the new message count, last activity and read index of a chat.
+   * @param chat The chat; ignored if it is not in the inbox.
+   */
+  void update(const Chat &chat);
+
+  /**
+   * @brief Marks the participant names of a chat for rebuilding.
+   * @param chat The chat; ignored if it is not in the inbox.
+   */
+  void invalidateCounterparts(const Chat &chat);
+
+  /**
+   * @brief Gets the number of chats.
+   * @return Number of chats in the inbox.
+   */
+  std::size_t size() const;
+
+  /**
+   * @brief Gets the number of unread messages in all chats.
+   * @return Total unread count, kept up to date on every change (O(1)).
+   */
+  std::size_t getTotalUnread() const;
+
+  /**
+   * @brief Gets one page of chats in display order.
+   * @param offset Number of chats to skip.
+   * @param limit Maximum number of chats to return.
+   * @param page Receives the entries; valid until the inbox changes.
+   * @return True if there are more chats after this page.
+   */
+  bool getPage(std::size_t offset, std::size_t limit, std::vector<const InboxEntry *> &page) const;
+
+  /**
+   * @brief Gets the names of the other participants of a chat.
+   * @param entry Entry of the inbox.
+   * @return "Имя/логин; " of every other participant, rebuilt only after a change.
+   */
+  const std::string &getCounterparts(const InboxEntry &entry) const;
+};
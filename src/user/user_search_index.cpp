@@ -0,0 +1,180 @@
+#include "user/user_search_index.h"
+#include "system/utf8_case.h"
+#include <algorithm>
+
+namespace {
+
+const std::size_t TRIGRAM = 3; ///< Length of an indexed byte sequence.
+
+} // namespace
+
+/**
+ * @brief Collects the distinct trigrams of a text.
+ * @param text Lowercased text.
+ * @param trigrams Receives the sorted distinct trigrams.
+ */
+void UserSearchIndex::collectTrigrams(const std::string &text, std::vector<std::uint32_t> &trigrams) {
+  trigrams.clear();
+  for (std::size_t i = 0; i + TRIGRAM <= text.size(); ++i) {
+    trigrams.push_back(static_cast<std::uint32_t>(static_cast<unsigned char>(text[i])) << 16 |
+                       static_cast<std::uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8 |
+                       static_cast<unsigned char>(text[i + 2]));
+  }
+  std::sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+/**
+ * @brief Indexes a user.
+ * @param userId Handle of the user.
+ * @param login Login of the user.
+ * @param userName Display name of the user.
+ */
+void UserSearchIndex::add(UserId userId, const std::string &login, const std::string &userName) {
+  if (userId._index >= _entries.size())
+    _entries.resize(userId._index + 1);
+
+  auto &entry = _entries[userId._index];
+  entry._userId = userId;
+  // перевод строки не встречается во вводе, поэтому совпадение не захватит и логин, и имя
+  entry._text.clear();
+  appendFoldedUtf8(login, entry._text);
+  entry._text.push_back('\n');
+  appendFoldedUtf8(userName, entry._text);
+
+  std::vector<std::uint32_t> trigrams;
+  collectTrigrams(entry._text, trigrams);
+  for (auto trigram : trigrams) {
+    auto &slots = _postings[trigram];
+    auto it = std::lower_bound(slots.begin(), slots.end(), userId._index);
+    if (it == slots.end() || *it != userId._index)
+      slots.insert(it, userId._index);
+  }
+}
+
+/**
+ * @brief Reindexes a user after the login or the name changed.
+ * @param userId Handle of the user.
+ * @param login New login.
+ * @param userName New display name.
+ */
+void UserSearchIndex::update(UserId userId, const std::string &login, const std::string &userName) {
+  remove(userId);
+  add(userId, login, userName);
+}
+
+/**
+ * @brief Removes a user from the index.
+ * @param userId Handle of the user.
+ */
+void UserSearchIndex::remove(UserId userId) {
+  if (userId._index >= _entries.size() || _entries[userId._index]._userId != userId)
+    return;
+
+  auto &entry = _entries[userId._index];
+  std::vector<std::uint32_t> trigrams;
+  collectTrigrams(entry._text, trigrams);
+  for (auto trigram : trigrams) {
+    auto posting = _postings.find(trigram);
+    if (posting == _postings.end())
+      continue;
+
+    auto &slots = posting->second;
+    auto it = std::lower_bound(slots.begin(), slots.end(), userId._index);
+    if (it != slots.end() && *it == userId._index)
+      slots.erase(it);
+    if (slots.empty())
+      _postings.erase(posting);
+  }
+  entry = Entry();
+}
+
+/**
+ * @brief Checks the next candidate of a query and adds it to the page if it matches.
+ * @param slot Candidate slot.
+ * @param query Lowercased search string.
+ * @param exclude User left out of the results.
+ * @param skip Matches still to skip before the page starts.
+ * @param limit Size of the page.
+ * @param found The page.
+ * @param hasMore Set once a match after the page is seen.
+ * @return False once the page is full and one more match was seen.
+ */
+bool UserSearchIndex::acceptCandidate(std::uint32_t slot, const std::string &query, UserId exclude,
+                                      std::size_t &skip, std::size_t limit, std::vector<UserId> &found,
+                                      bool &hasMore) const {
+  const auto &entry = _entries[slot];
+  if (!entry._userId.isValid() || entry._userId == exclude)
+    return true;
+
+  // совпадение всех триграмм еще не означает вхождение подстроки
+  if (entry._text.find(query) == std::string::npos)
+    return true;
+
+  if (skip > 0) {
+    --skip;
+    return true;
+  }
+  if (found.size() == limit) {
+    hasMore = true;
+    return false;
+  }
+  found.push_back(entry._userId);
+  return true;
+}
+
+/**
+ * @brief Finds users whose login or name contains a text, case-insensitively.
+ * @param textToFind Search string.
+ * @param exclude User left out of the results (e.g. the active user).
+ * @param offset Number of matches to skip (start of the page).
+ * @param limit Maximum number of matches to return.
+ * @param found Receives the handles of the matches, ordered by slot.
+ * @return True if there are more matches after this page.
+ */
+bool UserSearchIndex::find(const std::string &textToFind, UserId exclude, std::size_t offset, std::size_t limit,
+                           std::vector<UserId> &found) const {
+  found.clear();
+  std::string query;
+  appendFoldedUtf8(textToFind, query);
+  std::size_t skip = offset;
+  bool hasMore = false;
+
+  // короткий запрос почти не отсекает кандидатов - просто идем по текстам до заполнения страницы
+  if (query.size() < TRIGRAM) {
+    for (std::uint32_t slot = 0; slot < _entries.size(); ++slot)
+      if (!acceptCandidate(slot, query, exclude, skip, limit, found, hasMore))
+        break;
+    return hasMore;
+  }
+
+  std::vector<std::uint32_t> trigrams;
+  collectTrigrams(query, trigrams);
+
+  std::vector<const std::vector<std::uint32_t> *> lists;
+  for (auto trigram : trigrams) {
+    auto posting = _postings.find(trigram);
+    if (posting == _postings.end())
+      return false; // такой триграммы нет ни у кого
+    lists.push_back(&posting->second);
+  }
+  std::sort(lists.begin(), lists.end(),
+            [](const std::vector<std::uint32_t> *a, const std::vector<std::uint32_t> *b) { return a->size() < b->size(); });
+
+  // идем по самому короткому списку, в остальных ищем с последней найденной позиции
+  std::vector<std::size_t> positions(lists.size(), 0);
+  for (auto slot : *lists[0]) {
+    bool inAll = true;
+    for (std::size_t k = 1; k < lists.size() && inAll; ++k) {
+      const auto &slots = *lists[k];
+      auto it = std::lower_bound(slots.begin() + positions[k], slots.end(), slot);
+      positions[k] = it - slots.begin();
+      if (it == slots.end())
+        return hasMore; // дальше пересечение пусто
+      inAll = *it == slot;
+    }
+    if (inAll && !acceptCandidate(slot, query, exclude, skip, limit, found, hasMore))
+      break;
+  }
+  return hasMore;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "user/user_id.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+const std::size_t USER_SEARCH_PAGE_SIZE = 20; ///< Users shown per page of search results.
+
+/**
+ * @brief Trigram index over the case-folded logins and names of the users.
+ * @details Every distinct three-byte sequence of "login\nname" has a sorted posting list
+ * of the slots of the users containing it. A substring query intersects the lists of its
+ * trigrams, starting from the shortest, and checks the few remaining candidates against
+ * the stored text. Queries shorter than three bytes scan the stored texts, stopping as
+ * soon as the requested page is full.
+ */
+class UserSearchIndex {
+private:
+  /**
+   * @brief Indexed text of one slot of the UserTable.
+   */
+  struct Entry {
+    UserId _userId;    ///< Occupant of the slot; invalid if the slot is not indexed.
+    std::string _text; ///< Lowercased "login\nname".
+  };
+
+  std::vector<Entry> _entries;                                         ///< Indexed texts by slot.
+  std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> _postings; ///< Trigram -> sorted slots.
+
+  /**
+   * @brief Collects the distinct trigrams of a text.
+   * @param text Lowercased text.
+   * @param trigrams Receives the sorted distinct trigrams.
+   */
+  static void collectTrigrams(const std::string &text, std::vector<std::uint32_t> &trigrams);
+
+  /**
+   * @brief Checks the next candidate of a query and adds it to the page if it matches.
+   * @return False once the page is full and one more match was seen.
+   */
+  bool acceptCandidate(std::uint32_t slot, const std::string &query, UserId exclude, std::size_t &skip,
+                       std::size_t limit, std::vector<UserId> &found, bool &hasMore) const;
+
+public:
+  /**
+   * @brief Indexes a user.
+   * @param userId Handle of the user.
+   * @param login Login of the user.
+   * @param userName Display name of the user.
+   */
+  void add(UserId userId, const std::string &login, const std::string &userName);
+
+  /**
+   * @brief Reindexes a user after the login or the name changed.
+   * @param userId Handle of the user.
+   * @param login New login.
+   * @param userName New display name.
+   */
+  void update(UserId userId, const std::string &login, const std::string &userName);
+
+  /**
+   * @brief Removes a user from the index.
+   * @param userId Handle of the user.
+   */
+  void remove(UserId userId);
+
+  /**
+   * @brief Finds users whose login or name contains a text, case-insensitively.
+   * @param textToFind Search string.
+   * @param exclude User left out of the results (e.g. the active user).
+   * @param offset Number of matches to skip (start of the page).
+   * @param limit Maximum number of matches to return.
+   * @param found Receives the handles of the matches, ordered by slot.
+   * @return True if there are more matches after this page.
+   */
+  bool find(const std::string &textToFind, UserId exclude, std::size_t offset, std::size_t limit,
+            std::vector<UserId> &found) const;
+};
@@ -0,0 +1,71 @@
+#include "user/user_table.h"
+#include "user/user.h"
+#include <stdexcept>
+
+/**
+ * @brief Constructor for an empty table.
+ */
+UserTable::UserTable() : _chunks(new std::atomic<Slot *>[MAX_CHUNKS]) {
+  for (std::size_t i = 0; i < MAX_CHUNKS; ++i)
+    _chunks[i].store(nullptr, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Puts a user into a free slot.
+ * @param user Shared pointer to the user.
+ * @return Handle of the user.
+ * @throws std::length_error If the table is full.
+ */
+UserId UserTable::add(const std::shared_ptr<User> &user) {
+  if (!_freeSlots.empty()) {
+    std::uint32_t index = _freeSlots.back();
+    _freeSlots.pop_back();
+
+    auto &slot = _chunks[index >> CHUNK_SHIFT].load(std::memory_order_relaxed)[index & CHUNK_MASK];
+    slot._user = user;
+    return UserId{index, slot._generation};
+  }
+
+  std::uint32_t index = _slotCount.load(std::memory_order_relaxed);
+  if ((index >> CHUNK_SHIFT) >= MAX_CHUNKS)
+    throw std::length_error("UserTable: слишком много пользователей");
+
+  if ((index & CHUNK_MASK) == 0) {
+    _ownedChunks.push_back(std::make_unique<Slot[]>(CHUNK_SIZE));
+    _chunks[index >> CHUNK_SHIFT].store(_ownedChunks.back().get(), std::memory_order_relaxed);
+  }
+
+  // слот заполняется до публикации счетчика - читатели видят его уже готовым
+  auto &slot = _chunks[index >> CHUNK_SHIFT].load(std::memory_order_relaxed)[index & CHUNK_MASK];
+  slot._user = user;
+  _slotCount.store(index + 1, std::memory_order_release);
+  return UserId{index, slot._generation};
+}
+
+/**
+ * @brief Frees the slot of a user; handles to it stop resolving.
+ * @param id Handle of the user.
+ * @return True if the handle was live.
+ */
+bool UserTable::remove(UserId id) {
+  if (!get(id))
+    return false;
+
+  auto &slot = _chunks[id._index >> CHUNK_SHIFT].load(std::memory_order_relaxed)[id._index & CHUNK_MASK];
+  slot._user.reset();
+  if (++slot._generation == 0) // 0 зарезервирован для пустого UserId
+    slot._generation = 1;
+  _freeSlots.push_back(id._index);
+  return true;
+}
+
+/**
+ * @brief Resolves a handle to an owning pointer.
+ * @param id Handle of the user.
+ * @return Shared pointer to the user, or nullptr if the handle is invalid or stale.
+ */
+std::shared_ptr<User> UserTable::getShared(UserId id) const {
+  if (!get(id))
+    return nullptr;
+  return _chunks[id._index >> CHUNK_SHIFT].load(std::memory_order_relaxed)[id._index & CHUNK_MASK]._user;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "user/user_id.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class User;
+
+/**
+ * @brief Slot table that owns the users of a ChatSystem and resolves UserId handles.
+ * @details Resolving a handle is an index and a generation compare; no reference count
+ * is touched. Freed slots are reused with a new generation.
+ *
+ * Slots live in fixed chunks that never move, so get() runs without a lock while
+ * another thread adds users; add() and remove() must be serialized by the owner.
+ * A removed user must not be resolved concurrently with the reuse of its slot.
+ */
+class UserTable {
+private:
+  /**
+   * @brief One slot of the table.
+   */
+  struct Slot {
+    std::shared_ptr<User> _user;    ///< Occupant, nullptr if free.
+    std::uint32_t _generation = 1;  ///< Generation of the current or next occupant.
+  };
+
+  static constexpr std::size_t CHUNK_SHIFT = 12;               ///< log2 of the chunk size.
+  static constexpr std::size_t CHUNK_SIZE = 1u << CHUNK_SHIFT;  ///< Slots per chunk.
+  static constexpr std::size_t CHUNK_MASK = CHUNK_SIZE - 1;     ///< Index inside a chunk.
+  static constexpr std::size_t MAX_CHUNKS = 1u << 14;           ///< Chunks, up to 64M users.
+
+  std::unique_ptr<std::atomic<Slot *>[]> _chunks;    ///< Published chunks, read without a lock.
+  std::vector<std::unique_ptr<Slot[]>> _ownedChunks; ///< Owners of the chunks.
+  std::atomic<std::uint32_t> _slotCount{0};          ///< Slots visible to readers.
+  std::vector<std::uint32_t> _freeSlots;             ///< Indexes of free slots.
+
+public:
+  /**
+   * @brief Constructor for an empty table.
+   */
+  UserTable();
+  UserTable(const UserTable &) = delete;
+  UserTable &operator=(const UserTable &) = delete;
+
+  /**
+   * @brief Puts a user into a free slot.
+   * @param user Shared pointer to the user.
+   * @return Handle of the user.
+   * @throws std::length_error If the table is full.
+   */
+  UserId add(const std::shared_ptr<User> &user);
+
+  /**
+   * @brief Frees the slot of a user; handles to it stop resolving.
+   * @param id Handle of the user.
+   * @return True if the handle was live.
+   */
+  bool remove(UserId id);
+
+  /**
+   * @brief Resolves a handle.
+   * @param id Handle of the user.
+   * @return The user, or nullptr if the handle is invalid or stale.
+   */
+  User *get(UserId id) const {
+    if (id._index >= _slotCount.load(std::memory_order_acquire))
+      return nullptr;
+    const auto &slot = _chunks[id._index >> CHUNK_SHIFT].load(std::memory_order_relaxed)[id._index & CHUNK_MASK];
+    return slot._generation == id._generation ? slot._user.get() : nullptr;
+  }
+
+  /**
+   * @brief Resolves a handle to an owning pointer.
+   * @param id Handle of the user.
+   * @return Shared pointer to the user, or nullptr if the handle is invalid or stale.
+   */
+  std::shared_ptr<User> getShared(UserId id) const;
+};